@@ -81,6 +81,7 @@ namespace CNTK
             m_useNesterovMomentum(useNesterovMomentum),
             m_resetSGDMomentumAfterAggregation(resetSGDMomentumAfterAggregation),
             m_blockLearningRate(blockLearningRate),
+            m_blockMomentumAsTimeConstant(blockMomentumAsTimeConstant),
             m_blockMomentumAsTimeConstantPerWorker(blockMomentumAsTimeConstant / communicator->Workers().size()),
             m_globalModelAggregationBlockSize(globalModelAggregationBlockSize),
             m_numSamplesSeenInCurrentBlock(0),
@@ -195,6 +196,22 @@ namespace CNTK
             m_prevParamInitialized = false;
         }
 
+        void ResetCommunicator(const DistributedCommunicatorPtr& communicator) override
+        {
+            // The block size and the block momentum are global, the share of each worker changes with the number of workers.
+            size_t syncPeriodPerWorker = m_globalModelAggregationBlockSize / communicator->Workers().size();
+            if (syncPeriodPerWorker == 0)
+                InvalidArgument("Sync period is too small for %d workers.", (int)communicator->Workers().size());
+
+            DistributedLearnerBase::ResetCommunicator(communicator);
+
+            m_syncPeriodPerWorker = syncPeriodPerWorker;
+            m_blockMomentumAsTimeConstantPerWorker = m_blockMomentumAsTimeConstant / communicator->Workers().size();
+            m_numSamplesSeenInCurrentBlock = 0;
+            m_endOfDataReached = false;
+            m_shutDownSeenBefore = false;
+        }
+
     private:
         // Block momentum needs to do aggregation of loss and eval across workers.
         virtual void DoAggregateMetricsIfNeeded(NDArrayViewPtr& localTrainingLoss, NDArrayViewPtr& localEvalCriterion) override
@@ -635,9 +652,10 @@ namespace CNTK
         const bool m_resetSGDMomentumAfterAggregation;
         const bool m_useNesterovMomentum;
         const double m_blockLearningRate;
-        const double m_blockMomentumAsTimeConstantPerWorker;
+        const double m_blockMomentumAsTimeConstant;
+        double m_blockMomentumAsTimeConstantPerWorker;
 
-        const size_t m_syncPeriodPerWorker;
+        size_t m_syncPeriodPerWorker;
         const size_t m_globalModelAggregationBlockSize;
         size_t m_numSamplesSeenInCurrentBlock;
         size_t m_localTotalNumSamplesSeen;
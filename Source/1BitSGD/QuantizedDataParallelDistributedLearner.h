@@ -90,6 +90,18 @@ namespace CNTK
             return DistributedLearnerBase::CreateCheckpoint();
         }
 
+        void ResetCommunicator(const DistributedCommunicatorPtr& communicator) override
+        {
+            if (!std::dynamic_pointer_cast<QuantizedDistributedCommunicator>(communicator))
+                InvalidArgument("Quantized data parallel distributed learner requires a quantized communicator.");
+
+            DistributedLearnerBase::ResetCommunicator(communicator);
+
+            // The stripe this worker is responsible for depends on the number of workers; the residuals are reallocated on the next aggregation.
+            m_residuals.clear();
+            m_stripeResiduals.clear();
+        }
+
     private:
         // Residuals of quantized gradients.
         std::vector<NDArrayViewPtr> m_residuals;
@@ -48,6 +48,11 @@ namespace CNTK
             : m_zeroThresholdFor1Bit(zeroThresholdFor1Bit), m_useQuantizationForSelfStripe(useQuantizationForSelfStripe), m_numQuantizationBits(numQuantizationBits)
         {}
 
+        QuantizedMPICommunicatorImpl(const Microsoft::MSR::CNTK::MPIWrapperPtr& mpi, bool zeroThresholdFor1Bit, bool useQuantizationForSelfStripe, size_t numQuantizationBits)
+            : Base(mpi, DEFAULT_PACK_THRESHOLD_SIZE_IN_BYTES, MPICommunicatorCompression::None),
+              m_zeroThresholdFor1Bit(zeroThresholdFor1Bit), m_useQuantizationForSelfStripe(useQuantizationForSelfStripe), m_numQuantizationBits(numQuantizationBits)
+        {}
+
         void QuantizedAggregateInPlace(
             std::vector<NDArrayViewPtr>& inValues,
             std::vector<NDArrayViewPtr>& valueQuantizationResidues,
@@ -102,7 +107,16 @@ namespace CNTK
         // TODO: Use using and virtual inheritance after switching to VS2015.
         const std::unordered_set<DistributedWorkerDescriptor>& Workers() const override { return Base::Workers(); }
         const DistributedWorkerDescriptor& CurrentWorker() const override { return Base::CurrentWorker(); }
-        DistributedCommunicatorPtr SubGroup(const std::unordered_set<DistributedWorkerDescriptor>& g) const override { return Base::SubGroup(g); }
+        DistributedCommunicatorPtr SubGroup(const std::unordered_set<DistributedWorkerDescriptor>& g) const override
+        {
+            auto mpi = CreateSubGroupMPI(g);
+            if (mpi == nullptr)
+                return nullptr;
+
+            // DistributedCommunicator is an ambiguous base, use the quantized one like QuantizedMPICommunicator() does.
+            return std::static_pointer_cast<QuantizedDistributedCommunicator>(
+                std::make_shared<QuantizedMPICommunicatorImpl>(mpi, m_zeroThresholdFor1Bit, m_useQuantizationForSelfStripe, m_numQuantizationBits));
+        }
         void Concatenate(
             const std::vector<ValuePtr>& in,
             std::vector<ValuePtr>& out,
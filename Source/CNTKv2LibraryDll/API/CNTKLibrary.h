@@ -668,8 +668,10 @@ namespace CNTK
         friend class PackedValue;
         friend class MPICommunicatorImpl;
         friend class BlockMomentumDistributedLearner;
+        friend class ModelAveragingDistributedLearner;
         friend class Internal::VariableResolver;
         friend class Trainer;
+        friend class Serializer;
 
         template <typename T, typename ...CtorArgTypes>
         friend inline std::shared_ptr<T> MakeSharedObject(CtorArgTypes&& ...ctorArgs);
@@ -3161,6 +3163,37 @@ namespace CNTK
         /// ONNX support limited subset of CNTK.
         ///
         ONNX,
+
+        ///
+        /// CNTK version 2 format with the parameter values stored aligned, outside of the graph description.
+        /// Loading memory-maps the file: parameters are paged in when they are first touched and their memory
+        /// is shared by all processes that load the same file. The parameters of a loaded model are copy-on-write.
+        ///
+        CNTKv2Mapped,
+    };
+
+    ///
+    /// List of supported disk formats for Trainer checkpoints.
+    ///
+    enum class CheckpointFormat
+    {
+        ///
+        /// The model and the trainer state are each saved as a single Dictionary protobuf.
+        ///
+        CNTKv2,
+
+        ///
+        /// Tensors are written one at a time, as chunked records with a CRC-32 checksum. Trainer::SaveCheckpoint
+        /// reads the parameters and the learner state in place while writing them, so that saving does not need
+        /// in-memory copies of the model and the learner state (values on a GPU are copied to the CPU one tensor at a time).
+        /// SaveCheckpointAsync takes copies instead, since training continues while they are written.
+        ///
+        CNTKv2Streaming,
+
+        ///
+        /// Same as CNTKv2Streaming, with the chunks compressed by zlib. Mostly pays off for the learner state.
+        ///
+        CNTKv2StreamingCompressed,
     };
 
 
@@ -4797,6 +4830,19 @@ namespace CNTK
     ///
     CNTK_API FunctionPtr AsComposite(const FunctionPtr& rootFunction, const std::wstring& name = L"");
 
+    ///
+    /// Creates a frozen, inference only copy of the specified model that computes the specified outputs (all outputs of the model by default).
+    /// Everything that does not contribute to the outputs (e.g. the training criterion) is dropped, Parameters are turned into Constants,
+    /// Block Functions are inlined, Dropout is removed, BatchNormalization is folded into the weights and bias of a preceding Times or Convolution
+    /// where possible, and all subgraphs that only depend on Constants are precomputed on the specified device.
+    /// If 'maxBatchSize' is non-zero, the memory of all intermediate results is planned and allocated upfront, when the model is first
+    /// evaluated, for minibatches of up to 'maxBatchSize' samples, so that evaluation of smaller minibatches does not allocate any memory.
+    /// When the frozen model is evaluated, the bias and the ReLU, Sigmoid or Tanh activation of dense layers (Times followed by Plus) are
+    /// applied in the epilogue of the matrix product instead of as separate passes over its result; frozen models cannot be trained.
+    /// The frozen model is a regular composite Function; the memory plan and the fusion are preserved by Save/Load and Clone.
+    ///
+    CNTK_API FunctionPtr FreezeForInference(const FunctionPtr& model, const std::vector<Variable>& outputs = {}, size_t maxBatchSize = 0, const DeviceDescriptor& device = DeviceDescriptor::UseDefaultDevice());
+
     ///
     /// Create an instance of the CNTK built-in elementwise exponential linear unit operation with the specified input operand.
     ///
@@ -5357,6 +5403,20 @@ namespace CNTK
             return m_communicator;
         }
 
+        ///
+        /// Replaces the distributed communicator after the set of workers has changed (see ElasticConfig).
+        /// All workers of the new communicator must call this at the same minibatch boundary, with the state of the
+        /// learner synchronized by CreateCheckpoint() on the workers of the previous communicator.
+        /// Derived learners recompute their state that depends on the number of workers.
+        ///
+        CNTK_API virtual void ResetCommunicator(const DistributedCommunicatorPtr& communicator)
+        {
+            if (!communicator)
+                InvalidArgument("Communicator passed to a Distributed learner must not be null.");
+
+            m_communicator = communicator;
+        }
+
         bool Update(std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues, size_t minibatchSampleCount, bool sweepEnd) override
         {
             MinibatchInfo info{ false, sweepEnd, minibatchSampleCount };
@@ -5447,7 +5507,7 @@ namespace CNTK
         }
 
         const LearnerPtr m_learner;
-        const DistributedCommunicatorPtr m_communicator;
+        DistributedCommunicatorPtr m_communicator;
         const size_t m_distributeAfterSamples;
         bool m_metricAggregator;
 
@@ -5478,6 +5538,22 @@ namespace CNTK
         bool resetSGDMomentumAfterAggregation = true,
         double blockLearningRate = 1.0);
 
+    ///
+    /// Creates a local SGD / periodic model averaging distributed learner, supported on both CPU and GPU builds.
+    /// Every 'syncPeriod' minibatches the local models are averaged across workers, weighted by the number of samples
+    /// each worker processed. The averaging runs on a background thread overlapped with at most 'maxStaleness' further
+    /// local minibatches; 'maxStaleness' == 0 makes the averaging synchronous. The background averaging uses a private
+    /// duplicate of the communicator and requires MPI with MPI_THREAD_MULTIPLE support, which is only requested if
+    /// Internal::EnableConcurrentMPICalls() is called before the first communicator is created; without it the averaging is synchronous.
+    ///
+    CNTK_API DistributedLearnerPtr CreateModelAveragingDistributedLearner(
+        DistributedCommunicatorPtr communicator,
+        LearnerPtr learner,
+        size_t distributeAfterSamples,
+        size_t syncPeriod,
+        size_t maxStaleness = 1,
+        bool resetSGDMomentumAfterAggregation = false);
+
     ///
     /// Evaluator is a top-level abstraction for evaluating a model's performance with specified error criterion.
     ///
@@ -5556,6 +5632,17 @@ namespace CNTK
             m_communicator = communicator;
         }
 
+        // Used when the set of distributed workers changes during training.
+        void ReplaceCommunicator(DistributedCommunicatorPtr communicator)
+        {
+            if (m_communicator == nullptr)
+                LogicError("Communicator has not been initialized.");
+
+            m_communicator = communicator;
+        }
+
+        const DistributedCommunicatorPtr& Communicator() const { return m_communicator; }
+
         // Helper functions.
         std::vector<Variable> GetCombinedEvalFunctionArgs() const;
         static size_t GetSampleCount(const Variable& var, const ValuePtr& value);
@@ -5590,6 +5677,63 @@ namespace CNTK
     ///
     CNTK_API EvaluatorPtr CreateEvaluator(const FunctionPtr& evaluationFunction, const std::vector<ProgressWriterPtr>& progressWriters = {});
 
+    ///
+    /// A pool of evaluation contexts for evaluating a model on multiple threads concurrently.
+    /// A context is a clone of the model that shares the values of all Parameters and Constants with it. Everything else
+    /// is per context: each one holds a complete computation network (all nodes and their activation buffers), so memory
+    /// other than the weights grows linearly with the number of contexts. Contexts are compiled once and reused after
+    /// being released, so acquiring a context from the pool does not rebuild the network.
+    ///
+    class EvaluationContextPool : public std::enable_shared_from_this<EvaluationContextPool>
+    {
+        friend CNTK_API EvaluationContextPoolPtr CreateEvaluationContextPool(const FunctionPtr& model, const DeviceDescriptor& device, size_t initialSize, const std::vector<Variable>& outputs);
+
+        template <typename T, typename ...CtorArgTypes>
+        friend inline std::shared_ptr<T> MakeSharedObject(CtorArgTypes&& ...ctorArgs);
+
+    public:
+        ///
+        /// Returns a context for the exclusive use of the caller; a new one is created if none is available.
+        /// The context goes back to the pool when the last reference to it is released.
+        /// The context has its own argument and output Variables, in the same order as the ones of the model.
+        ///
+        CNTK_API FunctionPtr Acquire();
+
+        ///
+        /// Number of contexts created by the pool, including the ones in use.
+        ///
+        CNTK_API size_t NumberOfContexts() const;
+
+        ///
+        /// Number of contexts ready to be acquired without creating a new one.
+        ///
+        CNTK_API size_t NumberOfAvailableContexts() const;
+
+    private:
+        EvaluationContextPool(const FunctionPtr& model, const DeviceDescriptor& device, size_t initialSize, const std::vector<Variable>& outputs);
+
+        FunctionPtr CreateContext() const;
+        void Release(const FunctionPtr& context);
+
+        FunctionPtr m_model;
+        DeviceDescriptor m_device;
+
+        // Indices of the model outputs the contexts are compiled for.
+        std::vector<size_t> m_outputIndices;
+
+        mutable std::mutex m_mutex;
+        std::vector<FunctionPtr> m_availableContexts;
+        size_t m_numberOfContexts;
+    };
+
+    ///
+    /// Construct an EvaluationContextPool for the specified model, with 'initialSize' contexts compiled upfront for evaluating
+    /// the specified outputs of the model (all outputs, if empty). The element type of the network is the data type of the
+    /// arguments these outputs depend on, which must all agree, as in Function::Forward. Contexts of models whose arguments
+    /// have free or inferred dimensions or types are compiled on their first evaluation instead.
+    ///
+    CNTK_API EvaluationContextPoolPtr CreateEvaluationContextPool(const FunctionPtr& model, const DeviceDescriptor& device = DeviceDescriptor::UseDefaultDevice(), size_t initialSize = 0, const std::vector<Variable>& outputs = {});
+
     enum class DataUnit : unsigned int
     {
         ///Indiciate that the frequency of action is counted by sweep.
@@ -5636,7 +5780,32 @@ namespace CNTK
         ///
         /// Checkpoint the model and other Trainer state at the specified file location
         ///
-        CNTK_API void SaveCheckpoint(const std::wstring& filePath, Dictionary externalState = Dictionary());
+        CNTK_API void SaveCheckpoint(const std::wstring& filePath, Dictionary externalState = Dictionary(), CheckpointFormat format = CheckpointFormat::CNTKv2);
+
+        ///
+        /// Same as SaveCheckpoint, but only takes an in-memory snapshot of the model and the Trainer state on the calling thread.
+        /// The snapshot is serialized and written on a background thread while training continues. At most one checkpoint is
+        /// written at a time: the call waits for the previous one first. In distributed training the workers do not wait for
+        /// the main worker to finish writing. Errors of the background write are reported by the next call of SaveCheckpoint,
+        /// SaveCheckpointAsync, RestoreFromCheckpoint or WaitForPendingCheckpoint.
+        ///
+        CNTK_API void SaveCheckpointAsync(const std::wstring& filePath, Dictionary externalState = Dictionary(), CheckpointFormat format = CheckpointFormat::CNTKv2);
+
+        ///
+        /// Waits until the checkpoint started by SaveCheckpointAsync, if any, has been written.
+        ///
+        CNTK_API void WaitForPendingCheckpoint();
+
+        ///
+        /// Checkpoint the model and other Trainer state, writing only what changed since the last full checkpoint.
+        /// The first call for a file location, and every 'compactionPeriod'-th call after it, writes a full checkpoint.
+        /// The other calls write a delta file next to it, which holds the columns of the parameters and of the learners'
+        /// smoothed gradients that were changed by sparse (block column) gradients since then, e.g. the rows of an embedding
+        /// that occurred in the data, as well as the complete scalar learner state, the mutable constants and the external state.
+        /// Parameters updated with dense gradients are written as a whole. RestoreFromCheckpoint applies the delta, if present.
+        /// Requires the built-in learners and is not supported in distributed training.
+        ///
+        CNTK_API void SaveDeltaCheckpoint(const std::wstring& filePath, Dictionary externalState = Dictionary(), size_t compactionPeriod = 10);
 
         ///
         /// Restore the model and trainer state from a previously saved model and checkpoint from the specified file location
@@ -5713,12 +5882,34 @@ namespace CNTK
         bool TrainLocalMinibatch(const std::unordered_map<Variable, ValuePtr>& arguments, std::unordered_map<Variable, ValuePtr>& outputsToFetch, bool sweepEnd, const DeviceDescriptor& computeDevice);
         bool TrainDistributedMinibatch(const std::unordered_map<Variable, ValuePtr>& arguments, std::unordered_map<Variable, ValuePtr>& outputsToFetch, bool sweepEnd, const DeviceDescriptor& computeDevice);
 
-        void Save(const std::wstring& modelFilePath, const std::vector<DictionaryValue>& learnerState,
-            const Dictionary& externalState, const Dictionary& distributedState = {});
+        void SaveCheckpoint(const std::wstring& filePath, Dictionary externalState, CheckpointFormat format, bool async);
+
+        void Save(const std::wstring& modelFilePath, std::vector<DictionaryValue>&& learnerState,
+            const Dictionary& externalState, const Dictionary& distributedState = {}, CheckpointFormat format = CheckpointFormat::CNTKv2, bool async = false);
+
+        // Applies the delta written by SaveDeltaCheckpoint, if any, on top of the restored full checkpoint
+        // and returns the external state stored in it.
+        Dictionary RestoreFromDeltaCheckpoint(const std::wstring& modelFilePath, const Dictionary& externalState, bool isDeltaCheckpointBase);
 
         void UpdateTrainingProgress(size_t numSamples, const ValuePtr& loss, const ValuePtr& evalCriterion, const DeviceDescriptor& computeDevice);
         void AddProgressWriters(const std::vector<ProgressWriterPtr>& progressWriters);
 
+        // Elastic training: switches all distributed learners to the communicator of the new set of workers.
+        void ResetCommunicator(const DistributedCommunicatorPtr& communicator);
+
+        // Elastic training: copies the model, the given learner state and external state from the 'rootRank' worker
+        // to all others, which restore their learners from it. Returns the external state of the 'rootRank' worker.
+        Dictionary SynchronizeState(const std::vector<DictionaryValue>& learnerState, const Dictionary& externalState, size_t rootRank);
+
+        // The checkpoint being written by SaveCheckpointAsync.
+        std::future<void> m_pendingCheckpoint;
+
+        // The full checkpoint subsequent SaveDeltaCheckpoint calls write their deltas against, the number of samples
+        // seen when it was written and the number of deltas written since then.
+        std::wstring m_deltaCheckpointBase;
+        size_t m_deltaCheckpointBaseSampleCount;
+        size_t m_numDeltaCheckpoints;
+
         FunctionPtr m_model;
         FunctionPtr m_combinedTrainingFunction;
         FunctionPtr m_lossFunction;
@@ -6169,7 +6360,8 @@ namespace CNTK
 
         CNTK_API virtual const DistributedWorkerDescriptor& CurrentWorker() const = 0;
 
-        // Creates a new distributed communicator comprising of a subset of the workers in this communicator
+        // Creates a new distributed communicator comprising of a subset of the workers in this communicator.
+        // This is a collective call; workers that are not part of the sub-group get a null communicator.
         CNTK_API virtual DistributedCommunicatorPtr SubGroup(const std::unordered_set<DistributedWorkerDescriptor>& subGroupWorkers) const = 0;
 
         // A collective communication API to concatenate values across each worker of this communicator. The concatenated values are only sent to the specified workers; for all others the returned Values are null
@@ -6250,6 +6442,24 @@ namespace CNTK
     ///
     CNTK_API DistributedCommunicatorPtr MPICommunicator(size_t packThresholdSizeInBytes = Internal::GetMPIPackThreshold());
 
+    ///
+    /// Precision of the float values sent over the network by the aggregations of a compressed MPI communicator.
+    ///
+    enum class MPICommunicatorCompression : unsigned int
+    {
+        None = 0,
+        Float16 = 1,   // IEEE half precision
+        BFloat16 = 2,  // upper half of fp32: same range as fp32, fewer mantissa bits
+    };
+
+    ///
+    /// Built-in MPI-based communicator that converts float values to 16 bits before aggregating them, halving the network traffic.
+    /// Each reduction step adds in fp32 but rounds the partial sum back to 16 bits, so the rounding error grows with the number of workers.
+    /// With Float16, values whose sum over all workers could exceed the fp16 range are sent in fp32 instead.
+    /// Only used for values that are aggregated through CPU memory; NCCL aggregations are unaffected.
+    ///
+    CNTK_API DistributedCommunicatorPtr CompressedMPICommunicator(MPICommunicatorCompression compression, size_t packThresholdSizeInBytes = Internal::GetMPIPackThreshold());
+
     ///
     /// Distributed communicator that allows quantized aggregations.
     ///
@@ -6295,19 +6505,22 @@ namespace CNTK
         /// checkpointFrequencyInSamples: frequency in samples when to perform checkpointing.
         /// restoreFromCheckpointIfExists: if flag is set, the training session will try to restore before training.
         /// preserveAllCheckpoints: if flag is set, all checkpoints will be preserved.
+        /// asyncCheckpointing: if flag is set, checkpoints are written on a background thread (see Trainer::SaveCheckpointAsync).
         ///
         CNTK_API CheckpointConfig(
             const std::wstring& checkPointFileName,
             size_t checkpointFrequency = std::numeric_limits<size_t>::max(),
             DataUnit checkpointFrequencyUnit = DataUnit::Sample,
             bool restoreFromCheckpointIfExists = true,
-            bool preserveAllCheckpoints = false);
+            bool preserveAllCheckpoints = false,
+            bool asyncCheckpointing = false);
 
     private:
         friend class TrainingSession;
         const std::wstring m_fileName;
         const bool m_restore;
         const bool m_preserveAll;
+        const bool m_async;
         const size_t m_frequency;
         const DataUnit m_frequencyUnit;
     };
@@ -6333,6 +6546,34 @@ namespace CNTK
         const std::unordered_map<Variable, StreamInformation> m_varToStream;
     };
 
+    ///
+    /// Elastic training configuration
+    ///
+    struct ElasticConfig
+    {
+    public:
+        ///
+        /// Elastic training configuration.
+        /// frequency: how often the workers agree on the set of training workers. Workers that called TrainingSession::RequestLeave()
+        ///            stop training at the next such point, without interrupting the others. Zero disables elastic training.
+        /// numberOfActiveWorkers: number of workers that train; the remaining workers wait as spares and take over from the
+        ///            workers that leave. By default all workers train.
+        ///
+        /// Membership changes are cooperative only. A worker that crashes or is killed is not detected and not replaced:
+        /// the other workers block in their next collective call until the MPI runtime aborts the job.
+        ///
+        CNTK_API ElasticConfig(
+            size_t frequency = 0,
+            DataUnit frequencyUnit = DataUnit::Minibatch,
+            size_t numberOfActiveWorkers = std::numeric_limits<size_t>::max());
+
+    private:
+        friend class TrainingSession;
+        const size_t m_frequency;
+        const DataUnit m_frequencyUnit;
+        const size_t m_numberOfActiveWorkers;
+    };
+
     ///
     /// Base abstract class that represents a training session.
     /// Derived classes can redefine different aspects of training, overriding base virtual methods (GetMinibatchSize, OnMinibatchStart, etc.)
@@ -6368,7 +6609,8 @@ namespace CNTK
             DataUnit progressFrequencyUnit,
             const CheckpointConfig& checkpointing,
             const CrossValidationConfig& crossValidation,
-            const TestConfig& test);
+            const TestConfig& test,
+            const ElasticConfig& elastic = ElasticConfig());
 
         ///
         /// Runs the session.
@@ -6380,6 +6622,12 @@ namespace CNTK
         ///
         CNTK_API void RestoreFromCheckpoint(const std::wstring& checkpointFileName);
 
+        ///
+        /// In elastic training, asks for the current worker to stop training at the next membership update.
+        /// Train() then returns on this worker while the others continue. Can be called from any thread.
+        ///
+        CNTK_API void RequestLeave();
+
         CNTK_API virtual ~TrainingSession() {}
 
     public:
@@ -6449,6 +6697,21 @@ namespace CNTK
         void RestoreFromCheckpoint();
         void SaveCheckpoint(size_t currentIndex);
         void SaveFinalCheckpoint();
+        void RecalculateActionIndices();
+
+        // Elastic training.
+        enum class WorkerStatus : unsigned int
+        {
+            Active = 0,
+            Leaving = 1,
+            Spare = 2,
+            Finished = 3,
+            Gone = 4,   // not part of the training anymore; never exchanged
+        };
+
+        WorkerStatus StartElasticTraining();
+        WorkerStatus UpdateMembership(WorkerStatus status);
+        void UpdateDistributedConfiguration();
 
         bool CrossValidate(size_t currentIndex, const DeviceDescriptor& computeDevice);
         void ReportProgress(size_t currentIndex);
@@ -6476,6 +6739,12 @@ namespace CNTK
         CheckpointConfig m_checkpoint;
         CrossValidationConfig m_cv;
         TestConfig m_test;
+        ElasticConfig m_elastic;
+
+        // All workers that take part in elastic training, including the spares.
+        DistributedCommunicatorPtr m_elasticCommunicator;
+        size_t m_membershipUpdateIndex;
+        std::atomic<bool> m_leaveRequested;
     };
 
     ///
@@ -6607,7 +6876,8 @@ namespace CNTK
         DataUnit progressFrequencyUnit,
         const CheckpointConfig& checkpointing = { L"" },
         const CrossValidationConfig& crossValidation = { nullptr },
-        const TestConfig& test = { nullptr });
+        const TestConfig& test = { nullptr },
+        const ElasticConfig& elastic = ElasticConfig());
 
     ///
     /// Creates an instance of crop node, which crops one of its inputs along spatial dimensions only.
@@ -98,6 +98,8 @@ CNTK_API CNTK_StatusCode CNTK_DefaultDevice(
 //
 // Loads a model from the specified file and returns an opaque handle to the model
 // that should be passed to further operations.
+// Parameters and constants with the same content as the ones of an already loaded model
+// are not allocated again, they are shared read only between the models.
 //
 // Parameters:
 //     modelFilePath [in]: a null-terminated path to a CNTK model file
@@ -130,7 +132,8 @@ enum CNTK_ParameterCloningMethod
 };
 
 //
-// Clones the specified model using the provided method.
+// Clones the specified model using the provided method. Unless the method is CNTK_ModelParameterClone,
+// the clone shares its parameters with the model and all other models with the same parameter values.
 //
 // Parameters:
 //    model [in]: model to clone
@@ -153,6 +156,29 @@ CNTK_API CNTK_StatusCode CNTK_CloneModel(
 CNTK_API void CNTK_ReleaseModel(
     /*[in]*/ CNTK_ModelHandle model);
 
+//
+// Memory used by the parameters and constants of a model.
+//
+typedef struct CNTK_ModelMemoryUsage
+{
+    uint64_t totalBytes;        // All parameters and constants of the model
+    uint64_t sharedBytes;       // Part of totalBytes that is shared with other models
+    uint64_t uniqueBytes;       // Part of totalBytes that is used by this model only
+    uint64_t proportionalBytes; // Unique bytes plus an even part of the shared bytes among the models sharing them
+} CNTK_ModelMemoryUsage;
+
+//
+// Gets the memory used by the parameters of the model. The proportional bytes of all loaded
+// models sum up to the parameter memory of the process.
+//
+// Parameters:
+//    model [in]: model
+//    usage [out]: memory usage of the model
+//
+CNTK_API CNTK_StatusCode CNTK_GetModelMemoryUsage(
+    /*[in]*/ CNTK_ModelHandle model,
+    /*[out]*/ CNTK_ModelMemoryUsage* usage);
+
 //
 // Represents a shape of multi dimensional array. Counterpart of CNTK::NDShape.
 //
@@ -219,6 +245,99 @@ CNTK_API CNTK_StatusCode CNTK_EvaluateSequence(CNTK_ModelHandle model,
     /*[in]*/uint32_t numOutputs,
     /*[in/out]*/CNTK_Value** outputValues);
 
+//
+// Dynamic request batching.
+//
+// A batching evaluator accepts single sample requests from many threads concurrently and
+// coalesces them into minibatches, so that one forward pass serves many callers.
+//
+
+typedef void* CNTK_BatchingEvaluatorHandle;
+
+typedef struct CNTK_BatchingOptions
+{
+    uint32_t maxBatchSize;           // Maximum number of requests evaluated in one forward pass.
+    uint32_t maxLatencyMicroseconds; // Maximum time the oldest pending request waits for the batch to fill up.
+} CNTK_BatchingOptions;
+
+//
+// Latency percentiles in microseconds.
+//
+typedef struct CNTK_LatencyPercentiles
+{
+    double p50;
+    double p90;
+    double p99;
+    double max;
+} CNTK_LatencyPercentiles;
+
+typedef struct CNTK_BatchingStatistics
+{
+    uint64_t numRequests;                   // Number of requests evaluated
+    uint64_t numBatches;                    // Number of forward passes
+    CNTK_LatencyPercentiles queueLatency;   // From the submission of a request till the start of its batch
+    CNTK_LatencyPercentiles computeLatency; // Duration of the forward pass of the batch, per request
+} CNTK_BatchingStatistics;
+
+//
+// Creates a batching evaluator for the model. The evaluator works on its own clone of the model
+// that shares the parameters with it; the model handle can be released afterwards.
+//
+// Parameters:
+//    model [in]: model to evaluate
+//    options [in]: batching options
+//    evaluator [out]: the resulting evaluator
+//
+CNTK_API CNTK_StatusCode CNTK_CreateBatchingEvaluator(
+    /*[in]*/ CNTK_ModelHandle model,
+    /*[in]*/ const CNTK_BatchingOptions* options,
+    /*[out]*/ CNTK_BatchingEvaluatorHandle* evaluator);
+
+//
+// Evaluates a single sample. Blocks until the batch containing the request has been evaluated.
+// Can be called from multiple threads concurrently.
+//
+// Parameters:
+//    evaluator [in]: batching evaluator
+//    inputs [in]: all arguments of the model
+//    inputValues [in]: one sample for each of the arguments; its size must match the argument shape
+//    numInputs [in]: number of inputs
+//    outputs [in]: outputs to evaluate
+//    numOutputs [in]: number of outputs
+//    outputValues [in/out]: if *outputValues is null, an array of values is allocated, otherwise
+//                           the results are written to the preallocated buffers
+//
+CNTK_API CNTK_StatusCode CNTK_EvaluateBatched(CNTK_BatchingEvaluatorHandle evaluator,
+    /*[in]*/const CNTK_Variable* inputs,
+    /*[in]*/const CNTK_Value* inputValues,
+    /*[in]*/uint32_t numInputs,
+    /*[in]*/const CNTK_Variable* outputs,
+    /*[in]*/uint32_t numOutputs,
+    /*[in/out]*/CNTK_Value** outputValues);
+
+//
+// Gets the number of evaluated requests and batches, and the latency percentiles of the most recent requests.
+//
+// Parameters:
+//    evaluator [in]: batching evaluator
+//    reset [in]: whether to reset the statistics afterwards
+//    statistics [out]: the statistics
+//
+CNTK_API CNTK_StatusCode CNTK_GetBatchingStatistics(
+    /*[in]*/ CNTK_BatchingEvaluatorHandle evaluator,
+    /*[in]*/ bool reset,
+    /*[out]*/ CNTK_BatchingStatistics* statistics);
+
+//
+// Evaluates the pending requests and releases all resources associated with the evaluator.
+// No requests must be submitted concurrently.
+//
+// Parameters:
+//    evaluator [in]: evaluator to release
+//
+CNTK_API void CNTK_ReleaseBatchingEvaluator(
+    /*[in]*/ CNTK_BatchingEvaluatorHandle evaluator);
+
 //
 // Auxiliary functions.
 //
@@ -214,6 +214,9 @@ namespace CNTK
     class Evaluator;
     typedef std::shared_ptr<Evaluator> EvaluatorPtr;
 
+    class EvaluationContextPool;
+    typedef std::shared_ptr<EvaluationContextPool> EvaluationContextPoolPtr;
+
     class Trainer;
     typedef std::shared_ptr<Trainer> TrainerPtr;
 
@@ -315,6 +318,16 @@ namespace CNTK
         CNTK_API void EnableGradientAccumulationOptimization();
         CNTK_API void DisableGradientAccumulationOptimization();
 
+        // Evaluate independent nodes of networks on the CPU concurrently, e.g. the towers of multi-tower models.
+        // Applies to networks whose matrices are allocated afterwards.
+        CNTK_API void EnableParallelNodeEvaluation();
+        CNTK_API void DisableParallelNodeEvaluation();
+
+        // Run the forward pass of CPU convolutions with 1x1 and 3x3 kernels on Winograd and direct kernels instead of GEMM.
+        // Applies to convolutions validated afterwards.
+        CNTK_API void EnableSmallFilterConvolution();
+        CNTK_API void DisableSmallFilterConvolution();
+
         static const uint64_t DefaultProfilerBufferSize = 32 * 1024 * 1024;
         CNTK_API void StartProfiler(const std::wstring& profilerDir = L"profiler", bool profilerSyncGpu = false, size_t profilerBufferSize = DefaultProfilerBufferSize);
         CNTK_API void EnableProfiler();
@@ -330,6 +343,10 @@ namespace CNTK
         CNTK_API void SetMPIPackThreshold(size_t packThesholdInBytes);
         CNTK_API size_t GetMPIPackThreshold();
 
+        // Initialize MPI with MPI_THREAD_MULTIPLE, as the background rounds of the model averaging learner need.
+        // Must be called before the first MPI communicator is created.
+        CNTK_API void EnableConcurrentMPICalls();
+
         CNTK_API bool AreEquivalent(const ::CNTK::FunctionPtr& f1, const ::CNTK::FunctionPtr& f2);
         CNTK_API bool AreEquivalent(const ::CNTK::Variable& v1, const ::CNTK::Variable& v2, bool allowParameterAndConstantsEquivalence = false);
 
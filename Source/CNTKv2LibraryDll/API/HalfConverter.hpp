@@ -2,6 +2,13 @@
 
 #pragma once
 
+#include <cstddef>
+
+#if (defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))) && !defined(__CUDACC__)
+#include <immintrin.h>
+#define CNTK_HAS_F16C 1
+#endif
+
 namespace CNTK {
 
 // Host functions for converting between FP32 and FP16 formats
@@ -36,9 +43,9 @@ inline void float16ToFloat(const unsigned short* src, float* res)
     *(unsigned*)res = ((sign << 31) | (exponent << 23) | mantissa);
 }
 
-inline void floatToFloat16(float* src, unsigned short* dest)
+inline void floatToFloat16(const float* src, unsigned short* dest)
 {
-    unsigned x = *(unsigned*)src;
+    unsigned x = *(const unsigned*)src;
     unsigned u = (x & 0x7fffffff), remainder, shift, lsb, lsb_s1, lsb_m1;
     unsigned short sign;
     unsigned exponent, mantissa;
@@ -91,4 +98,55 @@ inline void floatToFloat16(float* src, unsigned short* dest)
     *dest = (sign | (unsigned short)((exponent << 10) | mantissa));
 }
 
+// Host functions for converting between FP32 and bfloat16, the upper half of FP32; rounds to nearest even
+inline void floatToBFloat16(const float* src, unsigned short* dest)
+{
+    unsigned x = *(const unsigned*)src;
+    if ((x & 0x7fffffff) > 0x7f800000) // NaN, keep it a quiet NaN after truncation
+        *dest = (unsigned short)((x >> 16) | 0x40);
+    else
+        *dest = (unsigned short)((x + 0x7fff + ((x >> 16) & 1)) >> 16);
+}
+
+inline void bfloat16ToFloat(const unsigned short* src, float* res)
+{
+    *(unsigned*)res = ((unsigned)*src) << 16;
+}
+
+// Array versions of the conversions, e.g. for compressing buffers before sending them over the network.
+// The FP16 ones use F16C when the build targets it; the bfloat16 ones are left to the compiler to vectorize.
+inline void floatToFloat16(const float* src, unsigned short* dest, size_t count)
+{
+    size_t i = 0;
+#ifdef CNTK_HAS_F16C
+    for (; i + 8 <= count; i += 8)
+        _mm_storeu_si128((__m128i*)(dest + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+    for (; i < count; i++)
+        floatToFloat16(src + i, dest + i);
+}
+
+inline void float16ToFloat(const unsigned short* src, float* res, size_t count)
+{
+    size_t i = 0;
+#ifdef CNTK_HAS_F16C
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(res + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(src + i))));
+#endif
+    for (; i < count; i++)
+        float16ToFloat(src + i, res + i);
+}
+
+inline void floatToBFloat16(const float* src, unsigned short* dest, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        floatToBFloat16(src + i, dest + i);
+}
+
+inline void bfloat16ToFloat(const unsigned short* src, float* res, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        bfloat16ToFloat(src + i, res + i);
+}
+
 }
\ No newline at end of file
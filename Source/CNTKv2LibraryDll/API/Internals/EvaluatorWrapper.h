@@ -12,6 +12,12 @@
 #include <functional>
 #include <codecvt>
 #include <locale>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
 
 #include "CNTKLibrary.h"
 #include "CNTKLibraryC.h"
@@ -94,14 +100,19 @@ namespace CNTK
        return std::wstring_convert<cntk_codecvt>().to_bytes(ws);
     }
 
+    class BatchingEvaluatorWrapper;
+    class SharedParameters;
+
     // Evaluator interface
     class EvaluatorWrapper : boost::noncopyable
     {
     public:
         virtual void GetModelArgumentsInfo(CNTK_Variable** inputs, uint32_t* numInputs) = 0;
         virtual void GetModelOutputsInfo(CNTK_Variable** outputs, uint32_t* numOutputs) = 0;
+        virtual void GetMemoryUsage(CNTK_ModelMemoryUsage* usage) = 0;
 
         virtual std::unique_ptr<EvaluatorWrapper> Clone(CNTK_ParameterCloningMethod method, bool flatten) = 0;
+        virtual std::unique_ptr<BatchingEvaluatorWrapper> CreateBatchingEvaluator(const CNTK_BatchingOptions& options) = 0;
         virtual void EvaluateSequence(
             const CNTK_Variable* inputs,
             const CNTK_Value* inputValues,
@@ -152,12 +163,14 @@ namespace CNTK
     public:
         CNTKEvaluatorWrapper(const char* modelFilePath, const CNTK_DeviceDescriptor* device);
         CNTKEvaluatorWrapper(const char* modelFilePath, DeviceDescriptor device);
-        CNTKEvaluatorWrapper(FunctionPtr model, DeviceDescriptor device);
+        CNTKEvaluatorWrapper(FunctionPtr model, DeviceDescriptor device, bool shareParameters = false);
 
         void GetModelArgumentsInfo(CNTK_Variable** inputs, uint32_t* numInputs) override;
         void GetModelOutputsInfo(CNTK_Variable** outputs, uint32_t* numOutputs) override;
+        void GetMemoryUsage(CNTK_ModelMemoryUsage* usage) override;
 
         std::unique_ptr<EvaluatorWrapper> Clone(CNTK_ParameterCloningMethod method, bool flatten) override;
+        std::unique_ptr<BatchingEvaluatorWrapper> CreateBatchingEvaluator(const CNTK_BatchingOptions& options) override;
 
         void EvaluateSequence(
             const CNTK_Variable* inputs,
@@ -169,11 +182,87 @@ namespace CNTK
             CNTK_Value** outputValues) override;
 
     private:
+        // Parameter values this model shares with other models; also kept alive by the batching evaluators of the model.
+        std::shared_ptr<SharedParameters> m_sharedParameters;
         FunctionPtr m_func;
         DeviceDescriptor m_device;
         std::unordered_map<std::string, Variable> m_arguments;
         std::unordered_map<std::string, Variable> m_outputs;
     };
+
+    //
+    // Coalesces single sample requests of concurrent callers into minibatches.
+    // Requests are queued and evaluated on a dedicated thread; a batch is started when it reaches
+    // the maximum batch size or when the oldest request has waited for the maximum latency.
+    //
+    class BatchingEvaluatorWrapper : boost::noncopyable
+    {
+    public:
+        BatchingEvaluatorWrapper(FunctionPtr model, DeviceDescriptor device, const CNTK_BatchingOptions& options,
+                                 std::shared_ptr<SharedParameters> sharedParameters = nullptr);
+        ~BatchingEvaluatorWrapper();
+
+        void Evaluate(
+            const CNTK_Variable* inputs,
+            const CNTK_Value* inputValues,
+            uint32_t numInputs,
+            const CNTK_Variable* outputs,
+            uint32_t numOutputs,
+            CNTK_Value** outputValues);
+
+        void GetStatistics(bool reset, CNTK_BatchingStatistics* statistics);
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        struct Request
+        {
+            std::vector<const float*> m_inputs;  // One sample per argument, in the order of m_argumentList
+            std::vector<Variable> m_outputs;
+            std::vector<float*> m_outputBuffers; // One sample per output
+            Clock::time_point m_submitted;
+            std::shared_ptr<std::promise<void>> m_done; // Shared with the evaluator thread that may outlive the request
+        };
+
+        // Latencies of the most recent requests, in microseconds.
+        class LatencyWindow
+        {
+        public:
+            void Add(double latency);
+            CNTK_LatencyPercentiles Percentiles() const;
+            void Clear();
+
+        private:
+            std::vector<double> m_latencies;
+            size_t m_next = 0;
+        };
+
+        void Run();
+        void EvaluateBatch(const std::vector<Request*>& batch);
+
+        std::shared_ptr<SharedParameters> m_sharedParameters;
+        FunctionPtr m_func;
+        DeviceDescriptor m_device;
+        const size_t m_maxBatchSize;
+        const std::chrono::microseconds m_maxLatency;
+
+        std::vector<Variable> m_argumentList;
+        std::unordered_map<std::string, size_t> m_arguments;
+        std::unordered_map<std::string, Variable> m_outputs;
+
+        std::mutex m_mutex;
+        std::condition_variable m_requestAvailable;
+        std::deque<Request*> m_queue;
+        bool m_stopping;
+
+        std::mutex m_statisticsMutex;
+        uint64_t m_numRequests;
+        uint64_t m_numBatches;
+        LatencyWindow m_queueLatency;
+        LatencyWindow m_computeLatency;
+
+        std::thread m_worker;
+    };
 }
 
 //#pragma warning(pop)
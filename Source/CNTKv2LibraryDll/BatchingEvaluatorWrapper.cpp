@@ -0,0 +1,297 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "stdafx.h"
+#include "EvaluatorWrapper.h"
+
+namespace CNTK
+{
+    using namespace std;
+    using namespace std::placeholders;
+
+    // Number of most recent requests the latency percentiles are computed on.
+    static const size_t LatencyWindowSize = 10000;
+
+    void BatchingEvaluatorWrapper::LatencyWindow::Add(double latency)
+    {
+        if (m_latencies.size() < LatencyWindowSize)
+            m_latencies.push_back(latency);
+        else
+            m_latencies[m_next] = latency;
+        m_next = (m_next + 1) % LatencyWindowSize;
+    }
+
+    CNTK_LatencyPercentiles BatchingEvaluatorWrapper::LatencyWindow::Percentiles() const
+    {
+        CNTK_LatencyPercentiles result{ 0, 0, 0, 0 };
+        if (m_latencies.empty())
+            return result;
+
+        auto sorted = m_latencies;
+        sort(sorted.begin(), sorted.end());
+        auto percentile = [&sorted](size_t p) { return sorted[(sorted.size() - 1) * p / 100]; };
+        result.p50 = percentile(50);
+        result.p90 = percentile(90);
+        result.p99 = percentile(99);
+        result.max = sorted.back();
+        return result;
+    }
+
+    void BatchingEvaluatorWrapper::LatencyWindow::Clear()
+    {
+        m_latencies.clear();
+        m_next = 0;
+    }
+
+    BatchingEvaluatorWrapper::BatchingEvaluatorWrapper(FunctionPtr model, DeviceDescriptor device, const CNTK_BatchingOptions& options,
+                                                       shared_ptr<SharedParameters> sharedParameters)
+        : m_sharedParameters(sharedParameters), m_func(model), m_device(device),
+          m_maxBatchSize(options.maxBatchSize),
+          m_maxLatency(options.maxLatencyMicroseconds),
+          m_stopping(false),
+          m_numRequests(0),
+          m_numBatches(0)
+    {
+        if (m_maxBatchSize == 0)
+            InvalidArgument("Maximum batch size of the batching evaluator must be positive.");
+
+        m_argumentList = m_func->Arguments();
+        for (size_t i = 0; i < m_argumentList.size(); ++i)
+        {
+            const auto& arg = m_argumentList[i];
+            if (arg.DynamicAxes().empty())
+                InvalidArgument("Argument '%S' of the batching evaluator has no batch axis.", arg.Name().c_str());
+            if (arg.Shape().HasUnboundDimension())
+                InvalidArgument("Argument '%S' of the batching evaluator has an unknown shape.", arg.Name().c_str());
+            m_arguments.insert(make_pair(WStringToString(arg.Name()), i));
+        }
+
+        for (const auto& output : m_func->Outputs())
+            m_outputs.insert(make_pair(WStringToString(output.Name()), output));
+
+        m_worker = thread(&BatchingEvaluatorWrapper::Run, this);
+    }
+
+    BatchingEvaluatorWrapper::~BatchingEvaluatorWrapper()
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_requestAvailable.notify_one();
+        m_worker.join();
+    }
+
+    void BatchingEvaluatorWrapper::Evaluate(
+        const CNTK_Variable* inputs,
+        const CNTK_Value* inputValues,
+        uint32_t numInputs,
+        const CNTK_Variable* outputs,
+        uint32_t numOutputs,
+        CNTK_Value** outputValues)
+    {
+        Request request;
+
+        // Prepare inputs, the caller is blocked till the batch is evaluated so the data is not copied.
+        request.m_inputs.resize(m_argumentList.size(), nullptr);
+        for (uint32_t i = 0; i < numInputs; ++i)
+        {
+            auto arg = m_arguments.find(inputs[i].name);
+            if (arg == m_arguments.end())
+                InvalidArgument("Unexpected argument.");
+
+            const auto& var = m_argumentList[arg->second];
+            if (ToNDShape(inputValues[i].shape).TotalSize() != var.Shape().TotalSize())
+                InvalidArgument("The value of argument '%s' must contain exactly one sample of shape '%S'.",
+                    inputs[i].name, var.Shape().AsString().c_str());
+
+            request.m_inputs[arg->second] = inputValues[i].data;
+        }
+
+        for (size_t i = 0; i < m_argumentList.size(); ++i)
+            if (request.m_inputs[i] == nullptr)
+                InvalidArgument("No value given for argument '%S'.", m_argumentList[i].Name().c_str());
+
+        // Prepare outputs, each of them receives one sample of the batch.
+        auto arrayValueCleaner = std::bind(CleanAndDestroyValues, _1, numOutputs);
+        unique_ptr<CNTK_Value, decltype(arrayValueCleaner)> result(nullptr, arrayValueCleaner);
+        if (*outputValues == nullptr)
+        {
+            result.reset(new CNTK_Value[numOutputs]);
+            memset(result.get(), 0, sizeof(CNTK_Value) * numOutputs);
+        }
+
+        for (uint32_t i = 0; i < numOutputs; ++i)
+        {
+            auto var = m_outputs.find(outputs[i].name);
+            if (var == m_outputs.end())
+                InvalidArgument("Unexpected output.");
+
+            auto sampleSize = var->second.Shape().TotalSize();
+            if (result)
+            {
+                // The shape of a single sample as returned by CNTK_EvaluateSequence, with all dynamic axes of size 1.
+                auto& v = result.get()[i];
+                v.shape = FromNDShape(var->second.Shape().AppendShape(NDShape(var->second.DynamicAxes().size(), 1)));
+                v.data = new float[sampleSize];
+                request.m_outputBuffers.push_back(v.data);
+            }
+            else // Buffer has been preallocated.
+            {
+                auto& buffer = (*outputValues)[i];
+                if (ToNDShape(buffer.shape).TotalSize() != sampleSize)
+                    InvalidArgument("The buffer of output '%s' must be of the size of one sample of shape '%S'.",
+                        outputs[i].name, var->second.Shape().AsString().c_str());
+                request.m_outputBuffers.push_back(buffer.data);
+            }
+            request.m_outputs.push_back(var->second);
+        }
+
+        request.m_done = make_shared<promise<void>>();
+        auto done = request.m_done->get_future();
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (m_stopping)
+                RuntimeError("The batching evaluator is being released.");
+
+            request.m_submitted = Clock::now();
+            m_queue.push_back(&request);
+        }
+        m_requestAvailable.notify_one();
+
+        done.get(); // rethrows errors of the evaluation
+
+        if (result)
+            *outputValues = result.release();
+    }
+
+    void BatchingEvaluatorWrapper::Run()
+    {
+        for (;;)
+        {
+            vector<Request*> batch;
+            {
+                unique_lock<mutex> lock(m_mutex);
+                m_requestAvailable.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+                if (m_queue.empty())
+                    return; // Stopping, and all requests have been served.
+
+                // Give the concurrent callers the chance to join the batch of the oldest request.
+                auto deadline = m_queue.front()->m_submitted + m_maxLatency;
+                m_requestAvailable.wait_until(lock, deadline, [this] { return m_stopping || m_queue.size() >= m_maxBatchSize; });
+
+                auto batchSize = min(m_queue.size(), m_maxBatchSize);
+                batch.assign(m_queue.begin(), m_queue.begin() + batchSize);
+                m_queue.erase(m_queue.begin(), m_queue.begin() + batchSize);
+            }
+
+            EvaluateBatch(batch);
+        }
+    }
+
+    void BatchingEvaluatorWrapper::EvaluateBatch(const vector<Request*>& batch)
+    {
+        // The requests live on the stacks of their callers, they must not be touched once their promises are fulfilled.
+        vector<shared_ptr<promise<void>>> done;
+        for (auto request : batch)
+            done.push_back(request->m_done);
+
+        auto started = Clock::now();
+        try
+        {
+            // Gather the samples of all requests into one minibatch per argument.
+            unordered_map<Variable, ValuePtr> preparedInputs;
+            for (size_t i = 0; i < m_argumentList.size(); ++i)
+            {
+                const auto& arg = m_argumentList[i];
+                auto sampleSize = arg.Shape().TotalSize();
+
+                vector<float> data;
+                data.reserve(sampleSize * batch.size());
+                for (auto request : batch)
+                    data.insert(data.end(), request->m_inputs[i], request->m_inputs[i] + sampleSize);
+
+                preparedInputs[arg] = Value::CreateBatch(arg.Shape(), data, m_device, /*readOnly =*/ true);
+            }
+
+            // Evaluate the union of the outputs the requests asked for.
+            unordered_map<Variable, ValuePtr> preparedOutputs;
+            for (auto request : batch)
+                for (const auto& output : request->m_outputs)
+                    preparedOutputs[output] = nullptr;
+
+            m_func->Evaluate(preparedInputs, preparedOutputs, m_device);
+
+            // Scatter the samples back to the requests.
+            unordered_map<Variable, NDArrayViewPtr> results;
+            for (const auto& output : preparedOutputs)
+            {
+                auto data = output.second->Data();
+                if (data->Shape().TotalSize() != output.first.Shape().TotalSize() * batch.size())
+                    RuntimeError("Output '%S' does not produce one sample per request.", output.first.Name().c_str());
+
+                if (data->Device().Type() == DeviceKind::GPU)
+                {
+                    data = std::make_shared<NDArrayView>(DataType::Float, data->Shape(), DeviceDescriptor::CPUDevice());
+                    data->CopyFrom(*(output.second->Data()));
+                }
+                results[output.first] = data;
+            }
+
+            for (size_t r = 0; r < batch.size(); ++r)
+            {
+                auto request = batch[r];
+                for (size_t i = 0; i < request->m_outputs.size(); ++i)
+                {
+                    auto sampleSize = request->m_outputs[i].Shape().TotalSize();
+                    auto sample = results[request->m_outputs[i]]->DataBuffer<float>() + r * sampleSize;
+                    std::copy(sample, sample + sampleSize, request->m_outputBuffers[i]);
+                }
+            }
+        }
+        catch (...)
+        {
+            for (auto& d : done)
+                d->set_exception(current_exception());
+            return;
+        }
+
+        auto finished = Clock::now();
+        {
+            lock_guard<mutex> lock(m_statisticsMutex);
+            m_numRequests += batch.size();
+            m_numBatches++;
+
+            auto computeLatency = chrono::duration<double, micro>(finished - started).count();
+            for (auto request : batch)
+            {
+                m_queueLatency.Add(chrono::duration<double, micro>(started - request->m_submitted).count());
+                m_computeLatency.Add(computeLatency);
+            }
+        }
+
+        for (auto& d : done)
+            d->set_value();
+    }
+
+    void BatchingEvaluatorWrapper::GetStatistics(bool reset, CNTK_BatchingStatistics* statistics)
+    {
+        lock_guard<mutex> lock(m_statisticsMutex);
+        statistics->numRequests = m_numRequests;
+        statistics->numBatches = m_numBatches;
+        statistics->queueLatency = m_queueLatency.Percentiles();
+        statistics->computeLatency = m_computeLatency.Percentiles();
+
+        if (reset)
+        {
+            m_numRequests = 0;
+            m_numBatches = 0;
+            m_queueLatency.Clear();
+            m_computeLatency.Clear();
+        }
+    }
+}
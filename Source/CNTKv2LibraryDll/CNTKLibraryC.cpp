@@ -120,6 +120,17 @@ void CNTK_ReleaseModel(CNTK_ModelHandle model)
     delete (EvaluatorWrapper*)model;
 }
 
+CNTK_StatusCode CNTK_GetModelMemoryUsage(CNTK_ModelHandle model, CNTK_ModelMemoryUsage* usage)
+{
+    if (model == CNTK_INVALID_MODEL_HANDLE)
+        return StatusCode(CNTK_INVALID_MODEL_HANDLE, "Invalid model handle");
+
+    if (!usage)
+        return StatusCode(CNTK_ERROR_NULL_POINTER, "'usage' parameter is not allowed to be null");
+
+    return ExceptionCatcher::Call([&]() { ((EvaluatorWrapper*)model)->GetMemoryUsage(usage); });
+}
+
 CNTK_StatusCode CNTK_GetModelArgumentsInfo(CNTK_ModelHandle model, CNTK_Variable** inputs, uint32_t* numInputs)
 {
     if (model == CNTK_INVALID_MODEL_HANDLE)
@@ -171,6 +182,59 @@ CNTK_StatusCode CNTK_EvaluateSequence(CNTK_ModelHandle model,
     });
 }
 
+CNTK_StatusCode CNTK_CreateBatchingEvaluator(CNTK_ModelHandle model, const CNTK_BatchingOptions* options, CNTK_BatchingEvaluatorHandle* evaluator)
+{
+    if (model == CNTK_INVALID_MODEL_HANDLE)
+        return StatusCode(CNTK_INVALID_MODEL_HANDLE, "Invalid model handle");
+
+    if (!options)
+        return StatusCode(CNTK_ERROR_NULL_POINTER, "'options' parameter is not allowed to be null");
+
+    if (!evaluator)
+        return StatusCode(CNTK_ERROR_NULL_POINTER, "'evaluator' parameter is not allowed to be null");
+
+    *evaluator = nullptr;
+    return ExceptionCatcher::Call([&]() { *evaluator = ((EvaluatorWrapper*)model)->CreateBatchingEvaluator(*options).release(); });
+}
+
+CNTK_StatusCode CNTK_EvaluateBatched(CNTK_BatchingEvaluatorHandle evaluator,
+    const CNTK_Variable* inputs,
+    const CNTK_Value* inputValues,
+    uint32_t numInputs,
+    const CNTK_Variable* outputs,
+    uint32_t numOutputs,
+    CNTK_Value** outputValues)
+{
+    if (evaluator == nullptr)
+        return StatusCode(CNTK_ERROR_INVALID_HANDLE, "Invalid evaluator handle");
+
+    if (!outputValues)
+        return StatusCode(CNTK_ERROR_NULL_POINTER, "'outputValues' parameter is not allowed to be null");
+
+    return ExceptionCatcher::Call(
+    [&]()
+    {
+        ((BatchingEvaluatorWrapper*)evaluator)->Evaluate(
+            inputs, inputValues, numInputs, outputs, numOutputs, outputValues);
+    });
+}
+
+CNTK_StatusCode CNTK_GetBatchingStatistics(CNTK_BatchingEvaluatorHandle evaluator, bool reset, CNTK_BatchingStatistics* statistics)
+{
+    if (evaluator == nullptr)
+        return StatusCode(CNTK_ERROR_INVALID_HANDLE, "Invalid evaluator handle");
+
+    if (!statistics)
+        return StatusCode(CNTK_ERROR_NULL_POINTER, "'statistics' parameter is not allowed to be null");
+
+    return ExceptionCatcher::Call([&]() { ((BatchingEvaluatorWrapper*)evaluator)->GetStatistics(reset, statistics); });
+}
+
+void CNTK_ReleaseBatchingEvaluator(CNTK_BatchingEvaluatorHandle evaluator)
+{
+    delete (BatchingEvaluatorWrapper*)evaluator;
+}
+
 void CNTK_ReleaseArray(void* array)
 {
     // No destructor will be called!
@@ -171,6 +171,26 @@ namespace CNTK
             Microsoft::MSR::CNTK::Globals::SetGradientAccumulationOptimization(/* enable = */ false);
         }
 
+        void EnableParallelNodeEvaluation()
+        {
+            Microsoft::MSR::CNTK::Globals::SetParallelNodeEvaluation(/* enable = */ true);
+        }
+
+        void DisableParallelNodeEvaluation()
+        {
+            Microsoft::MSR::CNTK::Globals::SetParallelNodeEvaluation(/* enable = */ false);
+        }
+
+        void EnableSmallFilterConvolution()
+        {
+            Microsoft::MSR::CNTK::Globals::SetSmallFilterConvolution(/* enable = */ true);
+        }
+
+        void DisableSmallFilterConvolution()
+        {
+            Microsoft::MSR::CNTK::Globals::SetSmallFilterConvolution(/* enable = */ false);
+        }
+
         void StartProfiler(const wstring& profilerDir, bool profilerSyncGpu, size_t profilerBufferSize)
         {
 #ifndef CNTK_UWP
@@ -245,6 +265,11 @@ namespace CNTK
             return Microsoft::MSR::CNTK::Globals::GetMPIPackThreshold();
         }
 
+        void EnableConcurrentMPICalls()
+        {
+            Microsoft::MSR::CNTK::Globals::SetConcurrentMPICalls(true);
+        }
+
         bool AreEquivalent(const Variable& var1, const Variable& var2, bool allowParameterAndConstantsEquivalence)
         {
             bool areDynamicAxesCompatible = (var1.DynamicAxes().size() == var2.DynamicAxes().size());
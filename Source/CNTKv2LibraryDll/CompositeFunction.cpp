@@ -45,6 +45,10 @@ namespace CNTK
         if (!Name().empty())
             dict[nameKey] = Name();
         dict[uidKey] = Uid();
+        if (m_maxBatchSizeForMemoryPlan > 0)
+            dict[maxBatchSizeForMemoryPlanKey] = m_maxBatchSizeForMemoryPlan;
+        if (m_fuseTimesPlusActivation)
+            dict[fuseTimesPlusActivationKey] = m_fuseTimesPlusActivation;
 
         return dict;
     }
@@ -223,6 +227,11 @@ namespace CNTK
 
         } while (placeholderReplacements.size() > 0);
 
+        if (dict.Contains(maxBatchSizeForMemoryPlanKey))
+            std::static_pointer_cast<CompositeFunction>(composite)->m_maxBatchSizeForMemoryPlan = dict[maxBatchSizeForMemoryPlanKey].Value<size_t>();
+        if (dict.Contains(fuseTimesPlusActivationKey))
+            std::static_pointer_cast<CompositeFunction>(composite)->m_fuseTimesPlusActivation = dict[fuseTimesPlusActivationKey].Value<bool>();
+
         return composite;
     }
 
@@ -1776,6 +1785,29 @@ namespace CNTK
 
             std::tie(m_computationNetwork, m_variableToNodeMap) = CreateComputationNetwork<ElementType>(this->shared_from_this(), device, outputs, m_fullyDefinedArgumentsMap, m_inputsExcludedFromGradientComputation, /*useMangledNamesForComputationNodes =*/ false);
 
+            // The fused nodes have no gradient, hence the network is only fused when it is compiled for evaluation. The Variables
+            // of the merged Times and Plus nodes are not among the outputs, which are kept by the pass, and are no longer computed.
+            if (m_fuseTimesPlusActivation && m_currentBackpropRoots.empty())
+            {
+                auto replacedNodes = m_computationNetwork->FuseTimesPlusActivation<ElementType>();
+                if (!replacedNodes.empty())
+                {
+                    for (auto varNodeIter = m_variableToNodeMap.begin(); varNodeIter != m_variableToNodeMap.end();)
+                    {
+                        auto replacedNodeIter = replacedNodes.find(varNodeIter->second);
+                        if (replacedNodeIter == replacedNodes.end())
+                            ++varNodeIter;
+                        else if (replacedNodeIter->second)
+                            (varNodeIter++)->second = replacedNodeIter->second;
+                        else
+                            varNodeIter = m_variableToNodeMap.erase(varNodeIter);
+                    }
+
+                    m_computationNetwork->CompileNetwork();
+                    m_computationNetwork->SetEvalTimeStampsOutdatedWithRegardToAll();
+                }
+            }
+
             // Record the timestamps of Parameters and Constants
             assert(m_lastRecordedTimeStamps.empty());
             auto functionParameters = Parameters();
@@ -1813,6 +1845,9 @@ namespace CNTK
             for (auto output : outputs)
                 forwardOutputNodes.push_back(m_variableToNodeMap.at(output));
 
+            if ((m_maxBatchSizeForMemoryPlan > 0) && !backpropRootNode)
+                m_computationNetwork->SetPreallocationMinibatchSize(m_maxBatchSizeForMemoryPlan);
+
             m_computationNetwork->AllocateAllMatrices(forwardRootNodes, forwardOutputNodes, backpropRootNode);
             m_networkMatricesAllocated = allocateNetworkMatrices;
         }
@@ -2118,6 +2153,55 @@ namespace CNTK
         return currentBackpropRootsTimeStamps;
     }
 
+    bool CompositeFunction::CompileForEvaluation(const std::unordered_set<Variable>& outputs, const DeviceDescriptor& device)
+    {
+        if (outputs.empty())
+            InvalidArgument("At least one output has to be specified when compiling the Function '%S'.", this->AsString().c_str());
+
+        // Same choice of the ElementType as in Forward: the one of the arguments the outputs depend on, all of which must
+        // agree, or else the one of the outputs. If that cannot be decided here, the network is built by the first Forward.
+        std::unordered_set<Variable> requiredArguments;
+        for (const auto& output : outputs)
+        {
+            auto& requiredArgumentsForCurrentOutput = GetArgumentDependencies(output);
+            requiredArguments.insert(requiredArgumentsForCurrentOutput.begin(), requiredArgumentsForCurrentOutput.end());
+        }
+
+        auto dataType = DataType::Unknown;
+        for (const auto& argument : requiredArguments)
+        {
+            if (argument.Shape().HasUnboundDimension() || argument.GetDataType() == DataType::Unknown)
+                return false;
+
+            if (dataType == DataType::Unknown)
+                dataType = argument.GetDataType();
+            else if (dataType != argument.GetDataType())
+                LogicError("Function '%S' CompileForEvaluation: The DataType of all arguments must be same.", this->AsString().c_str());
+        }
+
+        if (dataType == DataType::Unknown)
+        {
+            for (const auto& output : outputs)
+            {
+                if (dataType == DataType::Unknown)
+                    dataType = output.GetDataType();
+                else if (dataType != output.GetDataType())
+                    return false;
+            }
+        }
+
+        if (dataType == DataType::Float)
+            GetComputationNetwork<float>(device, {}, outputs, {}, true);
+        else if (dataType == DataType::Double)
+            GetComputationNetwork<double>(device, {}, outputs, {}, true);
+        else if (dataType == DataType::Float16)
+            GetComputationNetwork<half>(device, {}, outputs, {}, true);
+        else
+            InvalidArgument("Unsupported DataType %s", DataTypeName(dataType));
+
+        return true;
+    }
+
     /*virtual*/ BackPropStatePtr CompositeFunction::Forward(const std::unordered_map<Variable, ValuePtr>& arguments,
                                                             std::unordered_map<Variable, ValuePtr>& outputs,
                                                             const DeviceDescriptor& computeDevice,
@@ -126,6 +126,20 @@ namespace CNTK
             return CompositeFunctionOpName;
         }
 
+        // Maximum number of samples per minibatch to allocate the memory of the computation network for upfront, when compiled
+        // for evaluation only; 0 if the memory is allocated on demand. Preserved when cloning or saving the Function.
+        size_t MaxBatchSizeForMemoryPlan() const { return m_maxBatchSizeForMemoryPlan; }
+        void SetMaxBatchSizeForMemoryPlan(size_t maxBatchSize) { m_maxBatchSizeForMemoryPlan = maxBatchSize; }
+
+        // Whether the dense layers Times -> Plus -> ReLU/Sigmoid/Tanh are computed by single fused nodes when the computation network is
+        // compiled for evaluation only, see ComputationNetwork::FuseTimesPlusActivation(). Preserved when cloning or saving the Function.
+        bool ShouldFuseTimesPlusActivation() const { return m_fuseTimesPlusActivation; }
+        void SetFuseTimesPlusActivation(bool fuse) { m_fuseTimesPlusActivation = fuse; }
+
+        // Compiles the computation network for evaluating the specified outputs ahead of the first Forward call.
+        // Returns false if the network can only be compiled once the shapes and types of the arguments are known.
+        bool CompileForEvaluation(const std::unordered_set<Variable>& outputs, const DeviceDescriptor& device);
+
         void PrintNodeTiming() override
         {
             if (m_computationNetwork)
@@ -222,7 +236,7 @@ namespace CNTK
 
         CompositeFunction(const FunctionPtr& rootFunction, std::unordered_set<FunctionPtr>&& allPrimitiveFunctions, const std::wstring& name, const std::wstring& uid = Internal::GenerateUid(L"CompositeFunction"))
             : Function({}, Dictionary(), rootFunction, name, uid),
-            m_allPrimitiveFunctions(std::move(allPrimitiveFunctions)), m_networkMatricesAllocated(false)
+            m_allPrimitiveFunctions(std::move(allPrimitiveFunctions)), m_networkMatricesAllocated(false), m_maxBatchSizeForMemoryPlan(0), m_fuseTimesPlusActivation(false)
         {}
 
         std::vector<Variable> DetermineInputs(bool pythonOperandOrder = false) const
@@ -406,6 +420,10 @@ namespace CNTK
 
         bool m_networkMatricesAllocated;
 
+        size_t m_maxBatchSizeForMemoryPlan;
+
+        bool m_fuseTimesPlusActivation;
+
         std::unordered_set<Variable> m_allNetworkRoots;
 
         std::unordered_map<Variable, size_t> m_lastRecordedTimeStamps;
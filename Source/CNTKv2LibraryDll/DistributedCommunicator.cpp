@@ -34,6 +34,11 @@ namespace CNTK
         return std::make_shared<MPICommunicatorImpl>(packThresholdSizeInBytes);
     }
 
+    DistributedCommunicatorPtr CompressedMPICommunicator(MPICommunicatorCompression compression, size_t packThresholdSizeInBytes)
+    {
+        return std::make_shared<MPICommunicatorImpl>(packThresholdSizeInBytes, compression);
+    }
+
     void DistributedCommunicator::Finalize()
     {
         auto mpi = MPIWrapper::GetInstance(false);
@@ -71,13 +76,24 @@ namespace CNTK
         return nullptr; // Make compiler happy.
     }
 
-    MPICommunicatorImpl::MPICommunicatorImpl(size_t packThresholdSizeInBytes)
+    static MPIWrapperPtr GetOrCreateMPIWrapper()
     {
-        m_mpi = MPIWrapper::GetInstance();
-        if (m_mpi == nullptr)
+        auto mpi = MPIWrapper::GetInstance();
+        if (mpi == nullptr)
         {
-            m_mpi = MPIWrapper::GetInstance(true /*create*/);
+            mpi = MPIWrapper::GetInstance(true /*create*/);
         }
+        return mpi;
+    }
+
+    MPICommunicatorImpl::MPICommunicatorImpl(size_t packThresholdSizeInBytes, MPICommunicatorCompression compression)
+        : MPICommunicatorImpl(GetOrCreateMPIWrapper(), packThresholdSizeInBytes, compression)
+    {
+    }
+
+    MPICommunicatorImpl::MPICommunicatorImpl(const MPIWrapperPtr& mpi, size_t packThresholdSizeInBytes, MPICommunicatorCompression compression)
+        : m_compression(compression), m_mpi(mpi)
+    {
         m_currentWorker.m_globalRank = m_mpi->CurrentNodeRank();
         m_currentWorker.m_hostId = std::wstring(m_mpi->CurrentNodeName());
         for (size_t i = 0; i < m_mpi->NumNodesInUse(); ++i)
@@ -179,9 +195,29 @@ namespace CNTK
         AggregateImpl(values, outputValues, sendToWorkers);
     }
 
-    DistributedCommunicatorPtr MPICommunicatorImpl::SubGroup(const std::unordered_set<DistributedWorkerDescriptor>&) const
+    MPIWrapperPtr MPICommunicatorImpl::CreateSubGroupMPI(const std::unordered_set<DistributedWorkerDescriptor>& subGroupWorkers) const
     {
-        NOT_IMPLEMENTED;
+        std::vector<size_t> ranks;
+        for (const auto& worker : subGroupWorkers)
+        {
+            if (worker.m_globalRank >= m_workers.size())
+                InvalidArgument("MPICommunicator: worker %d of the sub-group is not part of this communicator.", (int)worker.m_globalRank);
+            ranks.push_back(worker.m_globalRank);
+        }
+
+        if (ranks.empty())
+            InvalidArgument("MPICommunicator: the sub-group must have at least one worker.");
+
+        return m_mpi->CreateSubGroup(ranks);
+    }
+
+    DistributedCommunicatorPtr MPICommunicatorImpl::SubGroup(const std::unordered_set<DistributedWorkerDescriptor>& subGroupWorkers) const
+    {
+        auto mpi = CreateSubGroupMPI(subGroupWorkers);
+        if (mpi == nullptr)
+            return nullptr;
+
+        return std::make_shared<MPICommunicatorImpl>(mpi, m_packThresholdSizeInBytes, m_compression);
     }
 
     void MPICommunicatorImpl::Concatenate(const std::vector<ValuePtr>&, std::vector<ValuePtr>&, const std::unordered_set<DistributedWorkerDescriptor>&)
@@ -282,6 +318,37 @@ namespace CNTK
         m_mpi->WaitAll(allReduceRequests);
     }
 
+    void MPICommunicatorImpl::Broadcast(const std::vector<NDArrayViewPtr>& values, size_t rootRank)
+    {
+        for (const auto& value : values)
+        {
+            if (value->GetStorageFormat() != StorageFormat::Dense)
+                RuntimeError("MPICommunicator: Broadcast of sparse values is currently not supported.");
+
+            // Values are exchanged through CPU memory.
+            auto cpuValue = value->Device().Type() == DeviceKind::CPU ? value : value->DeepClone(DeviceDescriptor::CPUDevice());
+            Broadcast(static_cast<char*>(GetDataBuffer(cpuValue)), GetBufferSize(cpuValue), rootRank);
+            if (cpuValue != value)
+                value->CopyFrom(*cpuValue);
+        }
+    }
+
+    void MPICommunicatorImpl::Broadcast(std::string& data, size_t rootRank)
+    {
+        size_t size = data.size();
+        m_mpi->Bcast(&size, 1, rootRank);
+        data.resize(size);
+        Broadcast(&data[0], size, rootRank);
+    }
+
+    void MPICommunicatorImpl::Broadcast(char* data, size_t size, size_t rootRank)
+    {
+        // MPI counts are ints.
+        const size_t maxChunkSize = std::numeric_limits<int>::max();
+        for (size_t offset = 0; offset < size; offset += maxChunkSize)
+            m_mpi->Bcast(data + offset, (int)std::min(maxChunkSize, size - offset), MPI_CHAR, (int)rootRank);
+    }
+
     void MPICommunicatorImpl::AggregateInPlace(
         const std::vector<NDArrayViewPtr>& values,
         const std::unordered_set<DistributedWorkerDescriptor>& sendToWorkers)
@@ -367,6 +434,9 @@ namespace CNTK
         CopyDataFromGPUToCPU(valuesToAggregate);
 
         std::vector<MPI_Request> allReduceRequests;
+        auto compress = SelectValuesToCompress(valuesToAggregate);
+        m_compressedBuffers.resize(numValues);
+        m_compressedOutputs.assign(numValues, nullptr);
         for (auto i = 0; i < numValues; ++i)
         {
             auto inputValue = valuesToAggregate[i];
@@ -389,7 +459,11 @@ namespace CNTK
             void* inputData = (ShouldCopyDataToCPU(inputValue)) ? m_intermediateCPUBuffers[i].data.get() : GetDataBuffer(inputValue);
             void* outputData = (ShouldCopyDataToCPU(inputValue)) ? m_intermediateCPUBuffers[i].data.get() : GetDataBuffer(outputValue);
 
-            if (dataType == DataType::Float)
+            if (compress[i])
+            {
+                AllReduceDataCompressed(i, static_cast<float*>(inputData), static_cast<float*>(outputData), numElements, &allReduceRequests);
+            }
+            else if (dataType == DataType::Float)
             {
                 AllReduceData(static_cast<float*>(inputData), static_cast<float*>(outputData), numElements,
                     &allReduceRequests, (inputValue->Device() == DeviceDescriptor::CPUDevice()));
@@ -430,6 +504,9 @@ namespace CNTK
             assert(idx < valuesToAggregate.size());
             auto value = valuesToAggregate[idx];
 
+            if (m_compressedOutputs[idx] != nullptr)
+                DecompressAggregate(idx);
+
             if (ShouldCopyDataToCPU(value))
             {
                 auto view = valuesAfterAggregate[idx];
@@ -737,7 +814,85 @@ namespace CNTK
             return;
         }
 
-        //half aggregation other than NCCL is not supported
-        NOT_IMPLEMENTED;
+        // The reduction operator runs on the host, so with GPUDirect RDMA there is no way to sum values in GPU memory.
+        if ((m_mpi->UseGpuGdr() && !dataOnCPU) || op != MPI_SUM)
+            NOT_IMPLEMENTED;
+
+        if (inputData != outputData)
+            memcpy(outputData, inputData, numElements * sizeof(half));
+
+        if (forceSync)
+        {
+            m_mpi->AllReduceFloat16(reinterpret_cast<unsigned short*>(outputData), numElements, /*isBFloat16=*/false);
+            return;
+        }
+
+        pAllReduceRequests->push_back(MPI_Request());
+        m_mpi->AllReduceFloat16Async(reinterpret_cast<unsigned short*>(outputData), numElements, /*isBFloat16=*/false, &(pAllReduceRequests->back()));
+    }
+
+    bool MPICommunicatorImpl::ShouldCompress(const NDArrayViewPtr& inputValue)
+    {
+        // Only values that are aggregated from CPU memory can be converted on the way.
+        if (m_compression == MPICommunicatorCompression::None)
+            return false;
+
+        return inputValue->Device() == DeviceDescriptor::CPUDevice() || ShouldCopyDataToCPU(inputValue);
+    }
+
+    std::vector<bool> MPICommunicatorImpl::SelectValuesToCompress(const std::vector<NDArrayViewPtr>& values)
+    {
+        std::vector<bool> compress(values.size(), false);
+        std::vector<float> maxAbsValues;
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            compress[i] = values[i]->GetDataType() == DataType::Float && ShouldCompress(values[i]);
+            if (compress[i] && m_compression == MPICommunicatorCompression::Float16)
+                maxAbsValues.push_back(GetMatrix<float>(values[i])->MatrixNormInf());
+        }
+
+        // bfloat16 has the range of fp32. The partial sums of fp16 values stay in range if the largest
+        // magnitude on any worker times the number of workers does; otherwise the value goes in fp32.
+        if (maxAbsValues.empty())
+            return compress;
+
+        m_mpi->AllReduce(maxAbsValues.data(), maxAbsValues.size(), MPI_MAX);
+
+        const float float16Max = 65504.0f;
+        const float numWorkers = (float)m_mpi->NumNodesInUse();
+        for (size_t i = 0, j = 0; i < values.size(); ++i)
+        {
+            if (!compress[i])
+                continue;
+            // also false for inf and NaN, which fp32 aggregation passes on unchanged
+            compress[i] = maxAbsValues[j++] * numWorkers <= float16Max;
+        }
+
+        return compress;
+    }
+
+    void MPICommunicatorImpl::AllReduceDataCompressed(size_t index, float* inputData, float* outputData, size_t numElements, std::vector<MPI_Request>* pAllReduceRequests)
+    {
+        const bool isBFloat16 = (m_compression == MPICommunicatorCompression::BFloat16);
+        auto& buffer = m_compressedBuffers[index];
+        buffer.resize(numElements);
+        if (isBFloat16)
+            floatToBFloat16(inputData, buffer.data(), numElements);
+        else
+            floatToFloat16(inputData, buffer.data(), numElements);
+
+        m_compressedOutputs[index] = outputData;
+        pAllReduceRequests->push_back(MPI_Request());
+        m_mpi->AllReduceFloat16Async(buffer.data(), numElements, isBFloat16, &(pAllReduceRequests->back()));
+    }
+
+    void MPICommunicatorImpl::DecompressAggregate(size_t index)
+    {
+        auto& buffer = m_compressedBuffers[index];
+        if (m_compression == MPICommunicatorCompression::BFloat16)
+            bfloat16ToFloat(buffer.data(), m_compressedOutputs[index], buffer.size());
+        else
+            float16ToFloat(buffer.data(), m_compressedOutputs[index], buffer.size());
+        m_compressedOutputs[index] = nullptr;
     }
 }
@@ -23,13 +23,17 @@ namespace CNTK
     class MPICommunicatorImpl : public DistributedCommunicator, public std::enable_shared_from_this<MPICommunicatorImpl>
     {
     public:
-        MPICommunicatorImpl(size_t packThresholdSizeInBytes = DEFAULT_PACK_THRESHOLD_SIZE_IN_BYTES);
+        MPICommunicatorImpl(size_t packThresholdSizeInBytes = DEFAULT_PACK_THRESHOLD_SIZE_IN_BYTES, MPICommunicatorCompression compression = MPICommunicatorCompression::None);
+
+        // Communicator over the nodes of the given MPI wrapper, e.g. one created for a sub-group.
+        MPICommunicatorImpl(const Microsoft::MSR::CNTK::MPIWrapperPtr& mpi, size_t packThresholdSizeInBytes, MPICommunicatorCompression compression);
 
         virtual const std::unordered_set<DistributedWorkerDescriptor>& Workers() const override;
 
         virtual const DistributedWorkerDescriptor& CurrentWorker() const override;
 
-        // Creates a new distributed communicator comprising of a subset of the workers in this communicator
+        // Creates a new distributed communicator comprising of a subset of the workers in this communicator.
+        // Must be called by all workers; the workers of the sub-group are renumbered in the order of their current rank.
         virtual DistributedCommunicatorPtr SubGroup(const std::unordered_set<DistributedWorkerDescriptor>& subGroupWorkers) const override;
 
         // A collective communication API to concatenate values across each worker of this communicator. The concatenated values are only sent to the specified workers; for all others the returned Values are null
@@ -63,11 +67,20 @@ namespace CNTK
 
         virtual void Barrier() override;
 
+        // True if this communicator may be used from one thread while another one communicates on a different communicator.
+        bool SupportsConcurrentUse() const { return m_mpi->SupportsConcurrentCalls(); }
+
+        // Copies the values (or bytes) of the 'rootRank' worker to all other workers, e.g. to bring workers that join training up to date.
+        void Broadcast(const std::vector<NDArrayViewPtr>& values, size_t rootRank);
+        void Broadcast(std::string& data, size_t rootRank);
+
         virtual ~MPICommunicatorImpl() {}
 
     private:
         void Initialize(const std::vector<NDArrayViewPtr>& values);
 
+        void Broadcast(char* data, size_t size, size_t rootRank);
+
         void AggregateImpl(
             const std::vector<NDArrayViewPtr>& inputValues,
             const std::vector<NDArrayViewPtr>& outputValues,
@@ -98,6 +111,12 @@ namespace CNTK
 
         std::vector<Buffer> m_intermediateSBCIndexCPUBuffers;
         std::vector<Buffer> m_intermediateSBCValueCPUBuffers;
+
+        // Wire format of float values, and the 16-bit copies being aggregated together with
+        // the buffers they are decompressed to when the aggregation completes.
+        MPICommunicatorCompression m_compression;
+        std::vector<std::vector<unsigned short>> m_compressedBuffers;
+        std::vector<float*> m_compressedOutputs;
     protected:
         DeviceDescriptor GetNonCPUDevice(const std::vector<NDArrayViewPtr>& values)
         {
@@ -124,6 +143,9 @@ namespace CNTK
 
         void CheckWorkers(const std::unordered_set<DistributedWorkerDescriptor>& sendToWorkers);
 
+        // Collective; returns the MPI wrapper of the sub-group, or null if the current worker is not part of it.
+        Microsoft::MSR::CNTK::MPIWrapperPtr CreateSubGroupMPI(const std::unordered_set<DistributedWorkerDescriptor>& subGroupWorkers) const;
+
         Microsoft::MSR::CNTK::MPIWrapperPtr m_mpi;
 
         bool ShouldCopyDataToCPU(NDArrayViewPtr inputValue);
@@ -145,5 +167,12 @@ namespace CNTK
         void AllReduceData(ElemType* inputData, ElemType* outputData, size_t numElements, std::vector<MPI_Request>* pAllReduceRequests, bool dataOnCPU, MPI_Op op = MPI_SUM, bool forceSync = false);
 
         void AllReduceDataHalf(half* inputData, half* outputData, size_t numElements, std::vector<MPI_Request>* pAllReduceRequests, bool dataOnCPU, MPI_Op op = MPI_SUM, bool forceSync = false);
+
+        bool ShouldCompress(const NDArrayViewPtr& inputValue);
+
+        // Collective; for each value, whether it is sent in 16 bits. Float16 values that could overflow on the way stay in fp32.
+        std::vector<bool> SelectValuesToCompress(const std::vector<NDArrayViewPtr>& values);
+        void AllReduceDataCompressed(size_t index, float* inputData, float* outputData, size_t numElements, std::vector<MPI_Request>* pAllReduceRequests);
+        void DecompressAggregate(size_t index);
     };
 }
@@ -0,0 +1,124 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#include "stdafx.h"
+#include "CNTKLibrary.h"
+#include "CompositeFunction.h"
+
+namespace CNTK
+{
+    EvaluationContextPoolPtr CreateEvaluationContextPool(const FunctionPtr& model, const DeviceDescriptor& device, size_t initialSize, const std::vector<Variable>& outputs)
+    {
+        return MakeSharedObject<EvaluationContextPool>(model, device, initialSize, outputs);
+    }
+
+    EvaluationContextPool::EvaluationContextPool(const FunctionPtr& model, const DeviceDescriptor& device, size_t initialSize, const std::vector<Variable>& outputs)
+        : m_model(model), m_device(device), m_numberOfContexts(0)
+    {
+        if (!m_model)
+            InvalidArgument("EvaluationContextPool: model must not be null.");
+
+        // The contexts have their own output Variables, so the outputs are identified by their position.
+        auto modelOutputs = m_model->Outputs();
+        for (const auto& output : outputs)
+        {
+            auto iter = std::find(modelOutputs.begin(), modelOutputs.end(), output);
+            if (iter == modelOutputs.end())
+                InvalidArgument("EvaluationContextPool: '%S' is not an output of the model '%S'.", output.AsString().c_str(), m_model->AsString().c_str());
+            m_outputIndices.push_back(iter - modelOutputs.begin());
+        }
+
+        if (m_outputIndices.empty())
+        {
+            for (size_t i = 0; i < modelOutputs.size(); ++i)
+                m_outputIndices.push_back(i);
+        }
+
+        for (size_t i = 0; i < initialSize; ++i)
+            m_availableContexts.push_back(CreateContext());
+        m_numberOfContexts = initialSize;
+    }
+
+    FunctionPtr EvaluationContextPool::CreateContext() const
+    {
+        auto context = m_model->Clone(ParameterCloningMethod::Share);
+
+        auto compositeContext = std::dynamic_pointer_cast<CompositeFunction>(context);
+        if (compositeContext)
+        {
+            auto contextOutputs = context->Outputs();
+            std::unordered_set<Variable> outputs;
+            for (auto index : m_outputIndices)
+                outputs.insert(contextOutputs[index]);
+
+            compositeContext->CompileForEvaluation(outputs, m_device);
+        }
+
+        return context;
+    }
+
+    FunctionPtr EvaluationContextPool::Acquire()
+    {
+        FunctionPtr context;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_availableContexts.empty())
+            {
+                context = m_availableContexts.back();
+                m_availableContexts.pop_back();
+            }
+            else
+                m_numberOfContexts++;
+        }
+
+        // Creating a context is expensive, so it is done outside of the lock.
+        if (!context)
+        {
+            try
+            {
+                context = CreateContext();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_numberOfContexts--;
+                throw;
+            }
+        }
+
+        // The context is handed out through a lease that puts it back into the pool once the caller releases it.
+        struct Lease
+        {
+            Lease(const EvaluationContextPoolPtr& pool, const FunctionPtr& context) : m_pool(pool), m_context(context) {}
+            ~Lease() { m_pool->Release(m_context); }
+
+            Lease(const Lease&) = delete; Lease& operator=(const Lease&) = delete;
+
+            EvaluationContextPoolPtr m_pool;
+            FunctionPtr m_context;
+        };
+
+        auto lease = std::make_shared<Lease>(shared_from_this(), context);
+        return FunctionPtr(lease, context.get());
+    }
+
+    void EvaluationContextPool::Release(const FunctionPtr& context)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_availableContexts.push_back(context);
+    }
+
+    size_t EvaluationContextPool::NumberOfContexts() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_numberOfContexts;
+    }
+
+    size_t EvaluationContextPool::NumberOfAvailableContexts() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_availableContexts.size();
+    }
+}
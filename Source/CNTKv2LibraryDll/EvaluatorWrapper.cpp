@@ -7,6 +7,7 @@
 
 #include "stdafx.h"
 #include "EvaluatorWrapper.h"
+#include "SharedParameterCache.h"
 
 namespace CNTK
 {
@@ -14,9 +15,11 @@ namespace CNTK
     using namespace std::placeholders;
 
     // Main interface
-    CNTKEvaluatorWrapper::CNTKEvaluatorWrapper(FunctionPtr model, DeviceDescriptor device)
-        : m_func(model), m_device(device)
+    CNTKEvaluatorWrapper::CNTKEvaluatorWrapper(FunctionPtr model, DeviceDescriptor device, bool shareParameters)
+        : m_sharedParameters(make_shared<SharedParameters>()), m_device(device)
     {
+        m_func = shareParameters ? m_sharedParameters->Share(model) : model;
+
         for (const auto arg : m_func->Arguments())
             m_arguments.insert(make_pair(WStringToString(arg.Name()), arg));
 
@@ -25,7 +28,7 @@ namespace CNTK
     }
 
     CNTKEvaluatorWrapper::CNTKEvaluatorWrapper(const char* modelFilePath, DeviceDescriptor device) :
-        CNTKEvaluatorWrapper(Function::Load(StringToWString(modelFilePath), device), device)
+        CNTKEvaluatorWrapper(Function::Load(StringToWString(modelFilePath), device), device, /*shareParameters =*/ true)
     {}
 
     CNTKEvaluatorWrapper::CNTKEvaluatorWrapper(const char* modelFilePath, const CNTK_DeviceDescriptor* device) :
@@ -46,6 +49,35 @@ namespace CNTK
         return GetVariableInfo(m_func->Outputs(), outputs, numOutputs);
     }
 
+    void CNTKEvaluatorWrapper::GetMemoryUsage(CNTK_ModelMemoryUsage* usage)
+    {
+        assert(usage != nullptr);
+        *usage = CNTK_ModelMemoryUsage{ 0, 0, 0, 0 };
+
+        auto& cache = SharedParameterCache::Instance();
+        unordered_set<const NDArrayView*> accounted;
+        auto account = [&](const NDArrayViewPtr& value)
+        {
+            if (!accounted.insert(value.get()).second)
+                return;
+
+            uint64_t bytes = value->Shape().TotalSize() * DataTypeSize(value->GetDataType());
+            auto numUsers = max<size_t>(cache.NumUsers(value.get()), 1);
+            usage->totalBytes += bytes;
+            if (numUsers > 1)
+                usage->sharedBytes += bytes;
+            else
+                usage->uniqueBytes += bytes;
+            usage->proportionalBytes += bytes / numUsers;
+        };
+
+        for (const auto& parameter : m_func->Parameters())
+            account(parameter.Value());
+
+        for (const auto& constant : m_func->Constants())
+            account(constant.Value());
+    }
+
     void CNTKEvaluatorWrapper::EvaluateSequence(
         const CNTK_Variable* inputs,
         const CNTK_Value* inputValues,
@@ -144,6 +176,15 @@ namespace CNTK
             cloned = m_func->CloneFlattened(ToNative(method));
         else
             cloned = m_func->Clone(ToNative(method));
-        return unique_ptr<EvaluatorWrapper>(new CNTKEvaluatorWrapper(cloned, m_device));
+
+        // Frozen clones deep copy the values; share them again. Cloned parameters are private to the clone.
+        bool shareParameters = (method != CNTK_ModelParameterClone);
+        return unique_ptr<EvaluatorWrapper>(new CNTKEvaluatorWrapper(cloned, m_device, shareParameters));
+    }
+
+    unique_ptr<BatchingEvaluatorWrapper> CNTKEvaluatorWrapper::CreateBatchingEvaluator(const CNTK_BatchingOptions& options)
+    {
+        // The evaluator thread must not share the network with the callers of this wrapper.
+        return unique_ptr<BatchingEvaluatorWrapper>(new BatchingEvaluatorWrapper(m_func->Clone(ParameterCloningMethod::Share), m_device, options, m_sharedParameters));
     }
 }
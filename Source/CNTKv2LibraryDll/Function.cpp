@@ -10,6 +10,7 @@
 #include "CompositeFunction.h"
 #include "BlockFunction.h"
 #include "Utils.h"
+#include "Serialization.h"
 #include "UserFunctionFactory.h"
 #include "TrainingNodes.h"
 #include "proto/onnx/ONNX.h"
@@ -500,6 +501,12 @@ namespace CNTK
             ONNXFormat::Save(RootFunction(), filepath);
             break;
         }
+
+        case ModelFormat::CNTKv2Mapped:
+        {
+            SaveMappedModel(Serialize(), filepath);
+            break;
+        }
         }
     }
 
@@ -509,6 +516,10 @@ namespace CNTK
         {
         case ModelFormat::CNTKv2:
         {
+            // The model file of a streaming trainer checkpoint.
+            if (IsStreamingCheckpoint(filepath))
+                return Function::Deserialize(LoadStreamingCheckpoint(filepath), computeDevice);
+
             auto stream = GetFstream(filepath, true);
             if (!Internal::IsLegacyModel(*stream))
             {
@@ -526,6 +537,10 @@ namespace CNTK
         case ModelFormat::ONNX:
             return ONNXFormat::Load(filepath, computeDevice);
             break;
+
+        case ModelFormat::CNTKv2Mapped:
+            return Function::Deserialize(LoadMappedModel(filepath), computeDevice);
+            break;
         }
 
         return nullptr;
@@ -565,6 +580,12 @@ namespace CNTK
 
     void Function::Restore(const std::wstring& filepath)
     {
+        if (IsStreamingCheckpoint(filepath))
+        {
+            RestoreFromCheckpoint(LoadStreamingCheckpoint(filepath));
+            return;
+        }
+
         auto stream = GetFstream(filepath, true);
         if (!Internal::IsLegacyModel(*stream))
         {
@@ -1035,6 +1056,8 @@ namespace CNTK
 
         auto clonedComposite = AsComposite(clonedRootFunction, compositeFunction->Name());
         clonedComposite->ReplacePlaceholders(placeholderReplacements);
+        std::static_pointer_cast<CompositeFunction>(clonedComposite)->SetMaxBatchSizeForMemoryPlan(compositeFunction->MaxBatchSizeForMemoryPlan());
+        std::static_pointer_cast<CompositeFunction>(clonedComposite)->SetFuseTimesPlusActivation(compositeFunction->ShouldFuseTimesPlusActivation());
         return clonedComposite;
     }
 
@@ -0,0 +1,296 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#include "stdafx.h"
+#include "CNTKLibrary.h"
+#include "CompositeFunction.h"
+#include "PrimitiveFunction.h"
+#include "PrimitiveFunctionAttribute.h"
+
+namespace CNTK
+{
+    namespace
+    {
+        std::shared_ptr<PrimitiveFunction> AsPrimitive(const FunctionPtr& function)
+        {
+            return std::dynamic_pointer_cast<PrimitiveFunction>(function);
+        }
+
+        bool IsDropout(const FunctionPtr& function)
+        {
+            auto primitiveFunction = AsPrimitive(function);
+            return primitiveFunction && (primitiveFunction->OpType() == PrimitiveOpType::Dropout);
+        }
+
+        // Dropout is the identity during inference; returns the model with each Dropout output replaced by the Dropout input.
+        FunctionPtr RemoveDropout(FunctionPtr model)
+        {
+            for (;;)
+            {
+                std::unordered_map<Variable, Variable> replacements;
+                model->PreorderTraverse([&replacements](const FunctionPtr& function) {
+                    if (!IsDropout(function))
+                        return;
+
+                    // The replacements are not cloned, so a chain of Dropouts has to be skipped in one go.
+                    auto input = function->Inputs()[0];
+                    while (input.IsOutput() && IsDropout(input.Owner()))
+                        input = input.Owner()->Inputs()[0];
+
+                    replacements.insert({ function->Output(), input });
+                });
+
+                if (replacements.empty())
+                    return model;
+
+                // The subgraphs below the replacements are not cloned and may still contain Dropouts; they are handled by the next round.
+                model = model->Clone(ParameterCloningMethod::Share, replacements);
+            }
+        }
+
+        bool IsPrimitive(const Variable& variable, PrimitiveOpType opType)
+        {
+            if (!variable.IsOutput())
+                return false;
+
+            auto primitiveFunction = AsPrimitive(variable.Owner());
+            return primitiveFunction && (primitiveFunction->OpType() == opType);
+        }
+
+        // Counts how often each Variable is consumed in the graph of the model; the model outputs count as a use.
+        std::unordered_map<Variable, size_t> CountUses(const FunctionPtr& model)
+        {
+            std::unordered_map<Variable, size_t> uses;
+            model->PreorderTraverse([&uses](const FunctionPtr& function) {
+                for (const auto& input : function->Inputs())
+                    uses[input]++;
+            });
+
+            for (const auto& output : model->Outputs())
+                uses[output]++;
+
+            return uses;
+        }
+
+        // In inference BatchNormalization computes y = (x - mean) * scale / sqrt(variance + epsilon) + bias with the running statistics.
+        // If x = W * z (+ b) is a Times or Convolution with Constant weights, this is folded into W' * z + b' with
+        // W' = W * s and b' = (b - mean) * s + bias, s = scale / sqrt(variance + epsilon), for each output channel.
+        // Returns the replacement of the BatchNormalization output, or nullptr if it cannot be folded.
+        FunctionPtr FoldBatchNormalization(const FunctionPtr& batchNormalization, const std::unordered_map<Variable, size_t>& uses)
+        {
+            auto inputs = batchNormalization->Inputs();
+            const auto& scale = inputs[1];
+            const auto& bias = inputs[2];
+            const auto& runningMean = inputs[3];
+            const auto& runningVariance = inputs[4];
+            if (!scale.IsConstant() || !bias.IsConstant() || !runningMean.IsConstant() || !runningVariance.IsConstant())
+                return nullptr;
+
+            const auto& attributes = batchNormalization->Attributes();
+            auto spatial = attributes[PrimitiveFunctionAttribute::AttributeNameSpatial].Value<bool>();
+            auto epsilon = attributes[PrimitiveFunctionAttribute::AttributeNameEpsilon].Value<double>();
+
+            // The statistics are shaped such that they broadcast over the output: per channel (last axis) if spatial, else per element.
+            auto outputShape = batchNormalization->Output().Shape();
+            auto numChannels = scale.Shape().TotalSize();
+            if ((outputShape.Rank() == 0) || outputShape.HasUnboundDimension())
+                return nullptr;
+
+            if (spatial ? (outputShape[outputShape.Rank() - 1] != numChannels) : (outputShape.TotalSize() != numChannels))
+                return nullptr;
+
+            NDShape statisticsShape = outputShape;
+            if (spatial)
+            {
+                statisticsShape = NDShape(outputShape.Rank(), 1);
+                statisticsShape[outputShape.Rank() - 1] = numChannels;
+            }
+
+            // An optional Constant bias between the weights and the normalization.
+            auto operand = inputs[0];
+            Variable offset;
+            if (IsPrimitive(operand, PrimitiveOpType::Plus) && (uses.at(operand) == 1))
+            {
+                auto plusInputs = operand.Owner()->Inputs();
+                if (plusInputs[1].IsConstant())
+                {
+                    offset = plusInputs[1];
+                    operand = plusInputs[0];
+                }
+                else if (plusInputs[0].IsConstant())
+                {
+                    offset = plusInputs[0];
+                    operand = plusInputs[1];
+                }
+            }
+
+            bool isTimes = IsPrimitive(operand, PrimitiveOpType::Times);
+            bool isConvolution = IsPrimitive(operand, PrimitiveOpType::Convolution);
+            if ((!isTimes && !isConvolution) || (uses.at(operand) != 1) || (operand.Shape() != outputShape))
+                return nullptr;
+
+            auto producer = AsPrimitive(operand.Owner());
+            auto producerInputs = producer->Inputs();
+            const auto& weights = producerInputs[0];
+            if (!weights.IsConstant() || (weights.GetDataType() != scale.GetDataType()))
+                return nullptr;
+
+            // The shape the per channel factor has to be brought into to scale the weights of each output channel.
+            NDShape weightsScaleShape;
+            if (isTimes)
+            {
+                // W has the shape [outputShape x inputShape]; this requires that the operand has no additional static axes.
+                auto outputRank = producer->Attributes()[PrimitiveFunctionAttribute::AttributeNameOutputRank].Value<size_t>();
+                if (outputRank != outputShape.Rank())
+                    return nullptr;
+
+                weightsScaleShape = statisticsShape;
+            }
+            else
+            {
+                // The kernel has the shape [kernel x input channels x output channels]; per element normalization cannot be folded into it.
+                auto weightsRank = weights.Shape().Rank();
+                if (!spatial || producer->Attributes()[PrimitiveFunctionAttribute::AttributeNameTranspose].Value<bool>() || (weightsRank == 0) || (weights.Shape()[weightsRank - 1] != numChannels))
+                    return nullptr;
+
+                weightsScaleShape = NDShape(weightsRank, 1);
+                weightsScaleShape[weightsRank - 1] = numChannels;
+            }
+
+            // All of this only depends on Constants and is precomputed by FoldConstants().
+            auto epsilonConstant = Constant::Scalar(scale.GetDataType(), epsilon);
+            auto factor = ElementDivide(Reshape(scale, statisticsShape), Sqrt(Plus(Reshape(runningVariance, statisticsShape), epsilonConstant)));
+            Variable foldedBias = Minus(Reshape(bias, statisticsShape), ElementTimes(Reshape(runningMean, statisticsShape), factor));
+            if (offset.IsInitialized())
+                foldedBias = Plus(foldedBias, ElementTimes(offset, factor));
+
+            producerInputs[0] = ElementTimes(weights, Reshape(factor, weightsScaleShape));
+            auto foldedProducer = MakeSharedObject<PrimitiveFunction>(producer->OpType(), producerInputs, Dictionary(producer->Attributes()), producer->Name());
+
+            return Plus(foldedProducer->Output(), foldedBias, batchNormalization->Name());
+        }
+
+        FunctionPtr FoldBatchNormalization(FunctionPtr model)
+        {
+            for (;;)
+            {
+                auto uses = CountUses(model);
+                std::unordered_map<Variable, Variable> replacements;
+                model->PreorderTraverse([&replacements, &uses](const FunctionPtr& function) {
+                    auto primitiveFunction = AsPrimitive(function);
+                    if (!primitiveFunction || (primitiveFunction->OpType() != PrimitiveOpType::BatchNormalization))
+                        return;
+
+                    auto folded = FoldBatchNormalization(function, uses);
+                    if (folded)
+                        replacements.insert({ function->Output(), folded->Output() });
+                });
+
+                if (replacements.empty())
+                    return model;
+
+                // As for the Dropouts, normalizations below the replacements are folded in the next round.
+                model = model->Clone(ParameterCloningMethod::Share, replacements);
+            }
+        }
+
+        bool IsFoldable(const FunctionPtr& function, const std::unordered_set<Variable>& modelOutputs)
+        {
+            auto primitiveFunction = AsPrimitive(function);
+            if (!primitiveFunction || primitiveFunction->IsStateful())
+                return false;
+
+            switch (primitiveFunction->OpType())
+            {
+            case PrimitiveOpType::Combine:
+            case PrimitiveOpType::NoOp:
+            case PrimitiveOpType::PastValue:
+            case PrimitiveOpType::FutureValue:
+            case PrimitiveOpType::Assign:
+                return false;
+            default:
+                break;
+            }
+
+            auto inputs = function->Inputs();
+            if (inputs.empty() || std::any_of(inputs.begin(), inputs.end(), [](const Variable& input) { return !input.IsConstant(); }))
+                return false;
+
+            auto outputs = function->Outputs();
+            if (outputs.size() != 1)
+                return false;
+
+            const auto& output = outputs.front();
+            return !output.IsSparse() && output.DynamicAxes().empty() && !output.Shape().HasUnboundDimension() && (modelOutputs.find(output) == modelOutputs.end());
+        }
+
+        // Replaces each primitive Function whose inputs are all Constants by a Constant holding its precomputed value.
+        FunctionPtr FoldConstants(FunctionPtr model, const DeviceDescriptor& device)
+        {
+            auto modelOutputs = model->Outputs();
+            std::unordered_set<Variable> modelOutputSet(modelOutputs.begin(), modelOutputs.end());
+            for (;;)
+            {
+                std::vector<FunctionPtr> foldableFunctions;
+                model->PreorderTraverse([&foldableFunctions, &modelOutputSet](const FunctionPtr& function) {
+                    if (IsFoldable(function, modelOutputSet))
+                        foldableFunctions.push_back(function);
+                });
+
+                if (foldableFunctions.empty())
+                    return model;
+
+                std::unordered_map<Variable, Variable> replacements;
+                for (const auto& function : foldableFunctions)
+                {
+                    auto output = function->Output();
+                    std::unordered_map<Variable, ValuePtr> outputValues = { { output, nullptr } };
+                    AsComposite(function)->Evaluate({}, outputValues, device);
+
+                    // The value may be backed by the memory of the evaluated network, which goes away with it.
+                    auto value = outputValues[output]->Data()->DeepClone(device, /*readOnly =*/ true);
+                    value = value->AsShape(output.Shape());
+                    replacements.insert({ output, Constant(value, function->Name()) });
+                }
+
+                model = model->Clone(ParameterCloningMethod::Share, replacements);
+            }
+        }
+    }
+
+    FunctionPtr FreezeForInference(const FunctionPtr& model, const std::vector<Variable>& outputs, size_t maxBatchSize, const DeviceDescriptor& device)
+    {
+        if (!model)
+            InvalidArgument("FreezeForInference: model must not be null.");
+
+        for (const auto& output : outputs)
+        {
+            if (!output.IsOutput())
+                InvalidArgument("FreezeForInference: '%S' is not an output of a Function of the model '%S'.", output.AsString().c_str(), model->AsString().c_str());
+        }
+
+        // Only what the requested outputs depend on is kept; the training criterion and the evaluation metric are dropped with the rest.
+        auto root = outputs.empty() ? model : Combine(outputs);
+        auto frozenModel = root->CloneFlattened(ParameterCloningMethod::Freeze);
+
+        frozenModel = RemoveDropout(frozenModel);
+        frozenModel = FoldBatchNormalization(frozenModel);
+        frozenModel = FoldConstants(frozenModel, device);
+
+        auto compositeFunction = std::dynamic_pointer_cast<CompositeFunction>(frozenModel);
+        if (!compositeFunction)
+            LogicError("FreezeForInference: the frozen model '%S' is not a composite Function.", frozenModel->AsString().c_str());
+
+        // The bias and the activation of the dense layers, including those the batch normalizations were folded into, are applied
+        // in the epilogue of the matrix product once the model is compiled for evaluation.
+        compositeFunction->SetFuseTimesPlusActivation(true);
+
+        // The remaining batch normalizations run on the frozen running statistics since the model is only ever evaluated without a backprop root.
+        if (maxBatchSize > 0)
+            compositeFunction->SetMaxBatchSizeForMemoryPlan(maxBatchSize);
+
+        return frozenModel;
+    }
+}
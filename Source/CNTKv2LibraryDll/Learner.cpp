@@ -116,6 +116,9 @@ namespace CNTK
                 v.second->SetValue(0.0);
             else
                 LogicError("Unsupported DataType %s", DataTypeName(v.second->GetDataType()));
+
+            if (m_trackUpdatedColumns)
+                m_updatedColumns[v.first].clear();
         }
     }
 
@@ -209,7 +212,9 @@ namespace CNTK
                              AdditionalLearningOptions additionalOptions)
                              : Learner(parameters, learningRateSchedule, additionalOptions),
                              m_noiseInjectionSeed(Internal::GenerateRandomSeed()),
-                             m_masterParameterUpdated(false)
+                             m_masterParameterUpdated(false),
+                             m_trackUpdatedColumns(false),
+                             m_checkpointSmoothedGradients(true)
     {
         if (parameters.empty())
             InvalidArgument("The parameters list specified to a Learner must not be empty.");
@@ -309,6 +314,9 @@ namespace CNTK
                 pv.CastAssignValuesOf(*pv16);
             }
 
+            if (m_trackUpdatedColumns)
+                RecordUpdatedColumns(parameter, gradientValue);
+
             // TODO: make this a runtime parameter.
 #if DUMPOUTPUT
             LOGPRINTF(stderr, "Update_%ls\n", parameter.Uid().c_str());
@@ -401,6 +409,10 @@ namespace CNTK
         checkpoint[noiseInjectionSeedKey] = m_noiseInjectionSeed;
         checkpoint[masterParameterUpdatedKey] = m_masterParameterUpdated;
 
+        // Delta checkpoints store the changed columns of the smoothed gradients separately.
+        if (!m_checkpointSmoothedGradients)
+            return checkpoint;
+
         // TODO: should we also save momentum schedule into the checkpoint?
         // If that is the case, need to be able to override this method in subclasses.
         std::vector<DictionaryValue> serializedSmoothedGradients(Parameters().size());
@@ -422,7 +434,7 @@ namespace CNTK
 
         auto version = ValidateDictionary<LearnerBase>(checkpoint, s_requiredDictionaryKeys, s_learnerTypeValue, CurrentVersion());
 
-        if (version >= 2) 
+        if (version >= 2 && m_checkpointSmoothedGradients)
         {
             ValidateDictionary<LearnerBase>(checkpoint, { smoothedGradientsKey }, s_learnerTypeValue, CurrentVersion());
         }
@@ -455,6 +467,9 @@ namespace CNTK
         // The one given at construction time or the one loaded from a checkpoint?
         m_learningRateSchedule = TrainingParameterSchedule<double>::Deserialize(checkpoint[learningRateScheduleKey].Value<Dictionary>());
 
+        if (!m_checkpointSmoothedGradients)
+            return;
+
         const auto& parameters = Parameters();
 
         auto getSmoothedGradValue = [version, &checkpoint] (size_t i, const Parameter& parameter) -> const DictionaryValue&
@@ -502,6 +517,262 @@ namespace CNTK
 
     }
 
+    void LearnerBase::ResetUpdatedColumns()
+    {
+        m_trackUpdatedColumns = true;
+        m_updatedColumns.clear();
+    }
+
+    void LearnerBase::RecordUpdatedColumns(const Parameter& parameter, const NDArrayViewPtr& gradientValue)
+    {
+        // Regularization and noise injection touch all columns of the parameter.
+        bool updatesColumns = UpdatesOnlyGradientColumns() &&
+                              gradientValue->GetStorageFormat() == StorageFormat::SparseBlockCol &&
+                              m_additionalOptions.l1RegularizationWeight == 0 &&
+                              m_additionalOptions.l2RegularizationWeight == 0 &&
+                              GetCurrentTrainingParameterValue(m_additionalOptions.gaussianNoiseInjectionStdDev) == 0;
+
+        auto iter = m_updatedColumns.find(parameter);
+        if (!updatesColumns)
+        {
+            m_updatedColumns[parameter].clear();
+            return;
+        }
+
+        if (iter == m_updatedColumns.end())
+            iter = m_updatedColumns.emplace(parameter, std::vector<bool>(GetMatrixShape(parameter)[1], false)).first;
+        else if (iter->second.empty())
+            return; // the whole parameter has changed already
+
+        auto columns = (parameter.GetDataType() == DataType::Float) ?
+            GetMatrix<float>(gradientValue)->GetSparseBlockColumns() :
+            GetMatrix<double>(gradientValue)->GetSparseBlockColumns();
+
+        for (auto column : columns)
+            iter->second[column] = true;
+    }
+
+    // The smoothed gradient holds 'factor' matrices of the parameter's shape side by side, e.g. the two moments of Adam.
+    /*static*/ std::vector<size_t> LearnerBase::GetSmoothedGradientColumns(const Parameter& parameter, const NDArrayViewPtr& smoothedGradientValue, const std::vector<size_t>& columns)
+    {
+        const auto numColumns = GetMatrixShape(parameter)[1];
+        const auto factor = smoothedGradientValue->Shape().TotalSize() / parameter.Shape().TotalSize();
+
+        std::vector<size_t> smoothedGradientColumns;
+        for (size_t k = 0; k < factor; ++k)
+        {
+            for (auto column : columns)
+                smoothedGradientColumns.push_back(k * numColumns + column);
+        }
+        return smoothedGradientColumns;
+    }
+
+    Dictionary LearnerBase::CreateDeltaCheckpoint()
+    {
+        if (!m_trackUpdatedColumns)
+            LogicError("Learner::CreateDeltaCheckpoint: ResetUpdatedColumns() must be called before creating a delta checkpoint.");
+
+        // Let the subclasses add their state first, e.g. AdaDelta flushes its lazily updated smoothed gradients here.
+        Dictionary checkpoint;
+        {
+            m_checkpointSmoothedGradients = false;
+            auto resetFlag = MakeScopeExit([this] { m_checkpointSmoothedGradients = true; });
+            checkpoint = CreateCheckpoint();
+        }
+
+        std::vector<DictionaryValue> parameterDeltas;
+        for (const auto& parameter : Parameters())
+            parameterDeltas.push_back(CreateParameterDelta(parameter));
+
+        checkpoint[parameterDeltasKey] = parameterDeltas;
+        return checkpoint;
+    }
+
+    Dictionary LearnerBase::CreateParameterDelta(const Parameter& parameter) const
+    {
+        Dictionary delta;
+
+        auto iter = m_updatedColumns.find(parameter);
+        if (iter == m_updatedColumns.end())
+            return delta;
+
+        const auto& smoothedGradientValue = m_smoothedGradientValues.at(parameter);
+        const auto& mask = iter->second;
+        if (mask.empty())
+        {
+            delta[valueKey] = *parameter.Value();
+            delta[smoothedGradientKey] = *smoothedGradientValue;
+            return delta;
+        }
+
+        std::vector<size_t> columns;
+        for (size_t column = 0; column < mask.size(); ++column)
+        {
+            if (mask[column])
+                columns.push_back(column);
+        }
+
+        if (columns.empty())
+            return delta;
+
+        delta[updatedColumnsKey] = std::vector<DictionaryValue>(columns.begin(), columns.end());
+
+        auto smoothedGradientColumns = GetSmoothedGradientColumns(parameter, smoothedGradientValue, columns);
+        if (parameter.GetDataType() == DataType::Float)
+        {
+            delta[valueKey] = *GatherColumns<float>(parameter.Value(), columns);
+            if (!smoothedGradientColumns.empty())
+                delta[smoothedGradientKey] = *GatherColumns<float>(smoothedGradientValue, smoothedGradientColumns);
+        }
+        else
+        {
+            delta[valueKey] = *GatherColumns<double>(parameter.Value(), columns);
+            if (!smoothedGradientColumns.empty())
+                delta[smoothedGradientKey] = *GatherColumns<double>(smoothedGradientValue, smoothedGradientColumns);
+        }
+
+        // A scalar smoothed gradient is stored as a whole.
+        if (smoothedGradientColumns.empty())
+            delta[smoothedGradientKey] = *smoothedGradientValue;
+
+        return delta;
+    }
+
+    void LearnerBase::RestoreFromDeltaCheckpoint(const Dictionary& delta)
+    {
+        // Continue tracking from the changes stored in the delta.
+        m_trackUpdatedColumns = true;
+        m_updatedColumns.clear();
+
+        {
+            m_checkpointSmoothedGradients = false;
+            auto resetFlag = MakeScopeExit([this] { m_checkpointSmoothedGradients = true; });
+            RestoreFromCheckpoint(delta);
+        }
+
+        const auto& parameterDeltas = delta[parameterDeltasKey].Value<std::vector<DictionaryValue>>();
+        if (parameterDeltas.size() != Parameters().size())
+            LogicError("Learner::RestoreFromDeltaCheckpoint: The delta checkpoint holds %zu parameters, while the learner has %zu.", parameterDeltas.size(), Parameters().size());
+
+        size_t i = 0;
+        for (const auto& parameter : Parameters())
+            RestoreParameterDelta(parameter, parameterDeltas[i++].Value<Dictionary>());
+    }
+
+    void LearnerBase::RestoreParameterDelta(const Parameter& parameter, const Dictionary& delta)
+    {
+        if (!delta.Contains(valueKey))
+            return;
+
+        const auto& value = delta[valueKey].Value<NDArrayView>();
+        const auto& smoothedGradient = delta[smoothedGradientKey].Value<NDArrayView>();
+        const auto& smoothedGradientValue = m_smoothedGradientValues.at(parameter);
+
+        if (!delta.Contains(updatedColumnsKey))
+        {
+            if (parameter.Value()->Shape() != value.Shape() || smoothedGradientValue->Shape() != smoothedGradient.Shape())
+                LogicError("Learner::RestoreFromDeltaCheckpoint: The shapes stored for the parameter '%S' do not match.", parameter.AsString().c_str());
+
+            parameter.Value()->CopyFrom(value);
+            smoothedGradientValue->CopyFrom(smoothedGradient);
+            m_updatedColumns[parameter].clear();
+        }
+        else
+        {
+            const auto numColumns = GetMatrixShape(parameter)[1];
+            std::vector<size_t> columns;
+            for (const auto& column : delta[updatedColumnsKey].Value<std::vector<DictionaryValue>>())
+            {
+                columns.push_back(column.Value<size_t>());
+                if (columns.back() >= numColumns)
+                    LogicError("Learner::RestoreFromDeltaCheckpoint: Column %zu stored for the parameter '%S' is out of range.", columns.back(), parameter.AsString().c_str());
+            }
+
+            auto& mask = m_updatedColumns[parameter];
+            mask.assign(numColumns, false);
+            for (auto column : columns)
+                mask[column] = true;
+
+            auto smoothedGradientColumns = GetSmoothedGradientColumns(parameter, smoothedGradientValue, columns);
+            if (smoothedGradientColumns.empty())
+                smoothedGradientValue->CopyFrom(smoothedGradient);
+
+            if (parameter.GetDataType() == DataType::Float)
+            {
+                ScatterColumns<float>(parameter.Value(), columns, value);
+                if (!smoothedGradientColumns.empty())
+                    ScatterColumns<float>(smoothedGradientValue, smoothedGradientColumns, smoothedGradient);
+            }
+            else
+            {
+                ScatterColumns<double>(parameter.Value(), columns, value);
+                if (!smoothedGradientColumns.empty())
+                    ScatterColumns<double>(smoothedGradientValue, smoothedGradientColumns, smoothedGradient);
+            }
+        }
+
+        auto paramRef = parameter;
+        paramRef.RecordValueUpdate();
+    }
+
+    // The gather/scatter kernels take the column indices as values of the element type, which are exact integers
+    // only up to 2^24 for float. 'f' is called for each window of at most that many columns of 'matrix' that holds
+    // some of the 'columns', with the indices relative to the start of the window and the range of 'columns' it covers.
+    template <typename ElementType, typename F>
+    static void ForEachColumnWindow(const Matrix<ElementType>& matrix, const std::vector<size_t>& columns, F f)
+    {
+        const size_t maxWindowSize = (size_t)1 << std::numeric_limits<ElementType>::digits;
+        for (size_t begin = 0; begin < columns.size();)
+        {
+            size_t windowStart = columns[begin] - columns[begin] % maxWindowSize;
+            size_t windowSize = std::min(maxWindowSize, matrix.GetNumCols() - windowStart);
+
+            std::vector<ElementType> columnIndices;
+            size_t end = begin;
+            for (; end < columns.size() && columns[end] >= windowStart && columns[end] - windowStart < windowSize; end++)
+                columnIndices.push_back((ElementType)(columns[end] - windowStart));
+
+            Matrix<ElementType> indices(1, columnIndices.size(), columnIndices.data(), matrix.GetDeviceId());
+            f(indices, matrix.ColumnSlice(windowStart, windowSize), begin, end - begin);
+            begin = end;
+        }
+    }
+
+    template <typename ElementType>
+    /*static*/ NDArrayViewPtr LearnerBase::GatherColumns(const NDArrayViewPtr& value, const std::vector<size_t>& columns)
+    {
+        auto matrix = GetMatrix<ElementType>(value);
+        auto result = MakeSharedObject<NDArrayView>(AsDataType<ElementType>(), NDShape({ matrix->GetNumRows(), columns.size() }), value->Device());
+        auto resultMatrix = GetWritableMatrix<ElementType>(result);
+
+        ForEachColumnWindow(*matrix, columns, [&](const Matrix<ElementType>& indices, const Matrix<ElementType>& window, size_t first, size_t count)
+        {
+            resultMatrix->ColumnSlice(first, count).DoGatherColumnsOf(0, indices, window, 1);
+        });
+        return result;
+    }
+
+    template <typename ElementType>
+    /*static*/ void LearnerBase::ScatterColumns(const NDArrayViewPtr& value, const std::vector<size_t>& columns, const NDArrayView& columnValues)
+    {
+        auto matrix = GetWritableMatrix<ElementType>(value);
+
+        auto newColumns = MakeSharedObject<NDArrayView>(AsDataType<ElementType>(), columnValues.Shape(), value->Device());
+        newColumns->CopyFrom(columnValues);
+        if (GetMatrix<ElementType>(newColumns)->GetNumCols() != columns.size())
+            LogicError("Learner::RestoreFromDeltaCheckpoint: The number of columns in the delta checkpoint does not match.");
+
+        auto newColumnsMatrix = GetMatrix<ElementType>(newColumns);
+        ForEachColumnWindow(*matrix, columns, [&](const Matrix<ElementType>& indices, Matrix<ElementType> window, size_t first, size_t count)
+        {
+            // Scattering adds to the target columns: clear them first, so that the restored values are bit-exact.
+            Matrix<ElementType> oldColumns(matrix->GetDeviceId());
+            oldColumns.DoGatherColumnsOf(0, indices, window, 1);
+            window.DoScatterColumnsOf(1, indices, oldColumns, -1, /*idxHaveDups =*/ false);
+            window.DoScatterColumnsOf(1, indices, newColumnsMatrix->ColumnSlice(first, count), 1, /*idxHaveDups =*/ false);
+        });
+    }
+
     void LearnerBase::ReportTrainingParameterValue(const TrainingParameterSchedule<double>& schedule, const wstring& name) const
     {
         double value = GetCurrentTrainingParameterValue(schedule);
@@ -9,6 +9,7 @@
 #include "CNTKLibrary.h"
 #include <numeric>
 #include <functional>
+#include <typeinfo>
 
 namespace CNTK 
 {
@@ -29,6 +30,17 @@ namespace CNTK
 
         virtual void ResetSmoothedGradients() override;
 
+        // Delta checkpoints (see Trainer::SaveDeltaCheckpoint).
+        // Starts recording which columns of the parameter values and smoothed gradients are changed by subsequent updates.
+        void ResetUpdatedColumns();
+
+        // Creates a checkpoint that holds the complete learner state, except for the parameter values and the smoothed
+        // gradients, of which only the columns changed since the last ResetUpdatedColumns() call are included.
+        Dictionary CreateDeltaCheckpoint();
+
+        // Applies a checkpoint created by CreateDeltaCheckpoint() on top of the state restored from the base checkpoint.
+        void RestoreFromDeltaCheckpoint(const Dictionary& delta);
+
     protected:
         LearnerBase(const std::vector<Parameter>& parameters,
             const LearningRateSchedule& learningRateSchedule,
@@ -41,6 +53,11 @@ namespace CNTK
         // Allows derived class may override this to perform per-minibatch update actions
         virtual void UpdateOnMinibatch(size_t /*trainingSampleCount*/) {}
 
+        // Returns true if an update with a sparse block column gradient only changes the columns of the parameter value
+        // and of the smoothed gradient that are present in the gradient. Learners that decay their state everywhere
+        // (e.g. Adam) or update it lazily (AdaDelta) must keep the default.
+        virtual bool UpdatesOnlyGradientColumns() const { return false; }
+
         std::string LearnerType() const;
 
         // Returns current learning rate.
@@ -127,6 +144,27 @@ namespace CNTK
         static bool HasNan(const NDArrayViewPtr& value, const char* name);
         static void Print(const NDArrayViewPtr& value, const char* msg);
 
+        void RecordUpdatedColumns(const Parameter& parameter, const NDArrayViewPtr& gradientValue);
+
+        Dictionary CreateParameterDelta(const Parameter& parameter) const;
+        void RestoreParameterDelta(const Parameter& parameter, const Dictionary& delta);
+
+        static std::vector<size_t> GetSmoothedGradientColumns(const Parameter& parameter, const NDArrayViewPtr& smoothedGradientValue, const std::vector<size_t>& columns);
+
+        template <typename ElementType>
+        static NDArrayViewPtr GatherColumns(const NDArrayViewPtr& value, const std::vector<size_t>& columns);
+
+        template <typename ElementType>
+        static void ScatterColumns(const NDArrayViewPtr& value, const std::vector<size_t>& columns, const NDArrayView& columnValues);
+
+        // Columns changed since ResetUpdatedColumns(), per parameter; an empty mask means that the whole parameter changed.
+        // Parameters without an entry have not been updated.
+        bool m_trackUpdatedColumns;
+        std::unordered_map<Parameter, std::vector<bool>> m_updatedColumns;
+
+        // Cleared while CreateDeltaCheckpoint() collects the rest of the learner state.
+        bool m_checkpointSmoothedGradients;
+
         // Version history:
         // 1 -- initial version.
         // 2 -- instead of storing smoothed gradients as a map<parameter_uid, smoothed_grad_value>.
@@ -151,6 +189,8 @@ namespace CNTK
 
         virtual void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) override;
 
+        virtual bool UpdatesOnlyGradientColumns() const override { return true; }
+
         template <typename ElementType>
         void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const;
     };
@@ -181,6 +221,10 @@ namespace CNTK
     protected:
         virtual void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) override;
 
+        // Sparse momentum only decays the smoothed gradient of the columns present in the gradient. The learners
+        // derived from momentum SGD (Nesterov, FSAdaGrad, Adam) update all columns and keep the default.
+        virtual bool UpdatesOnlyGradientColumns() const override { return typeid(*this) == typeid(LearnerMomentumSGD); }
+
         template <typename ElemType>
         void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const;
 
@@ -246,6 +290,8 @@ namespace CNTK
 
         virtual void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) override;
 
+        virtual bool UpdatesOnlyGradientColumns() const override { return true; }
+
         template <typename ElementType>
         void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const;
     };
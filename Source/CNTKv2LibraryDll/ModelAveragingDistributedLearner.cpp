@@ -0,0 +1,311 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#include "stdafx.h"
+#include "ModelAveragingDistributedLearner.h"
+#include "DistributedCommunicator.h"
+#include "Learner.h"
+#include "PerformanceProfiler.h"
+#include "Utils.h"
+
+namespace CNTK
+{
+    DistributedLearnerPtr CreateModelAveragingDistributedLearner(
+        DistributedCommunicatorPtr communicator,
+        LearnerPtr learner,
+        size_t distributeAfterSamples,
+        size_t syncPeriod,
+        size_t maxStaleness,
+        bool resetSGDMomentumAfterAggregation)
+    {
+        return MakeSharedObject<ModelAveragingDistributedLearner>(
+            communicator,
+            learner,
+            distributeAfterSamples,
+            syncPeriod,
+            maxStaleness,
+            resetSGDMomentumAfterAggregation);
+    }
+
+    ModelAveragingDistributedLearner::ModelAveragingDistributedLearner(
+        DistributedCommunicatorPtr communicator,
+        LearnerPtr learner,
+        size_t distributeAfterSamples,
+        size_t syncPeriod,
+        size_t maxStaleness,
+        bool resetSGDMomentumAfterAggregation)
+        : DistributedLearnerBase(communicator, learner, distributeAfterSamples),
+          m_syncPeriod(syncPeriod),
+          m_maxStaleness(maxStaleness),
+          m_resetSGDMomentumAfterAggregation(resetSGDMomentumAfterAggregation),
+          m_numMinibatchesSinceSnapshot(0),
+          m_numSamplesSinceSnapshot(0),
+          m_pendingRoundAge(0),
+          m_averageInBackground(false)
+    {
+        if (m_syncPeriod == 0)
+            InvalidArgument("Sync period of the model averaging distributed learner must be positive.");
+
+        // Need to allocate memory here to make sure not hitting OOM in the middle of training
+        std::vector<NDArrayViewPtr> parameterValues;
+        for (const auto& p : learner->Parameters())
+            parameterValues.push_back(p.Value());
+        AllocateBuffers(parameterValues);
+    }
+
+    ModelAveragingDistributedLearner::~ModelAveragingDistributedLearner()
+    {
+        // Make sure the background thread does not outlive the buffers it works on.
+        if (m_pendingAveraging.valid())
+            m_pendingAveraging.wait();
+    }
+
+    bool ModelAveragingDistributedLearner::Update(std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues, MinibatchInfo& info)
+    {
+        if (m_communicator->Workers().size() == 1)
+        {
+            if (info.IsEmpty())
+                return false;
+
+            m_sampleCount += info.numberOfSamples;
+            return m_learner->Update(gradientValues, info.numberOfSamples, info.atEndOfSweep);
+        }
+
+        if (m_sampleCount < m_distributeAfterSamples)
+            return UpdateWarmUp(gradientValues, info);
+
+        if (!info.IsEmpty())
+        {
+#ifndef  CNTK_UWP
+            auto profWeights = Microsoft::MSR::CNTK::ScopeProfile(Microsoft::MSR::CNTK::profilerEvtMainWeights);
+#endif
+            // The return value of the local learner is ignored: the number of averaging rounds has to match between workers.
+            m_learner->Update(gradientValues, info.numberOfSamples, info.atEndOfSweep);
+        }
+
+        m_numSamplesSinceSnapshot += info.numberOfSamples;
+        m_numMinibatchesSinceSnapshot++;
+
+        bool continueTraining = true;
+        if (m_pendingAveraging.valid() && ++m_pendingRoundAge >= m_maxStaleness)
+            continueTraining = FinishAveraging();
+
+        if (continueTraining && m_numMinibatchesSinceSnapshot >= m_syncPeriod)
+        {
+            // At most one averaging round can be in flight.
+            if (m_pendingAveraging.valid())
+                continueTraining = FinishAveraging();
+
+            if (continueTraining)
+            {
+                StartAveraging();
+                if (!m_averageInBackground)
+                    continueTraining = FinishAveraging();
+            }
+        }
+
+        return continueTraining;
+    }
+
+    bool ModelAveragingDistributedLearner::UpdateWarmUp(std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues, MinibatchInfo& info)
+    {
+        if (!info.IsEmpty())
+        {
+#ifndef  CNTK_UWP
+            auto profWeights = Microsoft::MSR::CNTK::ScopeProfile(Microsoft::MSR::CNTK::profilerEvtMainWeights);
+#endif
+            m_learner->Update(gradientValues, info.numberOfSamples, info.atEndOfSweep);
+        }
+
+        // Only the sample count is exchanged, so that all workers switch to model averaging at the same minibatch.
+        auto value = MakeSharedObject<NDArrayView>(static_cast<double>(info.numberOfSamples), NDShape{}, DeviceDescriptor::CPUDevice());
+        m_communicator->AggregateInPlace(std::vector<NDArrayViewPtr>{ value }, m_communicator->Workers());
+
+        auto totalNumberOfSamples = static_cast<size_t>(*value->DataBuffer<double>());
+        m_sampleCount += totalNumberOfSamples;
+        return totalNumberOfSamples != 0;
+    }
+
+    void ModelAveragingDistributedLearner::CreateAveragingCommunicator()
+    {
+        // MPI calls from the background thread may only overlap with the ones of the training thread if MPI
+        // is thread safe. All workers have to take the same decision, since it determines the communicator used.
+        auto mpiCommunicator = std::dynamic_pointer_cast<MPICommunicatorImpl>(m_communicator);
+        bool canAverageInBackground = m_maxStaleness > 0 && mpiCommunicator && mpiCommunicator->SupportsConcurrentUse();
+
+        auto value = MakeSharedObject<NDArrayView>(canAverageInBackground ? 1.0 : 0.0, NDShape{}, DeviceDescriptor::CPUDevice());
+        m_communicator->AggregateInPlace(std::vector<NDArrayViewPtr>{ value }, m_communicator->Workers());
+        m_averageInBackground = static_cast<size_t>(*value->DataBuffer<double>()) == m_communicator->Workers().size();
+
+        if (m_averageInBackground)
+        {
+            // A communicator of its own keeps the messages of the rounds apart from the collectives of the training thread.
+            m_averagingCommunicator = m_communicator->SubGroup(m_communicator->Workers());
+        }
+        else
+        {
+            if (m_maxStaleness > 0)
+                fprintf(stderr, "WARNING: Model averaging: MPI does not support concurrent calls (MPI_THREAD_MULTIPLE), the averaging is done synchronously.\n");
+            m_averagingCommunicator = m_communicator;
+        }
+    }
+
+    void ModelAveragingDistributedLearner::StartAveraging()
+    {
+        assert(!m_pendingAveraging.valid());
+
+        if (!m_averagingCommunicator)
+            CreateAveragingCommunicator();
+
+        const auto& parameters = m_learner->Parameters();
+        for (size_t i = 0; i < parameters.size(); ++i)
+        {
+            auto value = parameters[i].Value();
+            if (value->GetDataType() == DataType::Double)
+                TakeSnapshot<double>(i, value, static_cast<double>(m_numSamplesSinceSnapshot));
+            else if (value->GetDataType() == DataType::Float)
+                TakeSnapshot<float>(i, value, static_cast<float>(m_numSamplesSinceSnapshot));
+            else
+                RuntimeError("Unsupported type.");
+        }
+        m_sampleCountBuffer->SetValue(static_cast<double>(m_numSamplesSinceSnapshot));
+
+        m_numSamplesSinceSnapshot = 0;
+        m_numMinibatchesSinceSnapshot = 0;
+        m_pendingRoundAge = 0;
+
+        int deviceId = m_snapshot.front()->Device().Type() == DeviceKind::CPU ? CPUDEVICE : static_cast<int>(m_snapshot.front()->Device().Id());
+        // A deferred round runs on the training thread when it is finished.
+        m_pendingAveraging = std::async(m_averageInBackground ? std::launch::async : std::launch::deferred, [this, deviceId] {
+            // We are starting on a new thread. Make sure the new thread is
+            // setup to use the right device
+            Matrix<float>::SetDevice(deviceId);
+            m_averagingCommunicator->AggregateInPlace(m_aggregationBuffer, m_averagingCommunicator->Workers());
+        });
+    }
+
+    bool ModelAveragingDistributedLearner::FinishAveraging()
+    {
+        assert(m_pendingAveraging.valid());
+        {
+#ifndef  CNTK_UWP
+            auto profGradientAgg = Microsoft::MSR::CNTK::ScopeProfile(Microsoft::MSR::CNTK::profilerEvtMainGradient);
+#endif
+            m_pendingAveraging.get();
+        }
+
+        auto totalNumberOfSamples = static_cast<size_t>(*m_sampleCountBuffer->DataBuffer<double>());
+        if (totalNumberOfSamples == 0)
+        {
+            // Nobody has processed anything since the previous snapshot, the models did not move.
+            return false;
+        }
+
+        const auto& parameters = m_learner->Parameters();
+        for (size_t i = 0; i < parameters.size(); ++i)
+        {
+            auto value = parameters[i].Value();
+            if (value->GetDataType() == DataType::Double)
+                ApplyAverage<double>(i, value, static_cast<double>(totalNumberOfSamples));
+            else
+                ApplyAverage<float>(i, value, static_cast<float>(totalNumberOfSamples));
+        }
+
+        m_sampleCount += totalNumberOfSamples;
+
+        if (m_resetSGDMomentumAfterAggregation)
+            m_learner->ResetSmoothedGradients();
+
+        if (GetTraceLevel() >= TraceLevel::Info)
+            fprintf(stderr, "Model averaging: worker %d averaged %d samples after %d stale minibatches\n",
+                    (int)m_communicator->CurrentWorker().m_globalRank, (int)totalNumberOfSamples, (int)m_pendingRoundAge);
+
+        return true;
+    }
+
+    Dictionary ModelAveragingDistributedLearner::CreateCheckpoint()
+    {
+        // All workers checkpoint at the same minibatch. Finish the pending round and do a synchronous one,
+        // so that all workers hold exactly the same model and no averaging state needs to be saved.
+        if (m_communicator->Workers().size() > 1 && m_sampleCount >= m_distributeAfterSamples)
+        {
+            if (m_pendingAveraging.valid())
+                FinishAveraging();
+
+            if (m_numMinibatchesSinceSnapshot > 0)
+            {
+                StartAveraging();
+                FinishAveraging();
+            }
+        }
+
+        return DistributedLearnerBase::CreateCheckpoint();
+    }
+
+    void ModelAveragingDistributedLearner::RestoreFromCheckpoint(const Dictionary& checkpoint)
+    {
+        if (m_pendingAveraging.valid())
+            m_pendingAveraging.get();
+
+        DistributedLearnerBase::RestoreFromCheckpoint(checkpoint);
+
+        m_numMinibatchesSinceSnapshot = 0;
+        m_numSamplesSinceSnapshot = 0;
+        m_pendingRoundAge = 0;
+    }
+
+    void ModelAveragingDistributedLearner::ResetCommunicator(const DistributedCommunicatorPtr& communicator)
+    {
+        // The pending round runs on the previous communicator. Normally CreateCheckpoint() has finished it already.
+        if (m_pendingAveraging.valid())
+            m_pendingAveraging.get();
+
+        DistributedLearnerBase::ResetCommunicator(communicator);
+        m_averagingCommunicator = nullptr;
+
+        m_numMinibatchesSinceSnapshot = 0;
+        m_numSamplesSinceSnapshot = 0;
+        m_pendingRoundAge = 0;
+    }
+
+    void ModelAveragingDistributedLearner::AllocateBuffers(const std::vector<NDArrayViewPtr>& parameterValues)
+    {
+        m_snapshot.clear();
+        m_aggregationBuffer.clear();
+        for (const auto& value : parameterValues)
+        {
+            m_snapshot.push_back(MakeSharedObject<NDArrayView>(value->GetDataType(), value->Shape(), value->Device()));
+            m_aggregationBuffer.push_back(MakeSharedObject<NDArrayView>(value->GetDataType(), value->Shape(), value->Device()));
+        }
+
+        m_sampleCountBuffer = MakeSharedObject<NDArrayView>(0.0, NDShape{}, DeviceDescriptor::CPUDevice());
+        m_aggregationBuffer.push_back(m_sampleCountBuffer);
+    }
+
+    template<class ElemType>
+    void ModelAveragingDistributedLearner::TakeSnapshot(size_t index, const NDArrayViewPtr& parameterValue, ElemType sampleWeight)
+    {
+        const Matrix<ElemType>& currentWeight = *parameterValue->GetMatrix<ElemType>();
+        Matrix<ElemType>& snapshot = *m_snapshot[index]->GetWritableMatrix<ElemType>();
+        Matrix<ElemType>& weightedSnapshot = *m_aggregationBuffer[index]->GetWritableMatrix<ElemType>();
+
+        snapshot.SetValue(currentWeight);
+
+        // Workers contribute proportionally to the number of samples they processed since the previous snapshot.
+        Matrix<ElemType>::Scale(sampleWeight, currentWeight, weightedSnapshot);
+    }
+
+    template<class ElemType>
+    void ModelAveragingDistributedLearner::ApplyAverage(size_t index, const NDArrayViewPtr& parameterValue, ElemType totalSampleWeight)
+    {
+        Matrix<ElemType>& currentWeight = *parameterValue->GetWritableMatrix<ElemType>();
+        Matrix<ElemType>& snapshot = *m_snapshot[index]->GetWritableMatrix<ElemType>();
+        const Matrix<ElemType>& weightedSum = *m_aggregationBuffer[index]->GetMatrix<ElemType>();
+
+        // w <-- average + (w - snapshot), i.e. keep the local progress made while the averaging was in flight.
+        currentWeight -= snapshot;
+        Matrix<ElemType>::ScaleAndAdd((ElemType)1 / totalSampleWeight, weightedSum, currentWeight);
+    }
+}
@@ -0,0 +1,100 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#pragma  once
+
+#include <future>
+#include "CNTKLibrary.h"
+#include "DistributedLearnerBase.h"
+
+namespace CNTK
+{
+    ///
+    /// Local SGD / periodic model averaging distributed learner.
+    ///
+    /// Every worker runs the local learner on its own minibatches. Every 'syncPeriod' minibatches
+    /// a snapshot of the local model is taken and averaged (weighted by the number of samples each
+    /// worker processed since the previous snapshot) across all workers. The all-reduce runs on a
+    /// background thread, overlapped with the next 'maxStaleness' local minibatches; after that the
+    /// average is folded back into the local model while keeping the local progress made since the
+    /// snapshot:  w <-- average + (w - snapshot).
+    ///
+    /// All synchronization decisions are taken on the number of Update calls, which is the same on all
+    /// workers, so the collectives of different workers always match. The background all-reduce runs on a
+    /// private duplicate of the communicator, so that the training thread can keep using the original one
+    /// (e.g. for distributed evaluation) while a round is in flight. This requires MPI to provide
+    /// MPI_THREAD_MULTIPLE, which it is only asked for if Internal::EnableConcurrentMPICalls() was called
+    /// before the first communicator was created; otherwise the averaging is done synchronously on the training thread.
+    ///
+    class ModelAveragingDistributedLearner : public DistributedLearnerBase
+    {
+        template<class T> using Matrix = Microsoft::MSR::CNTK::Matrix<T>;
+
+    public:
+        ModelAveragingDistributedLearner(
+            DistributedCommunicatorPtr communicator,
+            LearnerPtr learner,
+            size_t distributeAfterSamples,
+            size_t syncPeriod,
+            size_t maxStaleness,
+            bool resetSGDMomentumAfterAggregation);
+
+        ~ModelAveragingDistributedLearner();
+
+        bool Update(std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues, MinibatchInfo& info) override;
+
+        Dictionary CreateCheckpoint() override;
+
+        void RestoreFromCheckpoint(const Dictionary& checkpoint) override;
+
+        void ResetCommunicator(const DistributedCommunicatorPtr& communicator) override;
+
+    private:
+        // Aggregates only the number of samples; used during warm up to keep the sample count identical on all workers.
+        bool UpdateWarmUp(std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues, MinibatchInfo& info);
+
+        // Takes the snapshot of the local model and starts the averaging all-reduce on a background thread.
+        void StartAveraging();
+
+        // Waits for the pending averaging round and folds the result into the local model.
+        // Returns false if none of the workers processed any samples during the round, i.e. all workers ran out of data.
+        bool FinishAveraging();
+
+        // Collective; decides whether rounds can run in the background and creates the communicator they use.
+        void CreateAveragingCommunicator();
+
+        void AllocateBuffers(const std::vector<NDArrayViewPtr>& parameterValues);
+
+        template<class ElemType>
+        void TakeSnapshot(size_t index, const NDArrayViewPtr& parameterValue, ElemType sampleWeight);
+
+        template<class ElemType>
+        void ApplyAverage(size_t index, const NDArrayViewPtr& parameterValue, ElemType totalSampleWeight);
+
+        const size_t m_syncPeriod;
+        const size_t m_maxStaleness;
+        const bool m_resetSGDMomentumAfterAggregation;
+
+        size_t m_numMinibatchesSinceSnapshot;
+        size_t m_numSamplesSinceSnapshot;
+
+        // Number of local minibatches processed since the pending averaging round has been started.
+        size_t m_pendingRoundAge;
+        std::future<void> m_pendingAveraging;
+
+        // Communicator of the averaging rounds, and whether the rounds run on a background thread.
+        DistributedCommunicatorPtr m_averagingCommunicator;
+        bool m_averageInBackground;
+
+        // Local model at the time the pending round was started, and the (sample weighted) values that are being all-reduced.
+        std::vector<NDArrayViewPtr> m_snapshot;
+        std::vector<NDArrayViewPtr> m_aggregationBuffer;
+
+        // Number of samples the local worker contributed to the pending round; the last element of the aggregation buffer.
+        NDArrayViewPtr m_sampleCountBuffer;
+
+        ModelAveragingDistributedLearner(const ModelAveragingDistributedLearner&) = delete; ModelAveragingDistributedLearner& operator=(const ModelAveragingDistributedLearner&) = delete; ModelAveragingDistributedLearner& operator=(ModelAveragingDistributedLearner&&) = delete; ModelAveragingDistributedLearner(ModelAveragingDistributedLearner&& other) = delete;
+    };
+}
@@ -6,6 +6,7 @@
 #include "stdafx.h"
 #include "CNTKLibrary.h"
 #include "Utils.h"
+#include "Serialization.h"
 #include <istream>
 #include <ostream>
 #include <string>
@@ -22,6 +23,22 @@
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/arena.h>
 #pragma warning(pop)
+#include <boost/crc.hpp>
+
+// zlib is a system library on Linux; on Windows it comes with the optional zip support (ZLIB_PATH).
+#if !defined(_MSC_VER) || defined(USE_ZIP)
+#define CNTK_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+// after the protobuf headers, which do not cope with the GetMessage macro
+#ifdef _MSC_VER
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace CNTK
 {
@@ -31,6 +48,136 @@ namespace CNTK
     static const uint32 MAGIC_NUMBER = 0x636e746bU;
     static const uint32 BLOCK_SIZE = 8 << 10; // 8Kb;
 
+    // Memory-mapped model container (ModelFormat::CNTKv2Mapped):
+    //   uint32 magic number, uint32 format version, uint64 byte size of the metadata,
+    //   metadata (a Dictionary protobuf, where dense NDArrayViews only hold the location of their values),
+    //   tensor data section, aligned, with the raw values of each NDArrayView aligned as well.
+    static const uint32 MAPPED_MAGIC_NUMBER = 0x6d746e63U;
+    static const uint32 MAPPED_FORMAT_VERSION = 1;
+    static const size_t MAPPED_HEADER_SIZE = 2 * sizeof(uint32) + sizeof(uint64);
+    static const size_t MAPPED_DATA_ALIGNMENT = 64; // cache line, also enough for any vectorized kernel
+
+    static size_t AlignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Streaming checkpoint container (CheckpointFormat::CNTKv2Streaming):
+    //   uint32 magic number, uint32 format version,
+    //   one record per dense NDArrayView, in the order in which they appear in the Dictionary,
+    //   metadata (a Dictionary protobuf, where dense NDArrayViews only hold the location of their record),
+    //   uint64 offset of the metadata, uint64 byte size of the metadata, uint32 magic number.
+    // A record is a sequence of chunks, each prefixed with its raw and stored byte size (equal if the chunk
+    // is not compressed), followed by the CRC-32 of the raw values.
+    static const uint32 STREAMING_MAGIC_NUMBER = 0x73746e63U;
+    static const uint32 STREAMING_FORMAT_VERSION = 1;
+    static const size_t STREAMING_HEADER_SIZE = 2 * sizeof(uint32);
+    static const size_t STREAMING_TRAILER_SIZE = 2 * sizeof(uint64) + sizeof(uint32);
+    static const size_t STREAMING_CHUNK_SIZE = 4 << 20; // 4Mb, a multiple of all element sizes
+
+    // Chunk compression of streaming checkpoints with zlib, at the fastest level: the zero or constant tensors
+    // that are common in the learner state shrink a lot, and little time is spent on the others.
+    // Returns false if the chunk does not get smaller.
+    static bool CompressChunk(const char* src, size_t size, std::vector<char>& dst)
+    {
+#ifdef CNTK_HAS_ZLIB
+        uLongf storedSize = compressBound(static_cast<uLong>(size));
+        dst.resize(storedSize);
+        if (compress2(reinterpret_cast<Bytef*>(dst.data()), &storedSize, reinterpret_cast<const Bytef*>(src), static_cast<uLong>(size), Z_BEST_SPEED) != Z_OK)
+            return false;
+        dst.resize(storedSize);
+        return storedSize < size;
+#else
+        UNUSED(src); UNUSED(size); UNUSED(dst);
+        InvalidArgument("Compressed streaming checkpoints require zlib, which this build of CNTK does not include.");
+#endif
+    }
+
+    static bool DecompressChunk(const char* src, size_t storedSize, char* dst, size_t size)
+    {
+#ifdef CNTK_HAS_ZLIB
+        uLongf rawSize = static_cast<uLongf>(size);
+        return uncompress(reinterpret_cast<Bytef*>(dst), &rawSize, reinterpret_cast<const Bytef*>(src), static_cast<uLong>(storedSize)) == Z_OK && rawSize == size;
+#else
+        UNUSED(src); UNUSED(storedSize); UNUSED(dst); UNUSED(size);
+        RuntimeError("The streaming checkpoint is compressed with zlib, which this build of CNTK does not include.");
+#endif
+    }
+
+    // Read-only file mapped as copy-on-write: pages are shared with all other processes that map the same file,
+    // and are only read from the disk when they are touched. Writes (e.g. training a loaded model) go to private copies.
+    class MappedFile
+    {
+    public:
+        MappedFile(const std::wstring& filename)
+            : m_data(nullptr), m_size(0)
+        {
+#ifdef _MSC_VER
+            m_file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            if (m_file == INVALID_HANDLE_VALUE)
+                RuntimeError("Cannot open file '%S' for reading.", filename.c_str());
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(m_file, &size))
+            {
+                CloseHandle(m_file);
+                RuntimeError("Cannot retrieve the size of file '%S'.", filename.c_str());
+            }
+            m_size = (size_t)size.QuadPart;
+
+            m_mapping = m_size > 0 ? CreateFileMapping(m_file, NULL, PAGE_WRITECOPY, 0, 0, NULL) : NULL;
+            if (m_mapping != NULL)
+                m_data = (char*)MapViewOfFile(m_mapping, FILE_MAP_COPY, 0, 0, 0);
+            if (m_data == nullptr)
+            {
+                if (m_mapping != NULL)
+                    CloseHandle(m_mapping);
+                CloseHandle(m_file);
+                RuntimeError("Could not memory map file '%S'.", filename.c_str());
+            }
+#else
+            int fd = GetFileDescriptor(filename, true);
+            struct stat sb;
+            if (fstat(fd, &sb) == -1)
+            {
+                close(fd);
+                RuntimeError("Cannot retrieve the size of file '%S'.", filename.c_str());
+            }
+            m_size = sb.st_size;
+
+            void* data = m_size > 0 ? mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+            close(fd); // the mapping keeps its own reference to the file
+            if (data == MAP_FAILED)
+                RuntimeError("Could not memory map file '%S'.", filename.c_str());
+            m_data = (char*)data;
+#endif
+        }
+
+        ~MappedFile()
+        {
+#ifdef _MSC_VER
+            UnmapViewOfFile(m_data);
+            CloseHandle(m_mapping);
+            CloseHandle(m_file);
+#else
+            munmap(m_data, m_size);
+#endif
+        }
+
+        char* Data() const { return m_data; }
+        size_t Size() const { return m_size; }
+
+    private:
+#ifdef _MSC_VER
+        HANDLE m_file;
+        HANDLE m_mapping;
+#endif
+        char* m_data;
+        size_t m_size;
+
+        MappedFile(const MappedFile&) = delete; MappedFile& operator=(const MappedFile&) = delete;
+    };
+
     static void SetUTF8Locale()
     {
 #ifndef _MSC_VER
@@ -124,6 +271,13 @@ namespace CNTK
         friend class Dictionary;
         friend class DictionaryValue;
 
+        friend void SaveMappedModel(const Dictionary& model, const std::wstring& filename);
+        friend Dictionary LoadMappedModel(const std::wstring& filename);
+
+        friend void SaveStreamingCheckpoint(Dictionary&& checkpoint, const std::wstring& filename, bool compress);
+        friend Dictionary LoadStreamingCheckpoint(const std::wstring& filename);
+        friend bool IsStreamingCheckpoint(const std::wstring& filename);
+
         Serializer(const Dictionary& dict);
         Serializer(const DictionaryValue& dict);
 
@@ -140,6 +294,7 @@ namespace CNTK
         void Copy(const DictionaryValue& src, proto::DictionaryValue& dst, Arena* arena = nullptr);
 
         void CopyNDArrayViewDataToProtos();
+        void CopyNDArrayViewDataToProto(const NDArrayView& src, proto::NDArrayView* dst);
         void WriteNDArrayViewData(io::CodedOutputStream& output);
 
         std::ostream& Write(std::ostream& stream);
@@ -158,6 +313,14 @@ namespace CNTK
 
         bool ReadNDArrayViewData(io::ZeroCopyInputStream& input);
 
+        void WriteMapped(const std::wstring& filename);
+        bool ReadMapped(const std::wstring& filename, Dictionary& dict);
+        NDArrayView* CreateMappedFromProto(const proto::NDArrayView& src, const NDShape& shape);
+
+        void WriteStreaming(const std::wstring& filename, bool compress);
+        bool ReadStreaming(const std::wstring& filename, Dictionary& dict);
+        NDArrayView* CreateStreamedFromProto(const proto::NDArrayView& src, const NDShape& shape);
+
         size_t GetTotalByteSize()
         {
             return m_byteSize + m_proto->ByteSizeLong();
@@ -344,11 +507,157 @@ namespace CNTK
             memcpy(buffer, src.data(), size * sizeof(int8_t));
         }
 
+        static const void* RawDataBuffer(const NDArrayView& src)
+        {
+            switch (src.GetDataType())
+            {
+            case DataType::Float:
+                return src.DataBuffer<float>();
+            case DataType::Double:
+                return src.DataBuffer<double>();
+            case DataType::Float16:
+                return src.DataBuffer<float16>();
+            case DataType::Int8:
+                return src.DataBuffer<int8_t>();
+            case DataType::Int16:
+                return src.DataBuffer<int16_t>();
+            default:
+                LogicError("Unsupported DataType %s", DataTypeName(src.GetDataType()));
+            }
+        }
+
+        static void* WritableRawDataBuffer(NDArrayView& dst)
+        {
+            switch (dst.GetDataType())
+            {
+            case DataType::Float:
+                return dst.WritableDataBuffer<float>();
+            case DataType::Double:
+                return dst.WritableDataBuffer<double>();
+            case DataType::Float16:
+                return dst.WritableDataBuffer<float16>();
+            case DataType::Int8:
+                return dst.WritableDataBuffer<int8_t>();
+            case DataType::Int16:
+                return dst.WritableDataBuffer<int16_t>();
+            default:
+                LogicError("Unsupported DataType %s", DataTypeName(dst.GetDataType()));
+            }
+        }
+
+        static void WriteRaw(const void* data, size_t size, io::CodedOutputStream& output)
+        {
+            // WriteRaw() takes an int.
+            const char* buffer = static_cast<const char*>(data);
+            while (size > 0)
+            {
+                size_t chunkSize = size > INT_MAX ? INT_MAX : size;
+                output.WriteRaw(buffer, (int)chunkSize);
+                buffer += chunkSize;
+                size -= chunkSize;
+            }
+        }
+
+        static void WritePadding(size_t size, io::CodedOutputStream& output)
+        {
+            static const char zeros[MAPPED_DATA_ALIGNMENT] = {};
+            assert(size < MAPPED_DATA_ALIGNMENT);
+            output.WriteRaw(zeros, (int)size);
+        }
+
+        // Writes the values of 'src' as a streaming checkpoint record, returns the byte size of the record.
+        static size_t WriteRecord(const NDArrayView& src, bool compress, io::CodedOutputStream& output)
+        {
+            auto elementSize = DataTypeSize(src.GetDataType());
+            auto byteSize = src.Shape().TotalSize() * elementSize;
+            const char* data = static_cast<const char*>(RawDataBuffer(src));
+
+            boost::crc_32_type crc;
+            std::vector<char> buffer;
+            size_t recordSize = 0;
+            for (size_t offset = 0; offset < byteSize; offset += STREAMING_CHUNK_SIZE)
+            {
+                size_t rawSize = (byteSize - offset > STREAMING_CHUNK_SIZE) ? STREAMING_CHUNK_SIZE : byteSize - offset;
+                crc.process_bytes(data + offset, rawSize);
+
+                bool compressed = compress && CompressChunk(data + offset, rawSize, buffer);
+                size_t storedSize = compressed ? buffer.size() : rawSize;
+                output.WriteLittleEndian32(static_cast<uint32>(rawSize));
+                output.WriteLittleEndian32(static_cast<uint32>(storedSize));
+                output.WriteRaw(compressed ? buffer.data() : data + offset, (int)storedSize);
+                recordSize += 2 * sizeof(uint32) + storedSize;
+            }
+
+            output.WriteLittleEndian32(crc.checksum());
+            return recordSize + sizeof(uint32);
+        }
+
+        static bool ReadLittleEndian32(std::istream& stream, uint32& value)
+        {
+            uint8 buffer[sizeof(uint32)];
+            if (!stream.read(reinterpret_cast<char*>(buffer), sizeof(buffer)))
+                return false;
+            io::CodedInputStream::ReadLittleEndian32FromArray(buffer, &value);
+            return true;
+        }
+
+        // Reads a streaming checkpoint record of 'recordSize' bytes into 'dst'. Returns false if the record is
+        // inconsistent with the shape of 'dst' or its checksum does not match.
+        static bool ReadRecord(std::istream& stream, size_t recordSize, NDArrayView& dst)
+        {
+            auto elementSize = DataTypeSize(dst.GetDataType());
+            auto byteSize = dst.Shape().TotalSize() * elementSize;
+            char* data = static_cast<char*>(WritableRawDataBuffer(dst));
+
+            boost::crc_32_type crc;
+            std::vector<char> buffer;
+            size_t position = 0;
+            for (size_t offset = 0; offset < byteSize;)
+            {
+                uint32 rawSize, storedSize;
+                if (position + 2 * sizeof(uint32) > recordSize || !ReadLittleEndian32(stream, rawSize) || !ReadLittleEndian32(stream, storedSize))
+                    return false;
+                position += 2 * sizeof(uint32);
+
+                if (rawSize == 0 || rawSize > byteSize - offset || storedSize > rawSize || position + storedSize > recordSize)
+                    return false;
+
+                if (storedSize == rawSize)
+                {
+                    if (!stream.read(data + offset, rawSize))
+                        return false;
+                }
+                else
+                {
+                    buffer.resize(storedSize);
+                    if (!stream.read(buffer.data(), storedSize) || !DecompressChunk(buffer.data(), storedSize, data + offset, rawSize))
+                        return false;
+                }
+
+                crc.process_bytes(data + offset, rawSize);
+                offset += rawSize;
+                position += storedSize;
+            }
+
+            uint32 checksum;
+            if (position + sizeof(uint32) != recordSize || !ReadLittleEndian32(stream, checksum))
+                return false;
+            return checksum == crc.checksum();
+        }
+
         UsingUTF8 m_locale;
         Arena m_arena;
         Message* m_proto;
         std::vector<std::pair<NDArrayView*, proto::NDArrayView*>> m_arrayViews;
         size_t m_byteSize {0};
+
+        // Only set while reading a memory-mapped model: the file and the position of its tensor data section.
+        std::shared_ptr<MappedFile> m_mappedFile;
+        size_t m_mappedDataOffset {0};
+
+        // Only set while reading a streaming checkpoint: the file and the end of its records.
+        std::shared_ptr<std::fstream> m_streamingFile;
+        size_t m_streamingDataEnd {0};
     };
 
 
@@ -365,32 +674,33 @@ namespace CNTK
     void Serializer::CopyNDArrayViewDataToProtos()
     {
         for (auto& pair : m_arrayViews) 
+            CopyNDArrayViewDataToProto(*(pair.first), pair.second);
+    }
+
+    void Serializer::CopyNDArrayViewDataToProto(const NDArrayView& src, proto::NDArrayView* dst)
+    {
+        if (src.GetDataType() == DataType::Float)
         {
-            const auto& src = *(pair.first);
-            auto dst = pair.second;
-            if (src.GetDataType() == DataType::Float)
-            {
-                CopyData<float>(src, dst->mutable_float_values()->mutable_value());
-            }
-            else if (src.GetDataType() == DataType::Double)
-            {
-                CopyData<double>(src, dst->mutable_double_values()->mutable_value());
-            }
-            else if (src.GetDataType() == DataType::Float16)
-            {
-                CopyData<float16, float>(src, dst->mutable_float_values()->mutable_value());
-            }
-            else if (src.GetDataType() == DataType::Int8)
-            {
-                // Directly copy the data as a byte array.
-                auto size = src.Shape().TotalSize();
-                const int8_t* buffer = src.DataBuffer<int8_t>();
-                dst->mutable_bytes_value()->set_value(buffer, size);
-            }
-            else if (src.GetDataType() == DataType::Int16)
-            {
-               CopyData<int16_t, int32>(src, dst->mutable_sint32_values()->mutable_value());
-            }
+            CopyData<float>(src, dst->mutable_float_values()->mutable_value());
+        }
+        else if (src.GetDataType() == DataType::Double)
+        {
+            CopyData<double>(src, dst->mutable_double_values()->mutable_value());
+        }
+        else if (src.GetDataType() == DataType::Float16)
+        {
+            CopyData<float16, float>(src, dst->mutable_float_values()->mutable_value());
+        }
+        else if (src.GetDataType() == DataType::Int8)
+        {
+            // Directly copy the data as a byte array.
+            auto size = src.Shape().TotalSize();
+            const int8_t* buffer = src.DataBuffer<int8_t>();
+            dst->mutable_bytes_value()->set_value(buffer, size);
+        }
+        else if (src.GetDataType() == DataType::Int16)
+        {
+            CopyData<int16_t, int32>(src, dst->mutable_sint32_values()->mutable_value());
         }
     }
 
@@ -534,6 +844,9 @@ namespace CNTK
         }
 
         std::unique_ptr<NDShape> shape(CreateFromProto(src.shape()));
+        if (src.values_case() == proto::NDArrayView::kExternalValues)
+            return m_streamingFile ? CreateStreamedFromProto(src, *shape) : CreateMappedFromProto(src, *shape);
+
         auto dataType = FromProtoType(src.data_type());
         auto storageFormat = FromProtoType(src.storage_format());
         NDArrayView* dst = new NDArrayView(dataType, storageFormat, *shape, DeviceDescriptor::CPUDevice());
@@ -876,6 +1189,275 @@ namespace CNTK
         return false;
     }
 
+    void Serializer::WriteMapped(const std::wstring& filename)
+    {
+        // Dense values go to the tensor data section, everything else is stored in the metadata as usual.
+        std::vector<std::pair<const NDArrayView*, size_t>> externalViews;
+        size_t dataSize = 0;
+        for (auto& pair : m_arrayViews)
+        {
+            const auto& src = *(pair.first);
+            if (src.GetStorageFormat() != StorageFormat::Dense)
+            {
+                CopyNDArrayViewDataToProto(src, pair.second);
+                continue;
+            }
+
+            dataSize = AlignUp(dataSize, MAPPED_DATA_ALIGNMENT);
+            auto byteSize = src.Shape().TotalSize() * DataTypeSize(src.GetDataType());
+            auto externalValues = pair.second->mutable_external_values();
+            externalValues->set_offset(dataSize);
+            externalValues->set_byte_size(byteSize);
+            externalViews.push_back({ &src, dataSize });
+            dataSize += byteSize;
+        }
+
+        size_t metadataSize = m_proto->ByteSizeLong();
+        if (metadataSize > static_cast<size_t>(INT_MAX))
+            RuntimeError("The model description exceeds 2GB without its parameters, it cannot be saved in the memory-mapped format.");
+
+        // The target may be mapped by a model loaded from it, whose parameters would change under it (or fault, if
+        // the file shrinks) if it was overwritten in place; the new file replaces the old one once it is complete.
+        std::wstring tempFilename = filename + L".tmp";
+        auto fd = GetFileDescriptor(tempFilename, false);
+        {
+            io::FileOutputStream stream(fd);
+            io::CodedOutputStream output(&stream);
+            output.WriteLittleEndian32(MAPPED_MAGIC_NUMBER);
+            output.WriteLittleEndian32(MAPPED_FORMAT_VERSION);
+            output.WriteLittleEndian64(metadataSize);
+            m_proto->SerializeToCodedStream(&output);
+
+            size_t position = MAPPED_HEADER_SIZE + metadataSize;
+            size_t dataOffset = AlignUp(position, MAPPED_DATA_ALIGNMENT);
+            for (const auto& view : externalViews)
+            {
+                auto offset = dataOffset + view.second;
+                WritePadding(offset - position, output);
+
+                auto byteSize = view.first->Shape().TotalSize() * DataTypeSize(view.first->GetDataType());
+                WriteRaw(RawDataBuffer(*view.first), byteSize, output);
+                position = offset + byteSize;
+            }
+
+            if (output.HadError())
+                RuntimeError("Failed to write the model to file '%S'.", tempFilename.c_str());
+        }
+#ifdef _MSC_VER
+        _close(fd);
+#else
+        close(fd);
+#endif
+        renameOrDie(tempFilename, filename);
+    }
+
+    bool Serializer::ReadMapped(const std::wstring& filename, Dictionary& dict)
+    {
+        auto file = std::make_shared<MappedFile>(filename);
+        if (file->Size() < MAPPED_HEADER_SIZE)
+            return false;
+
+        const uint8* header = reinterpret_cast<const uint8*>(file->Data());
+        uint32 magic, version;
+        uint64 metadataSize;
+        io::CodedInputStream::ReadLittleEndian32FromArray(header, &magic);
+        io::CodedInputStream::ReadLittleEndian32FromArray(header + sizeof(uint32), &version);
+        io::CodedInputStream::ReadLittleEndian64FromArray(header + 2 * sizeof(uint32), &metadataSize);
+        if (magic != MAPPED_MAGIC_NUMBER)
+            RuntimeError("File '%S' is not a memory-mapped CNTK model.", filename.c_str());
+        if (version > MAPPED_FORMAT_VERSION)
+            RuntimeError("Memory-mapped model format version %u of file '%S' is not supported by this version of CNTK (%u).", version, filename.c_str(), MAPPED_FORMAT_VERSION);
+        if (metadataSize > static_cast<uint64>(INT_MAX) || MAPPED_HEADER_SIZE + metadataSize > file->Size())
+            return false;
+
+        io::CodedInputStream input(header + MAPPED_HEADER_SIZE, (int)metadataSize);
+        input.SetTotalBytesLimit(INT_MAX, INT_MAX);
+        m_proto = Arena::CreateMessage<proto::Dictionary>(&m_arena);
+        if (!m_proto->ParseFromCodedStream(&input) || !input.ConsumedEntireMessage())
+            return false;
+
+        m_mappedFile = file;
+        m_mappedDataOffset = AlignUp(MAPPED_HEADER_SIZE + metadataSize, MAPPED_DATA_ALIGNMENT);
+        Copy(*dynamic_cast<proto::Dictionary*>(m_proto), dict);
+        return true;
+    }
+
+    NDArrayView* Serializer::CreateMappedFromProto(const proto::NDArrayView& src, const NDShape& shape)
+    {
+        if (!m_mappedFile || src.storage_format() != proto::NDArrayView::Dense)
+            RuntimeError("NDArrayView values stored outside of the model description can only be read from a memory-mapped model or a streaming checkpoint.");
+
+        auto dataType = FromProtoType(src.data_type());
+        const auto& externalValues = src.external_values();
+        auto byteSize = shape.TotalSize() * DataTypeSize(dataType);
+        if (externalValues.byte_size() != byteSize ||
+            m_mappedDataOffset + externalValues.offset() + byteSize > m_mappedFile->Size())
+            RuntimeError("The memory-mapped model file is corrupt: NDArrayView values are out of range.");
+
+        if (byteSize == 0)
+            return new NDArrayView(dataType, StorageFormat::Dense, shape, DeviceDescriptor::CPUDevice());
+
+        // The view refers to the mapped file directly; the matrix storage keeps the mapping alive.
+        auto data = m_mappedFile->Data() + m_mappedDataOffset + externalValues.offset();
+        NDArrayView* dst = new NDArrayView(dataType, shape, data, byteSize, DeviceDescriptor::CPUDevice());
+        dst->GetWritableMatrixBase()->SetExternalBufferOwner(m_mappedFile);
+        return dst;
+    }
+
+    void SaveMappedModel(const Dictionary& model, const std::wstring& filename)
+    {
+        Serializer(model).WriteMapped(filename);
+    }
+
+    Dictionary LoadMappedModel(const std::wstring& filename)
+    {
+        Dictionary model;
+        if (!Serializer().ReadMapped(filename, model))
+            RuntimeError("Failed to parse memory-mapped model from file '%S'.", filename.c_str());
+        return model;
+    }
+
+    void Serializer::WriteStreaming(const std::wstring& filename, bool compress)
+    {
+        auto file = GetFstream(filename, false);
+        {
+            io::OstreamOutputStream stream(file.get());
+            io::CodedOutputStream output(&stream);
+            output.WriteLittleEndian32(STREAMING_MAGIC_NUMBER);
+            output.WriteLittleEndian32(STREAMING_FORMAT_VERSION);
+
+            // Dense values go to their own records, everything else is stored in the metadata as usual.
+            size_t position = STREAMING_HEADER_SIZE;
+            for (auto& pair : m_arrayViews)
+            {
+                auto& src = *(pair.first);
+
+                // Checkpoints of a trainer alias the live values, which are brought to the CPU one at a time.
+                NDArrayViewPtr cpuCopy;
+                if (src.Device() != DeviceDescriptor::CPUDevice())
+                    cpuCopy = src.DeepClone(DeviceDescriptor::CPUDevice(), /*readOnly =*/ true);
+                const auto& values = cpuCopy ? *cpuCopy : src;
+
+                if (values.GetStorageFormat() != StorageFormat::Dense)
+                {
+                    CopyNDArrayViewDataToProto(values, pair.second);
+                    continue;
+                }
+
+                auto recordSize = WriteRecord(values, compress, output);
+                auto externalValues = pair.second->mutable_external_values();
+                externalValues->set_offset(position);
+                externalValues->set_byte_size(recordSize);
+                position += recordSize;
+
+                // The checkpoint has been handed over to us, release the values (or the alias) as soon as they are written.
+                src.m_tensorView = nullptr;
+            }
+
+            size_t metadataSize = m_proto->ByteSizeLong();
+            if (metadataSize > static_cast<size_t>(INT_MAX))
+                RuntimeError("The checkpoint description exceeds 2GB without its tensors, it cannot be saved in the streaming format.");
+
+            m_proto->SerializeToCodedStream(&output);
+            output.WriteLittleEndian64(position);
+            output.WriteLittleEndian64(metadataSize);
+            output.WriteLittleEndian32(STREAMING_MAGIC_NUMBER);
+
+            if (output.HadError())
+                RuntimeError("Failed to write the checkpoint to file '%S'.", filename.c_str());
+        }
+        file->flush();
+        if (file->fail())
+            RuntimeError("Failed to write the checkpoint to file '%S'.", filename.c_str());
+    }
+
+    bool Serializer::ReadStreaming(const std::wstring& filename, Dictionary& dict)
+    {
+        auto file = GetFstream(filename, true);
+        file->seekg(0, std::ios_base::end);
+        size_t fileSize = static_cast<size_t>(file->tellg());
+        if (fileSize < STREAMING_HEADER_SIZE + STREAMING_TRAILER_SIZE)
+            return false;
+
+        uint8 header[STREAMING_HEADER_SIZE], trailer[STREAMING_TRAILER_SIZE];
+        file->seekg(0);
+        file->read(reinterpret_cast<char*>(header), sizeof(header));
+        file->seekg(fileSize - STREAMING_TRAILER_SIZE);
+        file->read(reinterpret_cast<char*>(trailer), sizeof(trailer));
+        if (!*file)
+            return false;
+
+        uint32 magic, version, trailerMagic;
+        uint64 metadataOffset, metadataSize;
+        io::CodedInputStream::ReadLittleEndian32FromArray(header, &magic);
+        io::CodedInputStream::ReadLittleEndian32FromArray(header + sizeof(uint32), &version);
+        io::CodedInputStream::ReadLittleEndian64FromArray(trailer, &metadataOffset);
+        io::CodedInputStream::ReadLittleEndian64FromArray(trailer + sizeof(uint64), &metadataSize);
+        io::CodedInputStream::ReadLittleEndian32FromArray(trailer + 2 * sizeof(uint64), &trailerMagic);
+        if (magic != STREAMING_MAGIC_NUMBER)
+            RuntimeError("File '%S' is not a streaming CNTK checkpoint.", filename.c_str());
+        if (version > STREAMING_FORMAT_VERSION)
+            RuntimeError("Streaming checkpoint format version %u of file '%S' is not supported by this version of CNTK (%u).", version, filename.c_str(), STREAMING_FORMAT_VERSION);
+        // A missing trailer means that writing the file did not complete.
+        if (trailerMagic != STREAMING_MAGIC_NUMBER || metadataSize > static_cast<uint64>(INT_MAX) ||
+            metadataOffset < STREAMING_HEADER_SIZE || metadataOffset + metadataSize + STREAMING_TRAILER_SIZE != fileSize)
+            return false;
+
+        std::string metadata(metadataSize, '\0');
+        file->seekg(metadataOffset);
+        if (!file->read(&metadata[0], metadataSize))
+            return false;
+
+        io::CodedInputStream input(reinterpret_cast<const uint8*>(metadata.data()), (int)metadataSize);
+        input.SetTotalBytesLimit(INT_MAX, INT_MAX);
+        m_proto = Arena::CreateMessage<proto::Dictionary>(&m_arena);
+        if (!m_proto->ParseFromCodedStream(&input) || !input.ConsumedEntireMessage())
+            return false;
+
+        m_streamingFile = file;
+        m_streamingDataEnd = metadataOffset;
+        Copy(*dynamic_cast<proto::Dictionary*>(m_proto), dict);
+        m_streamingFile = nullptr;
+        return true;
+    }
+
+    NDArrayView* Serializer::CreateStreamedFromProto(const proto::NDArrayView& src, const NDShape& shape)
+    {
+        if (src.storage_format() != proto::NDArrayView::Dense)
+            RuntimeError("The streaming checkpoint is corrupt: sparse NDArrayView values are stored in a record.");
+
+        const auto& externalValues = src.external_values();
+        if (externalValues.offset() < STREAMING_HEADER_SIZE || externalValues.offset() + externalValues.byte_size() > m_streamingDataEnd)
+            RuntimeError("The streaming checkpoint is corrupt: NDArrayView values are out of range.");
+
+        std::unique_ptr<NDArrayView> dst(new NDArrayView(FromProtoType(src.data_type()), StorageFormat::Dense, shape, DeviceDescriptor::CPUDevice()));
+        m_streamingFile->seekg(externalValues.offset());
+        if (!ReadRecord(*m_streamingFile, externalValues.byte_size(), *dst))
+            RuntimeError("The streaming checkpoint is corrupt: NDArrayView values at offset %zu do not match their checksum.", (size_t)externalValues.offset());
+
+        return dst.release();
+    }
+
+    void SaveStreamingCheckpoint(Dictionary&& checkpoint, const std::wstring& filename, bool compress)
+    {
+        Serializer(checkpoint).WriteStreaming(filename, compress);
+    }
+
+    Dictionary LoadStreamingCheckpoint(const std::wstring& filename)
+    {
+        Dictionary checkpoint;
+        if (!Serializer().ReadStreaming(filename, checkpoint))
+            RuntimeError("Failed to parse streaming checkpoint from file (%ls), it is truncated or corrupt.", filename.c_str());
+        return checkpoint;
+    }
+
+    bool IsStreamingCheckpoint(const std::wstring& filename)
+    {
+        auto file = GetFstream(filename, true);
+        uint32 magic = 0;
+        return Serializer::ReadLittleEndian32(*file, magic) && magic == STREAMING_MAGIC_NUMBER;
+    }
+
     std::ostream& operator<<(std::ostream& stream, const Dictionary& dictionary)
     {
         return Serializer(dictionary).Write(stream);
@@ -39,6 +39,9 @@ namespace CNTK
     const std::wstring noiseInjectionSeedKey = L"noise_injection_seed";
     const std::wstring masterParameterUpdatedKey = L"master_parameter_updated";
     const std::wstring smoothedCountKey = L"smoothed_count";
+    const std::wstring parameterDeltasKey = L"parameter_deltas";
+    const std::wstring updatedColumnsKey = L"updated_columns";
+    const std::wstring smoothedGradientKey = L"smoothed_gradient";
     const std::wstring stateKey = L"state";
     const std::wstring rngSeedKey = L"rng_seed";
     const std::wstring rngOffsetKey = L"rng_offset";
@@ -52,6 +55,8 @@ namespace CNTK
     const std::wstring udfModuleNameKey = L"module";
     const std::wstring udfFactoryMethodNameKey = L"deserialize_method";
     const std::wstring nativeUDFKey = L"native";
+    const std::wstring maxBatchSizeForMemoryPlanKey = L"max_batch_size_for_memory_plan";
+    const std::wstring fuseTimesPlusActivationKey = L"fuse_times_plus_activation";
 
     template <typename T> 
     inline std::string GetVersionsString(size_t currentVersion, size_t dictVersion)
@@ -89,6 +94,17 @@ namespace CNTK
         }
     }
 
+    // Saves and loads a model in the memory-mapped container format (ModelFormat::CNTKv2Mapped).
+    void SaveMappedModel(const Dictionary& model, const std::wstring& filename);
+    Dictionary LoadMappedModel(const std::wstring& filename);
+
+    // Saves and loads a checkpoint in the streaming container format (CheckpointFormat::CNTKv2Streaming).
+    // The checkpoint is written tensor by tensor, and the values of its NDArrayViews are released as soon as they are on disk.
+    // Its NDArrayViews may be aliases of live values (see NDArrayViewAliasingScope), of which only the alias is released.
+    void SaveStreamingCheckpoint(Dictionary&& checkpoint, const std::wstring& filename, bool compress);
+    Dictionary LoadStreamingCheckpoint(const std::wstring& filename);
+    bool IsStreamingCheckpoint(const std::wstring& filename);
+
     // Make sure that the dictionary contains all required keys, and if it does, return version value
     // from the dictionary.
     template <typename T>
@@ -0,0 +1,189 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#include "stdafx.h"
+#include <algorithm>
+#include <cstring>
+#include "SharedParameterCache.h"
+
+namespace CNTK
+{
+    static const char* RawDataBuffer(const NDArrayView& cpuValue)
+    {
+        switch (cpuValue.GetDataType())
+        {
+        case DataType::Float:
+            return reinterpret_cast<const char*>(cpuValue.DataBuffer<float>());
+        case DataType::Double:
+            return reinterpret_cast<const char*>(cpuValue.DataBuffer<double>());
+        case DataType::Float16:
+            return reinterpret_cast<const char*>(cpuValue.DataBuffer<float16>());
+        case DataType::Int8:
+            return reinterpret_cast<const char*>(cpuValue.DataBuffer<int8_t>());
+        case DataType::Int16:
+            return reinterpret_cast<const char*>(cpuValue.DataBuffer<int16_t>());
+        default:
+            LogicError("SharedParameterCache: Unsupported data type %s.", DataTypeName(cpuValue.GetDataType()));
+        }
+    }
+
+    static size_t SizeInBytes(const NDArrayView& value)
+    {
+        return value.Shape().TotalSize() * DataTypeSize(value.GetDataType());
+    }
+
+    static NDArrayViewPtr OnCPU(const NDArrayViewPtr& value)
+    {
+        if (value->Device().Type() == DeviceKind::CPU)
+            return value;
+        return value->DeepClone(DeviceDescriptor::CPUDevice(), /*readOnly =*/ true);
+    }
+
+    // FNV-1a over 64 bit words, seeded with the data type, shape and device of the value.
+    // Collisions are resolved by comparing the content, the hash only has to be cheap and well spread.
+    static size_t ContentHash(const NDArrayView& cpuValue, const DeviceDescriptor& device)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        auto mix = [&hash](uint64_t word) { hash = (hash ^ word) * 1099511628211ULL; };
+
+        mix(static_cast<uint64_t>(cpuValue.GetDataType()));
+        for (auto dimension : cpuValue.Shape().Dimensions())
+            mix(dimension);
+        mix(static_cast<uint64_t>(device.Type()));
+        mix(device.Id());
+
+        auto data = RawDataBuffer(cpuValue);
+        auto size = SizeInBytes(cpuValue);
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            memcpy(&word, data + i, sizeof(word));
+            mix(word);
+        }
+        for (; i < size; ++i)
+            mix(static_cast<unsigned char>(data[i]));
+
+        return static_cast<size_t>(hash);
+    }
+
+    SharedParameterCache& SharedParameterCache::Instance()
+    {
+        // Never destroyed: models may still be released by other static destructors at exit.
+        static SharedParameterCache* instance = new SharedParameterCache();
+        return *instance;
+    }
+
+    bool SharedParameterCache::HaveSameContent(const NDArrayView& cpuValue, const DeviceDescriptor& device, const NDArrayViewPtr& value)
+    {
+        if (value->GetDataType() != cpuValue.GetDataType() || value->Shape() != cpuValue.Shape() || value->Device() != device)
+            return false;
+
+        auto cpuRegisteredValue = OnCPU(value);
+        return memcmp(RawDataBuffer(cpuValue), RawDataBuffer(*cpuRegisteredValue), SizeInBytes(cpuValue)) == 0;
+    }
+
+    NDArrayViewPtr SharedParameterCache::Acquire(const NDArrayViewPtr& value)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto entry = m_entries.find(value.get());
+            if (entry != m_entries.end())
+            {
+                entry->second.m_numUsers++;
+                return value;
+            }
+        }
+
+        // Hashing a large model takes a while, the other loaders need not wait for it.
+        auto cpuValue = OnCPU(value);
+        auto contentHash = ContentHash(*cpuValue, value->Device());
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto candidates = m_entriesByContent.equal_range(contentHash);
+        for (auto candidate = candidates.first; candidate != candidates.second; ++candidate)
+        {
+            auto& entry = m_entries.at(candidate->second);
+            if (HaveSameContent(*cpuValue, value->Device(), entry.m_value))
+            {
+                entry.m_numUsers++;
+                return entry.m_value;
+            }
+        }
+
+        // The first value with this content is kept; it must not change while other models use it.
+        auto shared = value->IsReadOnly() ? value : value->Alias(/*readOnly =*/ true);
+        m_entries.insert({ shared.get(), Entry{ shared, contentHash, 1 } });
+        m_entriesByContent.insert({ contentHash, shared.get() });
+        return shared;
+    }
+
+    void SharedParameterCache::Release(const NDArrayViewPtr& value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto entry = m_entries.find(value.get());
+        if (entry == m_entries.end())
+            LogicError("SharedParameterCache: Releasing a value that has not been acquired.");
+
+        if (--entry->second.m_numUsers > 0)
+            return;
+
+        auto candidates = m_entriesByContent.equal_range(entry->second.m_contentHash);
+        for (auto candidate = candidates.first; candidate != candidates.second; ++candidate)
+        {
+            if (candidate->second == value.get())
+            {
+                m_entriesByContent.erase(candidate);
+                break;
+            }
+        }
+        m_entries.erase(entry);
+    }
+
+    size_t SharedParameterCache::NumUsers(const NDArrayView* value) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto entry = m_entries.find(value);
+        return (entry == m_entries.end()) ? 0 : entry->second.m_numUsers;
+    }
+
+    SharedParameters::~SharedParameters()
+    {
+        auto& cache = SharedParameterCache::Instance();
+        for (const auto& value : m_values)
+            cache.Release(value);
+    }
+
+    FunctionPtr SharedParameters::Share(const FunctionPtr& model)
+    {
+        auto& cache = SharedParameterCache::Instance();
+        std::unordered_map<Variable, Variable> replacements;
+        auto share = [&](const Variable& variable, const NDArrayViewPtr& value)
+        {
+            if (value->GetStorageFormat() != StorageFormat::Dense || value->Shape().TotalSize() == 0)
+                return;
+
+            auto shared = cache.Acquire(value);
+            if (std::find(m_values.begin(), m_values.end(), shared) == m_values.end())
+                m_values.push_back(shared);
+            else
+                cache.Release(shared); // Identical values within the model, e.g. zero initialized biases, count as one user.
+
+            if (shared != value)
+                replacements.insert({ variable, Constant(shared, variable.Name()) });
+        };
+
+        for (const auto& parameter : model->Parameters())
+            share(parameter, parameter.Value());
+
+        for (const auto& constant : model->Constants())
+            share(constant, constant.Value());
+
+        if (replacements.empty())
+            return model;
+
+        return model->Clone(ParameterCloningMethod::Share, replacements);
+    }
+}
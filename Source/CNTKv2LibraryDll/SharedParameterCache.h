@@ -0,0 +1,72 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "CNTKLibrary.h"
+
+namespace CNTK
+{
+    ///
+    /// Process wide registry of read only parameter values, keyed by their content.
+    ///
+    /// Models loaded for evaluation hand their parameter values to the cache; a value whose content (data type,
+    /// shape, device and bytes) matches one already registered is replaced by the registered one, so that
+    /// e.g. the base weights of many fine-tuned variants of a model are kept in memory only once.
+    /// Each registered value counts its users; it is dropped from the cache when the last user releases it.
+    ///
+    class SharedParameterCache : boost::noncopyable
+    {
+    public:
+        static SharedParameterCache& Instance();
+
+        // Returns a read only value with the same content as 'value' and adds a user to it.
+        NDArrayViewPtr Acquire(const NDArrayViewPtr& value);
+
+        // Removes a user from a value returned by Acquire.
+        void Release(const NDArrayViewPtr& value);
+
+        // Number of users of the value, 0 if the value is not registered.
+        size_t NumUsers(const NDArrayView* value) const;
+
+    private:
+        SharedParameterCache() {}
+
+        struct Entry
+        {
+            NDArrayViewPtr m_value;
+            size_t m_contentHash;
+            size_t m_numUsers;
+        };
+
+        static bool HaveSameContent(const NDArrayView& cpuValue, const DeviceDescriptor& device, const NDArrayViewPtr& value);
+
+        mutable std::mutex m_mutex;
+        std::unordered_map<const NDArrayView*, Entry> m_entries;
+        std::unordered_multimap<size_t, const NDArrayView*> m_entriesByContent;
+    };
+
+    ///
+    /// Parameter values a model acquired from the SharedParameterCache. Released when the last model or
+    /// evaluator holding on to them goes away.
+    ///
+    class SharedParameters : boost::noncopyable
+    {
+    public:
+        ~SharedParameters();
+
+        // Returns the model with all its dense parameters and constants replaced by shared read only constants.
+        // The values of the returned model must not be modified; it can only be used for evaluation.
+        FunctionPtr Share(const FunctionPtr& model);
+
+    private:
+        std::vector<NDArrayViewPtr> m_values;
+    };
+}
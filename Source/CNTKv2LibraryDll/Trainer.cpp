@@ -10,6 +10,7 @@
 #include "PerformanceProfiler.h"
 #include "CompositeFunction.h"
 #include "Serialization.h"
+#include "DistributedCommunicator.h"
 
 namespace
 {
@@ -17,6 +18,10 @@ namespace
     const std::wstring learnersPropertyName = L"Learners";
     const std::wstring externalStatePropertyName = L"ExternalState";
     const std::wstring distributedStatePropertyName = L"DistributedState";
+    const std::wstring baseSampleCountPropertyName = L"BaseSampleCount";
+    const std::wstring deltaCountPropertyName = L"DeltaCount";
+    const std::wstring constantsPropertyName = L"Constants";
+    const std::wstring internalStatePropertyName = L"InternalState";
 
     // Version history:
     // 0 -- a version number before the versioning was introduced for the trainer's checkpoints.
@@ -44,7 +49,9 @@ namespace CNTK
           m_distributed(false),
           m_aggregatedTrainingLossValue(std::make_shared<Accumulator>()),
           m_aggregatedTrainingEvalCriterionValue(),
-          m_prevDistributedTotalNumSamples(0)
+          m_prevDistributedTotalNumSamples(0),
+          m_deltaCheckpointBaseSampleCount(0),
+          m_numDeltaCheckpoints(0)
     {
         std::vector<Variable> combinedFunctionArgs;
         if (m_model) // model is optional, since it may not be adding any information on top of lossFunction
@@ -405,12 +412,76 @@ namespace CNTK
         return modelFilePath + checkpointExt;
     }
 
-    void Trainer::SaveCheckpoint(const std::wstring& modelFilePath, Dictionary externalState)
+    static std::wstring GetDeltaCheckpointFilePath(const std::wstring& modelFilePath)
     {
-        auto learnersState = m_parameterLearners->CreateCheckpoint();
+        const wchar_t* deltaExt = L".delta";
+        return modelFilePath + deltaExt;
+    }
+
+    // Writes a checkpoint of the model and the trainer state. Only uses its arguments, so that it can run on a background thread.
+    static void WriteCheckpoint(const std::wstring& modelFilePath, Dictionary&& model, Dictionary&& state, CheckpointFormat format)
+    {
+        std::wstring tempModelFile = modelFilePath + L".tmp";
+        std::wstring trainerStateCheckpointFilePath = GetTrainerStateCheckpointFilePath(modelFilePath);
+        std::wstring tempCheckpointFile = trainerStateCheckpointFilePath + L".tmp";
+
+        if (format == CheckpointFormat::CNTKv2)
+        {
+            {
+                auto stream = GetFstream(tempModelFile, false);
+                *stream << model;
+                stream->flush();
+            }
+            state.Save(tempCheckpointFile);
+        }
+        else
+        {
+            bool compress = (format == CheckpointFormat::CNTKv2StreamingCompressed);
+            SaveStreamingCheckpoint(std::move(model), tempModelFile, compress);
+            SaveStreamingCheckpoint(std::move(state), tempCheckpointFile, compress);
+        }
+
+        // The return value is ignored here.
+        _wunlink(modelFilePath.c_str());
+        _wunlink(trainerStateCheckpointFilePath.c_str());
+
+        renameOrDie(tempModelFile, modelFilePath);
+        renameOrDie(tempCheckpointFile, trainerStateCheckpointFilePath);
+    }
+
+    void Trainer::SaveCheckpoint(const std::wstring& modelFilePath, Dictionary externalState, CheckpointFormat format)
+    {
+        SaveCheckpoint(modelFilePath, externalState, format, /*async =*/ false);
+    }
+
+    void Trainer::SaveCheckpointAsync(const std::wstring& modelFilePath, Dictionary externalState, CheckpointFormat format)
+    {
+        SaveCheckpoint(modelFilePath, externalState, format, /*async =*/ true);
+    }
+
+    void Trainer::WaitForPendingCheckpoint()
+    {
+        if (m_pendingCheckpoint.valid())
+            m_pendingCheckpoint.get(); // rethrows errors of the write
+    }
+
+    void Trainer::SaveCheckpoint(const std::wstring& modelFilePath, Dictionary externalState, CheckpointFormat format, bool async)
+    {
+        // At most one checkpoint is written at a time.
+        WaitForPendingCheckpoint();
+
+        // A streaming checkpoint written right away reads the parameters and the learner state while writing
+        // them, instead of taking copies first. Background writes need the copies as a snapshot.
+        bool aliasValues = !async && format != CheckpointFormat::CNTKv2;
+
+        std::vector<DictionaryValue> learnersState;
+        {
+            NDArrayViewAliasingScope aliasing(aliasValues);
+            learnersState = m_parameterLearners->CreateCheckpoint();
+        }
 
         if (!m_distributed)
-            return Save(modelFilePath, learnersState, externalState);
+            return Save(modelFilePath, std::move(learnersState), externalState, {}, format, async);
 
         auto compositeFunction = dynamic_cast<CompositeFunction*>(m_combinedTrainingFunction.get());
 
@@ -419,7 +490,8 @@ namespace CNTK
         state[externalWorkerStateKey] = externalState;
 
         // Collect distributed external state.
-        DistributedCommunicatorPtr communicator = MPICommunicator();
+        // The communicator of the learners only spans the training workers, which may be a subset of all workers in elastic training.
+        DistributedCommunicatorPtr communicator = Communicator();
         communicator->Barrier();
 
         std::vector<DictionaryPtr> remoteState;
@@ -432,42 +504,189 @@ namespace CNTK
         }
 
         if (communicator->CurrentWorker().IsMain())
-            Save(modelFilePath, learnersState, externalState, aggregatedState);
+            Save(modelFilePath, std::move(learnersState), externalState, aggregatedState, format, async);
 
         // all workers need to sync up after saving model to avoid read-after-write hazard
-        // i.e. one worker is in the middle of write while another tries to read
-        communicator->Barrier();
+        // i.e. one worker is in the middle of write while another tries to read.
+        // A background write is waited for by RestoreFromCheckpoint instead.
+        if (!async)
+            communicator->Barrier();
     }
 
-    void Trainer::Save(const std::wstring& modelFilePath, const std::vector<DictionaryValue>& learnerState, const Dictionary& externalState, const Dictionary& distributedState)
+    void Trainer::Save(const std::wstring& modelFilePath, std::vector<DictionaryValue>&& learnerState, const Dictionary& externalState, const Dictionary& distributedState, CheckpointFormat format, bool async)
     {
-        std::wstring tempModelFile = modelFilePath + L".tmp";
         Dictionary state;
         state[versionPropertyName] = trainerCheckpointVersion;
-        state[learnersPropertyName] = learnerState;
+        // The learner state can be as large as the model, move it instead of copying it.
+        state[learnersPropertyName] = std::vector<DictionaryValue>();
+        state[learnersPropertyName].Value<std::vector<DictionaryValue>>() = std::move(learnerState);
         state[externalStatePropertyName] = externalState;
         state[distributedStatePropertyName] = distributedState;
 
-        m_combinedTrainingFunction->Save(tempModelFile);
-        std::wstring trainerStateCheckpointFilePath = GetTrainerStateCheckpointFilePath(modelFilePath);
-        std::wstring tempCheckpointFile = trainerStateCheckpointFilePath + L".tmp";
+        // For a background write, the serialized model holds copies of the parameter values: together with the
+        // learner state this is a snapshot of the training state that does not change when training continues.
+        Dictionary model;
+        {
+            NDArrayViewAliasingScope aliasing(!async && format != CheckpointFormat::CNTKv2);
+            model = m_combinedTrainingFunction->Serialize();
+        }
+
+        if (!async)
+            return WriteCheckpoint(modelFilePath, std::move(model), std::move(state), format);
+
+        m_pendingCheckpoint = std::async(std::launch::async, [modelFilePath, format, model = std::move(model), state = std::move(state)]() mutable {
+            WriteCheckpoint(modelFilePath, std::move(model), std::move(state), format);
+        });
+    }
+
+    void Trainer::SaveDeltaCheckpoint(const std::wstring& modelFilePath, Dictionary externalState, size_t compactionPeriod)
+    {
+        if (m_distributed)
+            InvalidArgument("Trainer::SaveDeltaCheckpoint: Delta checkpoints are not supported in distributed training.");
+
+        std::vector<LearnerBase*> learners;
+        for (const auto& learner : m_parameterLearners->ParameterLearners())
+        {
+            auto learnerBase = dynamic_cast<LearnerBase*>(learner.get());
+            if (!learnerBase)
+                InvalidArgument("Trainer::SaveDeltaCheckpoint: Delta checkpoints are only supported for the built-in learners.");
+            learners.push_back(learnerBase);
+        }
+
+        WaitForPendingCheckpoint();
+
+        auto deltaFilePath = GetDeltaCheckpointFilePath(modelFilePath);
+        if (m_deltaCheckpointBase != modelFilePath || m_numDeltaCheckpoints >= compactionPeriod)
+        {
+            // Remove the delta of the previous full checkpoint first. If writing the new one fails,
+            // the previous full checkpoint is left behind, which is older but consistent.
+            _wunlink(deltaFilePath.c_str());
+
+            SaveCheckpoint(modelFilePath, externalState);
+
+            for (auto learner : learners)
+                learner->ResetUpdatedColumns();
+
+            m_deltaCheckpointBase = modelFilePath;
+            m_deltaCheckpointBaseSampleCount = TotalNumberOfSamplesSeen();
+            m_numDeltaCheckpoints = 0;
+            return;
+        }
+
+        // Each delta holds all changes since the full checkpoint, so only the latest one is kept.
+        std::vector<DictionaryValue> learnerDeltas;
+        for (auto learner : learners)
+            learnerDeltas.push_back(learner->CreateDeltaCheckpoint());
+
+        // E.g. the running statistics of batch normalization.
+        Dictionary constants;
+        for (const auto& constant : m_combinedTrainingFunction->Constants())
+        {
+            if (!constant.Value()->IsReadOnly())
+                constants[constant.Uid()] = *constant.Value();
+        }
 
-        state.Save(tempCheckpointFile);
+        auto compositeFunction = dynamic_cast<CompositeFunction*>(m_combinedTrainingFunction.get());
+
+        Dictionary state;
+        state[versionPropertyName] = trainerCheckpointVersion;
+        state[baseSampleCountPropertyName] = m_deltaCheckpointBaseSampleCount;
+        state[deltaCountPropertyName] = m_numDeltaCheckpoints + 1;
+        state[learnersPropertyName] = learnerDeltas;
+        state[constantsPropertyName] = constants;
+        state[internalStatePropertyName] = compositeFunction->GetInternalState();
+        state[externalStatePropertyName] = externalState;
+
+        std::wstring tempDeltaFile = deltaFilePath + L".tmp";
+        state.Save(tempDeltaFile);
 
         // The return value is ignored here.
-        _wunlink(modelFilePath.c_str());
-        _wunlink(trainerStateCheckpointFilePath.c_str());
+        _wunlink(deltaFilePath.c_str());
+        renameOrDie(tempDeltaFile, deltaFilePath);
 
-        renameOrDie(tempModelFile, modelFilePath);
-        renameOrDie(tempCheckpointFile, trainerStateCheckpointFilePath);
+        m_numDeltaCheckpoints++;
+    }
+
+    Dictionary Trainer::RestoreFromDeltaCheckpoint(const std::wstring& modelFilePath, const Dictionary& externalState, bool isDeltaCheckpointBase)
+    {
+        auto deltaFilePath = GetDeltaCheckpointFilePath(modelFilePath);
+        if (!fexists(deltaFilePath))
+        {
+            // This trainer has written the full checkpoint and no delta since then: continue writing deltas against it.
+            if (isDeltaCheckpointBase && TotalNumberOfSamplesSeen() == m_deltaCheckpointBaseSampleCount)
+            {
+                for (const auto& learner : m_parameterLearners->ParameterLearners())
+                    dynamic_cast<LearnerBase*>(learner.get())->ResetUpdatedColumns();
+
+                m_deltaCheckpointBase = modelFilePath;
+                m_numDeltaCheckpoints = 0;
+            }
+
+            return externalState;
+        }
+
+        Dictionary delta = Dictionary::Load(deltaFilePath);
+
+        // A delta is removed before its full checkpoint is overwritten; check anyway, e.g. for files copied by hand.
+        auto baseSampleCount = delta[baseSampleCountPropertyName].Value<size_t>();
+        if (baseSampleCount != TotalNumberOfSamplesSeen())
+        {
+            fprintf(stderr, "WARNING: Ignoring the delta checkpoint '%ls', which does not belong to the restored checkpoint.\n", deltaFilePath.c_str());
+            return externalState;
+        }
+
+        const auto& learners = m_parameterLearners->ParameterLearners();
+        const auto& learnerDeltas = delta[learnersPropertyName].Value<std::vector<DictionaryValue>>();
+        if (learners.size() != learnerDeltas.size())
+            RuntimeError("RestoreFromCheckpoint: Number of learners (%zu) does not match learner count in the delta checkpoint (%zu).", learners.size(), learnerDeltas.size());
+
+        for (size_t i = 0; i < learners.size(); ++i)
+        {
+            auto learnerBase = dynamic_cast<LearnerBase*>(learners[i].get());
+            if (!learnerBase)
+                InvalidArgument("Trainer::RestoreFromCheckpoint: Delta checkpoints are only supported for the built-in learners.");
+            learnerBase->RestoreFromDeltaCheckpoint(learnerDeltas[i].Value<Dictionary>());
+        }
+
+        const auto& constants = delta[constantsPropertyName].Value<Dictionary>();
+        for (auto& constant : m_combinedTrainingFunction->Constants())
+        {
+            if (constant.Value()->IsReadOnly() || !constants.Contains(constant.Uid()))
+                continue;
+
+            constant.Value()->CopyFrom(constants[constant.Uid()].Value<NDArrayView>());
+            constant.RecordValueUpdate();
+        }
+
+        auto compositeFunction = dynamic_cast<CompositeFunction*>(m_combinedTrainingFunction.get());
+        compositeFunction->SetInternalState(delta[internalStatePropertyName].Value<Dictionary>());
+
+        // The learners continue tracking the changes against the same full checkpoint.
+        m_deltaCheckpointBase = modelFilePath;
+        m_deltaCheckpointBaseSampleCount = baseSampleCount;
+        m_numDeltaCheckpoints = delta[deltaCountPropertyName].Value<size_t>();
+
+        return delta[externalStatePropertyName].Value<Dictionary>();
     }
 
     Dictionary Trainer::RestoreFromCheckpoint(const std::wstring& modelFilePath)
     {
+        WaitForPendingCheckpoint();
+
+        // In distributed training, the main worker may still have been writing the checkpoint in the background.
+        if (m_distributed)
+            Communicator()->Barrier();
+
+        // The changes tracked for SaveDeltaCheckpoint no longer apply, unless the checkpoint written by it is restored.
+        bool isDeltaCheckpointBase = (m_deltaCheckpointBase == modelFilePath);
+        m_deltaCheckpointBase.clear();
+
         // Restore the model's parameters
         m_combinedTrainingFunction->Restore(modelFilePath);
 
-        Dictionary checkpoint = Dictionary::Load(GetTrainerStateCheckpointFilePath(modelFilePath));
+        auto trainerStateCheckpointFilePath = GetTrainerStateCheckpointFilePath(modelFilePath);
+        Dictionary checkpoint = IsStreamingCheckpoint(trainerStateCheckpointFilePath) ?
+            LoadStreamingCheckpoint(trainerStateCheckpointFilePath) : Dictionary::Load(trainerStateCheckpointFilePath);
 
         size_t version = 0;
 
@@ -481,12 +700,12 @@ namespace CNTK
 
         if (!m_distributed)
         {
-            return externalState;
+            return RestoreFromDeltaCheckpoint(modelFilePath, externalState, isDeltaCheckpointBase);
         }
 
         // this ensures that nobody will start writing to the model/checkpoint files, until
         // everybody is done reading them.
-        DistributedCommunicatorPtr communicator = MPICommunicator();
+        DistributedCommunicatorPtr communicator = Communicator();
         communicator->Barrier();
 
         auto mainWorkerId = std::to_wstring(0);
@@ -522,6 +741,63 @@ namespace CNTK
         return localState[externalWorkerStateKey].Value<Dictionary>();
     }
 
+    void Trainer::ResetCommunicator(const DistributedCommunicatorPtr& communicator)
+    {
+        if (!m_distributed)
+            LogicError("Trainer: the communicator can only be reset in distributed training.");
+
+        for (const auto& learner : m_parameterLearners->ParameterLearners())
+        {
+            auto distributed = std::dynamic_pointer_cast<DistributedLearner>(learner);
+            if (distributed)
+                distributed->ResetCommunicator(communicator);
+        }
+
+        ReplaceCommunicator(communicator);
+    }
+
+    Dictionary Trainer::SynchronizeState(const std::vector<DictionaryValue>& learnerState, const Dictionary& externalState, size_t rootRank)
+    {
+        auto communicator = std::dynamic_pointer_cast<MPICommunicatorImpl>(Communicator());
+        if (!communicator)
+            LogicError("Trainer: synchronizing the state of the workers requires the built-in MPI communicator.");
+
+        std::vector<NDArrayViewPtr> values;
+        for (const auto& parameter : m_combinedTrainingFunction->Parameters())
+            values.push_back(parameter.Value());
+
+        // E.g. the running statistics of batch normalization.
+        auto constants = m_combinedTrainingFunction->Constants();
+        for (const auto& constant : constants)
+            if (!constant.Value()->IsReadOnly())
+                values.push_back(constant.Value());
+
+        communicator->Broadcast(values, rootRank);
+
+        for (auto& parameter : m_combinedTrainingFunction->Parameters())
+            parameter.RecordValueUpdate();
+        for (auto& constant : constants)
+            if (!constant.Value()->IsReadOnly())
+                constant.RecordValueUpdate();
+
+        Dictionary state;
+        state[learnersPropertyName] = learnerState;
+        state[externalStatePropertyName] = externalState;
+
+        std::stringstream stream;
+        stream << state;
+        std::string encoded = stream.str();
+        communicator->Broadcast(encoded, rootRank);
+
+        if (communicator->CurrentWorker().m_globalRank == rootRank)
+            return externalState;
+
+        std::stringstream decoded(encoded);
+        decoded >> state;
+        m_parameterLearners->RestoreFromCheckpoint(state[learnersPropertyName].Value<std::vector<DictionaryValue>>());
+        return state[externalStatePropertyName].Value<Dictionary>();
+    }
+
     double Trainer::PreviousMinibatchLossAverage() const
     {
         // TODO: better return 0; it is then still valid to compute lossAverage * numSamples
@@ -35,9 +35,11 @@ namespace CNTK
         size_t checkpointFrequency,
         DataUnit checkpointFrequencyUnit,
         bool restoreFromCheckpointIfExists,
-        bool preserveAllCheckpoints) :
+        bool preserveAllCheckpoints,
+        bool asyncCheckpointing) :
         m_preserveAll(preserveAllCheckpoints),
         m_restore(restoreFromCheckpointIfExists),
+        m_async(asyncCheckpointing),
         m_fileName(checkPointFileName),
         m_frequency(checkpointFrequency),
         m_frequencyUnit(checkpointFrequencyUnit)
@@ -79,6 +81,18 @@ namespace CNTK
         m_varToStream(inputVarToStream)
     {
     }
+
+    ElasticConfig::ElasticConfig(
+        size_t frequency,
+        DataUnit frequencyUnit,
+        size_t numberOfActiveWorkers) :
+        m_frequency(frequency),
+        m_frequencyUnit(frequencyUnit),
+        m_numberOfActiveWorkers(numberOfActiveWorkers)
+    {
+        if (m_numberOfActiveWorkers == 0)
+            InvalidArgument("Number of active workers must not be zero.");
+    }
   
     CNTK_API TrainingSessionPtr CreateTrainingSession(
         const TrainerPtr& trainer,
@@ -90,7 +104,8 @@ namespace CNTK
         DataUnit progressFrequencyUnit,
         const CheckpointConfig& checkpointing,
         const CrossValidationConfig& crossValidation,
-        const TestConfig& test)
+        const TestConfig& test,
+        const ElasticConfig& elastic)
     {
         return MakeSharedObject<TrainingSession>(trainer,
             trainingSource,
@@ -99,7 +114,7 @@ namespace CNTK
             maxNumTrainingSamples,
             progressFrequency,
             progressFrequencyUnit,
-            checkpointing, crossValidation, test);
+            checkpointing, crossValidation, test, elastic);
     }
 
     TrainingSession::TrainingSession(
@@ -112,7 +127,8 @@ namespace CNTK
         DataUnit progressFrequencyUnit,
         const CheckpointConfig& checkpointing,
         const CrossValidationConfig& crossValidation,
-        const TestConfig& test) :
+        const TestConfig& test,
+        const ElasticConfig& elastic) :
         m_trainer(trainer),
         m_source(trainingSource),
         m_mbSize(minibatchSizeSchedule),
@@ -126,7 +142,10 @@ namespace CNTK
         m_workerRank(0),
         m_numberOfWorkers(1),
         m_test(test),
-        m_mbSizeScaleFactor(1)
+        m_mbSizeScaleFactor(1),
+        m_elastic(elastic),
+        m_membershipUpdateIndex(0),
+        m_leaveRequested(false)
     {
         if (!m_trainer)
             InvalidArgument("Trainer must not be null.");
@@ -154,9 +173,13 @@ namespace CNTK
                 m_workerRank = distributed->GetCommunicator()->CurrentWorker().m_globalRank;
                 m_numberOfWorkers = distributed->GetCommunicator()->Workers().size();
                 m_mbSizeScaleFactor = distributed->MinibatchSizeScaleFactor();
+                m_elasticCommunicator = distributed->GetCommunicator();
             }
         }
 
+        if (m_elastic.m_frequency != 0 && !m_elasticCommunicator)
+            InvalidArgument("Elastic training requires a distributed learner.");
+
         // Fill-in required actions.
         if (m_checkpoint.m_frequency != 0)
             m_actions.push_back({ m_checkpoint.m_frequency, m_checkpoint.m_frequencyUnit, 0, 0,
@@ -199,6 +222,17 @@ namespace CNTK
         if (IsInfinite(m_source, m_maxNumSamples))
             InvalidArgument("Train minibatch source must have a limited number of samples or sweeps.");
 
+        if (m_elastic.m_frequency != 0)
+        {
+            // Spares wait until they replace a worker that leaves, or until training finishes.
+            auto status = StartElasticTraining();
+            while (status == WorkerStatus::Spare)
+                status = UpdateMembership(WorkerStatus::Spare);
+
+            if (status != WorkerStatus::Active)
+                return;
+        }
+
         // Main train loop.
         bool earlyExit = false;
         while (shouldTrain)
@@ -238,8 +272,27 @@ namespace CNTK
                     action.unitCountWhenLastCalled = totalNumberOfUnitCounts;
                 }
             }
+
+            // Let the workers that asked for it leave and the spares replace them.
+            if (m_elastic.m_frequency != 0 && shouldTrain)
+            {
+                size_t index = Trainer()->TotalNumberOfUnitsSeen(m_elastic.m_frequencyUnit) / m_elastic.m_frequency;
+                if (index != m_membershipUpdateIndex)
+                {
+                    m_membershipUpdateIndex = index;
+                    if (UpdateMembership(m_leaveRequested ? WorkerStatus::Leaving : WorkerStatus::Active) != WorkerStatus::Active)
+                        return;
+                }
+            }
         }
 
+        // The last background checkpoint must be on disk when training is done.
+        Trainer()->WaitForPendingCheckpoint();
+
+        // Release the spares.
+        if (m_elastic.m_frequency != 0)
+            UpdateMembership(WorkerStatus::Finished);
+
         if (restoredNumberOfSamples != Trainer()->TotalNumberOfSamplesSeen())
         {
             // Let's do all actions on the last probably a partial data at the end.
@@ -415,7 +468,12 @@ namespace CNTK
         wstring checkpointFile = m_checkpoint.m_fileName;
         if (m_checkpoint.m_preserveAll)
             checkpointFile += std::to_wstring(currentIndex);
-        Trainer()->SaveCheckpoint(checkpointFile, externalState);
+
+        // With asynchronous checkpointing, OnCheckpointEnd is called once the snapshot has been taken.
+        if (m_checkpoint.m_async)
+            Trainer()->SaveCheckpointAsync(checkpointFile, externalState);
+        else
+            Trainer()->SaveCheckpoint(checkpointFile, externalState);
         OnCheckpointEnd(currentIndex);
     }
 
@@ -499,8 +557,11 @@ namespace CNTK
         fprintf(stderr, "Restoring training session from the checkpoint '%ls'\n", restoreFile.c_str());
 
         this->RestoreFromCheckpoint(restoreFile);
+        RecalculateActionIndices();
+    }
 
-        // Recalculate actions indicies.
+    void TrainingSession::RecalculateActionIndices()
+    {
         for (auto& action : m_actions)
         {
             size_t totalNumberOfUnitCounts = Trainer()->TotalNumberOfUnitsSeen(action.frequencyUnit);
@@ -508,5 +569,159 @@ namespace CNTK
             action.currentIndex = totalNumberOfUnitCounts / action.frequency;
             action.unitCountWhenLastCalled = totalNumberOfUnitCounts - totalNumberOfUnitCounts % action.frequency;
         }
+
+        if (m_elastic.m_frequency != 0)
+            m_membershipUpdateIndex = Trainer()->TotalNumberOfUnitsSeen(m_elastic.m_frequencyUnit) / m_elastic.m_frequency;
+    }
+
+    void TrainingSession::RequestLeave()
+    {
+        m_leaveRequested = true;
+    }
+
+    void TrainingSession::UpdateDistributedConfiguration()
+    {
+        for (const auto& l : m_trainer->ParameterLearners())
+        {
+            auto distributed = std::dynamic_pointer_cast<DistributedLearner>(l);
+            if (distributed)
+            {
+                m_workerRank = distributed->GetCommunicator()->CurrentWorker().m_globalRank;
+                m_numberOfWorkers = distributed->GetCommunicator()->Workers().size();
+                m_mbSizeScaleFactor = distributed->MinibatchSizeScaleFactor();
+            }
+        }
+    }
+
+    // Splits the workers into the ones that train and the spares.
+    TrainingSession::WorkerStatus TrainingSession::StartElasticTraining()
+    {
+        if (m_elastic.m_numberOfActiveWorkers >= m_elasticCommunicator->Workers().size())
+            return WorkerStatus::Active;
+
+        // The workers with the lowest ranks train. Spares are promoted in the order of their ranks,
+        // so the training workers always have lower ranks than the spares.
+        std::unordered_set<DistributedWorkerDescriptor> trainingWorkers;
+        for (const auto& worker : m_elasticCommunicator->Workers())
+            if (worker.m_globalRank < m_elastic.m_numberOfActiveWorkers)
+                trainingWorkers.insert(worker);
+
+        auto communicator = m_elasticCommunicator->SubGroup(trainingWorkers);
+        if (!communicator)
+            return WorkerStatus::Spare;
+
+        m_trainer->ResetCommunicator(communicator);
+        UpdateDistributedConfiguration();
+        return WorkerStatus::Active;
+    }
+
+    // Collective over all workers of elastic training, called at the same minibatch by all training workers.
+    // Exchanges the status of the workers, lets the workers that asked for it leave and replaces them by spares.
+    // The workers that start training take over the in-memory state of a worker that trained before.
+    // Returns the new status of the current worker: Active, Spare or Gone.
+    TrainingSession::WorkerStatus TrainingSession::UpdateMembership(WorkerStatus status)
+    {
+        auto statusValue = MakeSharedObject<NDArrayView>(static_cast<double>(status), NDShape{ 1 }, DeviceDescriptor::CPUDevice());
+        std::vector<NDArrayViewPtr> statuses;
+        m_elasticCommunicator->Concatenate(std::vector<NDArrayViewPtr>{ statusValue }, statuses, m_elasticCommunicator->Workers());
+
+        size_t numberOfWorkers = m_elasticCommunicator->Workers().size();
+        const double* buffer = statuses.front()->DataBuffer<double>();
+
+        std::vector<size_t> staying, leaving, spares;
+        for (size_t rank = 0; rank < numberOfWorkers; ++rank)
+        {
+            switch (static_cast<WorkerStatus>(static_cast<unsigned int>(buffer[rank])))
+            {
+            case WorkerStatus::Active:
+                staying.push_back(rank);
+                break;
+            case WorkerStatus::Leaving:
+                leaving.push_back(rank);
+                break;
+            case WorkerStatus::Spare:
+                spares.push_back(rank);
+                break;
+            case WorkerStatus::Finished:
+                // All training workers finish at the same minibatch.
+                return WorkerStatus::Gone;
+            default:
+                LogicError("Elastic training: unexpected worker status %d.", (int)buffer[rank]);
+            }
+        }
+
+        // Somebody has to hand the state over; the request of the first worker to leave is postponed to the next update.
+        if (staying.empty() && !leaving.empty())
+        {
+            staying.push_back(leaving.front());
+            leaving.erase(leaving.begin());
+        }
+
+        size_t numberOfPromoted = 0;
+        if (m_elastic.m_numberOfActiveWorkers > staying.size())
+            numberOfPromoted = (std::min)(spares.size(), m_elastic.m_numberOfActiveWorkers - staying.size());
+
+        if (leaving.empty() && numberOfPromoted == 0)
+            return status == WorkerStatus::Leaving ? WorkerStatus::Active : status;
+
+        bool wasTraining = status == WorkerStatus::Active || status == WorkerStatus::Leaving;
+        std::vector<DictionaryValue> learnerState;
+        Dictionary externalState;
+        if (wasTraining)
+        {
+            // Brings the training workers to a consistent state, e.g. finishes the pending model averaging.
+            learnerState = m_trainer->m_parameterLearners->CreateCheckpoint();
+            externalState[s_trainingMinibatchSource] = m_source->GetCheckpointState();
+        }
+
+        // The ranks of the remaining workers are renumbered in order.
+        std::vector<bool> isRemaining(numberOfWorkers, true);
+        for (auto rank : leaving)
+            isRemaining[rank] = false;
+        auto newRank = [&isRemaining](size_t rank) { return (size_t)std::count(isRemaining.begin(), isRemaining.begin() + rank, true); };
+
+        if (!leaving.empty())
+        {
+            std::unordered_set<DistributedWorkerDescriptor> remainingWorkers;
+            for (const auto& worker : m_elasticCommunicator->Workers())
+                if (isRemaining[worker.m_globalRank])
+                    remainingWorkers.insert(worker);
+
+            m_elasticCommunicator = m_elasticCommunicator->SubGroup(remainingWorkers);
+            if (!m_elasticCommunicator)
+                return WorkerStatus::Gone;
+        }
+
+        std::unordered_set<DistributedWorkerDescriptor> trainingWorkers;
+        for (auto rank : staying)
+            trainingWorkers.insert({ newRank(rank), L"" });
+        for (size_t i = 0; i < numberOfPromoted; ++i)
+            trainingWorkers.insert({ newRank(spares[i]), L"" });
+
+        auto communicator = m_elasticCommunicator->SubGroup(trainingWorkers);
+        if (!communicator)
+            return WorkerStatus::Spare;
+
+        m_trainer->ResetCommunicator(communicator);
+        UpdateDistributedConfiguration();
+
+        if (numberOfPromoted > 0)
+        {
+            size_t rootRank = std::count_if(trainingWorkers.begin(), trainingWorkers.end(),
+                [&](const DistributedWorkerDescriptor& w) { return w.m_globalRank < newRank(staying.front()); });
+
+            externalState = m_trainer->SynchronizeState(learnerState, externalState, rootRank);
+            if (!wasTraining)
+            {
+                m_source->RestoreFromCheckpoint(externalState[s_trainingMinibatchSource].Value<Dictionary>());
+                RecalculateActionIndices();
+            }
+        }
+
+        if (m_workerRank == 0)
+            fprintf(stderr, "Elastic training: %d workers left, %d workers joined, %d workers are training now\n",
+                    (int)leaving.size(), (int)numberOfPromoted, (int)m_numberOfWorkers);
+
+        return WorkerStatus::Active;
     }
 }
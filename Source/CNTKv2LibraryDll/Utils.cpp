@@ -37,10 +37,61 @@ namespace CNTK
         return new T(value);
     }
 
+    static thread_local size_t s_numActiveAliasingScopes = 0;
+
+    NDArrayViewAliasingScope::NDArrayViewAliasingScope(bool enabled)
+        : m_enabled(enabled)
+    {
+        if (m_enabled)
+            s_numActiveAliasingScopes++;
+    }
+
+    NDArrayViewAliasingScope::~NDArrayViewAliasingScope()
+    {
+        if (m_enabled)
+            s_numActiveAliasingScopes--;
+    }
+
+    /*static*/ bool NDArrayViewAliasingScope::IsActive()
+    {
+        return s_numActiveAliasingScopes > 0;
+    }
+
+    /*static*/ NDArrayView* Utils::NewAlias(const NDArrayView& view)
+    {
+        void* tensorView = nullptr;
+        switch (view.GetDataType())
+        {
+        case DataType::Float:
+            tensorView = new TensorView<float>(*(view.GetTensorView<float>()));
+            break;
+        case DataType::Double:
+            tensorView = new TensorView<double>(*(view.GetTensorView<double>()));
+            break;
+        case DataType::Float16:
+            tensorView = new TensorView<half>(*(view.GetTensorView<half>()));
+            break;
+        case DataType::Int8:
+            tensorView = new TensorView<char>(*(view.GetTensorView<char>()));
+            break;
+        case DataType::Int16:
+            tensorView = new TensorView<short>(*(view.GetTensorView<short>()));
+            break;
+        default:
+            LogicError("Utils::NewAlias: Unsupported DataType %s", DataTypeName(view.GetDataType()));
+            break;
+        }
+
+        return new NDArrayView(view.GetDataType(), view.Device(), view.GetStorageFormat(), view.Shape(), /*readOnly =*/ true, tensorView);
+    }
+
     template <>
     NDArrayView* CreateDataPtr<NDArrayView>(const NDArrayView& value)
     {
-        // TODO: replace this copy with an alias to value.
+        // See NDArrayViewAliasingScope.
+        if (NDArrayViewAliasingScope::IsActive())
+            return Utils::NewAlias(value);
+
         NDArrayView* viewPtr = new NDArrayView(value.GetDataType(), value.Shape(), DeviceDescriptor::CPUDevice());
         viewPtr->CopyFrom(value);
         return viewPtr;
@@ -668,9 +668,30 @@ namespace CNTK
         LearnerPtr m_metricAggregatingLearner;
     };
 
+    // While an instance is alive, NDArrayViews that are stored in a DictionaryValue on the current thread are
+    // read-only aliases of the original values instead of CPU copies. A checkpoint that is serialized in this scope
+    // does not hold a second copy of the model and the learner state, but must be written before training continues.
+    class NDArrayViewAliasingScope
+    {
+    public:
+        NDArrayViewAliasingScope(bool enabled = true);
+        ~NDArrayViewAliasingScope();
+
+        static bool IsActive();
+
+    private:
+        NDArrayViewAliasingScope(const NDArrayViewAliasingScope&) = delete;
+        NDArrayViewAliasingScope& operator=(const NDArrayViewAliasingScope&) = delete;
+
+        bool m_enabled;
+    };
+
     class Utils
     {
     public:
+        // Read-only alias of 'view' that shares its storage and is owned by the caller.
+        static NDArrayView* NewAlias(const NDArrayView& view);
+
         static Axis NewDynamicAxisDerivedFromOperand(const std::wstring& axisNamePrefix, const Variable& operand)
         {
             std::function<Variable(const Variable&)> GetActualSourceVariable;
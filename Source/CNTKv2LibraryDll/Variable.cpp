@@ -548,7 +548,9 @@ namespace CNTK
 
             // TODO: this copying here is redundant, value should be moved from the dictionary to the variable.
             // Also, the correct device should be used upfront when deserializing NDArrayView.
-            Variable var(shape, kind, dataType, value.DeepClone(device, value.IsReadOnly()), needsGradient, dynamicAxis, isSparse, name, uid);
+            // Values of a memory-mapped model are used in place, they are not copied unless they have to move to another device.
+            bool isMapped = (value.Device() == device) && value.GetMatrixBase()->HasExternalBufferOwner();
+            Variable var(shape, kind, dataType, isMapped ? value.Alias(value.IsReadOnly()) : value.DeepClone(device, value.IsReadOnly()), needsGradient, dynamicAxis, isSparse, name, uid);
             if (var.IsParameter())
                 return Parameter(var);
             else
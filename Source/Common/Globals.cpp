@@ -17,5 +17,8 @@ namespace Microsoft { namespace MSR { namespace CNTK {
     std::atomic<bool> Globals::m_enableShareNodeValueMatrices(true);
     std::atomic<bool> Globals::m_optimizeGradientAccumulation(true);
     std::atomic<bool> Globals::m_enableNodeTiming(false);
+    std::atomic<bool> Globals::m_enableParallelNodeEvaluation(false);
+    std::atomic<bool> Globals::m_enableSmallFilterConvolution(false);
     std::atomic<std::size_t> Globals::m_mpiPackThresholdInBytes(DEFAULT_PACK_THRESHOLD_SIZE_IN_BYTES);
+    std::atomic<bool> Globals::m_enableConcurrentMPICalls(false);
 }}}
@@ -62,6 +62,22 @@ ASGDHelper<ElemType>* NewASGDHelper(
     double adjustCoef = 0.2,                                                 // see in DecayCoefficient()
     size_t adjustPerMinibatches = 600,                                       //
     int traceLevel = 0,                                                      // log level
-    int syncPerfStats = 0);                                                  // shown perf data every syncPerfStats
+    int syncPerfStats = 0,                                                   // shown perf data every syncPerfStats
+    size_t maxStaleness = SIZE_MAX);                                         // max #syncs a worker may run ahead of the slowest one (built-in parameter server only)
+
+// Creates the parameter server built into CNTK, regardless of whether Multiverso is available; the arguments are those of NewASGDHelper().
+// All MPI ranks take part; the training thread must not use MPI while the helper is alive.
+template<class ElemType = float>
+ASGDHelper<ElemType>* NewLocalParameterServerHelper(
+    const std::list<ComputationNodeBasePtr> & learnableNodes,
+    size_t nodeNumRanks,
+    bool useAsyncBuffered = true,
+    bool isSimulatedModelAveragingSGD = false,
+    AdjustLearningRateAtBeginning adjusttype = AdjustLearningRateAtBeginning::None,
+    double adjustCoef = 0.2,
+    size_t adjustPerMinibatches = 600,
+    int traceLevel = 0,
+    int syncPerfStats = 0,
+    size_t maxStaleness = SIZE_MAX);
 
 }}}
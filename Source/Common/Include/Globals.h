@@ -31,8 +31,22 @@ namespace Microsoft { namespace MSR { namespace CNTK {
         static void SetNodeTiming(bool enable) { m_enableNodeTiming = enable; }
         static bool ShouldEnableNodeTiming() { return m_enableNodeTiming; }
 
+        // Evaluate independent nodes of a CPU network concurrently. Takes effect when the network's matrices are allocated.
+        static void SetParallelNodeEvaluation(bool enable) { m_enableParallelNodeEvaluation = enable; }
+        static bool ShouldEnableParallelNodeEvaluation() { return m_enableParallelNodeEvaluation; }
+
+        // Run the forward pass of CPU convolutions with 1x1 and 3x3 kernels on the Winograd and direct kernels instead of GEMM.
+        // Takes effect when the convolution engines are created, i.e. on validation.
+        static void SetSmallFilterConvolution(bool enable) { m_enableSmallFilterConvolution = enable; }
+        static bool ShouldEnableSmallFilterConvolution() { return m_enableSmallFilterConvolution; }
+
         static void SetMPIPackThreshold(std::size_t packThreholdInBytes) { m_mpiPackThresholdInBytes = packThreholdInBytes; }
         static std::size_t GetMPIPackThreshold() { return m_mpiPackThresholdInBytes; }
+
+        // Initialize MPI with MPI_THREAD_MULTIPLE instead of MPI_THREAD_SERIALIZED, for communication from background threads.
+        // Only takes effect if set before MPI is initialized.
+        static void SetConcurrentMPICalls(bool enable) { m_enableConcurrentMPICalls = enable; }
+        static bool ShouldEnableConcurrentMPICalls() { return m_enableConcurrentMPICalls; }
     private:
         static std::atomic<bool> m_forceDeterministicAlgorithms;
         // The global flag to enable matrices values in forward and backward prop
@@ -40,6 +54,9 @@ namespace Microsoft { namespace MSR { namespace CNTK {
         static std::atomic<bool> m_forceConstantRandomSeed;
         static std::atomic<bool> m_optimizeGradientAccumulation;
         static std::atomic<bool> m_enableNodeTiming;
+        static std::atomic<bool> m_enableParallelNodeEvaluation;
+        static std::atomic<bool> m_enableSmallFilterConvolution;
         static std::atomic<std::size_t> m_mpiPackThresholdInBytes;
+        static std::atomic<bool> m_enableConcurrentMPICalls;
     };
 }}}
@@ -90,9 +90,17 @@ public:
     virtual size_t MainNodeRank() const = 0;
     virtual bool IsMultiHost() const = 0;
 
+    // Creates a wrapper over the given subset of the ranks of this one; the members are renumbered in ascending order.
+    // Must be called by all ranks of this wrapper. Returns nullptr on the ranks that are not in the subset.
+    virtual MPIWrapperPtr CreateSubGroup(std::vector<size_t> ranks) const = 0;
+
     // Use GPUDirect RDMA support
     virtual bool UseGpuGdr() = 0;
 
+    // True if MPI was initialized with MPI_THREAD_MULTIPLE, i.e. different threads may communicate at the same time
+    // (each on its own communicator, see CreateSubGroup()).
+    virtual bool SupportsConcurrentCalls() const = 0;
+
     // -----------------------------------------------------------------------
     // data-exchange functions (wrappers around MPI functions)
     // -----------------------------------------------------------------------
@@ -104,6 +112,7 @@ public:
     virtual int Isend(const void* buf, int count, MPI_Datatype datatype, int dest, int tag, /*MPI_Comm comm,*/ MPI_Request* request) = 0;
     virtual int Recv(void* buf, int count, MPI_Datatype datatype, int source, int tag, /*MPI_Comm comm,*/ MPI_Status* status) = 0;
     virtual int Irecv(void* buf, int count, MPI_Datatype datatype, int source, int tag, /*MPI_Comm comm,*/ MPI_Request* request) = 0;
+    virtual int Test(MPI_Request* request, int* flag, MPI_Status* status) = 0;
     virtual int Iallreduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, /*MPI_Comm comm,*/ MPI_Request* request) = 0;
     virtual int Abort(int errorcode) = 0;
     virtual int Error_string(int errorcode, char* string, int* resultlen) = 0;
@@ -142,6 +151,10 @@ public:
     virtual void AllReduceAsync(double* sendData, double* receiveData, size_t numElements, MPI_Request* request, MPI_Op op = MPI_SUM) const = 0;
     virtual void AllReduceAsync(float* sendData, float* receiveData, size_t numElements, MPI_Request* request, MPI_Op op = MPI_SUM) const = 0;
 
+    // in-place sum of 16-bit floats (IEEE half precision or bfloat16); every partial sum is computed in fp32
+    virtual void AllReduceFloat16(unsigned short* data, size_t numElements, bool isBFloat16) const = 0;
+    virtual void AllReduceFloat16Async(unsigned short* data, size_t numElements, bool isBFloat16, MPI_Request* request) const = 0;
+
     virtual void Bcast(size_t* sendData, size_t numElements, size_t srcRank) = 0;
     virtual void Bcast(double* sendData, size_t numElements, size_t srcRank) = 0;
     virtual void Bcast(float* sendData, size_t numElements, size_t srcRank) = 0;
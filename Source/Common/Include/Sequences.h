@@ -9,6 +9,7 @@
 
 #include <vector>
 #include <memory> // for shared_ptr
+#include <atomic>
 #include <mutex>
 #include "Basics.h"
 #include "Matrix.h"
@@ -140,6 +141,7 @@ struct MBLayout
         m_timeStepHasGap = other->m_timeStepHasGap;
 
         m_columnsValidityMask.SetValue(other->m_columnsValidityMask);
+        m_columnsValidityMaskReady = !m_columnsValidityMask.IsEmpty();
         m_writable = other->m_writable;
         m_rightSplice = other->m_rightSplice;
 
@@ -167,6 +169,7 @@ struct MBLayout
         m_timeStepHasGap = std::move(other->m_timeStepHasGap);
 
         m_columnsValidityMask = std::move(other->m_columnsValidityMask);
+        m_columnsValidityMaskReady = !m_columnsValidityMask.IsEmpty();
         m_writable = other->m_writable;
         m_rightSplice = other->m_rightSplice;
 
@@ -192,6 +195,7 @@ public:
             m_timeStepHasGap.assign(m_numTimeSteps, false);
         }
         m_columnsValidityMask.Resize(0, 0); // invalidate
+        m_columnsValidityMaskReady = false;
         // reset state
         m_numFramesDeclared = 0;
         m_numGapFrames = 0;
@@ -638,6 +642,11 @@ private:
     // and 0 indicates invalid (aka MinibatchPackingFlags::NoInput)
     mutable Matrix<char> m_columnsValidityMask;
 
+    // Guard the lazy creation of m_columnsValidityMask; nodes sharing a layout may be evaluated concurrently.
+    // Once the mask exists, fetching it only reads the flag.
+    mutable std::atomic<bool> m_columnsValidityMaskReady;
+    mutable std::mutex m_columnsValidityMaskMutex;
+
     // A boolean flag indicating whether the MBLayout can be further modified
     // When it's value is false, no set operations are allowed on the MBLayout.
     // Meant to guard in lazy creation of m_columnsValidityMask.
@@ -949,6 +958,10 @@ inline const Matrix<char>& MBLayout::GetColumnsValidityMask(DEVICEID_TYPE device
 {
     CheckIsValid();
     // lazily compute the validity mask
+    if (m_columnsValidityMaskReady.load(std::memory_order_acquire))
+        return m_columnsValidityMask;
+
+    std::lock_guard<std::mutex> lock(m_columnsValidityMaskMutex);
     if (m_columnsValidityMask.IsEmpty())
     {
         assert(HasGaps() || m_rightSplice != 0); // must only be called if there are gaps
@@ -982,6 +995,7 @@ inline const Matrix<char>& MBLayout::GetColumnsValidityMask(DEVICEID_TYPE device
             m_columnsValidityMask = Matrix<char>(deviceId);
         m_columnsValidityMask.SetValue(1, nS * nT, deviceId, columnsValidityMask.data());
     }
+    m_columnsValidityMaskReady.store(true, std::memory_order_release);
     return m_columnsValidityMask;
 }
 
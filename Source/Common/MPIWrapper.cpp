@@ -5,9 +5,15 @@
 #include "Include/Basics.h"
 #include "Include/MPIWrapper.h"
 #include "Include/EnvironmentUtil.h"
+#include "Include/Globals.h"
+#include <algorithm>
+#include "../CNTKv2LibraryDll/API/HalfConverter.hpp"
 
 #if HAS_MPI
 #pragma comment(lib, "msmpi.lib")
+#ifndef MPIAPI // only MS-MPI has a calling convention for user functions
+#define MPIAPI
+#endif
 #else
 #define MPI_SUCCESS             0
 #define MPI_ERR_INTERN          1
@@ -33,6 +39,15 @@ class MPIWrapperMpi : public MPIWrapper
 
     // MPI communicator that reflects the current subset selection
     MPI_Comm m_currentComm;
+    // true for the wrappers created by CreateSubGroup(), which free their communicator
+    bool m_ownsComm;
+
+    // reduction operators for the 16-bit float all-reduce; created and freed by the instance that initialized MPI
+    MPI_Op m_float16SumOp;
+    MPI_Op m_bfloat16SumOp;
+    bool m_ownsOps;
+
+    void FreeOps();
 
     // MPI_Init() is loading the msmpi.dll. Failing to load the dll will terminate the
     // application.
@@ -48,18 +63,26 @@ class MPIWrapperMpi : public MPIWrapper
     static int s_myRank;
     static void MPIWorkaroundAtExit();
 
+    // thread support level provided by MPI_Init_thread()
+    static int s_threadSupport;
+
 public:
     MPIWrapperMpi();
 
     // Note: we don't clear the sub-communication here although we should, because in case of a crash, this prevents the EXE from terminating.
     // It's OK since this class is a singleton anyway that gets instantiated exactly once at program startup.
+    // Wrappers created by CreateSubGroup() are the exception: they own their communicator and free it.
     ~MPIWrapperMpi();
 
 private:
+    // Wraps a communicator created by CreateSubGroup(). MPI is initialized already, so this is not the singleton.
+    MPIWrapperMpi(MPI_Comm comm, const MPIWrapperMpi& parent);
+
     void Ping(const char *msg) const;
     MPI_Comm Communicator() const;
 
     void RequestNodes(const char *msg, size_t requestednodes = SIZE_MAX /*default: all*/);
+    static bool SpansMultipleHosts(MPI_Comm comm, size_t numNodes);
 
 public:
 
@@ -71,9 +94,11 @@ public:
     bool UsingAllNodes() const;
     size_t MainNodeRank() const;
     bool IsMultiHost() const;
+    virtual MPIWrapperPtr CreateSubGroup(std::vector<size_t> ranks) const override;
 
     // Use GPUDirect RDMA support
     virtual bool UseGpuGdr() override;
+    virtual bool SupportsConcurrentCalls() const override;
 
     // -----------------------------------------------------------------------
     // data-exchange functions (wrappers around MPI functions)
@@ -86,6 +111,7 @@ public:
     virtual int Isend(const void* buf, int count, MPI_Datatype datatype, int dest, int tag, /*MPI_Comm comm,*/ MPI_Request* request);
     virtual int Recv(void* buf, int count, MPI_Datatype datatype, int source, int tag, /*MPI_Comm comm,*/ MPI_Status* status);
     virtual int Irecv(void* buf, int count, MPI_Datatype datatype, int source, int tag, /*MPI_Comm comm,*/ MPI_Request* request);
+    virtual int Test(MPI_Request* request, int* flag, MPI_Status* status);
     virtual int Iallreduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, /*MPI_Comm comm,*/ MPI_Request* request);
     virtual int Abort(int errorcode);
     virtual int Error_string(int errorcode, char* string, int* resultlen);
@@ -117,6 +143,9 @@ public:
     virtual void AllReduceAsync(double* sendData, double* receiveData, size_t numElements, MPI_Request* request, MPI_Op op = MPI_SUM) const;
     virtual void AllReduceAsync(float* sendData, float* receiveData, size_t numElements, MPI_Request* request, MPI_Op op = MPI_SUM) const;
 
+    virtual void AllReduceFloat16(unsigned short* data, size_t numElements, bool isBFloat16) const;
+    virtual void AllReduceFloat16Async(unsigned short* data, size_t numElements, bool isBFloat16, MPI_Request* request) const;
+
     virtual void Bcast(size_t* sendData, size_t numElements, size_t srcRank);
     virtual void Bcast(double* sendData, size_t numElements, size_t srcRank);
     virtual void Bcast(float* sendData, size_t numElements, size_t srcRank);
@@ -169,8 +198,10 @@ public:
     bool UsingAllNodes() const;
     size_t MainNodeRank() const;
     bool IsMultiHost() const;
+    virtual MPIWrapperPtr CreateSubGroup(std::vector<size_t> ranks) const override;
     // Use GPUDirect RDMA
     virtual bool UseGpuGdr() override;
+    virtual bool SupportsConcurrentCalls() const override;
 
     // -----------------------------------------------------------------------
     // data-exchange functions (wrappers around MPI functions)
@@ -183,6 +214,7 @@ public:
     virtual int Isend(const void* buf, int count, MPI_Datatype datatype, int dest, int tag, /*MPI_Comm comm,*/ MPI_Request* request);
     virtual int Recv(void* buf, int count, MPI_Datatype datatype, int source, int tag, /*MPI_Comm comm,*/ MPI_Status* status);
     virtual int Irecv(void* buf, int count, MPI_Datatype datatype, int source, int tag, /*MPI_Comm comm,*/ MPI_Request* request);
+    virtual int Test(MPI_Request* request, int* flag, MPI_Status* status);
     virtual int Iallreduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, /*MPI_Comm comm,*/ MPI_Request* request);
     virtual int Abort(int errorcode);
     virtual int Error_string(int errorcode, char* string, int* resultlen);
@@ -214,6 +246,9 @@ public:
     virtual void AllReduceAsync(double* sendData, double* receiveData, size_t numElements, MPI_Request* request, MPI_Op op = MPI_SUM) const;
     virtual void AllReduceAsync(float* sendData, float* receiveData, size_t numElements, MPI_Request* request, MPI_Op op = MPI_SUM) const;
 
+    virtual void AllReduceFloat16(unsigned short* data, size_t numElements, bool isBFloat16) const;
+    virtual void AllReduceFloat16Async(unsigned short* data, size_t numElements, bool isBFloat16, MPI_Request* request) const;
+
     virtual void Bcast(size_t* sendData, size_t numElements, size_t srcRank);
     virtual void Bcast(double* sendData, size_t numElements, size_t srcRank);
     virtual void Bcast(float* sendData, size_t numElements, size_t srcRank);
@@ -371,9 +406,47 @@ MPI_Datatype MPIWrapper::GetDataType(size_t *)
 // -----------------------------------------------------------------------
 
 int MPIWrapperMpi::s_myRank = -1;
+int MPIWrapperMpi::s_threadSupport = MPI_THREAD_SINGLE;
+
+// MPI reduction operator that adds 16-bit floats; the operands are widened to fp32, added, and rounded back
+template <bool isBFloat16>
+static void MPIAPI SumFloat16(void* invec, void* inoutvec, int* len, MPI_Datatype*)
+{
+    const size_t chunkSize = 1024;
+    float in[chunkSize];
+    float inout[chunkSize];
+    auto in16 = static_cast<const unsigned short*>(invec);
+    auto inout16 = static_cast<unsigned short*>(inoutvec);
+    for (size_t begin = 0; begin < (size_t)*len; begin += chunkSize)
+    {
+        size_t count = std::min(chunkSize, (size_t)*len - begin);
+        if (isBFloat16)
+        {
+            ::CNTK::bfloat16ToFloat(in16 + begin, in, count);
+            ::CNTK::bfloat16ToFloat(inout16 + begin, inout, count);
+        }
+        else
+        {
+            ::CNTK::float16ToFloat(in16 + begin, in, count);
+            ::CNTK::float16ToFloat(inout16 + begin, inout, count);
+        }
+
+        for (size_t i = 0; i < count; i++)
+            inout[i] += in[i];
+
+        if (isBFloat16)
+            ::CNTK::floatToBFloat16(inout, inout16 + begin, count);
+        else
+            ::CNTK::floatToFloat16(inout, inout16 + begin, count);
+    }
+}
 
 MPIWrapperMpi::MPIWrapperMpi()
-    : m_currentComm(MPI_COMM_WORLD)
+    : m_currentComm(MPI_COMM_WORLD),
+      m_ownsComm(false),
+      m_float16SumOp(MPI_OP_NULL),
+      m_bfloat16SumOp(MPI_OP_NULL),
+      m_ownsOps(true)
 {
     static bool initialized = false;
     if (initialized)
@@ -419,6 +492,9 @@ MPIWrapperMpi::MPIWrapperMpi()
         fflush(stderr);
     }
 
+    MPI_Op_create(&SumFloat16<false>, /*commute=*/1, &m_float16SumOp) || MpiFail("MPIWrapperMpi: MPI_Op_create");
+    MPI_Op_create(&SumFloat16<true>, /*commute=*/1, &m_bfloat16SumOp) || MpiFail("MPIWrapperMpi: MPI_Op_create");
+
     // do an initial handshake
     Ping("mpihelper");
 
@@ -427,13 +503,42 @@ MPIWrapperMpi::MPIWrapperMpi()
     ::Sleep((DWORD)(500 * CurrentNodeRank()));
 }
 
-// Note: we don't clear the sub-communication here although we should, because in case of a crash, this prevents the EXE from terminating.
-// It's OK since this class is a singleton anyway that gets instantiated exactly once at program startup.
+MPIWrapperMpi::MPIWrapperMpi(MPI_Comm comm, const MPIWrapperMpi& parent)
+    : m_myName(parent.m_myName),
+      m_currentComm(comm),
+      m_ownsComm(true),
+      m_float16SumOp(parent.m_float16SumOp),
+      m_bfloat16SumOp(parent.m_bfloat16SumOp),
+      m_ownsOps(false)
+{
+    MPI_Comm_rank(comm, &m_myRank) || MpiFail("MPIWrapperMpi: MPI_Comm_rank");
+    MPI_Comm_size(comm, &m_numMPINodes) || MpiFail("MPIWrapperMpi: MPI_Comm_size");
+    m_numNodesInUse = m_numMPINodes;
+    m_multiHost = SpansMultipleHosts(comm, m_numNodesInUse);
+
+    if (GetMathLibTraceLevel() > 0)
+    {
+        fprintf(stderr, "MPIWrapperMpi: sub-group of %d nodes; we are node %d\n", (int)m_numMPINodes, (int)m_myRank);
+        fflush(stderr);
+    }
+}
+
+// Note: the singleton doesn't clear its sub-communication here although it should, because in case of a crash, this prevents the EXE from terminating.
+// It's OK since it gets instantiated exactly once at program startup. The wrappers of sub-groups, which come and go with membership changes, do free theirs.
 MPIWrapperMpi::~MPIWrapperMpi()
 {
     if (GetMathLibTraceLevel() > 0)
         fprintf(stderr, "~MPIWrapperMpi\n");
 
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (!finalized)
+    {
+        if (m_ownsComm)
+            MPI_Comm_free(&m_currentComm);
+        FreeOps();
+    }
+
     int rc = fflush(stderr);
     if (!std::uncaught_exception())
     {
@@ -456,17 +561,20 @@ int MPIWrapperMpi::MPI_Init_DL()
     int flag = 0;
     MPI_Initialized(&flag);
     if (flag)
-        return MPI_SUCCESS;
+        return MPI_Query_thread(&s_threadSupport);
 
     int argc = 0;
     char **argv = NULL;
-    // TODO(qiwye) Multiverso(parameter server) will benefit from MPI_THREAD_MULTIPLE .
+    // Serialized calls are all we need. MPI_THREAD_MULTIPLE, which some MPI implementations only provide at the cost of
+    // slower transports, is asked for only if background communication (asynchronous model averaging) was requested.
     int requiredThreadLevelSupport = MPI_THREAD_SERIALIZED;
+    int requestedThreadLevelSupport = Globals::ShouldEnableConcurrentMPICalls() ? MPI_THREAD_MULTIPLE : requiredThreadLevelSupport;
     int provided;
-    int ret = MPI_Init_thread(&argc, &argv, requiredThreadLevelSupport, &provided);
-    if (provided != requiredThreadLevelSupport)
+    int ret = MPI_Init_thread(&argc, &argv, requestedThreadLevelSupport, &provided);
+    if (provided < requiredThreadLevelSupport)
         LogicError("Failed to initialize MPI with the desired level of thread support");
 
+    s_threadSupport = provided;
     return ret;
 }
 
@@ -555,34 +663,36 @@ void MPIWrapperMpi::RequestNodes(const char *msg, size_t requestednodes /*defaul
     }
     Ping("requestnodes (after change)");
 
-    // If all ranks run on a single host, we can enable optimized communication
-    // paths (e.g. NCCL). To determine if a single machine is being used, we
-    // check that MPI_Get_processor_name matches for all ranks.
+    m_multiHost = SpansMultipleHosts(m_currentComm, m_numNodesInUse);
+
+    fprintf(stderr, "requestnodes [%s]: using %d out of %d MPI nodes on %s (%d requested); we (%d) are %s\n",
+        msg, (int)m_numNodesInUse, (int)m_numMPINodes, m_multiHost ? "multiple hosts" : "a single host",
+        (int)requestednodes, (int)CurrentNodeRank(), IsIdle() ? "out (idle)" : "in (participating)");
+    fflush(stderr);
+}
+
+// If all ranks run on a single host, we can enable optimized communication
+// paths (e.g. NCCL). To determine if a single machine is being used, we
+// check that MPI_Get_processor_name matches for all ranks.
+bool MPIWrapperMpi::SpansMultipleHosts(MPI_Comm comm, size_t numNodes)
+{
     const int nameMax = MPI_MAX_PROCESSOR_NAME + 1;
     char myName[nameMax] = { 0 };
     int  myNameLen = 0;
     MPI_Get_processor_name(myName, &myNameLen) || MpiFail("requestnodes: MPI_Get_processor_name");
     myName[myNameLen] = '\0';
 
-    std::vector<char> nameBuffer(m_numNodesInUse * nameMax);
+    std::vector<char> nameBuffer(numNodes * nameMax);
     char* allNames = nameBuffer.data();
-    MPI_Allgather(myName, nameMax, MPI_CHAR, allNames, nameMax, MPI_CHAR, m_currentComm)
+    MPI_Allgather(myName, nameMax, MPI_CHAR, allNames, nameMax, MPI_CHAR, comm)
         || MpiFail("requestnodes: MPI_Allgather");
 
-    m_multiHost = false;
-    for (size_t i = 1; i<m_numNodesInUse; i++)
+    for (size_t i = 1; i<numNodes; i++)
     {
         if (strcmp(allNames, allNames + i*nameMax) != 0)
-        {
-            m_multiHost = true;
-            break;
-        }
+            return true;
     }
-
-    fprintf(stderr, "requestnodes [%s]: using %d out of %d MPI nodes on %s (%d requested); we (%d) are %s\n",
-        msg, (int)m_numNodesInUse, (int)m_numMPINodes, m_multiHost ? "multiple hosts" : "a single host",
-        (int)requestednodes, (int)CurrentNodeRank(), IsIdle() ? "out (idle)" : "in (participating)");
-    fflush(stderr);
+    return false;
 }
 
 bool MPIWrapperMpi::IsMultiHost() const
@@ -590,6 +700,20 @@ bool MPIWrapperMpi::IsMultiHost() const
     return m_multiHost;
 }
 
+MPIWrapperPtr MPIWrapperMpi::CreateSubGroup(std::vector<size_t> ranks) const
+{
+    std::sort(ranks.begin(), ranks.end());
+    bool isMember = std::binary_search(ranks.begin(), ranks.end(), CurrentNodeRank());
+
+    // Ordering by the current rank keeps the relative order of the members.
+    MPI_Comm subComm = MPI_COMM_NULL;
+    MPI_Comm_split(m_currentComm, isMember ? 0 : MPI_UNDEFINED, m_myRank, &subComm) || MpiFail("CreateSubGroup: MPI_Comm_split");
+    if (!isMember)
+        return nullptr;
+
+    return MPIWrapperPtr(new MPIWrapperMpi(subComm, *this));
+}
+
 MPI_Comm MPIWrapperMpi::Communicator() const
 {
     return m_currentComm;
@@ -597,9 +721,22 @@ MPI_Comm MPIWrapperMpi::Communicator() const
 
 int MPIWrapperMpi::Finalize(void)
 {
+    FreeOps();
     return MPI_Finalize();
 }
 
+void MPIWrapperMpi::FreeOps()
+{
+    // wrappers of sub-groups share the operators of the instance that created them
+    if (!m_ownsOps)
+        return;
+
+    if (m_float16SumOp != MPI_OP_NULL)
+        MPI_Op_free(&m_float16SumOp);
+    if (m_bfloat16SumOp != MPI_OP_NULL)
+        MPI_Op_free(&m_bfloat16SumOp);
+}
+
 // wait for all ranks to reach here
 int MPIWrapperMpi::WaitAll()
 {
@@ -641,6 +778,11 @@ int MPIWrapperMpi::Irecv(void* buf, int count, MPI_Datatype datatype, int source
     return MPI_Irecv(buf, count, datatype, source, tag, m_currentComm, request);
 }
 
+int MPIWrapperMpi::Test(MPI_Request* request, int* flag, MPI_Status* status)
+{
+    return MPI_Test(request, flag, status);
+}
+
 int MPIWrapperMpi::Iallreduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, MPI_Request* request)
 {
     return MPI_Iallreduce(sendbuf, recvbuf, count, datatype, op, m_currentComm, request);
@@ -657,6 +799,11 @@ int MPIWrapperMpi::Error_string(int errorcode, char* str, int* resultlen)
     return MPI_Error_string(errorcode, str, resultlen);
 }
 
+bool MPIWrapperMpi::SupportsConcurrentCalls() const
+{
+    return s_threadSupport == MPI_THREAD_MULTIPLE;
+}
+
 bool MPIWrapperMpi::UseGpuGdr()
 {
     // Only support GPUDirect RDMA on Unix and built with GDR
@@ -823,6 +970,16 @@ void MPIWrapperMpi::AllReduceAsync(float *sendData, float *receiveData, size_t n
     MPI_Iallreduce(sendData, receiveData, (int)numElements, GetDataType(sendData), op, Communicator(), request) || MpiFail("AllReduceAsync: MPI_Iallreduce");
 }
 
+void MPIWrapperMpi::AllReduceFloat16(unsigned short* data, size_t numElements, bool isBFloat16) const
+{
+    MPI_Allreduce(MPI_IN_PLACE, data, (int)numElements, MPI_UNSIGNED_SHORT, isBFloat16 ? m_bfloat16SumOp : m_float16SumOp, Communicator()) || MpiFail("AllReduceFloat16: MPI_Allreduce");
+}
+
+void MPIWrapperMpi::AllReduceFloat16Async(unsigned short* data, size_t numElements, bool isBFloat16, MPI_Request* request) const
+{
+    MPI_Iallreduce(MPI_IN_PLACE, data, (int)numElements, MPI_UNSIGNED_SHORT, isBFloat16 ? m_bfloat16SumOp : m_float16SumOp, Communicator(), request) || MpiFail("AllReduceFloat16Async: MPI_Iallreduce");
+}
+
 
 void MPIWrapperMpi::Bcast(double* sendData, size_t numElements, size_t srcRank)
 {
@@ -973,6 +1130,20 @@ bool MPIWrapperEmpty::IsMultiHost() const
     return false;
 }
 
+MPIWrapperPtr MPIWrapperEmpty::CreateSubGroup(std::vector<size_t> ranks) const
+{
+    // There is only one node, so the sub-group is either this wrapper or empty.
+    if (std::find(ranks.begin(), ranks.end(), CurrentNodeRank()) == ranks.end())
+        return nullptr;
+
+    return std::const_pointer_cast<MPIWrapper>(shared_from_this());
+}
+
+bool MPIWrapperEmpty::SupportsConcurrentCalls() const
+{
+    return false;
+}
+
 bool MPIWrapperEmpty::UseGpuGdr()
 {
     return false;
@@ -1024,6 +1195,11 @@ int MPIWrapperEmpty::Irecv(void* buf, int count, MPI_Datatype datatype, int sour
     return MPI_UNDEFINED;
 }
 
+int MPIWrapperEmpty::Test(MPI_Request* request, int* flag, MPI_Status* status)
+{
+    return MPI_UNDEFINED;
+}
+
 int MPIWrapperEmpty::Iallreduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, MPI_Request* request)
 {
     return MPI_UNDEFINED;
@@ -1160,6 +1336,14 @@ void MPIWrapperEmpty::AllReduceAsync(float *sendData, float *receiveData, size_t
 {
 }
 
+void MPIWrapperEmpty::AllReduceFloat16(unsigned short* data, size_t numElements, bool isBFloat16) const
+{
+}
+
+void MPIWrapperEmpty::AllReduceFloat16Async(unsigned short* data, size_t numElements, bool isBFloat16, MPI_Request* request) const
+{
+}
+
 void MPIWrapperEmpty::Bcast(size_t* sendData, size_t numElements, size_t srcRank)
 {
 }
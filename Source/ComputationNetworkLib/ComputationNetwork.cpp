@@ -486,6 +486,7 @@ bool ComputationNetwork::IsTypicalCriterionNode(ComputationNodeBasePtr nodePtr)
         nodePtr->OperationName() == OperationNameOf(LatticeSequenceWithSoftmaxNode) ||
         nodePtr->OperationName() == OperationNameOf(CrossEntropyNode) ||
         nodePtr->OperationName() == OperationNameOf(ClassBasedCrossEntropyWithSoftmaxNode) ||
+        nodePtr->OperationName() == OperationNameOf(SampledSoftmaxWithCrossEntropyNode) ||
         nodePtr->OperationName() == OperationNameOf(ClassificationErrorNode) ||
         nodePtr->OperationName() == OperationNameOf(ForwardBackwardNode) ||
 #ifdef COMING_SOON
@@ -671,6 +672,25 @@ void ComputationNetwork::SetSeqParam(ComputationNetworkPtr net,
     }
 }
 
+/*static*/ void ComputationNetwork::SetQuantizationCalibration(ComputationNetworkPtr net, bool calibrate)
+{
+    size_t numQuantizedNodes = 0;
+    for (auto& node : net->GetAllNodes())
+    {
+        if (!node->Is<IQuantizedNode>())
+            continue;
+
+        if (calibrate)
+            node->As<IQuantizedNode>()->StartQuantizationCalibration();
+        else
+            node->As<IQuantizedNode>()->FinishQuantizationCalibration();
+        numQuantizedNodes++;
+    }
+
+    if (numQuantizedNodes == 0)
+        fprintf(stderr, "WARNING: No quantized operation found.\n");
+}
+
 /*static*/ void ComputationNetwork::SetMaxTempMemSizeForCNN(ComputationNetworkPtr net, const ComputationNodeBasePtr& criterionNode, const size_t maxTempMemSizeInSamples)
 {
     if (maxTempMemSizeInSamples > 0)
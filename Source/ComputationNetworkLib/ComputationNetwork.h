@@ -59,6 +59,7 @@ public:
         m_randomSeedOffset(0),
         m_isCompiled(false),
         m_areMatricesAllocated(false),
+        m_parallelNodeEvaluation(false),
         m_pMBLayoutOfNetwork(make_shared<MBLayout>(1, 0, ComputationNodeBase::DefaultDynamicAxisName)),
         m_environment(make_shared<ComputationEnvironment>())
     {
@@ -183,6 +184,9 @@ public:
     template <class NODESET> // version that takes multiple nodes
     void ForwardProp(const NODESET& nodes)
     {
+        if (m_parallelNodeEvaluation)
+            return ForwardPropInParallel(std::vector<ComputationNodeBasePtr>(nodes.begin(), nodes.end()));
+
         TravserseInSortedGlobalEvalOrder(nodes, [](const ComputationNodeBasePtr& node) {
             PARTraversalFlowControlNode::ForwardProp(node, FrameRange(nullptr));
         });
@@ -267,6 +271,8 @@ private:
     void VerifyIsCompiled(const char* where) const;
 public:
     void AllocateAllMatrices(const std::vector<ComputationNodeBasePtr>& evalRootNodes, const std::vector<ComputationNodeBasePtr>& outValueRootNodes, ComputationNodeBasePtr trainRootNode);
+    // Call before AllocateAllMatrices() to allocate all shared matrices upfront for minibatches of up to 'minibatchSize' samples.
+    void SetPreallocationMinibatchSize(size_t minibatchSize) { m_matrixPool.SetPreallocationMinibatchSize(minibatchSize); }
 
     // From the set of nodes extract all nodes which are used as accumulator nodes.
     std::set<ComputationNodeBasePtr> ExtractNodesWhichAccumulateResult(std::set<ComputationNodeBasePtr> nodes);
@@ -275,6 +281,18 @@ private:
     void PrintMemorySharingStructure(const std::vector<ComputationNodeBasePtr>& nodes);
     void ReleaseMatricesAfterEvalForChildren(ComputationNodeBasePtr n, std::unordered_map<ComputationNodeBasePtr, std::unordered_set<ComputationNodeBasePtr>>& parentsMap);
 
+    // -----------------------------------------------------------------------
+    // evaluation: concurrent execution of independent nodes (see Globals::SetParallelNodeEvaluation())
+    // The nodes of a traversal (top-level nodes and SEQTraversalFlowControlNodes, in evaluation order) are grouped into
+    // levels whose members do not depend on each other, nor read a common input with an MBLayout (whose gaps they may mask in place).
+    // Levels run one after the other, the nodes of a level concurrently.
+    // AllocateAllMatrices() plans memory sharing level by level, so no two nodes of a level share a matrix.
+    // -----------------------------------------------------------------------
+
+    static std::vector<std::vector<ComputationNodeBasePtr>> FormForwardPropLevels(const std::vector<ComputationNodeBasePtr>& nodes);
+    static std::vector<std::vector<ComputationNodeBasePtr>> FormBackpropLevels(const std::vector<ComputationNodeBasePtr>& nodes);
+    void ForwardPropInParallel(const std::vector<ComputationNodeBasePtr>& nodes);
+
 public:
     // -----------------------------------------------------------------------
     // evaluation: execution plan and network recurrent-loop analysis
@@ -475,6 +493,11 @@ public:
     //ComputationNodeBasePtr RemoveFeatureNode(ComputationNodeBasePtr featureNode);
     void SetLearnableNodesBelowLearningRateMultiplier(const float learningRateMultiplier, const ComputationNodeBasePtr& rootNode = nullptr);
 
+    // Replaces the dense layers Times -> Plus -> RectifiedLinear/Sigmoid/Tanh by TimesPlusActivation nodes, for inference only.
+    // Returns the replaced nodes, each mapped to the node that replaces it or to nullptr if it was merged into one.
+    template <class ElemType>
+    std::map<ComputationNodeBasePtr, ComputationNodeBasePtr> FuseTimesPlusActivation();
+
     // -----------------------------------------------------------------------
     // node access
     // -----------------------------------------------------------------------
@@ -557,6 +580,10 @@ public:
                             const bool& sMBR = false);
     static void SetMaxTempMemSizeForCNN(ComputationNetworkPtr net, const ComputationNodeBasePtr& criterionNode, const size_t maxTempMemSizeInSamples);
 
+    // Starts (calibrate = true) or finishes recording the input ranges of all quantized nodes (IQuantizedNode) in the network.
+    // Evaluating the network on sample data in between calibrates the ranges with which these nodes quantize their inputs.
+    static void SetQuantizationCalibration(ComputationNetworkPtr net, bool calibrate);
+
     // -----------------------------------------------------------------------
     // node-group access
     // -----------------------------------------------------------------------
@@ -1212,6 +1239,16 @@ protected:
         // There is currently no other constructor for inner nested PAR-traversed sub-networks, but there will be.
         PARTraversalFlowControlNode(const std::vector<shared_ptr<SEQTraversalFlowControlNode>>& recurrentInfo, const std::list<ComputationNodeBasePtr>& allNodes);
         // Base::m_nestedNodes contains all top-level nodes, in evaluation order
+
+        // Run independent nested nodes concurrently. Must only be called once memory sharing has been planned for it.
+        void EnableParallelEvaluation();
+
+    private:
+        static void Backprop(const ComputationNodeBasePtr& node, const FrameRange& fr);
+
+        bool m_parallelEvaluation = false;
+        std::vector<std::vector<ComputationNodeBasePtr>> m_forwardPropLevels; // m_nestedNodes grouped by FormForwardPropLevels()
+        std::vector<std::vector<ComputationNodeBasePtr>> m_backpropLevels;    // m_nestedNodes grouped by FormBackpropLevels()
     };
 
 public:
@@ -1277,6 +1314,10 @@ private:
     std::map<const ComputationNodeBasePtr, std::list<ComputationNodeBasePtr>> m_evalOrders; // [out node] flat depth-first traversal starting from out node
     std::map<const ComputationNodeBasePtr, ComputationNodeBasePtr> m_nestedNetworks;        // [out node] network rewritten as recursive traveral, potentially optimized; execution plan
 
+    // concurrent execution, enabled by AllocateAllMatrices()
+    bool m_parallelNodeEvaluation;
+    std::map<std::vector<ComputationNodeBasePtr>, std::vector<std::vector<ComputationNodeBasePtr>>> m_parallelForwardPropLevels; // [out nodes] cached FormForwardPropLevels() for ForwardProp(nodes)
+
     // cached quick-access list for inputs and parameters
     std::map<const ComputationNodeBasePtr, std::list<ComputationNodeBasePtr>> m_inputValues;         // [out node] -> all input nodes feeding into out node
     std::map<const ComputationNodeBasePtr, std::list<ComputationNodeBasePtr>> m_learnableParameters; // [out node] -> all parameter nodes feeding into out node
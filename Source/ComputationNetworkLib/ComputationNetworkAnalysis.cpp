@@ -23,6 +23,7 @@ namespace Microsoft { namespace MSR { namespace CNTK {
 // Helper functions
 static int DetermineLoopDirection(const std::vector<ComputationNodeBasePtr>& nestedNodes);
 static int GetRecurrenceSteppingDirection(const ComputationNodeBasePtr& node);
+static std::vector<ComputationNodeBasePtr> HoistLoopInvariantNodes(::CNTK::StrongComponent<ComputationNodeBasePtr>& component);
 
 //
 // The method below determine evaluation order, which is tricky in the presence of recurrent loops.
@@ -31,6 +32,7 @@ static int GetRecurrenceSteppingDirection(const ComputationNodeBasePtr& node);
 // It sets/updates:
 //  - m_allSEQNodes
 //  - ComputationNode::m_isPartOfLoop (exposed to outside as IsPartOfLoop())
+//  - the node order of each strong component, with nodes that do not depend on the recurrence moved to its front
 //  - the cached m_evalOrders[root], reordered to make nodes belonging to the same loop consecutive. TODO: Try not to do that.
 // It is often called before ValidateNetwork() on the roots and is called from inside ValidateNetwork() as well.
 // Note: This function does not cache anything. BuildAndValidateSubNetwork() caches, but others don't.
@@ -53,11 +55,24 @@ void ComputationNetwork::FormRecurrentLoops()
     EvaluationSort(graph, delay, strongComponents);
 
     // Update m_allSEQNodes accordingly.
+    size_t numHoistedNodes = 0;
     for (size_t i = 0; i < strongComponents.size(); ++i)
     {
-        const auto& c = strongComponents[i];
+        auto& c = strongComponents[i];
+
+        // Nodes of the component whose values do not depend on the recurrence are computed once for the whole
+        // minibatch right before the loop, instead of frame by frame inside it.
+        auto hoistedNodes = HoistLoopInvariantNodes(c);
+        for (auto node : hoistedNodes)
+            node->m_isPartOfLoop = false;
+        numHoistedNodes += hoistedNodes.size();
+
+        std::vector<ComputationNodeBasePtr> nestedNodes(c.Nodes().begin() + hoistedNodes.size(), c.Nodes().end());
+        if (std::find(hoistedNodes.begin(), hoistedNodes.end(), componentRootNodes[i]) != hoistedNodes.end())
+            componentRootNodes[i] = nestedNodes.back();
+
         SEQTraversalFlowControlNode flowControlNode(i, componentRootNodes[i]);
-        flowControlNode.m_nestedNodes = c.Nodes(); // TODO: make these two part of the constructor
+        flowControlNode.m_nestedNodes = std::move(nestedNodes); // TODO: make these two part of the constructor
         for (auto node : flowControlNode.m_nestedNodes)
             node->m_isPartOfLoop = true; // this is the only flag in ComputationNode that escapes FormRecurrentLoops()!
         flowControlNode.m_steppingDirection = DetermineLoopDirection(flowControlNode.m_nestedNodes);
@@ -74,6 +89,8 @@ void ComputationNetwork::FormRecurrentLoops()
     // log the loops
     if (TraceLevel() > 0)
     {
+        if (numHoistedNodes > 0)
+            fprintf(stderr, "\n%d loop-invariant nodes are evaluated outside of their loops.\n", (int)numHoistedNodes);
         for (auto& iter : m_allSEQNodes)
         {
             fprintf(stderr, "\nLoop[%d] --> %ls -> %d nodes\n", (int)iter->m_loopId, iter->NodeName().c_str(), (int)iter->m_nestedNodes.size());
@@ -98,6 +115,43 @@ static int GetRecurrenceSteppingDirection(const ComputationNodeBasePtr& node)
         return 0;
 }
 
+// Reorders the nodes of a strong component, which must be in loop evaluation order, such that the nodes whose
+// values do not depend on the recurrence come first, and returns those.
+// A node depends on the recurrence if it is a delay node or if it uses the value of a node in the loop that does.
+// Nodes that only take the MBLayout from a loop node (e.g. ReconcileDynamicAxis for broadcast_as()) are
+// part of the strong component, but compute the same values whether they run per frame or for the whole minibatch.
+// Since the component keeps its position in the global evaluation order, all inputs from outside the loop are
+// still evaluated before the hoisted nodes.
+static std::vector<ComputationNodeBasePtr> HoistLoopInvariantNodes(::CNTK::StrongComponent<ComputationNodeBasePtr>& component)
+{
+    std::vector<ComputationNodeBasePtr> invariantNodes;
+    std::vector<ComputationNodeBasePtr> recurrentNodes;
+    std::set<ComputationNodeBasePtr> dependsOnRecurrence;
+    for (const auto& node : component.Nodes())
+    {
+        // In loop evaluation order, all inputs in the loop precede their node, except those of delay nodes.
+        bool isRecurrent = GetRecurrenceSteppingDirection(node) != 0;
+        for (size_t i = 0; i < node->GetNumInputs() && !isRecurrent; i++)
+            isRecurrent = node->InputUsedInComputingOutputValue(i) && dependsOnRecurrence.find(node->GetInputs()[i]) != dependsOnRecurrence.end();
+
+        if (isRecurrent)
+        {
+            dependsOnRecurrence.insert(node);
+            recurrentNodes.push_back(node);
+        }
+        else
+            invariantNodes.push_back(node);
+    }
+
+    if (!invariantNodes.empty())
+    {
+        std::vector<ComputationNodeBasePtr> reordered(invariantNodes);
+        reordered.insert(reordered.end(), recurrentNodes.begin(), recurrentNodes.end());
+        component.UpdateNodeOrder(std::move(reordered));
+    }
+    return invariantNodes;
+}
+
 // set m_steppingDirection for all loops
 // TODO: Move this up to where it is used (in a separate commit since git cannot track moving and changing at the same time).
 // BUGBUG: Need to extend to multi-dimensional loop directions. Use a vector<int>.
@@ -167,6 +167,7 @@ public:
     ComputationNodePtr Logistic(const ComputationNodePtr a, const ComputationNodePtr b, const ComputationNodePtr c, const std::wstring nodeName = L"");
     ComputationNodePtr Logistic(const ComputationNodePtr a, const ComputationNodePtr b, const std::wstring nodeName = L"");
     ComputationNodePtr LookupTable(const ComputationNodePtr dictionary, const ComputationNodePtr input, const std::wstring nodeName = L"");
+    ComputationNodePtr EmbeddingLookup(const ComputationNodePtr dictionary, const ComputationNodePtr input, const std::wstring nodeName = L"");
     ComputationNodePtr MatrixL1Reg(const ComputationNodePtr a, const std::wstring nodeName = L"");
     ComputationNodePtr MatrixL2Reg(const ComputationNodePtr a, const std::wstring nodeName = L"");
     ComputationNodePtr Mean(const ComputationNodePtr a, const std::wstring nodeName = L"");
@@ -182,6 +183,7 @@ public:
     ComputationNodePtr Reciprocal(const ComputationNodePtr a, const std::wstring nodeName = L"");
     ComputationNodePtr RandomSample(const ComputationNodePtr a, const std::wstring nodeName = L"");
     ComputationNodePtr RandomSampleInclusionFrequency(const ComputationNodePtr a, const std::wstring nodeName = L"");
+    ComputationNodePtr SampledSoftmaxWithCrossEntropy(const ComputationNodePtr label, const ComputationNodePtr prediction, const ComputationNodePtr outputWeights, const ComputationNodePtr samplingWeights, size_t sizeOfSampledSet, const std::wstring nodeName = L"");
     ComputationNodePtr RectifiedLinear(const ComputationNodePtr a, const std::wstring nodeName = L"");
     ComputationNodePtr Reshape(const ComputationNodePtr a, const TensorShape& imageLayout, const std::wstring nodeName = L"");
     ComputationNodePtr RowRepeat(const ComputationNodePtr a, const size_t num_repeat, const std::wstring nodeName = L"");
@@ -9,6 +9,8 @@
 #include "ComputationNode.h"
 #include "ComputationNetwork.h"
 #include "InputAndParamNodes.h"
+#include "LinearAlgebraNodes.h"
+#include "NonlinearityNodes.h"
 #include "TrainingNodes.h"
 #include <string>
 #include <vector>
@@ -367,4 +369,85 @@ void ComputationNetwork::SetLearnableNodesBelowLearningRateMultiplier(const floa
     }
 }
 
+// replaces each dense layer activation(Times(W, x) + b) by a TimesPlusActivation node, which applies the bias and the activation
+// in the epilogue of the matrix product
+// W must be a matrix and b a vector of matching dimension, both LearnableParameters, and the Times and the Plus must not be used by
+// any other node nor be in a node group, as their values are no longer computed. The fused node has no gradient, hence this is for
+// networks that are only evaluated. The pass needs the validated shapes, and the network has to be compiled again afterwards.
+template <class ElemType>
+map<ComputationNodeBasePtr, ComputationNodeBasePtr> ComputationNetwork::FuseTimesPlusActivation()
+{
+    VerifyIsCompiled("FuseTimesPlusActivation");
+
+    // membership in a node group (e.g. being an output) counts as a use
+    map<ComputationNodeBasePtr, size_t> numUses;
+    for (const auto& nameAndNode : m_nameToNodeMap)
+    {
+        for (const auto& input : nameAndNode.second->GetInputs())
+            numUses[input]++;
+    }
+    for (auto group : GetAllNodeGroups())
+    {
+        for (const auto& node : *group)
+            numUses[node]++;
+    }
+
+    vector<ComputationNodeBasePtr> activations;
+    for (const auto& nameAndNode : m_nameToNodeMap)
+    {
+        const auto& operationName = nameAndNode.second->OperationName();
+        if (operationName == OperationNameOf(RectifiedLinearNode) || operationName == OperationNameOf(SigmoidNode) || operationName == OperationNameOf(TanhNode))
+            activations.push_back(nameAndNode.second);
+    }
+
+    map<ComputationNodeBasePtr, ComputationNodeBasePtr> replacedNodes;
+    for (const auto& activation : activations)
+    {
+        auto plus = activation->Input(0);
+        if (plus->OperationName() != OperationNameOf(PlusNode) || numUses[plus] != 1)
+            continue;
+
+        size_t timesIndex = (plus->Input(0)->OperationName() == OperationNameOf(TimesNode)) ? 0 : 1;
+        auto times = plus->Input(timesIndex);
+        auto bias = plus->Input(1 - timesIndex);
+        auto timesNode = dynamic_pointer_cast<TimesNode<ElemType>>(times);
+        if (!timesNode || numUses[times] != 1 || timesNode->OutputRank() != 1 || timesNode->InferInputRankToMap() != TimesNode<ElemType>::NoInferredInputRank)
+            continue;
+
+        auto weights = times->Input(0);
+        auto input = times->Input(1);
+        if (weights->OperationName() != OperationNameOf(LearnableParameter) || weights->HasMBLayout() ||
+            bias->OperationName() != OperationNameOf(LearnableParameter) || bias->HasMBLayout())
+            continue;
+
+        // the bias must not broadcast the product into more dimensions
+        const auto& weightsShape = weights->GetSampleLayout();
+        const auto& biasShape = bias->GetSampleLayout();
+        if (weightsShape.GetRank() != 2 || times->GetSampleLayout() != TensorShape(weightsShape[0]) || plus->GetSampleLayout() != biasShape ||
+            biasShape.GetRank() == 0 || biasShape[0] != weightsShape[0] || biasShape.GetNumElements() != weightsShape[0] || plus->GetMBLayout() != times->GetMBLayout())
+            continue;
+
+        // the fused node takes over the name and the uses of the activation
+        auto fused = New<TimesPlusActivationNode<ElemType>>(activation->GetDeviceId(), activation->NodeName(), activation->OperationName());
+        ChangeNodeInputs(activation, fused);
+        for (auto group : GetAllNodeGroups())
+            std::replace(group->begin(), group->end(), activation, (ComputationNodeBasePtr)fused);
+
+        DeleteNode(activation->NodeName());
+        DeleteNode(plus->NodeName());
+        DeleteNode(times->NodeName());
+        AddNodeToNetAndAttachInputs(fused, { weights, input, bias });
+
+        replacedNodes[activation] = fused;
+        replacedNodes[plus] = nullptr;
+        replacedNodes[times] = nullptr;
+    }
+
+    return replacedNodes;
+}
+
+template map<ComputationNodeBasePtr, ComputationNodeBasePtr> ComputationNetwork::FuseTimesPlusActivation<float>();
+template map<ComputationNodeBasePtr, ComputationNodeBasePtr> ComputationNetwork::FuseTimesPlusActivation<double>();
+template map<ComputationNodeBasePtr, ComputationNodeBasePtr> ComputationNetwork::FuseTimesPlusActivation<half>();
+
 }}}
@@ -18,6 +18,10 @@
 #include <set>
 #include <algorithm>
 #include <map>
+#include <unordered_map>
+#include <functional>
+#include <exception>
+#include <mutex>
 
 using namespace std;
 
@@ -117,7 +121,7 @@ static bool DumpNode(ComputationNodeBasePtr nodep, bool dumpGradient);
 ComputationNetwork::PARTraversalFlowControlNode::PARTraversalFlowControlNode(const std::vector<shared_ptr<SEQTraversalFlowControlNode>>& recurrentInfo, const std::list<ComputationNodeBasePtr>& allNodes /*must be in eval order*/)
 {
     // traverse the network in evaluation order and create a new list that replaces all recurrence by a SEQTraversalFlowControlNode
-    set<shared_ptr<IComputationNode>> loopsSeen; // for consistency check only
+    std::set<shared_ptr<IComputationNode>> loopsSeen; // for consistency check only
     for (auto nodeIter = allNodes.begin(); nodeIter != allNodes.end();)
     {
         shared_ptr<SEQTraversalFlowControlNode> recInfo = FindInRecurrentLoops(recurrentInfo, *nodeIter); // check if this node participates in a recurrent loop
@@ -160,8 +164,43 @@ ComputationNetwork::PARTraversalFlowControlNode::PARTraversalFlowControlNode(con
 }
 
 
+// Runs 'action' on the nodes of a level, concurrently if there is more than one.
+// While several nodes run, the OpenMP regions of their math are nested and run single-threaded,
+// so wide levels spread their nodes over the cores and levels of a single node parallelize its math as usual.
+static void ForEachNodeInParallel(const vector<ComputationNodeBasePtr>& nodes, const function<void(const ComputationNodeBasePtr&)>& action)
+{
+    if (nodes.size() == 1)
+        return action(nodes.front());
+
+    exception_ptr firstException;
+    mutex exceptionMutex;
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int i = 0; i < (int)nodes.size(); i++)
+    {
+        try
+        {
+            action(nodes[i]);
+        }
+        catch (...) // exceptions must not leave the parallel region
+        {
+            lock_guard<mutex> lock(exceptionMutex);
+            if (!firstException)
+                firstException = current_exception();
+        }
+    }
+    if (firstException)
+        rethrow_exception(firstException);
+}
+
 /*virtual*/ void ComputationNetwork::PARTraversalFlowControlNode::ForwardProp(const FrameRange& fr) /*override*/
 {
+    if (m_parallelEvaluation)
+    {
+        for (auto& level : m_forwardPropLevels)
+            ForEachNodeInParallel(level, [&fr](const ComputationNodeBasePtr& node) { ForwardProp(node, fr); });
+        return;
+    }
+
     for (auto& node : m_nestedNodes)
         ForwardProp(node, fr);
 }
@@ -177,24 +216,39 @@ ComputationNetwork::PARTraversalFlowControlNode::PARTraversalFlowControlNode(con
         PostForwardAndBackProp(node);
 }
 
+/*static*/ void ComputationNetwork::PARTraversalFlowControlNode::Backprop(const ComputationNodeBasePtr& node, const FrameRange& fr)
+{
+    node->BeginBackprop();
+    node->BeginTiming(true /*backward*/);
+    node->Backprop(fr.WithLayout(node->GetMBLayout()), true /*childrenInThisLoop*/, true /*childrenInOuterLoop*/);
+    node->EndTiming(true /*backward*/);
+    node->EndBackprop();
+
+    // Extreme Tracing, part 2/4
+    if (node->HasEnvironmentPtr() && node->Environment().ShouldDumpNode() && node->NeedsGradient())
+        DumpNode(node, /*dumpGradient=*/true);
+}
+
 /*virtual*/ void ComputationNetwork::PARTraversalFlowControlNode::Backprop(const FrameRange& fr, bool childrenInThisLoop, bool childrenInOuterLoop) /*override*/
 {
     childrenInThisLoop, childrenInOuterLoop; // TODO: think through what these mean when coming from PAR mode
-    // process nodes in pre-determined order
-    for (auto pnode = m_nestedNodes.rbegin(); pnode != m_nestedNodes.rend(); pnode++) // iterate backwards over evaluation order
+    if (m_parallelEvaluation)
     {
-        auto& node = *pnode;
+        for (auto& level : m_backpropLevels)
+            ForEachNodeInParallel(level, [&fr](const ComputationNodeBasePtr& node) { Backprop(node, fr); });
+        return;
+    }
 
-        node->BeginBackprop();
-        node->BeginTiming(true /*backward*/);
-        node->Backprop(fr.WithLayout(node->GetMBLayout()), true /*childrenInThisLoop*/, true /*childrenInOuterLoop*/);
-        node->EndTiming(true /*backward*/);
-        node->EndBackprop();
+    // process nodes in pre-determined order
+    for (auto pnode = m_nestedNodes.rbegin(); pnode != m_nestedNodes.rend(); pnode++) // iterate backwards over evaluation order
+        Backprop(*pnode, fr);
+}
 
-        // Extreme Tracing, part 2/4
-        if (node->HasEnvironmentPtr() && node->Environment().ShouldDumpNode() && node->NeedsGradient())
-            DumpNode(node, /*dumpGradient=*/true);
-    }
+void ComputationNetwork::PARTraversalFlowControlNode::EnableParallelEvaluation()
+{
+    m_forwardPropLevels = FormForwardPropLevels(m_nestedNodes);
+    m_backpropLevels = FormBackpropLevels(m_nestedNodes);
+    m_parallelEvaluation = true;
 }
 /*virtual*/ void ComputationNetwork::PARTraversalFlowControlNode::RequestMatricesBeforeForwardProp(MatrixPool& matrixPool) /*override*/
 {
@@ -212,6 +266,194 @@ ComputationNetwork::PARTraversalFlowControlNode::PARTraversalFlowControlNode(con
 {
 }
 
+// -----------------------------------------------------------------------
+// concurrent execution of independent nodes
+// -----------------------------------------------------------------------
+
+// The nodes that are computed by each entry of a traversal: the entry itself, or the nodes of a loop.
+static unordered_map<ComputationNodeBasePtr, ComputationNodeBasePtr> MapToTraversalEntries(const vector<ComputationNodeBasePtr>& entries,
+                                                                                           const function<const vector<ComputationNodeBasePtr>&(const ComputationNodeBasePtr&)>& nestedNodes)
+{
+    unordered_map<ComputationNodeBasePtr, ComputationNodeBasePtr> entryOf;
+    for (const auto& entry : entries)
+    {
+        for (const auto& node : nestedNodes(entry))
+            entryOf[node] = entry;
+    }
+    return entryOf;
+}
+
+// Entries whose nodes are inputs of the nodes of 'entry'. For a loop these are the inputs from outside the loop.
+static vector<ComputationNodeBasePtr> InputEntries(const ComputationNodeBasePtr& entry, const unordered_map<ComputationNodeBasePtr, ComputationNodeBasePtr>& entryOf,
+                                                   const function<const vector<ComputationNodeBasePtr>&(const ComputationNodeBasePtr&)>& nestedNodes)
+{
+    vector<ComputationNodeBasePtr> inputEntries;
+    for (const auto& node : nestedNodes(entry))
+    {
+        for (const auto& input : node->GetInputs())
+        {
+            auto inputEntry = entryOf.find(input);
+            if (inputEntry != entryOf.end() && inputEntry->second != entry)
+                inputEntries.push_back(inputEntry->second);
+        }
+    }
+    return inputEntries;
+}
+
+// Inputs with an MBLayout that the nodes of 'entry' read, other than those computed by 'entry' itself.
+// Nodes mask the gaps of such inputs in place (MaskedValueFor(), MaskMissingValueColumnsTo()), not necessarily to the
+// same value (e.g. the neutral value of a reduction, or -1 for Gather), so two readers must not run concurrently.
+static vector<ComputationNodeBasePtr> InputsWithGaps(const ComputationNodeBasePtr& entry, const unordered_map<ComputationNodeBasePtr, ComputationNodeBasePtr>& entryOf,
+                                                     const function<const vector<ComputationNodeBasePtr>&(const ComputationNodeBasePtr&)>& nestedNodes)
+{
+    vector<ComputationNodeBasePtr> inputs;
+    for (const auto& node : nestedNodes(entry))
+    {
+        for (const auto& input : node->GetInputs())
+        {
+            auto inputEntry = entryOf.find(input);
+            if (input->HasMBLayout() && (inputEntry == entryOf.end() || inputEntry->second != entry))
+                inputs.push_back(input);
+        }
+    }
+    return inputs;
+}
+
+// Moves 'level' past the levels in which other readers of the same inputs with gaps run, and reserves it for this reader.
+static size_t SerializeReadersOfInputsWithGaps(size_t level, const vector<ComputationNodeBasePtr>& inputs, unordered_map<ComputationNodeBasePtr, size_t>& firstFreeLevelOfInput)
+{
+    for (const auto& input : inputs)
+    {
+        auto firstFreeLevel = firstFreeLevelOfInput.find(input);
+        if (firstFreeLevel != firstFreeLevelOfInput.end())
+            level = max(level, firstFreeLevel->second);
+    }
+    for (const auto& input : inputs)
+        firstFreeLevelOfInput[input] = level + 1;
+    return level;
+}
+
+// Each node goes into the level after the last one of its inputs.
+// Nodes that read the same input with an MBLayout go into different levels, in the sequential order, since they may mask it.
+/*static*/ vector<vector<ComputationNodeBasePtr>> ComputationNetwork::FormForwardPropLevels(const vector<ComputationNodeBasePtr>& nodes)
+{
+    vector<ComputationNodeBasePtr> single(1);
+    auto nestedNodes = [&single](const ComputationNodeBasePtr& entry) -> const vector<ComputationNodeBasePtr>&
+    {
+        if (entry->Is<SEQTraversalFlowControlNode>())
+            return entry->As<SEQTraversalFlowControlNode>()->m_nestedNodes;
+        single[0] = entry;
+        return single;
+    };
+    auto entryOf = MapToTraversalEntries(nodes, nestedNodes);
+
+    vector<vector<ComputationNodeBasePtr>> levels;
+    unordered_map<ComputationNodeBasePtr, size_t> levelOf;
+    unordered_map<ComputationNodeBasePtr, size_t> firstFreeLevelOfInput;
+    for (const auto& node : nodes)
+    {
+        size_t level = 0;
+        for (const auto& input : InputEntries(node, entryOf, nestedNodes))
+            level = max(level, levelOf[input] + 1);
+        level = SerializeReadersOfInputsWithGaps(level, InputsWithGaps(node, entryOf, nestedNodes), firstFreeLevelOfInput);
+
+        levelOf[node] = level;
+        if (levels.size() <= level)
+            levels.resize(level + 1);
+        levels[level].push_back(node);
+    }
+    return levels;
+}
+
+// Each node goes into the level after the last one of the nodes that consume it, since these provide its gradient.
+// Nodes that write the same gradient matrix, by accumulating into a common input or through a gradient shared
+// with their parent (ParentGradientOptimization::Reuse), are put into different levels, in the sequential order.
+// This keeps the results identical to sequential execution. As in forward prop, readers of the same input with an
+// MBLayout are serialized, since gradient computations may mask input values as well.
+/*static*/ vector<vector<ComputationNodeBasePtr>> ComputationNetwork::FormBackpropLevels(const vector<ComputationNodeBasePtr>& nodes)
+{
+    vector<ComputationNodeBasePtr> single(1);
+    auto nestedNodes = [&single](const ComputationNodeBasePtr& entry) -> const vector<ComputationNodeBasePtr>&
+    {
+        if (entry->Is<SEQTraversalFlowControlNode>())
+            return entry->As<SEQTraversalFlowControlNode>()->m_nestedNodes;
+        single[0] = entry;
+        return single;
+    };
+    auto entryOf = MapToTraversalEntries(nodes, nestedNodes);
+
+    unordered_map<ComputationNodeBasePtr, vector<ComputationNodeBasePtr>> consumers;
+    for (const auto& node : nodes)
+    {
+        for (const auto& input : InputEntries(node, entryOf, nestedNodes))
+            consumers[input].push_back(node);
+    }
+
+    // the node whose gradient matrix a node's gradient lives in
+    function<ComputationNodeBasePtr(const ComputationNodeBasePtr&)> gradientOwner = [&](const ComputationNodeBasePtr& node)
+    {
+        const auto& nodeConsumers = consumers[node];
+        if (node->ParentGradientReused() && nodeConsumers.size() == 1)
+            return gradientOwner(nodeConsumers.front());
+        return node;
+    };
+
+    vector<vector<ComputationNodeBasePtr>> levels;
+    unordered_map<ComputationNodeBasePtr, size_t> levelOf;
+    unordered_map<ComputationNodeBasePtr, size_t> firstFreeLevelOfGradient;
+    unordered_map<ComputationNodeBasePtr, size_t> firstFreeLevelOfInput;
+    for (auto iter = nodes.rbegin(); iter != nodes.rend(); iter++)
+    {
+        const auto& node = *iter;
+
+        vector<ComputationNodeBasePtr> writtenGradients;
+        if (!node->Is<SEQTraversalFlowControlNode>())
+            writtenGradients.push_back(gradientOwner(node));
+        for (const auto& nestedNode : nestedNodes(node))
+        {
+            for (const auto& input : nestedNode->GetInputs())
+            {
+                auto inputEntry = entryOf.find(input);
+                if (input->NeedsGradient() && inputEntry != entryOf.end() && inputEntry->second != node)
+                    writtenGradients.push_back(inputEntry->second->Is<SEQTraversalFlowControlNode>() ? input : gradientOwner(input));
+            }
+        }
+
+        size_t level = 0;
+        for (const auto& consumer : consumers[node])
+            level = max(level, levelOf[consumer] + 1);
+        for (const auto& gradient : writtenGradients)
+        {
+            auto firstFreeLevel = firstFreeLevelOfGradient.find(gradient);
+            if (firstFreeLevel != firstFreeLevelOfGradient.end())
+                level = max(level, firstFreeLevel->second);
+        }
+        level = SerializeReadersOfInputsWithGaps(level, InputsWithGaps(node, entryOf, nestedNodes), firstFreeLevelOfInput);
+        for (const auto& gradient : writtenGradients)
+            firstFreeLevelOfGradient[gradient] = level + 1;
+
+        levelOf[node] = level;
+        if (levels.size() <= level)
+            levels.resize(level + 1);
+        levels[level].push_back(node);
+    }
+    return levels;
+}
+
+void ComputationNetwork::ForwardPropInParallel(const vector<ComputationNodeBasePtr>& nodes)
+{
+    auto& levels = m_parallelForwardPropLevels[nodes];
+    if (levels.empty())
+    {
+        vector<ComputationNodeBasePtr> traversal;
+        TravserseInSortedGlobalEvalOrder(nodes, [&traversal](const ComputationNodeBasePtr& node) { traversal.push_back(node); });
+        levels = FormForwardPropLevels(traversal);
+    }
+
+    for (const auto& level : levels)
+        ForEachNodeInParallel(level, [](const ComputationNodeBasePtr& node) { PARTraversalFlowControlNode::ForwardProp(node, FrameRange(nullptr)); });
+}
+
 template<typename ElemType>
 bool TypedDumpNode(shared_ptr<ComputationNode<ElemType>> node, bool dumpGradient)
 {
@@ -480,6 +722,8 @@ void ComputationNetwork::InvalidateCompiledNetwork()
     m_allSEQNodes.clear();
     m_evalOrders.clear();
     m_nestedNetworks.clear();
+    m_parallelNodeEvaluation = false;
+    m_parallelForwardPropLevels.clear();
     m_inputValues.clear();
     m_learnableParameters.clear();
 }
@@ -1105,6 +1349,11 @@ void ComputationNetwork::AllocateAllMatrices(const std::vector<ComputationNodeBa
             for (int i = 0; i < node->GetNumInputs(); i++)
             {
                 ComputationNodeBasePtr input = node->GetInputs()[i];
+
+                // A node evaluated before a loop that only takes the MBLayout of a loop node must not count as its parent;
+                // it would release the loop node's value before the loop computed it.
+                if (!node->IsPartOfLoop() && input->IsPartOfLoop() && !node->InputUsedInComputingOutputValue(i))
+                    continue;
                 parentsMap[input].insert(node);
 
                 if (performingBackPropagation)
@@ -1158,7 +1407,11 @@ void ComputationNetwork::AllocateAllMatrices(const std::vector<ComputationNodeBa
 
     m_matrixPool.Reset();
 
-    TravserseInSortedGlobalEvalOrder(forwardPropRoots, [&outputValueNeededDuringBackProp, &parentsMap, this](const ComputationNodeBasePtr& node) {
+    // Nodes that may run concurrently must not share matrices. For that, all nodes of a level request
+    // their matrices before any of them releases matrices of its children.
+    bool parallelNodeEvaluation = Globals::ShouldEnableParallelNodeEvaluation() && GetDeviceId() == CPUDEVICE;
+
+    auto requestMatricesBeforeForwardProp = [&outputValueNeededDuringBackProp, this](const ComputationNodeBasePtr& node) {
         if (node->Is<SEQTraversalFlowControlNode>())
         {
             auto seqTraversalFlowControlNode = node->As<SEQTraversalFlowControlNode>();
@@ -1166,19 +1419,46 @@ void ComputationNetwork::AllocateAllMatrices(const std::vector<ComputationNodeBa
                 loopNode->SetOutputNeededDuringBackprop(outputValueNeededDuringBackProp[loopNode]);
 
             seqTraversalFlowControlNode->RequestMatricesBeforeForwardProp(m_matrixPool);
-
-            for (auto& loopNode : seqTraversalFlowControlNode->m_nestedNodes)
-                ReleaseMatricesAfterEvalForChildren(loopNode, parentsMap);
         }
         else
         {
             node->SetOutputNeededDuringBackprop(outputValueNeededDuringBackProp[node]);
             node->RequestMatricesBeforeForwardProp(m_matrixPool);
+        }
+    };
+    auto releaseMatricesAfterForwardProp = [&parentsMap, this](const ComputationNodeBasePtr& node) {
+        if (node->Is<SEQTraversalFlowControlNode>())
+        {
+            for (auto& loopNode : node->As<SEQTraversalFlowControlNode>()->m_nestedNodes)
+                ReleaseMatricesAfterEvalForChildren(loopNode, parentsMap);
+        }
+        else
+        {
             // we only release matrices for the children since the root node's information will be used
             // and should not be shared with others
             ReleaseMatricesAfterEvalForChildren(node, parentsMap);
         }
-    });
+    };
+
+    if (parallelNodeEvaluation)
+    {
+        vector<ComputationNodeBasePtr> forwardPropNodes;
+        TravserseInSortedGlobalEvalOrder(forwardPropRoots, [&forwardPropNodes](const ComputationNodeBasePtr& node) { forwardPropNodes.push_back(node); });
+        for (const auto& level : FormForwardPropLevels(forwardPropNodes))
+        {
+            for (const auto& node : level)
+                requestMatricesBeforeForwardProp(node);
+            for (const auto& node : level)
+                releaseMatricesAfterForwardProp(node);
+        }
+    }
+    else
+    {
+        TravserseInSortedGlobalEvalOrder(forwardPropRoots, [&](const ComputationNodeBasePtr& node) {
+            requestMatricesBeforeForwardProp(node);
+            releaseMatricesAfterForwardProp(node);
+        });
+    }
 
     if (trainRootNode != nullptr)
     {
@@ -1235,35 +1515,56 @@ void ComputationNetwork::AllocateAllMatrices(const std::vector<ComputationNodeBa
         m_matrixPool.SetAliasInfo(compactGradientAliasMap, compactGradientAliasRootMap);
 
         // now, simulate the gradient computation order to determine how to allocate matrices
+        // Loops are taken as a whole, in the position of their first node, as PARTraversalFlowControlNode does.
+        vector<ComputationNodeBasePtr> backPropTraversal;
         set<ComputationNodeBasePtr> completedGradient;
+        for (const auto& n : backPropNodes)
+        {
+            if (!n->IsPartOfLoop())
+                backPropTraversal.push_back(n);
+            else
+            {
+                shared_ptr<SEQTraversalFlowControlNode> recInfo = FindInRecurrentLoops(m_allSEQNodes, n);
+                if (completedGradient.insert(recInfo).second)
+                    backPropTraversal.push_back(recInfo);
+            }
+        }
+
+        auto allocateGradientMatricesForInputs = [this](const ComputationNodeBasePtr& n) {
+            // SEQ mode: allocate all in loop first, then deallocate again
+            // TODO: next step: use PARTraversalFlowControlNode::AllocateGradientMatricesForInputs() and ReleaseMatricesAfterBackprop()...
+            // BUGBUG: naw, ^^ would not work! Wrong order! Need to rethink this. Need to make AllocateEvalMatrices() and AllocateGradientMatrices() the virtual functions.
+            // PAR mode: we can allocate and immediately deallocate one by one
+            n->AllocateGradientMatricesForInputs(m_matrixPool);
+        };
+        auto releaseMatricesAfterBackprop = [this, &trainRootNode](const ComputationNodeBasePtr& n) {
+            // Loops are computed sample by sample so we have to allocate them all
+            if (n->Is<SEQTraversalFlowControlNode>())
+                n->ReleaseMatricesAfterBackprop(m_matrixPool);
+            // Root node's information will be used and should not be shared with others, also it's small (1x1)
+            else if ((n != trainRootNode) && n->NeedsGradient())
+                n->ReleaseMatricesAfterBackprop(m_matrixPool);
+        };
 
         // we need to call it here since we always compute gradients for children and root node is not children of other node
         trainRootNode->RequestMatricesBeforeBackprop(m_matrixPool);
 
-        for (auto iter = backPropNodes.rbegin(); iter != backPropNodes.rend(); iter++) // for gradient computation, traverse in reverse order
+        if (parallelNodeEvaluation)
         {
-            auto n = *iter;
-            if (n->IsPartOfLoop())
+            for (const auto& level : FormBackpropLevels(backPropTraversal))
             {
-                std::vector<ComputationNodeBasePtr> recurrentNodes;
-                shared_ptr<SEQTraversalFlowControlNode> recInfo = FindInRecurrentLoops(m_allSEQNodes, n);
-                if (completedGradient.insert(recInfo).second)
-                {
-                    // SEQ mode: allocate all in loop first, then deallocate again
-                    // TODO: next step: use PARTraversalFlowControlNode::AllocateGradientMatricesForInputs() and ReleaseMatricesAfterBackprop()...
-                    // BUGBUG: naw, ^^ would not work! Wrong order! Need to rethink this. Need to make AllocateEvalMatrices() and AllocateGradientMatrices() the virtual functions.
-                    recInfo->AllocateGradientMatricesForInputs(m_matrixPool);
-                    // Loops are computed sample by sample so we have to allocate them all
-                    recInfo->ReleaseMatricesAfterBackprop(m_matrixPool);
-                }
+                for (const auto& n : level)
+                    allocateGradientMatricesForInputs(n);
+                for (const auto& n : level)
+                    releaseMatricesAfterBackprop(n);
             }
-            else
+        }
+        else
+        {
+            for (auto iter = backPropTraversal.rbegin(); iter != backPropTraversal.rend(); iter++) // for gradient computation, traverse in reverse order
             {
-                // PAR mode: we can allocate and immediately deallocate one by one
-                n->AllocateGradientMatricesForInputs(m_matrixPool);
-                // Root node's information will be used and should not be shared with others, also it's small (1x1)
-                if ((n != trainRootNode) && n->NeedsGradient())
-                    n->ReleaseMatricesAfterBackprop(m_matrixPool);
+                allocateGradientMatricesForInputs(*iter);
+                releaseMatricesAfterBackprop(*iter);
             }
         }
     }
@@ -1271,6 +1572,14 @@ void ComputationNetwork::AllocateAllMatrices(const std::vector<ComputationNodeBa
     m_matrixPool.OptimizedMemoryAllocation(); 
     m_areMatricesAllocated = true;
 
+    // the memory plan allows running the nodes of a level concurrently from now on
+    if (parallelNodeEvaluation)
+    {
+        for (auto& nestedNetwork : m_nestedNetworks)
+            nestedNetwork.second->As<PARTraversalFlowControlNode>()->EnableParallelEvaluation();
+        m_parallelNodeEvaluation = true;
+    }
+
     // TO DO: At the time of AllocateAllMatrices we don't know the minibatch size. In theory one may allocate memory again once we start to receive
     // data from the reader (and the minibatch size is known). For some problems, minibatch size can change constantly, and there needs to be a 
     // tradeoff in deciding how frequent to run optimized memory allocation. For now, we do it only once at the very beginning for speed concerns. 
@@ -839,6 +839,12 @@ public:
     // Base-class version makes conservative assumption that it is. Override if not.
     virtual bool InputUsedInComputingInputNodesGradients(size_t /*childIndex*/) const { return true; }
 
+    // Is the value of the specified input node needed for computing the output value,
+    // as opposed to only its MBLayout. Used by the loop analysis to evaluate nodes outside
+    // of a recurrent loop when they are only connected to it through layout inputs.
+    // Base-class version makes conservative assumption that it is. Override if not.
+    virtual bool InputUsedInComputingOutputValue(size_t /*childIndex*/) const { return true; }
+
     void SetOutputNeededDuringBackprop(bool f) { m_outputNeededDuringBackprop = f; }
     bool IsOutputNeededDuringBackprop() const 
     { 
@@ -2348,6 +2354,19 @@ struct IRecurrentNode { virtual int GetRecurrenceSteppingDirection() const = 0;
 
 struct IFreezable { virtual void FreezeParameters() { } };
 
+// =======================================================================
+// IQuantizedNode -- nodes that quantize their inputs with a fixed range
+// that can be calibrated by evaluating the network on sample data
+// =======================================================================
+
+struct IQuantizedNode
+{
+    // while calibrating, the node records the range of its inputs
+    virtual void StartQuantizationCalibration() = 0;
+    // the recorded range becomes the fixed quantization range
+    virtual void FinishQuantizationCalibration() = 0;
+};
+
 // =======================================================================
 // PreComputedNodeBase -- interface implemented by ComputationNodes that precompute
 // TODO: We can use this interface in more places.
@@ -676,7 +676,7 @@ public:
                                                                    m_sharing, m_autoPad, m_lowerPad, m_upperPad, m_dilation, false, m_groups);
                 m_convEng = ConvolutionEngine<ElemType>::Create(geometry, m_deviceId, m_imageLayout,
                                                                 m_maxTempMemSizeInSamples, m_poolKind,
-                                                                ConvolutionEngineKind::All, NodeName(), Globals::ShouldForceDeterministicAlgorithms(),
+                                                                EnabledEngines(), NodeName(), Globals::ShouldForceDeterministicAlgorithms(),
                                                                 false, recomputeConvGeometry);
             }
 
@@ -733,6 +733,15 @@ public:
         ReleaseMatrixToPool(m_tempMatrixBackward, matrixPool);
     }
 
+protected:
+    // The convolution engines the node may run on.
+    virtual ConvolutionEngineKind EnabledEngines() const
+    {
+        if (Globals::ShouldEnableSmallFilterConvolution())
+            return (ConvolutionEngineKind)((int)ConvolutionEngineKind::All | (int)ConvolutionEngineKind::SmallFilter);
+        return ConvolutionEngineKind::All;
+    }
+
 private:
     using TransformerNode::m_transforms;
     using ConvolutionNodeBase<ElemType>::ComputeFilterTransform;
@@ -767,6 +776,131 @@ private:
     }
 };
 
+// -----------------------------------------------------------------------
+// Int8QuantizedConvolutionNode (convolutionWeights, inputFeature)
+// Convolution for inference on CPU that runs the GEMM of the convolution engine in int8, see Int8QuantizedMultiplier.
+// The kernel is quantized when the network is validated, with a scale for each output channel, the unrolled input on each call with the
+// range 'inputRange' (0: absolute max of the values). The range can be calibrated with
+// ComputationNetwork::SetQuantizationCalibration(). Only plain (non-transposed, non-grouped) convolution is supported.
+// -----------------------------------------------------------------------
+
+template <class ElemType>
+class Int8QuantizedConvolutionNode : public ConvolutionNode<ElemType>, public IQuantizedNode
+{
+    typedef ConvolutionNode<ElemType> Base; UsingConvolutionBaseNodeMembers;
+    static const std::wstring TypeName() { return L"Int8QuantizedConvolution"; }
+
+public:
+    Int8QuantizedConvolutionNode(DEVICEID_TYPE deviceId, const wstring& name)
+        : Base(deviceId, name), m_inputRange(0)
+    {
+    }
+    Int8QuantizedConvolutionNode(const ScriptableObjects::IConfigRecordPtr configp)
+        : Base(configp), m_inputRange(configp->Get(L"inputRange"))
+    {
+    }
+
+    virtual void CopyTo(ComputationNodeBasePtr nodeP, const std::wstring& newName, const CopyNodeFlags flags) const override
+    {
+        Base::CopyTo(nodeP, newName, flags);
+        if (flags & CopyNodeFlags::copyNodeValue)
+        {
+            auto node = dynamic_pointer_cast<Int8QuantizedConvolutionNode<ElemType>>(nodeP);
+            node->m_inputRange = GetInputRange();
+        }
+    }
+
+    void Save(File& fstream) const override
+    {
+        Base::Save(fstream);
+        fstream << GetInputRange();
+    }
+
+    void Load(File& fstream, size_t modelVersion) override
+    {
+        Base::Load(fstream, modelVersion);
+        fstream >> m_inputRange;
+    }
+
+    void ForwardProp(const FrameRange& fr) override
+    {
+        // The kernel was quantized when the network was validated; this only catches later updates of its values,
+        // and engines recreated for a new geometry.
+        if (m_quantizedEngine != m_convEng.get() || (m_isKernelConstant && Input(0)->GetEvalTimeStamp() != m_kernelTimeStamp))
+            QuantizeKernel();
+
+        Base::ForwardProp(fr);
+    }
+
+    void BackpropTo(const size_t /*inputIndex*/, const FrameRange& /*fr*/) override
+    {
+        // This operation is intended only for inference
+        NOT_IMPLEMENTED;
+    }
+
+    void Validate(bool isFinalValidationPass) override
+    {
+        Base::Validate(isFinalValidationPass);
+        if (isFinalValidationPass && m_deviceId != CPUDEVICE)
+            LogicError("Quantized operation is supposed to be used on CPU device only.");
+        if (isFinalValidationPass)
+            QuantizeKernel();
+    }
+
+    virtual void StartQuantizationCalibration() override
+    {
+        m_calibrating = true;
+        if (m_pInt8Multiplier)
+            m_pInt8Multiplier->StartCalibration();
+    }
+
+    virtual void FinishQuantizationCalibration() override
+    {
+        m_calibrating = false;
+        if (m_pInt8Multiplier)
+            m_inputRange = m_pInt8Multiplier->FinishCalibration();
+    }
+
+protected:
+    // Only the GEMM engine takes a quantized multiplier; the other CPU engines are not considered.
+    ConvolutionEngineKind EnabledEngines() const override { return ConvolutionEngineKind::Gemm; }
+
+private:
+    float GetInputRange() const { return m_pInt8Multiplier ? m_pInt8Multiplier->GetInputRange() : m_inputRange; }
+
+    // Hooks the multiplier into the engine and quantizes the kernel, which the engine multiplies as [XYC x K] matrix.
+    void QuantizeKernel()
+    {
+        if (m_quantizedEngine != m_convEng.get())
+        {
+            if (m_transpose || !m_convEng->SupportsQuantizedMultiplier())
+                RuntimeError("%ls %ls operation: only plain convolution with the GEMM engine on CPU can be quantized.", NodeName().c_str(), OperationName().c_str());
+
+            m_isKernelConstant = !!dynamic_pointer_cast<LearnableParameter<ElemType>>(Input(0));
+            m_pInt8Multiplier = make_shared<Int8QuantizedMultiplier<ElemType>>(false, m_isKernelConstant, GetInputRange());
+            if (m_calibrating)
+                m_pInt8Multiplier->StartCalibration();
+            m_convEng->SetQuantizedMultiplier(m_pInt8Multiplier);
+            m_quantizedEngine = m_convEng.get();
+        }
+
+        if (!m_isKernelConstant)
+            return;
+
+        const auto& kernel = InputRef(0).Value();
+        size_t unrollCols = m_convEng->Geometry()->KernelShape().GetNumElements();
+        m_pInt8Multiplier->QuantizeConstantOperand(kernel.Data(), (int)unrollCols, (int)(kernel.GetNumElements() / unrollCols), /*transpose =*/ false);
+        m_kernelTimeStamp = Input(0)->GetEvalTimeStamp();
+    }
+
+    float m_inputRange;
+    bool m_calibrating = false;
+    shared_ptr<Int8QuantizedMultiplier<ElemType>> m_pInt8Multiplier;
+    const ConvolutionEngine<ElemType>* m_quantizedEngine = nullptr;
+    bool m_isKernelConstant = false;
+    uint64_t m_kernelTimeStamp = 0;
+};
+
 
 // -----------------------------------------------------------------------
 // ConvolutionSequenceShapeNode -- for convolution over sequence axis
@@ -731,6 +731,120 @@ public:
 template class LookupTableNode<float>;
 template class LookupTableNode<double>;
 
+// -----------------------------------------------------------------------
+// EmbeddingLookupNode (embedding matrix, word indices)
+// Index-based embedding. Like LookupTableNode, each output column stacks the embeddings (columns of the
+// embedding matrix) of the words of one sample, but they are gathered by index instead of multiplying with
+// a one-hot matrix. The words come either
+//  - as sparse one-hot input, e.g. straight from a sparse reader stream, with k stacked one-hot vectors per
+//    column as for LookupTableNode; their row indices are the word indices, the values are not used.
+//    Sparse input is only supported on the CPU;
+//  - or as dense input with k word indices per column, coded as ElemType values like the indices of GatherNode.
+// The gradient of the embedding matrix is scattered into a sparse block column matrix that only holds the
+// columns that were looked up, which the learners update in place. On the GPU the gradient is dense.
+// The word indices have no gradient.
+// -----------------------------------------------------------------------
+
+template <class ElemType>
+class EmbeddingLookupNode : public ComputationNode<ElemType>, public NumInputs<2>
+{
+    typedef ComputationNode<ElemType> Base; UsingComputationNodeMembersBoilerplate;
+    static const std::wstring TypeName() { return L"EmbeddingLookup"; }
+
+public:
+    DeclareConstructorFromConfigWithNumInputs(EmbeddingLookupNode);
+    EmbeddingLookupNode(DEVICEID_TYPE deviceId, const wstring& name)
+        : Base(deviceId, name), m_indices(deviceId)
+    {
+    }
+
+    virtual void /*ComputationNode::*/ ForwardProp(const FrameRange& fr) override
+    {
+        const Matrix<ElemType>& embedding = InputRef(0).ValueAsMatrix();
+        Matrix<ElemType> indices = IndicesFor(fr);
+        Matrix<ElemType> output = ValueFor(fr).Reshaped(embedding.GetNumRows(), indices.GetNumCols());
+
+        // the gather skips missing words, which outside of gaps only sparse input can have
+        if (InputRef(1).Value().GetMatrixType() == SPARSE)
+            output.SetValue(0);
+        output.DoGatherColumnsOf(/*beta=*/0, indices, embedding, /*alpha=*/1);
+    }
+
+    virtual void /*ComputationNode::*/ BackpropTo(const size_t inputIndex, const FrameRange& fr) override
+    {
+        if (inputIndex != 0)
+            return;
+
+        auto& input0 = InputRef(0);
+        if (input0.GetPreferredGradientMatrixType() == UNDETERMINED &&
+            input0.Gradient().GetMatrixType() == DENSE && input0.Gradient().GetDeviceId() == CPUDEVICE)
+        {
+            // As in TimesNode for DENSE * SPARSE, we allocate a new sparse gradient instead of switching the type in place,
+            // since other nodes may share the dense matrix. It was cleared to zero anyway.
+            auto& currentGradient = input0.Gradient();
+            input0.GradientPtrRef() = std::make_shared<Matrix<ElemType>>(currentGradient.GetNumRows(), currentGradient.GetNumCols(),
+                                                                         currentGradient.GetPreferredDeviceId(), SPARSE, matrixFormatSparseBlockCol);
+            input0.SetPreferredGradientMatrixType(SPARSE);
+        }
+        else if (input0.Gradient().GetMatrixType() == SPARSE && input0.Gradient().GetDeviceId() != CPUDEVICE)
+        {
+            // scattering into a sparse matrix is only implemented on the CPU
+            input0.Gradient().SwitchToMatrixType(DENSE, matrixFormatDense, true);
+            input0.SetPreferredGradientMatrixType(DENSE);
+        }
+
+        // This is a reduction over the minibatch, hence we need to mask out gaps.
+        Matrix<ElemType> indices = IndicesFor(fr);
+        Matrix<ElemType> outputGradient = MaskedGradientFor(fr);
+        input0.Gradient().DoScatterColumnsOf(/*beta=*/1, indices, outputGradient.Reshaped(input0.Gradient().GetNumRows(), indices.GetNumCols()), /*alpha=*/1, /*idxHaveDups=*/true);
+    }
+
+    virtual bool OutputUsedInComputingInputNodesGradients() const override { return false; }
+    virtual bool InputUsedInComputingInputNodesGradients(size_t childIndex) const override { return childIndex == 1; }
+
+    virtual void /*ComputationNodeBase::*/ Validate(bool isFinalValidationPass) override
+    {
+        Base::Validate(isFinalValidationPass);
+        InferMBLayoutFromInputsForStandardCase(isFinalValidationPass);
+
+        if (isFinalValidationPass && !HasMBLayout())
+            InvalidArgument("%ls %ls operation can only operate on minibatches.", NodeName().c_str(), OperationName().c_str());
+
+        size_t numWords = Input(0)->GetAsMatrixNumCols();
+        size_t inputDim = Input(1)->GetSampleMatrixNumRows();
+        if (isFinalValidationPass && Input(1)->IsValueSparse() && (numWords == 0 || inputDim % numWords != 0))
+            InvalidArgument("%ls %ls operation: The dimension of the sparse input (%d) must be a multiple of the number of columns of the embedding matrix (%d).",
+                            NodeName().c_str(), OperationName().c_str(), (int)inputDim, (int)numWords);
+
+        if (isFinalValidationPass && Input(1)->IsValueSparse() && m_deviceId != CPUDEVICE)
+            InvalidArgument("%ls %ls operation: Sparse word input is only supported on the CPU. On the GPU, pass the word indices as dense input.",
+                            NodeName().c_str(), OperationName().c_str());
+
+        size_t wordsInEachSample = Input(1)->IsValueSparse() ? inputDim / max(numWords, (size_t)1) : inputDim;
+        SetDims(TensorShape(Input(0)->GetAsMatrixNumRows() * wordsInEachSample), true);
+    }
+
+private:
+    // Word indices of the samples in fr as a row vector, as DoGatherColumnsOf() and DoScatterColumnsOf() take them.
+    Matrix<ElemType> IndicesFor(const FrameRange& fr)
+    {
+        if (InputRef(1).Value().GetMatrixType() == SPARSE)
+        {
+            m_indices.AssignOneHotIndicesOf(InputRef(1).ValueFor(fr), InputRef(0).GetAsMatrixNumCols());
+            return m_indices.AsReference();
+        }
+
+        InputRef(1).MaskMissingValueColumnsTo(fr, -1); // indicates an invalid column to Gather/Scatter
+        Matrix<ElemType> indices = InputRef(1).ValueFor(fr);
+        return indices.Reshaped(1, indices.GetNumElements());
+    }
+
+    Matrix<ElemType> m_indices; // word indices of sparse input
+};
+
+template class EmbeddingLookupNode<float>;
+template class EmbeddingLookupNode<double>;
+
 // -----------------------------------------------------------------------
 // ConstantNode
 // -----------------------------------------------------------------------
@@ -9,6 +9,7 @@
 #include "Constants.h"
 #include "Matrix.h"
 #include "TensorView.h"
+#include "TensorOps.h"
 #include <unordered_set>
 #include <map>
 #include <string>
@@ -20,6 +21,7 @@
 #include <utility>
 #include <assert.h>
 #include <set>
+#include <type_traits>
 #include "Quantizers.h"
 #include "InputAndParamNodes.h"
 
@@ -1241,6 +1243,302 @@ template class QuantizedTimesNode<float>;
 template class QuantizedTimesNode<double>;
 template class QuantizedTimesNode<half>;
 
+// Int8 matrix product for inference on CPU, see Int8QuantizedMultiplier. The operand that is a LearnableParameter (the weights)
+// is quantized when the network is validated (after loading), with a scale for each output channel. The other operand is quantized on each call, with the fixed range
+// 'inputRange', or with the absolute max of its values if inputRange is 0. The range can be calibrated on sample data, see
+// ComputationNetwork::SetQuantizationCalibration(), and is saved with the model.
+// Like QuantizedTimes, this node can be included into a trained network with the Edit command:
+// node => if node.name == 'z.PlusArgs[0]' then Int8QuantizedTimes(node.inputs[0], node.inputs[1]) else node,
+template <class ElemType>
+class Int8QuantizedTimesNode : public TimesNodeBase<ElemType, false>, public IQuantizedNode
+{
+    typedef TimesNodeBase<ElemType, false> Base;
+    UsingComputationNodeMembersBoilerplate;
+    static const std::wstring TypeName()
+    {
+        return L"Int8QuantizedTimes";
+    }
+
+public:
+    Int8QuantizedTimesNode(DEVICEID_TYPE deviceId, const wstring& name, float inputRange = 0, size_t outputRank = 1, int inferInputRankToMap = Base::NoInferredInputRank)
+        : Base(deviceId, name, outputRank, inferInputRankToMap), m_inputRange(inputRange)
+    {
+        if (deviceId != CPUDEVICE)
+            LogicError("Quantized operation is supposed to be used on CPU device only.");
+    }
+
+    Int8QuantizedTimesNode(const ScriptableObjects::IConfigRecordPtr configp)
+        : Int8QuantizedTimesNode(configp->Get(L"deviceId"), L"<placeholder>", configp->Get(L"inputRange"), configp->Get(L"outputRank"), configp->Get(L"inferInputRankToMap"))
+    {
+        AttachInputsFromConfig(configp, this->GetExpectedNumInputs());
+    }
+
+    virtual void CopyTo(ComputationNodeBasePtr nodeP, const std::wstring& newName, const CopyNodeFlags flags) const override
+    {
+        Base::CopyTo(nodeP, newName, flags);
+        if (flags & CopyNodeFlags::copyNodeValue)
+        {
+            auto node = dynamic_pointer_cast<Int8QuantizedTimesNode<ElemType>>(nodeP);
+            node->m_inputRange = GetInputRange();
+        }
+    }
+
+    void Save(File& fstream) const override
+    {
+        Base::Save(fstream);
+        fstream << GetInputRange();
+    }
+
+    virtual void Load(File& fstream, size_t modelVersion) override
+    {
+        Base::Load(fstream, modelVersion);
+        fstream >> m_inputRange;
+    }
+
+    virtual void /*ComputationNode::*/ ForwardProp(const FrameRange& fr) override
+    {
+        // The weights were quantized when the network was validated; this only catches later updates of their values.
+        if (!m_pInt8Multiplier || (m_weights && m_weights->GetEvalTimeStamp() != m_weightsTimeStamp))
+            QuantizeWeights();
+
+        Base::ForwardProp(fr);
+    }
+
+    virtual void /*ComputationNodeBase::*/ Validate(bool isFinalValidationPass) override
+    {
+        Base::Validate(isFinalValidationPass);
+        if (isFinalValidationPass)
+            QuantizeWeights();
+    }
+
+    virtual void /*ComputationNode::*/ BackpropTo(const size_t /*inputIndex*/, const FrameRange& /*fr*/) override
+    {
+        // This operation is intended only for inference
+        NOT_IMPLEMENTED;
+    }
+
+    virtual void StartQuantizationCalibration() override
+    {
+        m_calibrating = true;
+        if (m_pInt8Multiplier)
+            m_pInt8Multiplier->StartCalibration();
+    }
+
+    virtual void FinishQuantizationCalibration() override
+    {
+        m_calibrating = false;
+        if (m_pInt8Multiplier)
+            m_inputRange = m_pInt8Multiplier->FinishCalibration();
+    }
+
+private:
+    float GetInputRange() const { return m_pInt8Multiplier ? m_pInt8Multiplier->GetInputRange() : m_inputRange; }
+
+    // Creates the multiplier once the inputs are known and quantizes the operand that is a LearnableParameter, if any.
+    void QuantizeWeights()
+    {
+        if (!m_pInt8Multiplier)
+        {
+            bool isAConstant = !!dynamic_pointer_cast<LearnableParameter<ElemType>>(Input(0));
+            bool isBConstant = !isAConstant && dynamic_pointer_cast<LearnableParameter<ElemType>>(Input(1));
+            m_pInt8Multiplier = make_shared<Int8QuantizedMultiplier<ElemType>>(isAConstant, isBConstant, m_inputRange);
+            if (m_calibrating)
+                m_pInt8Multiplier->StartCalibration();
+            this->m_pQuantizedMultiplier = m_pInt8Multiplier;
+            m_weights = isAConstant ? Input(0) : isBConstant ? Input(1) : nullptr;
+        }
+
+        if (!m_weights || m_weights->GetSampleLayout().GetNumElements() == 0)
+            return;
+
+        // The matrices the product is computed of, as TensorView flattens the inputs: the first OutputRank() dimensions
+        // of input 0 are the rows of A, and B has as many rows as A has columns.
+        const auto& shapeA = InputRef(0).GetSampleLayout();
+        size_t rowsA = 1;
+        for (size_t i = 0; i < std::min(this->OutputRank(), shapeA.GetRank()); i++)
+            rowsA *= shapeA[i];
+        size_t colsA = shapeA.GetNumElements() / rowsA;
+
+        auto& weights = dynamic_cast<ComputationNode<ElemType>&>(*m_weights).Value();
+        if (m_weights == Input(0))
+            m_pInt8Multiplier->QuantizeConstantOperand(weights.Data(), (int)rowsA, (int)colsA, /*transpose =*/ false);
+        else
+            m_pInt8Multiplier->QuantizeConstantOperand(weights.Data(), (int)colsA, (int)(weights.GetNumElements() / colsA), /*transpose =*/ false);
+        m_weightsTimeStamp = m_weights->GetEvalTimeStamp();
+    }
+
+    float m_inputRange;
+    bool m_calibrating = false;
+    shared_ptr<Int8QuantizedMultiplier<ElemType>> m_pInt8Multiplier;
+    ComputationNodeBasePtr m_weights;
+    uint64_t m_weightsTimeStamp = 0;
+};
+
+template class Int8QuantizedTimesNode<float>;
+template class Int8QuantizedTimesNode<double>;
+template class Int8QuantizedTimesNode<half>;
+
+// -----------------------------------------------------------------------
+// TimesPlusActivationNode (weights, input, bias, activation='RectifiedLinear') -- activation(weights * input + bias)
+// A dense layer Times -> Plus -> RectifiedLinear/Sigmoid/Tanh in a single node, as created by
+// ComputationNetwork::FuseTimesPlusActivation() for inference. The weights are a [rows x cols] matrix, the bias has rows elements.
+// On the CPU the bias and the activation are applied in the epilogue of the matrix product, to one block of output columns
+// at a time while it is still in the cache, instead of in two more passes over the whole output with a matrix in between.
+// Like QuantizedTimes, this operation is intended only for inference.
+// -----------------------------------------------------------------------
+
+template <class ElemType>
+class TimesPlusActivationNode : public ComputationNode<ElemType>, public NumInputs<3>
+{
+    typedef ComputationNode<ElemType> Base; UsingComputationNodeMembersBoilerplate;
+    static const std::wstring TypeName() { return L"TimesPlusActivation"; }
+
+    // the epilogue computes in float for half, like the CPU tensor operations
+    typedef typename std::conditional<std::is_same<ElemType, double>::value, double, float>::type ComputeType;
+
+public:
+    // 'activation' is the operation name of the activation node: RectifiedLinear, Sigmoid or Tanh.
+    TimesPlusActivationNode(DEVICEID_TYPE deviceId, const wstring& name, const wstring& activation = L"RectifiedLinear")
+        : Base(deviceId, name), m_activation(activation), m_activationOp(ActivationOp(activation))
+    {
+    }
+
+    TimesPlusActivationNode(const ScriptableObjects::IConfigRecordPtr configp)
+        : TimesPlusActivationNode(configp->Get(L"deviceId"), L"<placeholder>", configp->Get(L"activation"))
+    {
+        AttachInputsFromConfig(configp, this->GetExpectedNumInputs());
+    }
+
+    virtual void CopyTo(ComputationNodeBasePtr nodeP, const std::wstring& newName, const CopyNodeFlags flags) const override
+    {
+        Base::CopyTo(nodeP, newName, flags);
+        if (flags & CopyNodeFlags::copyNodeValue)
+        {
+            auto node = dynamic_pointer_cast<TimesPlusActivationNode<ElemType>>(nodeP);
+            node->m_activation = m_activation;
+            node->m_activationOp = m_activationOp;
+        }
+    }
+
+    virtual void Save(File& fstream) const override
+    {
+        Base::Save(fstream);
+        fstream << m_activation;
+    }
+
+    virtual void Load(File& fstream, size_t modelVersion) override
+    {
+        Base::Load(fstream, modelVersion);
+        fstream >> m_activation;
+        m_activationOp = ActivationOp(m_activation);
+    }
+
+    virtual void /*ComputationNode::*/ ForwardProp(const FrameRange& fr) override
+    {
+        const Matrix<ElemType>& weights = InputRef(0).ValueAsMatrix();
+        Matrix<ElemType> input = InputRef(1).ValueFor(fr);
+        Matrix<ElemType> output = ValueFor(fr);
+
+        if (output.GetDeviceId() != CPUDEVICE || input.GetMatrixType() != DENSE)
+        {
+            Matrix<ElemType>::Multiply(weights, false, input, false, output);
+            size_t rank = GetSampleLayout().GetRank();
+            auto result = ValueTensorFor(rank, fr);
+            result.DoBinaryOpOf(0, result, InputRef(2).ValueTensorFor(rank, fr.AllowBroadcast()), 1, opSum, opSum);
+            result.DoUnaryOpOf(0, result, 1, m_activationOp, opSum);
+            return;
+        }
+
+        size_t rows = output.GetNumRows();
+        size_t cols = output.GetNumCols();
+        size_t blockCols = std::max<size_t>(1, s_epilogueBlockBytes / (std::max<size_t>(rows, 1) * sizeof(ElemType)));
+        const ElemType* bias = InputRef(2).Value().Data();
+        for (size_t firstCol = 0; firstCol < cols; firstCol += blockCols)
+        {
+            size_t numCols = std::min(blockCols, cols - firstCol);
+            Matrix<ElemType> outputBlock = output.ColumnSlice(firstCol, numCols);
+            Matrix<ElemType>::Multiply(weights, false, input.ColumnSlice(firstCol, numCols), false, outputBlock);
+            switch (m_activationOp)
+            {
+            case opLinearRectifier: ApplyEpilogue(outputBlock.Data(), bias, rows, numCols, [](ComputeType v) { return OpLinearRectifier(v); }); break;
+            case opSigmoid:         ApplyEpilogue(outputBlock.Data(), bias, rows, numCols, [](ComputeType v) { return OpSigmoid(v); }); break;
+            case opTanh:            ApplyEpilogue(outputBlock.Data(), bias, rows, numCols, [](ComputeType v) { return OpTanh(v); }); break;
+            default:                LogicError("%ls %ls operation: Unexpected activation.", NodeName().c_str(), OperationName().c_str());
+            }
+        }
+    }
+
+    virtual void /*ComputationNode::*/ BackpropTo(const size_t /*inputIndex*/, const FrameRange& /*fr*/) override
+    {
+        // This operation is intended only for inference
+        NOT_IMPLEMENTED;
+    }
+
+    virtual bool OutputUsedInComputingInputNodesGradients() const override { return false; }
+    virtual bool InputUsedInComputingInputNodesGradients(size_t /*childIndex*/) const override { return false; }
+
+    virtual void /*ComputationNodeBase::*/ Validate(bool isFinalValidationPass) override
+    {
+        Base::Validate(isFinalValidationPass);
+        InferMBLayoutFromInputsForStandardCase(isFinalValidationPass);
+
+        size_t rows = Input(0)->GetAsMatrixNumRows();
+        if (isFinalValidationPass)
+        {
+            if (Input(0)->HasMBLayout() || Input(2)->HasMBLayout())
+                InvalidArgument("%ls %ls operation: The weights and the bias cannot be minibatch data.", NodeName().c_str(), OperationName().c_str());
+
+            if (Input(1)->GetSampleMatrixNumRows() != Input(0)->GetAsMatrixNumCols())
+                InvalidArgument("%ls %ls operation: The input dimension (%d) does not match the number of columns of the weights (%d).",
+                                NodeName().c_str(), OperationName().c_str(), (int)Input(1)->GetSampleMatrixNumRows(), (int)Input(0)->GetAsMatrixNumCols());
+
+            const auto& biasShape = Input(2)->GetSampleLayout();
+            if (biasShape.GetRank() == 0 || biasShape[0] != rows || biasShape.GetNumElements() != rows)
+                InvalidArgument("%ls %ls operation: The bias [%s] must be a vector of the dimension of the rows of the weights (%d).",
+                                NodeName().c_str(), OperationName().c_str(), string(biasShape).c_str(), (int)rows);
+        }
+
+        // like the sum in the Plus node, the output has the shape of the bias, which may have trailing singleton dimensions
+        SetDims(Input(2)->GetSampleLayout(), HasMBLayout());
+    }
+
+private:
+    static ElementWiseOperator ActivationOp(const wstring& activation)
+    {
+        if (activation == L"RectifiedLinear")
+            return opLinearRectifier;
+        else if (activation == L"Sigmoid")
+            return opSigmoid;
+        else if (activation == L"Tanh")
+            return opTanh;
+        else
+            InvalidArgument("TimesPlusActivation: Unsupported activation '%ls', only RectifiedLinear, Sigmoid and Tanh are supported.", activation.c_str());
+    }
+
+    // output[i, j] = activation(output[i, j] + bias[i]) for a column major [rows x cols] block of the output
+    template <class Activation>
+    static void ApplyEpilogue(ElemType* output, const ElemType* bias, size_t rows, size_t cols, const Activation& activation)
+    {
+#pragma omp parallel for
+        for (long j = 0; j < (long)cols; j++)
+        {
+            ElemType* column = output + j * rows;
+            for (size_t i = 0; i < rows; i++)
+                column[i] = (ElemType)activation((ComputeType)column[i] + (ComputeType)bias[i]);
+        }
+    }
+
+    // Bytes of the output per matrix product, such that the epilogue finds the block in the (L2) cache.
+    static const size_t s_epilogueBlockBytes = 256 * 1024;
+
+    wstring m_activation;
+    ElementWiseOperator m_activationOp;
+};
+
+template class TimesPlusActivationNode<float>;
+template class TimesPlusActivationNode<double>;
+template class TimesPlusActivationNode<half>;
+
 // -----------------------------------------------------------------------
 // SumElementsNode (input)
 // Sums up all elements in the input across all samples into a single scalar.
@@ -76,6 +76,10 @@ protected:
     set<DEVICEID_TYPE> m_deviceIDSet; 
     int m_stepCounter; 
 
+    // If not 0, the shared matrices are allocated upfront for minibatches of up to this number of samples,
+    // instead of growing on demand when the first minibatches arrive.
+    size_t m_preallocationMinibatchSize = 0;
+
     template <class ElemType>
     vector<MemRequestInfo<ElemType>>& GetMemRequestInfoVec();
 
@@ -147,6 +151,13 @@ public:
         *pMatrixPtr = make_shared<Matrix<ElemType>>(deviceId);
     }
 
+    // Makes OptimizedMemoryAllocation() allocate all memory for minibatches of up to 'minibatchSize' samples (0 = on demand).
+    // This turns the sharing plan into a static memory plan for inference with a known maximum minibatch size.
+    void SetPreallocationMinibatchSize(size_t minibatchSize)
+    {
+        m_preallocationMinibatchSize = minibatchSize;
+    }
+
     void OptimizedMemoryAllocation()
     {
         // MatrixPool is not templated, so we call both float and double versions here 
@@ -374,6 +385,7 @@ private:
                     auto matrixPtr = make_shared<Matrix<ElemType>>(devId);
                     if (!matrixPtr) // this can't really happen, because we haven't started allocating memory yet
                         LogicError("MatrixPool: failed to get a valid matrix.");
+                    size_t numElements = 0;
                     for (auto& memInfo : memInfoVec)
                     {
                         if (memInfo.deviceId == devId && memInfo.isWorkSpace == wsFlag && memInfo.memoryId == i)
@@ -382,8 +394,13 @@ private:
                             {
                                 *pOutMatrixPtr = matrixPtr;
                             }
+                            numElements = max(numElements, memInfo.matrixSize * (memInfo.mbScale ? m_preallocationMinibatchSize : 1));
                         }
                     }
+
+                    // Matrices only grow, so the nodes reshape the preallocated buffer instead of reallocating it.
+                    if (m_preallocationMinibatchSize > 0 && numElements > 0)
+                        matrixPtr->Resize(numElements, 1);
                 }
             }
         }
@@ -5,6 +5,7 @@
 
 #include "TrainingNodes.h"
 #include <boost/random/uniform_real_distribution.hpp>
+#include <numeric>
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
@@ -102,6 +103,11 @@ void RandomSampleNodeBase<ElemType>::Load(File& fstream, size_t modelVersion)
 template<class ElemType>
 void RandomSampleNodeBase<ElemType>::UpdateWeightsPrefixSum()
 {
+    // The weights are typically a constant or a parameter that changes at most once per minibatch, so keep the prefix sum
+    // as long as the time stamp of the input, which is bumped whenever its value is recomputed or updated, stays the same.
+    if (!m_samplingWeightsPrefixSum.empty() && Input(0)->GetEvalTimeStamp() == m_samplingWeightsTimeStamp)
+        return;
+
     const Matrix<ElemType>& samplingWeights = Input(0)->ValueAsMatrix();
     m_samplingWeightsPrefixSum.clear();
     double runningWeightsSum = 0;
@@ -114,6 +120,7 @@ void RandomSampleNodeBase<ElemType>::UpdateWeightsPrefixSum()
         runningWeightsSum += (double)currentWeight;
         m_samplingWeightsPrefixSum.push_back(runningWeightsSum);
     }
+    m_samplingWeightsTimeStamp = Input(0)->GetEvalTimeStamp();
 }
 
 // Runs the sampling returning a vector with the id's of the samples. The parameter nTries is used to return the number of draws that was needed
@@ -307,6 +314,289 @@ template class RandomSampleInclusionFrequencyNode<float>;
 template class RandomSampleInclusionFrequencyNode<double>;
 template class RandomSampleInclusionFrequencyNode<half>;
 
+// Vose's variant of the alias method: buckets with less than average probability are filled up by a bucket with more,
+// which becomes their alias; the leftover of the larger bucket is then classified again.
+void AliasTable::Build(const std::vector<double>& weights)
+{
+    const size_t numClasses = weights.size();
+    double totalWeight = 0;
+    for (double weight : weights)
+    {
+        if (weight < 0)
+            InvalidArgument("AliasTable: Sampling weights contain negative number %f.", weight);
+        totalWeight += weight;
+    }
+    if (numClasses == 0 || totalWeight <= 0)
+        InvalidArgument("AliasTable: Sampling weights must contain at least one positive number.");
+
+    m_probability.resize(numClasses);
+    m_alias.resize(numClasses);
+
+    std::vector<size_t> small, large;
+    for (size_t i = 0; i < numClasses; i++)
+    {
+        m_probability[i] = weights[i] * numClasses / totalWeight;
+        m_alias[i] = i;
+        (m_probability[i] < 1 ? small : large).push_back(i);
+    }
+
+    while (!small.empty() && !large.empty())
+    {
+        size_t s = small.back();
+        size_t l = large.back();
+        small.pop_back();
+        m_alias[s] = l;
+        m_probability[l] -= 1 - m_probability[s];
+        if (m_probability[l] < 1)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // what remains is 1 up to rounding errors
+    for (size_t i : large)
+        m_probability[i] = 1;
+    for (size_t i : small)
+        m_probability[i] = 1;
+}
+
+template <class ElemType>
+void SampledSoftmaxWithCrossEntropyNode<ElemType>::UpdateAliasTable()
+{
+    auto timeStamp = Input(SAMPLINGWEIGHTS)->GetEvalTimeStamp();
+    if (!m_aliasTable.IsEmpty() && timeStamp == m_samplingWeightsTimeStamp)
+        return;
+
+    const Matrix<ElemType>& samplingWeights = InputRef(SAMPLINGWEIGHTS).Value();
+    const size_t numClasses = samplingWeights.GetNumElements();
+    std::unique_ptr<ElemType[]> values(samplingWeights.CopyToArray());
+    std::vector<double> weights(values.get(), values.get() + numClasses);
+    m_aliasTable.Build(weights);
+
+    // log(S q(c)), the expected log count of class c in the sampled set; classes that are never sampled are clipped
+    // so that their labels still get finite logits
+    double totalWeight = std::accumulate(weights.begin(), weights.end(), 0.0);
+    m_logSamplingProbsBuffer.resize(numClasses);
+    for (size_t i = 0; i < numClasses; i++)
+        m_logSamplingProbsBuffer[i] = (ElemType)log(std::max(m_sizeOfSampledSet * weights[i] / totalWeight, (double)std::numeric_limits<float>::min()));
+    m_logSamplingProbs.SetValue(1, numClasses, m_deviceId, m_logSamplingProbsBuffer.data());
+
+    m_samplingWeightsTimeStamp = timeStamp;
+}
+
+template <class ElemType>
+void SampledSoftmaxWithCrossEntropyNode<ElemType>::DrawSamples()
+{
+    boost::random::uniform_real_distribution<double> r(0, 1);
+    CPURNGHandle* cpuRNGHandle = dynamic_cast<CPURNGHandle*>(&GetRNGHandle(CPUDEVICE));
+
+    m_sampleIndicesBuffer.resize(m_sizeOfSampledSet);
+    m_sampleLogSamplingProbsBuffer.resize(m_sizeOfSampledSet);
+    for (size_t i = 0; i < m_sizeOfSampledSet; i++)
+    {
+        size_t sample = m_aliasTable.Sample(r(cpuRNGHandle->Generator()));
+        m_sampleIndicesBuffer[i] = (ElemType)sample;
+        m_sampleLogSamplingProbsBuffer[i] = m_logSamplingProbsBuffer[sample];
+    }
+    UpdateRngOffset(GetRngOffset() + m_sizeOfSampledSet);
+
+    m_sampleIndices.SetValue(1, m_sizeOfSampledSet, m_deviceId, m_sampleIndicesBuffer.data());
+    m_sampleLogSamplingProbs.SetValue(m_sizeOfSampledSet, 1, m_deviceId, m_sampleLogSamplingProbsBuffer.data());
+}
+
+template <class ElemType>
+void SampledSoftmaxWithCrossEntropyNode<ElemType>::ForwardPropNonLooping()
+{
+    FrameRange fr(InputRef(LABELDATA).GetMBLayout());
+
+    // class index of each label column; the labels are one-hot, so this is a single product with 0, 1, ..., V-1
+    const size_t numClasses = InputRef(LABELDATA).GetSampleMatrixNumRows();
+    if (m_classIndices.GetNumCols() != numClasses)
+    {
+        std::vector<ElemType> classIndices(numClasses);
+        for (size_t i = 0; i < numClasses; i++)
+            classIndices[i] = (ElemType)i;
+        m_classIndices.SetValue(1, numClasses, m_deviceId, classIndices.data());
+    }
+    m_labelIndices.AssignProductOf(m_classIndices, false, InputRef(LABELDATA).MaskedValueFor(fr), false);
+
+    if (Environment().IsTraining())
+        ForwardPropSampled(fr);
+    else
+        ForwardPropFull(fr);
+
+#if NANCHECK
+    Value().HasNan("SampledSoftmaxWithCrossEntropy");
+#endif
+    m_needRecomputeLogitsGradient = true;
+}
+
+template <class ElemType>
+void SampledSoftmaxWithCrossEntropyNode<ElemType>::ForwardPropSampled(const FrameRange& fr)
+{
+    UpdateAliasTable();
+    DrawSamples();
+
+    const Matrix<ElemType>& hidden = InputRef(INPUTDATA).MaskedValueFor(fr);
+    const Matrix<ElemType>& weights = InputRef(OUTPUTWEIGHTS).ValueAsMatrix();
+    const size_t numSamples = m_sizeOfSampledSet;
+
+    // gather the weights of the labels and of the shared samples
+    m_labelWeights.DoGatherColumnsOf(0, m_labelIndices, weights, 1);
+    m_sampledWeights.DoGatherColumnsOf(0, m_sampleIndices, weights, 1);
+    m_labelLogSamplingProbs.DoGatherColumnsOf(0, m_labelIndices, m_logSamplingProbs, 1);
+
+    // label logits: column-wise dot products of the hidden activations and the label weights
+    Matrix<ElemType>::InnerProduct(hidden, m_labelWeights, m_labelLogits, true);
+    m_labelLogits -= m_labelLogSamplingProbs;
+
+    // sampled logits: one product of the sampled weights with the whole minibatch
+    m_sampledLogits.AssignProductOf(m_sampledWeights, true, hidden, false);
+    Matrix<ElemType>::ScaleAndAdd(-1, m_sampleLogSamplingProbs, m_sampledLogits); // [S x 1] is added to every column
+
+    m_logSoftmax.Resize(1 + numSamples, hidden.GetNumCols());
+    m_logSoftmax.AssignToRowSliceValuesOf(m_labelLogits, 0, 1);
+    m_logSoftmax.AssignToRowSliceValuesOf(m_sampledLogits, 1, numSamples);
+    m_logSoftmax.InplaceLogSoftmax(true);
+    m_softmax.AssignExpOf(m_logSoftmax);
+
+    // -sum of the label's log probabilities; gaps contribute zero
+    MaskMissingColumnsToZero(m_logSoftmax, InputRef(INPUTDATA).GetMBLayout(), fr);
+    m_labelLogits.AssignRowSliceValuesOf(m_logSoftmax, 0, 1);
+    Value().AssignSumOfElements(m_labelLogits);
+    Value() *= -1;
+
+    m_isSampled = true;
+}
+
+template <class ElemType>
+void SampledSoftmaxWithCrossEntropyNode<ElemType>::ForwardPropFull(const FrameRange& fr)
+{
+    m_logSoftmax.AssignProductOf(InputRef(OUTPUTWEIGHTS).ValueAsMatrix(), true, InputRef(INPUTDATA).MaskedValueFor(fr), false);
+    m_logSoftmax.InplaceLogSoftmax(true);
+    MaskMissingColumnsToZero(m_logSoftmax, InputRef(INPUTDATA).GetMBLayout(), fr);
+    Value().AssignInnerProductOfMatrices(InputRef(LABELDATA).MaskedValueFor(fr), m_logSoftmax);
+    Value() *= -1;
+
+    m_isSampled = false;
+}
+
+// The gradient w.r.t. the logits is softmax - 1 for the label (row 0) and softmax for the samples, times the criterion's gradient.
+template <class ElemType>
+void SampledSoftmaxWithCrossEntropyNode<ElemType>::ComputeLogitsGradient()
+{
+    if (!m_needRecomputeLogitsGradient)
+        return;
+
+    FrameRange fr(InputRef(LABELDATA).GetMBLayout());
+    m_labelGradient.AssignRowSliceValuesOf(m_softmax, 0, 1);
+    m_labelGradient -= 1;
+    m_sampledGradient.AssignRowSliceValuesOf(m_softmax, 1, m_sizeOfSampledSet);
+    MaskMissingColumnsToZero(m_labelGradient, InputRef(INPUTDATA).GetMBLayout(), fr);
+    MaskMissingColumnsToZero(m_sampledGradient, InputRef(INPUTDATA).GetMBLayout(), fr);
+    Matrix<ElemType>::Scale(Gradient(), m_labelGradient);
+    Matrix<ElemType>::Scale(Gradient(), m_sampledGradient);
+
+    m_needRecomputeLogitsGradient = false;
+}
+
+template <class ElemType>
+void SampledSoftmaxWithCrossEntropyNode<ElemType>::BackpropToNonLooping(size_t inputIndex)
+{
+    if (inputIndex != INPUTDATA && inputIndex != OUTPUTWEIGHTS)
+        InvalidArgument("%ls %ls operation only computes gradients with respect to the hidden activation and the output weights.", NodeName().c_str(), OperationName().c_str());
+    if (!m_isSampled)
+        LogicError("%ls %ls operation: Backpropagation requires a forward pass in training mode.", NodeName().c_str(), OperationName().c_str());
+
+    ComputeLogitsGradient();
+
+    FrameRange fr(InputRef(INPUTDATA).GetMBLayout());
+    if (inputIndex == INPUTDATA)
+    {
+        // sampled weights times the sampled gradient, plus each column's label weights scaled by its label gradient
+        auto gradient = InputRef(INPUTDATA).GradientFor(fr);
+        Matrix<ElemType>::MultiplyAndAdd(m_sampledWeights, false, m_sampledGradient, false, gradient);
+        m_temp.SetValue(m_labelWeights);
+        m_temp.RowElementMultiplyWith(m_labelGradient);
+        gradient += m_temp;
+    }
+    else
+    {
+        // only the columns of the samples and of the labels receive a gradient; both may contain duplicates
+        const Matrix<ElemType>& hidden = InputRef(INPUTDATA).MaskedValueFor(fr);
+        auto& gradient = InputRef(OUTPUTWEIGHTS).GradientAsMatrix();
+        m_temp.AssignProductOf(hidden, false, m_sampledGradient, true);
+        gradient.DoScatterColumnsOf(1, m_sampleIndices, m_temp, 1, /*idxHaveDups=*/ true);
+        m_temp.SetValue(hidden);
+        m_temp.RowElementMultiplyWith(m_labelGradient);
+        gradient.DoScatterColumnsOf(1, m_labelIndices, m_temp, 1, /*idxHaveDups=*/ true);
+    }
+}
+
+template <class ElemType>
+void SampledSoftmaxWithCrossEntropyNode<ElemType>::Validate(bool isFinalValidationPass)
+{
+    Base::Validate(isFinalValidationPass);
+    m_pMBLayout = nullptr; // this node does not hold mini-batch data
+
+    if (m_sizeOfSampledSet == 0)
+        InvalidArgument("%ls %ls operation: Number of requested samples is zero.", NodeName().c_str(), OperationName().c_str());
+
+    if (isFinalValidationPass)
+    {
+        size_t numClasses = Input(LABELDATA)->GetSampleMatrixNumRows();
+        if (Input(INPUTDATA)->GetSampleMatrixNumRows() != Input(OUTPUTWEIGHTS)->GetAsMatrixNumRows())
+            InvalidArgument("%ls %ls operation: The dimension of the hidden activation (%d) does not match the number of rows of the output weights (%d).",
+                            NodeName().c_str(), OperationName().c_str(), (int)Input(INPUTDATA)->GetSampleMatrixNumRows(), (int)Input(OUTPUTWEIGHTS)->GetAsMatrixNumRows());
+        if (Input(OUTPUTWEIGHTS)->GetAsMatrixNumCols() != numClasses)
+            InvalidArgument("%ls %ls operation: The number of columns of the output weights (%d) does not match the label dimension (%d).",
+                            NodeName().c_str(), OperationName().c_str(), (int)Input(OUTPUTWEIGHTS)->GetAsMatrixNumCols(), (int)numClasses);
+        if (Input(SAMPLINGWEIGHTS)->HasMBLayout() || Input(SAMPLINGWEIGHTS)->GetSampleLayout().GetNumElements() != numClasses)
+            InvalidArgument("%ls %ls operation: The sampling weights must be a vector with one element per class (%d).", NodeName().c_str(), OperationName().c_str(), (int)numClasses);
+        if (Input(LABELDATA)->GetMBLayout() != Input(INPUTDATA)->GetMBLayout())
+            InvalidArgument("%ls %ls operation requires that the layouts of inputs 0 (label) and 1 (hidden activation) match.", NodeName().c_str(), OperationName().c_str());
+        // the class indices of labels and samples are gathered and scattered as ElemType values, and half represents
+        // the integers exactly only up to 2048
+        if (std::is_same<ElemType, half>::value && numClasses > 2048)
+            InvalidArgument("%ls %ls operation: Half precision supports up to 2048 classes (%d given), use float or double.", NodeName().c_str(), OperationName().c_str(), (int)numClasses);
+    }
+
+    SetDims(TensorShape(1), false);
+}
+
+template <class ElemType>
+void SampledSoftmaxWithCrossEntropyNode<ElemType>::CopyTo(ComputationNodeBasePtr nodeP, const std::wstring& newName, const CopyNodeFlags flags) const
+{
+    Base::CopyTo(nodeP, newName, flags);
+    if (flags & CopyNodeFlags::copyNodeValue)
+    {
+        auto node = dynamic_pointer_cast<SampledSoftmaxWithCrossEntropyNode<ElemType>>(nodeP);
+        node->m_sizeOfSampledSet = m_sizeOfSampledSet;
+        node->SetRngState(GetRngSeed(), GetRngOffset());
+    }
+}
+
+template <class ElemType>
+void SampledSoftmaxWithCrossEntropyNode<ElemType>::Save(File& fstream) const
+{
+    Base::Save(fstream);
+    fstream << m_sizeOfSampledSet;
+    RngUser::Save(fstream);
+}
+
+template <class ElemType>
+void SampledSoftmaxWithCrossEntropyNode<ElemType>::Load(File& fstream, size_t modelVersion)
+{
+    Base::Load(fstream, modelVersion);
+    fstream >> m_sizeOfSampledSet;
+    RngUser::Load(fstream, modelVersion);
+}
+
+template class SampledSoftmaxWithCrossEntropyNode<float>;
+template class SampledSoftmaxWithCrossEntropyNode<double>;
+template class SampledSoftmaxWithCrossEntropyNode<half>;
+
 template<class ElemType>
 void DropoutNode<ElemType>::Save(File& fstream) const
 {
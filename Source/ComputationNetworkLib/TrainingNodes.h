@@ -1357,6 +1357,7 @@ public:
 
 protected:
 
+    // Rebuilds the prefix sum of the sampling weights if Input(0) was recomputed or updated since the last call.
     void UpdateWeightsPrefixSum();
 
     // Runs the sampling returning a vector with the id's of the samples. The parameter nTries is used to return the number of draws that was needed
@@ -1376,6 +1377,7 @@ protected:
     bool m_allowDuplicates; // The node can create samples allowing for duplicates (sampling with replacement) or not (sampling without replacement).
     size_t m_sizeOfSampledSet; // Requested size of sample in case of run-mode = CREATE_SAMPLES.
     std::vector<double> m_samplingWeightsPrefixSum;
+    uint64_t m_samplingWeightsTimeStamp = 0; // eval time stamp of Input(0) that m_samplingWeightsPrefixSum was computed from
 };
 
 // ------------------------------------------------------------------------------------------------------------------------------------------------
@@ -1456,6 +1458,145 @@ private:
     double EstimateNumberOfTries();
 };
 
+// -----------------------------------------------------------------------
+// AliasTable
+// Walker's alias method: draws from a fixed discrete distribution over numClasses classes in O(1) per sample,
+// using one uniform random number. Building the table is O(numClasses), so it pays off when the distribution
+// changes rarely compared to the number of samples drawn from it, as for the sampling weights of a vocabulary.
+// -----------------------------------------------------------------------
+
+class AliasTable
+{
+public:
+    // Builds the table for p(i) = weights[i] / sum_k(weights[k]). Weights must be >= 0 and not all zero.
+    void Build(const std::vector<double>& weights);
+
+    // Maps a uniform random number u in [0, 1) to a class index.
+    size_t Sample(double u) const
+    {
+        double x = u * m_probability.size();
+        size_t i = std::min((size_t)x, m_probability.size() - 1);
+        return (x - i) < m_probability[i] ? i : m_alias[i];
+    }
+
+    size_t GetNumClasses() const { return m_probability.size(); }
+    bool IsEmpty() const { return m_probability.empty(); }
+
+private:
+    std::vector<double> m_probability; // probability to keep bucket i rather than to take its alias
+    std::vector<size_t> m_alias;
+};
+
+// -----------------------------------------------------------------------
+// SampledSoftmaxWithCrossEntropyNode (labels, hidden, outputWeights, samplingWeights)
+// Sampled softmax criterion for output layers over very large vocabularies.
+//  - Input(0) [V x T] one-hot labels, preferably sparse
+//  - Input(1) [d x T] hidden activation. To model an output bias, append a constant row of ones to it.
+//  - Input(2) [d x V] output weights, one column per class
+//  - Input(3) [V x 1] sampling weights >= 0, e.g. unigram counts. They are treated as constant (no gradient).
+//  - sizeOfSampledSet: number S of classes sampled per minibatch
+//
+// In training, S classes are drawn with replacement from q(c) = samplingWeights(c) / sum(samplingWeights) and are
+// shared by all columns of the minibatch. Only the S sampled columns of the output weights are gathered, so the
+// logits cost one [S x d] x [d x T] product instead of the [V x d] x [d x T] product of the full softmax.
+// Each column's logits are those of its label followed by those of the samples, each corrected by -log(S q(c));
+// the criterion is the cross entropy of the softmax over these 1+S logits with the label at position 0.
+// Samples come from an AliasTable that is only rebuilt when the eval time stamp of the sampling weights changes.
+// Samples that happen to equal the label (accidental hits) are not removed.
+//
+// Outside of training the node computes the exact cross entropy with the full softmax, so that cross validation
+// and evaluation report true perplexities.
+// -----------------------------------------------------------------------
+
+template <class ElemType>
+class SampledSoftmaxWithCrossEntropyNode : public ComputationNodeNonLooping /*ComputationNode*/<ElemType>, public NumInputs<4>, public RngUser
+{
+    typedef ComputationNodeNonLooping<ElemType> Base; UsingComputationNodeMembersBoilerplate;
+    static const std::wstring TypeName() { return L"SampledSoftmaxWithCrossEntropy"; }
+
+    // our inputs
+    static const size_t LABELDATA = 0;
+    static const size_t INPUTDATA = 1;
+    static const size_t OUTPUTWEIGHTS = 2;
+    static const size_t SAMPLINGWEIGHTS = 3;
+
+public:
+    SampledSoftmaxWithCrossEntropyNode(DEVICEID_TYPE deviceId, const wstring& name, size_t sizeOfSampledSet = 0)
+        : Base(deviceId, name), m_sizeOfSampledSet(sizeOfSampledSet),
+          m_classIndices(deviceId), m_logSamplingProbs(deviceId),
+          m_sampleIndices(deviceId), m_sampleLogSamplingProbs(deviceId),
+          m_labelIndices(deviceId), m_labelLogSamplingProbs(deviceId),
+          m_sampledWeights(deviceId), m_labelWeights(deviceId),
+          m_labelLogits(deviceId), m_sampledLogits(deviceId),
+          m_logSoftmax(deviceId), m_softmax(deviceId),
+          m_labelGradient(deviceId), m_sampledGradient(deviceId),
+          m_temp(deviceId)
+    {
+        SetRngState(CreateUniqId());
+    }
+
+    SampledSoftmaxWithCrossEntropyNode(const ScriptableObjects::IConfigRecordPtr configp)
+        : SampledSoftmaxWithCrossEntropyNode(configp->Get(L"deviceId"), L"<placeholder>", configp->Get(L"sizeOfSampledSet"))
+    {
+        AttachInputsFromConfig(configp, this->GetExpectedNumInputs());
+    }
+
+    virtual void /*ComputationNodeNonLooping::*/ ForwardPropNonLooping() override;
+    virtual void BackpropToNonLooping(size_t inputIndex) override;
+    virtual void /*ComputationNodeBase::*/ Validate(bool isFinalValidationPass) override;
+
+    virtual bool OutputUsedInComputingInputNodesGradients() const override { return false; }
+    virtual void UpdateFunctionMBSize() override {}
+
+    virtual void CopyTo(ComputationNodeBasePtr nodeP, const std::wstring& newName, const CopyNodeFlags flags) const override;
+
+    virtual void Save(File& fstream) const override;
+    virtual void Load(File& fstream, size_t modelVersion) override;
+
+    size_t GetNumSamples() const { return m_sizeOfSampledSet; }
+
+private:
+    // Rebuilds the alias table and the log sampling probabilities if the sampling weights changed since the last call.
+    void UpdateAliasTable();
+
+    // Draws the shared samples of this minibatch into m_sampleIndices and m_sampleLogSamplingProbs.
+    void DrawSamples();
+
+    void ForwardPropSampled(const FrameRange& fr);
+    void ForwardPropFull(const FrameRange& fr);
+
+    // gradient of the criterion w.r.t. the label logits and the sampled logits
+    void ComputeLogitsGradient();
+
+private:
+    size_t m_sizeOfSampledSet;
+
+    AliasTable m_aliasTable;
+    uint64_t m_samplingWeightsTimeStamp = 0; // eval time stamp of the sampling weights the alias table was built from
+    std::vector<ElemType> m_logSamplingProbsBuffer; // log(S q(c)) of all classes, on the CPU
+    std::vector<ElemType> m_sampleIndicesBuffer;
+    std::vector<ElemType> m_sampleLogSamplingProbsBuffer;
+
+    Matrix<ElemType> m_classIndices;           // [1 x V] 0, 1, ..., V-1; times the labels gives the label indices
+    Matrix<ElemType> m_logSamplingProbs;       // [1 x V] log(S q(c))
+    Matrix<ElemType> m_sampleIndices;          // [1 x S]
+    Matrix<ElemType> m_sampleLogSamplingProbs; // [S x 1]
+    Matrix<ElemType> m_labelIndices;           // [1 x T]
+    Matrix<ElemType> m_labelLogSamplingProbs;  // [1 x T]
+    Matrix<ElemType> m_sampledWeights;         // [d x S] gathered columns of the output weights
+    Matrix<ElemType> m_labelWeights;           // [d x T]
+    Matrix<ElemType> m_labelLogits;            // [1 x T]
+    Matrix<ElemType> m_sampledLogits;          // [S x T]
+    Matrix<ElemType> m_logSoftmax;             // [(1+S) x T], or [V x T] outside of training
+    Matrix<ElemType> m_softmax;                // [(1+S) x T]
+    Matrix<ElemType> m_labelGradient;          // [1 x T]
+    Matrix<ElemType> m_sampledGradient;        // [S x T]
+    Matrix<ElemType> m_temp;
+
+    bool m_isSampled = false; // last forward pass used the sampled softmax
+    bool m_needRecomputeLogitsGradient = true;
+};
+
 // -----------------------------------------------------------------------
 // ClassBasedCrossEntropyWithSoftmaxNode (labeldata(.,t), inputdata(.,t), embeddingMatrix, clsProbBeforeSoftmaxData(.,t))
 //  - Input(0) [4 x T] label in dense matrix in
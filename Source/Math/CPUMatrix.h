@@ -29,6 +29,8 @@ namespace Microsoft { namespace MSR { namespace CNTK {
 
 double logadd(double x, double y);
 
+template<class ElemType> class CPURNNExecutor;
+
 // To comply with BLAS libraries matrices are stored in ColMajor. However, by default C/C++/C# use RowMajor
 // conversion is need when passing data between CPUMatrix and C++ matrices
 template <class ElemType>
@@ -435,6 +437,11 @@ public:
     void BatchNormalizationBackward(const CPUMatrix<ElemType>& in, CPUMatrix<ElemType>& grad, const CPUMatrix<StatType>& scale, double blendFactor, const CPUMatrix<StatType>& saveMean, const CPUMatrix<StatType>& saveInvStdDev,
                                     CPUMatrix<StatType>& scaleGrad, CPUMatrix<StatType>& biasGrad) const;
 
+    // RNN support functions
+    void RNNForward(const CPUMatrix<ElemType>& inputX, const CPUMatrix<ElemType>& paramW, size_t xDim, size_t yDim, const vector<size_t>& numSequencesForFrame, const struct RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace);
+    void RNNBackwardData(const CPUMatrix<ElemType>& outputDY, const CPUMatrix<ElemType>& paramW, CPUMatrix<ElemType>& outputDX, const struct RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace);
+    void RNNBackwardWeights(const CPUMatrix<ElemType>& inputX, const CPUMatrix<ElemType>& outputY, CPUMatrix<ElemType>& dw, const struct RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace);
+
 public:
     // This functions do not depend on <ElemType>, i.e. you can call them on any <ElemType>
     static int SetNumThreads(int numThreads);
@@ -597,6 +604,12 @@ private:
 
 private:
     static int m_optimizationFlags;
+
+// Have to use disable the warning to avoid issues with __declspec(dllexport) on Windows (C4251).
+#pragma warning(push)
+#pragma warning(disable : 4251)
+    mutable std::shared_ptr<CPURNNExecutor<ElemType>> m_rnnExecutor; // for OptimizedRNNStack
+#pragma warning(pop)
 };
 
 typedef CPUMatrix<float> CPUSingleMatrix;
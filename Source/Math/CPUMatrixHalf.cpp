@@ -7,44 +7,95 @@
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
-// General conversion function with no performance optimization
-// this should only be used in CPU half precision
-// For performance on inference on CPU, user should convert fp16 model to fp32 first, unless MKL supports half precision
-template<typename SrcT, typename DstT>
-static void ConvertBuffer(DstT* dst, const SrcT* src, size_t count)
+// Conversion of column-major blocks between half storage and float, F16C accelerated when the build targets it.
+static void HalfBlockToFloat(const half* src, size_t srcStride, size_t rows, size_t cols, float* dst)
 {
-    for (size_t i = 0; i < count; i++)
-    {
-        dst[i] = (DstT)src[i];
-    }
+    for (size_t j = 0; j < cols; j++)
+        ::CNTK::float16ToFloat(reinterpret_cast<const unsigned short*>(src + j * srcStride), dst + j * rows, rows);
 }
 
-// specialization to convert from half to float for computation, and then store in half
+static void FloatBlockToHalf(const float* src, size_t rows, size_t cols, half* dst, size_t dstStride)
+{
+    for (size_t j = 0; j < cols; j++)
+        ::CNTK::floatToFloat16(src + j * rows, reinterpret_cast<unsigned short*>(dst + j * dstStride), rows);
+}
+
+// Half precision GEMM. BLAS has no half precision product, so C is computed in tiles of s_halfGemmTileSize^2 elements:
+// each tile of C and the panels of op(A) and op(B) it needs are converted to float a block of s_halfGemmTileSize along the
+// inner dimension at a time, into per thread buffers that stay in cache, and multiplied by sgemm. Unlike converting
+// whole operands this needs no fp32 copy of the (possibly large) matrices, so fp16 models keep half the memory of fp32 ones.
+static const size_t s_halfGemmTileSize = 256;
+
 template <>
 void CPUMatrix<half>::MultiplyAndWeightedAdd(half alpha, const CPUMatrix<half>& a, const bool transposeA, const CPUMatrix<half>& b, const bool transposeB,
     half beta, CPUMatrix<half>& c, shared_ptr<QuantizedMultiplier<half>> pQuantizedMultiplier)
 {
-    CPUMatrix<float> af(a.GetNumRows(), a.GetNumCols());
-    CPUMatrix<float> bf(b.GetNumRows(), b.GetNumCols());
-    CPUMatrix<float> cf(c.GetNumRows(), c.GetNumCols());
+    if (pQuantizedMultiplier)
+        RuntimeError("Quantized matrix multiply not supported for Half");
 
-    if (alpha != 0)
-    {
-        ConvertBuffer<half, float>(af.Data(), a.Data(), a.GetNumElements());
-        ConvertBuffer<half, float>(bf.Data(), b.Data(), b.GetNumElements());
-    }
+    if (a.IsEmpty() || b.IsEmpty())
+        LogicError("MultiplyAndWeightedAdd:  one of the input matrices is empty.");
 
-    if (beta != 0)
-    {
-        ConvertBuffer<half, float>(cf.Data(), c.Data(), c.GetNumElements());
-    }
+    size_t m = transposeA ? a.GetNumCols() : a.GetNumRows();
+    size_t k = transposeA ? a.GetNumRows() : a.GetNumCols();
+    size_t l = transposeB ? b.GetNumCols() : b.GetNumRows();
+    size_t n = transposeB ? b.GetNumRows() : b.GetNumCols();
+    if (k != l)
+        InvalidArgument("CPUMatrix<ElemType>::MultiplyAndWeightedAdd : The inner dimensions of a (= %lu) and b (= %lu) don't match.", (unsigned long)k, (unsigned long)l);
 
-    if (pQuantizedMultiplier)
-        RuntimeError("Quantized matrix multiply not supported for Half");
+    if (beta == 0)
+        c.RequireSize(m, n);
+    else
+        c.VerifySize(m, n); // Can't resize if beta != 0
 
-    CPUMatrix<float>::MultiplyAndWeightedAdd((float)alpha, af, transposeA, bf, transposeB, (float)beta, cf, nullptr);
+    float alphaF = (float)alpha;
+    float betaF = (float)beta;
+    const size_t tile = s_halfGemmTileSize;
+    size_t tilesM = (m + tile - 1) / tile;
+    size_t tilesN = (n + tile - 1) / tile;
 
-    ConvertBuffer<float, half>(c.Data(), cf.Data(), c.GetNumElements());
+#pragma omp parallel
+    {
+        std::vector<float> aTile(tile * tile), bTile(tile * tile), cTile(tile * tile);
+#pragma omp for schedule(dynamic)
+        for (long long t = 0; t < (long long)(tilesM * tilesN); t++)
+        {
+            size_t i0 = (t % tilesM) * tile;
+            size_t j0 = (t / tilesM) * tile;
+            size_t mc = min(tile, m - i0);
+            size_t nc = min(tile, n - j0);
+
+            if (betaF != 0)
+                HalfBlockToFloat(c.Data() + j0 * m + i0, m, mc, nc, cTile.data());
+
+            if (alphaF == 0 || k == 0)
+            {
+                // Keeps NaNs in A or B from leaking in, like BLAS does.
+                for (size_t i = 0; i < mc * nc; i++)
+                    cTile[i] = betaF == 0 ? 0 : betaF * cTile[i];
+            }
+
+            for (size_t p0 = 0; alphaF != 0 && p0 < k; p0 += tile)
+            {
+                size_t kc = min(tile, k - p0);
+                // The tiles keep the stored orientation of A and B; sgemm applies the transposes.
+                if (transposeA)
+                    HalfBlockToFloat(a.Data() + i0 * k + p0, k, kc, mc, aTile.data());
+                else
+                    HalfBlockToFloat(a.Data() + p0 * m + i0, m, mc, kc, aTile.data());
+                if (transposeB)
+                    HalfBlockToFloat(b.Data() + p0 * n + j0, n, nc, kc, bTile.data());
+                else
+                    HalfBlockToFloat(b.Data() + j0 * k + p0, k, kc, nc, bTile.data());
+
+                cblas_sgemm(CblasColMajor, transposeA ? CblasTrans : CblasNoTrans, transposeB ? CblasTrans : CblasNoTrans,
+                            (int)mc, (int)nc, (int)kc, alphaF, aTile.data(), (int)(transposeA ? kc : mc), bTile.data(), (int)(transposeB ? nc : kc),
+                            p0 == 0 ? betaF : 1.0f, cTile.data(), (int)mc);
+            }
+
+            FloatBlockToHalf(cTile.data(), mc, nc, c.Data() + j0 * m + i0, m);
+        }
+    }
 }
 
 // specialization to RunTimeError for now due to omp implementation only support build-in type
@@ -113,6 +164,24 @@ void CPUMatrix<half>::AveragePoolingBackward(const CPUMatrix<int>& mpRowCol, con
     RuntimeError("half AveragePoolingBackward not supported.");
 }
 
+template <>
+void CPUMatrix<half>::RNNForward(const CPUMatrix<half>& inputX, const CPUMatrix<half>& paramW, size_t xDim, size_t yDim, const vector<size_t>& numSequencesForFrame, const RnnAttributes& rnnAttributes, CPUMatrix<half>& reserve, CPUMatrix<half>& workspace)
+{
+    RuntimeError("half RNNForward not supported.");
+}
+
+template <>
+void CPUMatrix<half>::RNNBackwardData(const CPUMatrix<half>& outputDY, const CPUMatrix<half>& paramW, CPUMatrix<half>& outputDX, const RnnAttributes& rnnAttributes, CPUMatrix<half>& reserve, CPUMatrix<half>& workspace)
+{
+    RuntimeError("half RNNBackwardData not supported.");
+}
+
+template <>
+void CPUMatrix<half>::RNNBackwardWeights(const CPUMatrix<half>& inputX, const CPUMatrix<half>& outputY, CPUMatrix<half>& dw, const RnnAttributes& rnnAttributes, CPUMatrix<half>& reserve, CPUMatrix<half>& workspace)
+{
+    RuntimeError("half RNNBackwardWeights not supported.");
+}
+
 // explicit instantiations, due to CPUMatrix being too big and causing VS2015 cl crash.
 template class MATH_API CPUMatrix<half>;
 template<> int CPUMatrix<half>::m_optimizationFlags = 0;
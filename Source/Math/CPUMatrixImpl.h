@@ -11,6 +11,7 @@
 #include "File.h"
 
 #include "CPUMatrix.h"
+#include "CPURNN.h"
 #include "TensorOps.h"
 #include <assert.h>
 #include <stdexcept>
@@ -5077,6 +5078,48 @@ void CPUMatrix<ElemType>::AveragePoolingBackward(const CPUMatrix<int>& mpRowCol,
     }
 }
 
+// Work split of the batch normalization passes over a minibatch of batchSize columns with numMaps maps of spatialSize
+// values each: the columns are cut into chunks and the maps into blocks of at least s_minBlockSize values, so every
+// item reads contiguous memory and there are enough items for all threads, also for small minibatches.
+class BatchNormWorkSplit
+{
+public:
+    BatchNormWorkSplit(size_t numMaps, size_t spatialSize, size_t batchSize)
+        : m_numMaps(numMaps), m_batchSize(batchSize)
+    {
+        size_t numThreads = (size_t)omp_get_max_threads();
+        m_mapsPerBlock = min(numMaps, max((size_t)1, s_minBlockSize / spatialSize));
+        m_numMapBlocks = (numMaps + m_mapsPerBlock - 1) / m_mapsPerBlock;
+        m_numChunks = max((size_t)1, min(batchSize, (numThreads + m_numMapBlocks - 1) / m_numMapBlocks));
+    }
+
+    size_t NumChunks() const { return m_numChunks; }
+
+    // Calls fn(chunk, firstColumn, endColumn, firstMap, endMap) for all items, in parallel.
+    template <class Fn>
+    void ForEach(const Fn& fn) const
+    {
+#pragma omp parallel for schedule(dynamic)
+        for (long long item = 0; item < (long long)(m_numChunks * m_numMapBlocks); item++)
+        {
+            size_t chunk = (size_t)item / m_numMapBlocks;
+            size_t mapBlock = (size_t)item % m_numMapBlocks;
+            fn(chunk, chunk * m_batchSize / m_numChunks, (chunk + 1) * m_batchSize / m_numChunks,
+               mapBlock * m_mapsPerBlock, min(m_numMaps, (mapBlock + 1) * m_mapsPerBlock));
+        }
+    }
+
+private:
+    static const size_t s_minBlockSize = 256;
+
+    size_t m_numMaps, m_batchSize;
+    size_t m_mapsPerBlock, m_numMapBlocks, m_numChunks;
+};
+
+// Training uses two passes over the input: the first computes mean and variance of all maps at once (each item
+// merges the statistics of the maps of every column into its running ones with Chan's update of Welford's algorithm,
+// and the items of a map are merged the same way), the second normalizes, scales and shifts. Running statistics and
+// saved statistics follow the GPU implementation in CntkBatchNormalization.cuh.
 template <class ElemType>
 template <class StatType>
 void CPUMatrix<ElemType>::BatchNormalizationForward(const CPUMatrix<StatType>& scale, const CPUMatrix<StatType>& bias, bool inferenceOnly, double expAvgFactor, double blendFactor,
@@ -5086,51 +5129,221 @@ void CPUMatrix<ElemType>::BatchNormalizationForward(const CPUMatrix<StatType>& s
     if (GetNumRows() % scale.GetNumRows() != 0)
         LogicError("The number of rows of this matrx must be multiple of the number of rows of the scale matrix.");
 
-    if (!inferenceOnly || expAvgFactor != 0 || blendFactor != 1)
-        RuntimeError("Batch normalization training on CPU is not yet implemented.");
-
-    saveMean.Resize(0, 0); // only doing inference: these two are not produced
-    saveInvStdDev.Resize(0, 0);
+    size_t numMaps = scale.GetNumRows();
+    size_t spatialSize = GetNumRows() / numMaps;
+    size_t vectorSize = GetNumRows();
+    size_t batchSize = GetNumCols();
+    BatchNormWorkSplit split(numMaps, spatialSize, batchSize);
 
-    bool spatial = GetNumRows() != scale.GetNumRows();
-    if (spatial)
+    // Mean and inverse standard deviation used for normalizing.
+    std::vector<StatType> mean(numMaps), invStdDev(numMaps);
+    if (inferenceOnly || (expAvgFactor == 0 && blendFactor == 1))
     {
-        size_t spatialSize = GetNumRows() / scale.GetNumRows();
-#pragma omp parallel for
-        for (long icol = 0; icol < out.GetNumCols(); icol++)
+        // Normalize with the running statistics, which need no update.
+        assert(!inferenceOnly || (expAvgFactor == 0 && blendFactor == 1));
+        for (size_t imap = 0; imap < numMaps; imap++)
         {
-            for (long irow = 0; irow < out.GetNumRows(); irow++)
+            mean[imap] = runMean(imap, 0);
+            invStdDev[imap] = (StatType)(1 / sqrt(runVariance(imap, 0) + epsilon));
+        }
+    }
+    else
+    {
+        // Per chunk of columns, running mean and sum of squared differences from it of every map.
+        size_t numChunks = split.NumChunks();
+        std::vector<StatType> chunkMean(numChunks * numMaps, 0), chunkM2(numChunks * numMaps, 0);
+        split.ForEach([&](size_t chunk, size_t colBegin, size_t colEnd, size_t mapBegin, size_t mapEnd)
+        {
+            StatType* pmean = chunkMean.data() + chunk * numMaps;
+            StatType* pm2 = chunkM2.data() + chunk * numMaps;
+            for (size_t icol = colBegin; icol < colEnd; icol++)
+            {
+                StatType countSoFar = (StatType)((icol - colBegin) * spatialSize);
+                StatType countNew = countSoFar + spatialSize;
+                for (size_t imap = mapBegin; imap < mapEnd; imap++)
+                {
+                    const ElemType* px = Data() + icol * vectorSize + imap * spatialSize;
+                    StatType sum = 0;
+                    for (size_t i = 0; i < spatialSize; i++)
+                        sum += (StatType)px[i];
+                    StatType colMean = sum / spatialSize;
+                    StatType colM2 = 0;
+                    for (size_t i = 0; i < spatialSize; i++)
+                    {
+                        StatType d = (StatType)px[i] - colMean;
+                        colM2 += d * d;
+                    }
+                    StatType d = colMean - pmean[imap];
+                    pmean[imap] += d * spatialSize / countNew;
+                    pm2[imap] += colM2 + d * d * countSoFar * spatialSize / countNew;
+                }
+            }
+        });
+
+        size_t count = batchSize * spatialSize;
+        for (size_t imap = 0; imap < numMaps; imap++)
+        {
+            StatType batchMean = chunkMean[imap];
+            StatType batchM2 = chunkM2[imap];
+            StatType countSoFar = (StatType)(batchSize / numChunks * spatialSize);
+            for (size_t chunk = 1; chunk < numChunks; chunk++)
             {
-                size_t imap = irow / spatialSize;
-                ElemType stdDev = sqrt(runVariance(imap, 0) + epsilon);
-                out(irow, icol) = (ElemType)(scale(imap, 0) * ((*this)(irow, icol) - runMean(imap, 0)) / stdDev + bias(imap, 0));
+                StatType chunkCount = (StatType)(((chunk + 1) * batchSize / numChunks - chunk * batchSize / numChunks) * spatialSize);
+                StatType d = chunkMean[chunk * numMaps + imap] - batchMean;
+                batchMean += d * chunkCount / (countSoFar + chunkCount);
+                batchM2 += chunkM2[chunk * numMaps + imap] + d * d * countSoFar * chunkCount / (countSoFar + chunkCount);
+                countSoFar += chunkCount;
             }
+
+            runMean(imap, 0) = (StatType)(expAvgFactor * batchMean + (1 - expAvgFactor) * runMean(imap, 0));
+            mean[imap] = (StatType)(blendFactor * runMean(imap, 0) + (1 - blendFactor) * batchMean);
+
+            StatType unbiasedVariance = count == 1 ? 0 : batchM2 / (count - 1);
+            runVariance(imap, 0) = (StatType)(expAvgFactor * unbiasedVariance + (1 - expAvgFactor) * runVariance(imap, 0));
+            invStdDev[imap] = (StatType)(1 / sqrt(batchM2 / count + epsilon));
+            if (blendFactor != 0)
+                invStdDev[imap] = (StatType)(blendFactor / sqrt(runVariance(imap, 0) + epsilon) + (1 - blendFactor) * invStdDev[imap]);
         }
     }
+
+    if (inferenceOnly)
+    {
+        saveMean.Resize(0, 0); // only doing inference: these two are not produced
+        saveInvStdDev.Resize(0, 0);
+    }
     else
     {
-#pragma omp parallel for
-        for (long icol = 0; icol < out.GetNumCols(); icol++)
+        saveMean.RequireSize(numMaps, 1);
+        saveInvStdDev.RequireSize(numMaps, 1);
+        memcpy(saveMean.Data(), mean.data(), numMaps * sizeof(StatType));
+        memcpy(saveInvStdDev.Data(), invStdDev.data(), numMaps * sizeof(StatType));
+    }
+
+    split.ForEach([&](size_t, size_t colBegin, size_t colEnd, size_t mapBegin, size_t mapEnd)
+    {
+        for (size_t icol = colBegin; icol < colEnd; icol++)
         {
-            for (long irow = 0; irow < out.GetNumRows(); irow++)
+            for (size_t imap = mapBegin; imap < mapEnd; imap++)
             {
-                ElemType stdDev = sqrt(runVariance(irow, 0) + epsilon);
-                out(irow, icol) = (ElemType)(scale(irow, 0) * ((*this)(irow, icol) - runMean(irow, 0)) / stdDev + bias(irow, 0));
+                const ElemType* px = Data() + icol * vectorSize + imap * spatialSize;
+                ElemType* py = out.Data() + icol * vectorSize + imap * spatialSize;
+                StatType m = mean[imap];
+                StatType factor = scale(imap, 0) * invStdDev[imap];
+                StatType offset = bias(imap, 0);
+                for (size_t i = 0; i < spatialSize; i++)
+                    py[i] = (ElemType)(((StatType)px[i] - m) * factor + offset);
             }
         }
-    }
+    });
 }
 
+// 'this' is the gradient of the output; the data gradient is added to grad. As in the forward pass the gradients of
+// scale and bias are reduced in one pass over input and output gradient, and the data gradient, which depends on
+// them, is computed in a second one.
 template <class ElemType>
 template <class StatType>
 void CPUMatrix<ElemType>::BatchNormalizationBackward(const CPUMatrix<ElemType>& in, CPUMatrix<ElemType>& grad, const CPUMatrix<StatType>& scale, double blendFactor,
                                                      const CPUMatrix<StatType>& saveMean, const CPUMatrix<StatType>& saveInvStdDev,
                                                      CPUMatrix<StatType>& scaleGrad, CPUMatrix<StatType>& biasGrad) const
 {
-    UNUSED(in); UNUSED(grad); UNUSED(scale); UNUSED(blendFactor), UNUSED(saveMean); UNUSED(saveInvStdDev); UNUSED(scaleGrad); UNUSED(biasGrad);
-    RuntimeError("Batch normalization training on CPU is not yet implemented.");
+    if (GetNumRows() % scale.GetNumRows() != 0)
+        LogicError("The number of rows of this matrx must be multiple of the number of rows of the scale matrix.");
+
+    size_t numMaps = scale.GetNumRows();
+    size_t spatialSize = GetNumRows() / numMaps;
+    size_t vectorSize = GetNumRows();
+    size_t batchSize = GetNumCols();
+    BatchNormWorkSplit split(numMaps, spatialSize, batchSize);
+
+    size_t numChunks = split.NumChunks();
+    std::vector<StatType> chunkScaleGrad(numChunks * numMaps, 0), chunkBiasGrad(numChunks * numMaps, 0);
+    split.ForEach([&](size_t chunk, size_t colBegin, size_t colEnd, size_t mapBegin, size_t mapEnd)
+    {
+        for (size_t icol = colBegin; icol < colEnd; icol++)
+        {
+            for (size_t imap = mapBegin; imap < mapEnd; imap++)
+            {
+                const ElemType* px = in.Data() + icol * vectorSize + imap * spatialSize;
+                const ElemType* pdy = Data() + icol * vectorSize + imap * spatialSize;
+                StatType m = saveMean(imap, 0);
+                StatType ds = 0, db = 0;
+                for (size_t i = 0; i < spatialSize; i++)
+                {
+                    ds += (StatType)pdy[i] * ((StatType)px[i] - m);
+                    db += (StatType)pdy[i];
+                }
+                chunkScaleGrad[chunk * numMaps + imap] += ds * saveInvStdDev(imap, 0);
+                chunkBiasGrad[chunk * numMaps + imap] += db;
+            }
+        }
+    });
+
+    for (size_t imap = 0; imap < numMaps; imap++)
+    {
+        StatType ds = 0, db = 0;
+        for (size_t chunk = 0; chunk < numChunks; chunk++)
+        {
+            ds += chunkScaleGrad[chunk * numMaps + imap];
+            db += chunkBiasGrad[chunk * numMaps + imap];
+        }
+        scaleGrad(imap, 0) = ds;
+        biasGrad(imap, 0) = db;
+    }
+
+    // From the BN paper, with xHat the normalized input and m the number of values per map:
+    //   dx = scale * invStdDev * (dy - mbStatsWeight * (xHat * dScale + dBias) / m)
+    // where mbStatsWeight is the weight of the minibatch statistics in the forward pass (0 for a locked model).
+    StatType mbStatsWeight = (StatType)(1 - blendFactor);
+    StatType count = (StatType)(batchSize * spatialSize);
+    split.ForEach([&](size_t, size_t colBegin, size_t colEnd, size_t mapBegin, size_t mapEnd)
+    {
+        for (size_t icol = colBegin; icol < colEnd; icol++)
+        {
+            for (size_t imap = mapBegin; imap < mapEnd; imap++)
+            {
+                const ElemType* px = in.Data() + icol * vectorSize + imap * spatialSize;
+                const ElemType* pdy = Data() + icol * vectorSize + imap * spatialSize;
+                ElemType* pdx = grad.Data() + icol * vectorSize + imap * spatialSize;
+                StatType m = saveMean(imap, 0);
+                StatType invStdDev = saveInvStdDev(imap, 0);
+                StatType factor = scale(imap, 0) * invStdDev;
+                StatType xHatWeight = mbStatsWeight * scaleGrad(imap, 0) * invStdDev / count;
+                StatType offset = mbStatsWeight * biasGrad(imap, 0) / count;
+                for (size_t i = 0; i < spatialSize; i++)
+                    pdx[i] = (ElemType)((StatType)pdx[i] + factor * ((StatType)pdy[i] - ((StatType)px[i] - m) * xHatWeight - offset));
+            }
+        }
+    });
 }
 
+#pragma region RNN Functions
+
+template <class ElemType>
+void CPUMatrix<ElemType>::RNNForward(const CPUMatrix<ElemType>& inputX, const CPUMatrix<ElemType>& paramW, size_t xDim, size_t yDim, const vector<size_t>& numSequencesForFrame, const RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace)
+{
+    if (!m_rnnExecutor)
+        m_rnnExecutor = std::make_shared<CPURNNExecutor<ElemType>>(xDim, yDim, rnnAttributes);
+    m_rnnExecutor->ForwardCore(paramW, inputX, *this, numSequencesForFrame, rnnAttributes, reserve, workspace);
+}
+
+template <class ElemType>
+void CPUMatrix<ElemType>::RNNBackwardData(const CPUMatrix<ElemType>& outputDY, const CPUMatrix<ElemType>& paramW, CPUMatrix<ElemType>& outputDX, const RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace)
+{
+    if (!m_rnnExecutor)
+        LogicError("RNNBackwardData called, but RNNWrapper object is not yet initialized");
+    m_rnnExecutor->BackwardDataCore(*this, outputDY, paramW, outputDX, rnnAttributes, reserve, workspace);
+}
+
+template <class ElemType>
+void CPUMatrix<ElemType>::RNNBackwardWeights(const CPUMatrix<ElemType>& inputX, const CPUMatrix<ElemType>& outputY, CPUMatrix<ElemType>& dw, const RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace)
+{
+    if (!m_rnnExecutor)
+        LogicError("RNNBackwardWeights called, but RNNWrapper object is not yet initialized");
+    m_rnnExecutor->BackwardWeightsCore(inputX, outputY, dw, rnnAttributes, reserve, workspace);
+}
+
+#pragma endregion RNN Functions
+
 
 #pragma region Static BLAS Functions
 
@@ -5213,11 +5426,7 @@ void CPUMatrix<ElemType>::MultiplyAndWeightedAdd(ElemType alpha, const CPUMatrix
     }
     else
     {
-        // TODO: support transpose product
-        if (mklTransA == CBLAS_TRANSPOSE::CblasTrans || mklTransB == CBLAS_TRANSPOSE::CblasTrans)
-            LogicError("Quantized multiplier currently doesn't support transpose.");
-
-        pQuantizedMultiplier->Multiply(m, n, k, a.Data(), b.Data(), c.Data());
+        pQuantizedMultiplier->Multiply(m, n, k, mklTransA == CBLAS_TRANSPOSE::CblasTrans, mklTransB == CBLAS_TRANSPOSE::CblasTrans, a.Data(), b.Data(), c.Data());
     }
 }
 
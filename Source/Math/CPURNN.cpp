@@ -0,0 +1,553 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include "CPURNN.h"
+#include "TensorOps.h"
+#include <algorithm>
+#include <omp.h>
+
+#ifdef USE_MKL
+#include <mkl_cblas.h>
+#else
+#include <cblas.h>
+#endif
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// Column major GEMM on raw buffers; the recurrence works on row slices (one direction of a bidirectional
+// output) and column ranges (the active sequences of a frame) that CPUMatrix cannot express as views.
+static void Gemm(bool transA, bool transB, size_t m, size_t n, size_t k, float alpha, const float* a, size_t lda, const float* b, size_t ldb, float beta, float* c, size_t ldc)
+{
+    cblas_sgemm(CblasColMajor, transA ? CblasTrans : CblasNoTrans, transB ? CblasTrans : CblasNoTrans,
+                (int)m, (int)n, (int)k, alpha, a, (int)lda, b, (int)ldb, beta, c, (int)ldc);
+}
+
+static void Gemm(bool transA, bool transB, size_t m, size_t n, size_t k, double alpha, const double* a, size_t lda, const double* b, size_t ldb, double beta, double* c, size_t ldc)
+{
+    cblas_dgemm(CblasColMajor, transA ? CblasTrans : CblasNoTrans, transB ? CblasTrans : CblasNoTrans,
+                (int)m, (int)n, (int)k, alpha, a, (int)lda, b, (int)ldb, beta, c, (int)ldc);
+}
+
+// c += a * x, with a being m x n.
+static void Gemv(size_t m, size_t n, const float* a, size_t lda, const float* x, float* c)
+{
+    cblas_sgemv(CblasColMajor, CblasNoTrans, (int)m, (int)n, 1.0f, a, (int)lda, x, 1, 1.0f, c, 1);
+}
+
+static void Gemv(size_t m, size_t n, const double* a, size_t lda, const double* x, double* c)
+{
+    cblas_dgemv(CblasColMajor, CblasNoTrans, (int)m, (int)n, 1.0, a, (int)lda, x, 1, 1.0, c, 1);
+}
+
+// Columns are distributed over threads only if a frame carries enough work to pay for the fork.
+static const size_t MinElementsPerParallelFrame = 4096;
+
+template <class ElemType>
+CPURNNExecutor<ElemType>::CPURNNExecutor(size_t xDim, size_t yDim, const RnnAttributes& rnnAttributes)
+    : m_rnnAttributes(rnnAttributes), m_xDim(xDim), m_yDim(yDim), m_numColumns(0), m_BackwardDataCalledYet(false)
+{
+    if      (m_rnnAttributes.m_recurrentOp == wstring(L"lstm"))    m_cellKind = CellKind::LSTM;
+    else if (m_rnnAttributes.m_recurrentOp == wstring(L"gru"))     m_cellKind = CellKind::GRU;
+    else if (m_rnnAttributes.m_recurrentOp == wstring(L"rnnReLU")) m_cellKind = CellKind::ReLU;
+    else if (m_rnnAttributes.m_recurrentOp == wstring(L"rnnTanh")) m_cellKind = CellKind::Tanh;
+    else InvalidArgument("Unknown cell type '%ls'. Supported values are 'lstm', 'gru', 'rnnReLU', 'rnnTanh'.", m_rnnAttributes.m_recurrentOp.c_str());
+
+    m_numGates = (m_cellKind == CellKind::LSTM) ? 4 : (m_cellKind == CellKind::GRU) ? 3 : 1;
+
+    // Same layout as cudnnGetRNNLinLayerMatrixParams(): all weight matrices layer by layer and direction by direction,
+    // followed by all biases in the same order.
+    const size_t hidden = m_rnnAttributes.m_hiddenSize;
+    const size_t gateRows = m_numGates * hidden;
+    size_t offset = 0;
+    m_offsets.resize(m_rnnAttributes.m_numLayers * NumDirections());
+    for (size_t layer = 0; layer < m_rnnAttributes.m_numLayers; layer++)
+    {
+        for (size_t direction = 0; direction < NumDirections(); direction++)
+        {
+            auto& offsets = m_offsets[layer * NumDirections() + direction];
+            offsets.m_w = offset;
+            offset += LayerInputDim(layer) * gateRows;
+            offsets.m_r = offset;
+            offset += hidden * gateRows;
+        }
+    }
+    for (auto& offsets : m_offsets)
+    {
+        offsets.m_bw = offset;
+        offset += gateRows;
+        offsets.m_br = offset;
+        offset += gateRows;
+    }
+    m_numParameters = offset;
+}
+
+template <class ElemType>
+size_t CPURNNExecutor<ElemType>::GateStateRows() const
+{
+    const size_t hidden = m_rnnAttributes.m_hiddenSize;
+    switch (m_cellKind)
+    {
+    case CellKind::LSTM: return 5 * hidden; // i, f, g, o, c
+    case CellKind::GRU:  return 4 * hidden; // r, z, n, and the recurrent part of n before the reset gate is applied
+    default:             return 0;          // the output is all that is needed
+    }
+}
+
+template <class ElemType>
+size_t CPURNNExecutor<ElemType>::GateGradientRows() const
+{
+    // GRU keeps the gradient of the recurrent part of n separately, since the reset gate sits between it and n.
+    return (m_cellKind == CellKind::GRU ? 4 : m_numGates) * m_rnnAttributes.m_hiddenSize;
+}
+
+template <class ElemType>
+size_t CPURNNExecutor<ElemType>::NumPreviousStates(size_t t, bool backward) const
+{
+    // Sequences are sorted by decreasing length, so the sequences that continue a state are a prefix of the frame.
+    if (backward)
+        return (t + 1 < m_numSequencesForFrame.size()) ? m_numSequencesForFrame[t + 1] : 0;
+    else
+        return (t > 0) ? m_numSequencesForFrame[t] : 0;
+}
+
+template <class ElemType>
+ElemType* CPURNNExecutor<ElemType>::LayerOutput(size_t layer, ElemType* reserve, ElemType* outputY) const
+{
+    if (layer + 1 == m_rnnAttributes.m_numLayers)
+        return outputY;
+    return reserve + layer * m_yDim * m_numColumns;
+}
+
+template <class ElemType>
+ElemType* CPURNNExecutor<ElemType>::GateState(size_t layer, size_t direction, ElemType* reserve) const
+{
+    const size_t layerOutputs = (m_rnnAttributes.m_numLayers - 1) * m_yDim * m_numColumns;
+    return reserve + layerOutputs + (layer * NumDirections() + direction) * GateStateRows() * m_numColumns;
+}
+
+template <class ElemType>
+void CPURNNExecutor<ElemType>::ForwardCore(
+    const CPUMatrix<ElemType>& weightsW,
+    const CPUMatrix<ElemType>& inputX, CPUMatrix<ElemType>& outputY,
+    const vector<size_t>& numSequencesForFrame,
+    const RnnAttributes& rnnAttributes,
+    CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace)
+{
+    UNUSED(workspace); // the forward pass only needs the reserve
+
+    // test that the RNN shape is correct
+    if (!(m_rnnAttributes == rnnAttributes))
+        LogicError("RNN Layout has changed during processing");
+
+    if (m_yDim != NumDirections() * m_rnnAttributes.m_hiddenSize)
+        InvalidArgument("CPU RNN ForwardCore: Output leading dimension must be twice hidden size for bidirectional networks");
+
+    if (weightsW.GetNumElements() != m_numParameters)
+        InvalidArgument("RNN needs %ld parameters, but %ld were allocated", m_numParameters, weightsW.GetNumElements());
+
+    m_numSequencesForFrame = numSequencesForFrame;
+    m_frameOffsets.resize(m_numSequencesForFrame.size());
+    m_numColumns = 0;
+    for (size_t t = 0; t < m_numSequencesForFrame.size(); t++)
+    {
+        if (t > 0 && m_numSequencesForFrame[t] > m_numSequencesForFrame[t - 1])
+            InvalidArgument("CPU RNN ForwardCore: Sequences must be sorted by decreasing length.");
+        m_frameOffsets[t] = m_numColumns;
+        m_numColumns += m_numSequencesForFrame[t];
+    }
+
+    if (inputX.GetNumRows() != m_xDim || inputX.GetNumCols() != m_numColumns)
+        InvalidArgument("CPU RNN ForwardCore: Input is %d x %d, expected %d x %d.", (int)inputX.GetNumRows(), (int)inputX.GetNumCols(), (int)m_xDim, (int)m_numColumns);
+
+    const size_t numLayers = m_rnnAttributes.m_numLayers;
+    outputY.Resize(m_yDim, m_numColumns);
+    reserve.Resize((numLayers - 1) * m_yDim * m_numColumns + numLayers * NumDirections() * GateStateRows() * m_numColumns, 1);
+
+    const ElemType* w = weightsW.Data();
+    const ElemType* x = inputX.Data();
+    for (size_t layer = 0; layer < numLayers; layer++)
+    {
+        ElemType* y = LayerOutput(layer, reserve.Data(), outputY.Data());
+        for (size_t direction = 0; direction < NumDirections(); direction++)
+            ForwardDirection(layer, direction, w, x, y, GateState(layer, direction, reserve.Data()));
+        x = y;
+    }
+
+    m_BackwardDataCalledYet = false;
+}
+
+template <class ElemType>
+void CPURNNExecutor<ElemType>::ForwardDirection(size_t layer, size_t direction, const ElemType* w, const ElemType* x, ElemType* y, ElemType* gates) const
+{
+    const size_t hidden = m_rnnAttributes.m_hiddenSize;
+    const size_t inputDim = LayerInputDim(layer);
+    const size_t gateRows = m_numGates * hidden;
+    const size_t stateRows = GateStateRows();
+    const bool backward = direction == 1;
+    const auto& offsets = Offsets(layer, direction);
+    const ElemType* weights = w + offsets.m_w;
+    const ElemType* recurrentWeights = w + offsets.m_r;
+    const ElemType* bias = w + offsets.m_bw;
+    const ElemType* recurrentBias = w + offsets.m_br;
+    ElemType* h = y + direction * hidden; // this direction's rows of the layer output, leading dimension m_yDim
+
+    // Input projection of all frames at once. Plain RNNs accumulate their pre-activation right in the output.
+    if (m_cellKind == CellKind::LSTM || m_cellKind == CellKind::GRU)
+        Gemm(true, false, gateRows, m_numColumns, inputDim, (ElemType)1, weights, inputDim, x, inputDim, (ElemType)0, gates, stateRows);
+    else
+        Gemm(true, false, hidden, m_numColumns, inputDim, (ElemType)1, weights, inputDim, x, inputDim, (ElemType)0, h, m_yDim);
+
+    const size_t numFrames = m_numSequencesForFrame.size();
+    for (size_t step = 0; step < numFrames; step++)
+    {
+        const size_t t = backward ? numFrames - 1 - step : step;
+        const size_t numSequences = m_numSequencesForFrame[t];
+        const size_t numPrevious = NumPreviousStates(t, backward);
+        const size_t frameOffset = FrameOffset(t);
+        const size_t prevOffset = numPrevious > 0 ? FrameOffset(PreviousFrame(t, backward)) : 0;
+
+        // Recurrent projection, only for the sequences that carry a state over from the previous frame.
+        if (numPrevious > 0)
+        {
+            const ElemType* hPrev = h + prevOffset * m_yDim;
+            switch (m_cellKind)
+            {
+            case CellKind::LSTM:
+                Gemm(true, false, gateRows, numPrevious, hidden, (ElemType)1, recurrentWeights, hidden, hPrev, m_yDim, (ElemType)1, gates + frameOffset * stateRows, stateRows);
+                break;
+            case CellKind::GRU:
+                Gemm(true, false, 2 * hidden, numPrevious, hidden, (ElemType)1, recurrentWeights, hidden, hPrev, m_yDim, (ElemType)1, gates + frameOffset * stateRows, stateRows);
+                Gemm(true, false, hidden, numPrevious, hidden, (ElemType)1, recurrentWeights + 2 * hidden * hidden, hidden, hPrev, m_yDim, (ElemType)0, gates + frameOffset * stateRows + 3 * hidden, stateRows);
+                break;
+            default:
+                Gemm(true, false, hidden, numPrevious, hidden, (ElemType)1, recurrentWeights, hidden, hPrev, m_yDim, (ElemType)1, h + frameOffset * m_yDim, m_yDim);
+                break;
+            }
+        }
+
+        // Biases, gate nonlinearities and state update, fused into one pass over each column.
+#pragma omp parallel for if (numSequences * gateRows >= MinElementsPerParallelFrame)
+        for (long j = 0; j < (long)numSequences; j++)
+        {
+            const bool hasPrevious = (size_t)j < numPrevious;
+            ElemType* hOut = h + (frameOffset + j) * m_yDim;
+            const ElemType* hIn = hasPrevious ? h + (prevOffset + j) * m_yDim : nullptr;
+            ElemType* g = gates + (frameOffset + j) * stateRows;
+            switch (m_cellKind)
+            {
+            case CellKind::LSTM:
+            {
+                ElemType* gi = g;
+                ElemType* gf = g + hidden;
+                ElemType* gc = g + 2 * hidden;
+                ElemType* go = g + 3 * hidden;
+                ElemType* c = g + 4 * hidden;
+                const ElemType* cPrev = hasPrevious ? gates + (prevOffset + j) * stateRows + 4 * hidden : nullptr;
+                for (size_t k = 0; k < gateRows; k++)
+                    g[k] += bias[k] + recurrentBias[k];
+                for (size_t k = 0; k < hidden; k++)
+                {
+                    gi[k] = StableSigmoid(gi[k]);
+                    gf[k] = StableSigmoid(gf[k]);
+                    gc[k] = tanh_(gc[k]);
+                    go[k] = StableSigmoid(go[k]);
+                }
+                for (size_t k = 0; k < hidden; k++)
+                    c[k] = gi[k] * gc[k] + (hasPrevious ? gf[k] * cPrev[k] : 0);
+                for (size_t k = 0; k < hidden; k++)
+                    hOut[k] = go[k] * tanh_(c[k]);
+                break;
+            }
+            case CellKind::GRU:
+            {
+                ElemType* gr = g;
+                ElemType* gz = g + hidden;
+                ElemType* gn = g + 2 * hidden;
+                ElemType* hn = g + 3 * hidden;
+                for (size_t k = 0; k < 2 * hidden; k++)
+                    g[k] = StableSigmoid(g[k] + bias[k] + recurrentBias[k]);
+                for (size_t k = 0; k < hidden; k++)
+                    hn[k] = (hasPrevious ? hn[k] : 0) + recurrentBias[2 * hidden + k];
+                for (size_t k = 0; k < hidden; k++)
+                    gn[k] = tanh_(gn[k] + bias[2 * hidden + k] + gr[k] * hn[k]);
+                for (size_t k = 0; k < hidden; k++)
+                    hOut[k] = (1 - gz[k]) * gn[k] + (hasPrevious ? gz[k] * hIn[k] : 0);
+                break;
+            }
+            case CellKind::ReLU:
+                for (size_t k = 0; k < hidden; k++)
+                    hOut[k] = std::max<ElemType>(hOut[k] + bias[k] + recurrentBias[k], 0);
+                break;
+            case CellKind::Tanh:
+                for (size_t k = 0; k < hidden; k++)
+                    hOut[k] = tanh_(hOut[k] + bias[k] + recurrentBias[k]);
+                break;
+            }
+        }
+    }
+}
+
+template <class ElemType>
+void CPURNNExecutor<ElemType>::BackwardDataCore(
+    const CPUMatrix<ElemType>& outputY, const CPUMatrix<ElemType>& outputDY, const CPUMatrix<ElemType>& weightsW, CPUMatrix<ElemType>& dx,
+    const RnnAttributes& rnnAttributes,
+    CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace)
+{
+    // test that the RNN shape is correct
+    if (!(m_rnnAttributes == rnnAttributes))
+        LogicError("RNN Layout has changed during processing");
+
+    if (m_BackwardDataCalledYet)
+        return;
+
+    if (outputDY.GetNumRows() != m_yDim || outputDY.GetNumCols() != m_numColumns)
+        InvalidArgument("CPU RNN BackwardDataCore: Output gradient does not match the output of the last forward pass.");
+
+    const size_t hidden = m_rnnAttributes.m_hiddenSize;
+    const size_t numLayers = m_rnnAttributes.m_numLayers;
+    const size_t gateRows = m_numGates * hidden;
+    const size_t gradientRows = GateGradientRows();
+
+    // Workspace: the gate gradients of all layers (kept for BackwardWeightsCore), the gradient of the hidden
+    // and cell state of the direction being processed, and two buffers for the gradient passed between layers.
+    const size_t gateGradientsSize = numLayers * NumDirections() * gradientRows * m_numColumns;
+    const size_t stateSize = hidden * m_numColumns;
+    const size_t layerGradientSize = numLayers > 1 ? m_yDim * m_numColumns : 0;
+    workspace.Resize(gateGradientsSize + 2 * stateSize + 2 * layerGradientSize, 1);
+    ElemType* dGates = workspace.Data();
+    ElemType* dh = dGates + gateGradientsSize;
+    ElemType* dc = dh + stateSize;
+    ElemType* layerGradients[2] = { dc + stateSize, dc + stateSize + layerGradientSize };
+
+    dx.Resize(m_xDim, m_numColumns);
+
+    const ElemType* w = weightsW.Data();
+    const ElemType* dy = outputDY.Data();
+    for (size_t layer = numLayers; layer-- > 0;)
+    {
+        const size_t inputDim = LayerInputDim(layer);
+        const ElemType* y = LayerOutput(layer, reserve.Data(), outputY.Data());
+        ElemType* dInput = layer == 0 ? dx.Data() : layerGradients[layer % 2];
+        for (size_t direction = 0; direction < NumDirections(); direction++)
+        {
+            ElemType* dGatesOfDirection = dGates + (layer * NumDirections() + direction) * gradientRows * m_numColumns;
+            BackwardDataDirection(layer, direction, w, y, dy, GateState(layer, direction, reserve.Data()), dGatesOfDirection, dh, dc);
+
+            // Gradient of the layer input, summed over both directions.
+            Gemm(false, false, inputDim, m_numColumns, gateRows, (ElemType)1, w + Offsets(layer, direction).m_w, inputDim, dGatesOfDirection, gradientRows,
+                 direction == 0 ? (ElemType)0 : (ElemType)1, dInput, inputDim);
+        }
+        dy = dInput;
+    }
+
+    m_BackwardDataCalledYet = true;
+}
+
+template <class ElemType>
+void CPURNNExecutor<ElemType>::BackwardDataDirection(size_t layer, size_t direction, const ElemType* w, const ElemType* y, const ElemType* dy, const ElemType* gates,
+                                                     ElemType* dGates, ElemType* dh, ElemType* dc) const
+{
+    const size_t hidden = m_rnnAttributes.m_hiddenSize;
+    const size_t gateRows = m_numGates * hidden;
+    const size_t stateRows = GateStateRows();
+    const size_t gradientRows = GateGradientRows();
+    const bool backward = direction == 1;
+    const ElemType* recurrentWeights = w + Offsets(layer, direction).m_r;
+    const ElemType* h = y + direction * hidden;
+
+    // dh starts out as the gradient of this direction's output; the frames add the recurrent part on top as they go.
+#pragma omp parallel for if (m_numColumns * hidden >= MinElementsPerParallelFrame)
+    for (long col = 0; col < (long)m_numColumns; col++)
+        std::copy(dy + col * m_yDim + direction * hidden, dy + col * m_yDim + (direction + 1) * hidden, dh + col * hidden);
+    if (m_cellKind == CellKind::LSTM)
+        std::fill(dc, dc + hidden * m_numColumns, (ElemType)0);
+
+    // Frames are visited in the opposite order of the forward pass.
+    const size_t numFrames = m_numSequencesForFrame.size();
+    for (size_t step = 0; step < numFrames; step++)
+    {
+        const size_t t = backward ? step : numFrames - 1 - step;
+        const size_t numSequences = m_numSequencesForFrame[t];
+        const size_t numPrevious = NumPreviousStates(t, backward);
+        const size_t frameOffset = FrameOffset(t);
+        const size_t prevOffset = numPrevious > 0 ? FrameOffset(PreviousFrame(t, backward)) : 0;
+
+#pragma omp parallel for if (numSequences * gateRows >= MinElementsPerParallelFrame)
+        for (long j = 0; j < (long)numSequences; j++)
+        {
+            const bool hasPrevious = (size_t)j < numPrevious;
+            const size_t col = frameOffset + j;
+            const size_t prevCol = prevOffset + j;
+            const ElemType* dhCol = dh + col * hidden;
+            const ElemType* g = gates + col * stateRows;
+            ElemType* dg = dGates + col * gradientRows;
+            switch (m_cellKind)
+            {
+            case CellKind::LSTM:
+            {
+                const ElemType* gi = g;
+                const ElemType* gf = g + hidden;
+                const ElemType* gc = g + 2 * hidden;
+                const ElemType* go = g + 3 * hidden;
+                const ElemType* c = g + 4 * hidden;
+                const ElemType* cPrev = hasPrevious ? gates + prevCol * stateRows + 4 * hidden : nullptr;
+                ElemType* dcCol = dc + col * hidden;
+                ElemType* dcPrev = dc + prevCol * hidden;
+                for (size_t k = 0; k < hidden; k++)
+                {
+                    ElemType tanhC = tanh_(c[k]);
+                    ElemType dcTotal = dcCol[k] + dhCol[k] * go[k] * (1 - tanhC * tanhC);
+                    dg[k]              = dcTotal * gc[k] * gi[k] * (1 - gi[k]);
+                    dg[hidden + k]     = hasPrevious ? dcTotal * cPrev[k] * gf[k] * (1 - gf[k]) : 0;
+                    dg[2 * hidden + k] = dcTotal * gi[k] * (1 - gc[k] * gc[k]);
+                    dg[3 * hidden + k] = dhCol[k] * tanhC * go[k] * (1 - go[k]);
+                    if (hasPrevious)
+                        dcPrev[k] = dcTotal * gf[k];
+                }
+                break;
+            }
+            case CellKind::GRU:
+            {
+                const ElemType* gr = g;
+                const ElemType* gz = g + hidden;
+                const ElemType* gn = g + 2 * hidden;
+                const ElemType* hn = g + 3 * hidden;
+                const ElemType* hIn = h + prevCol * m_yDim;
+                ElemType* dhPrev = dh + prevCol * hidden;
+                for (size_t k = 0; k < hidden; k++)
+                {
+                    ElemType hPrev = hasPrevious ? hIn[k] : 0;
+                    ElemType dn = dhCol[k] * (1 - gz[k]) * (1 - gn[k] * gn[k]);
+                    dg[k]              = dn * hn[k] * gr[k] * (1 - gr[k]);
+                    dg[hidden + k]     = dhCol[k] * (hPrev - gn[k]) * gz[k] * (1 - gz[k]);
+                    dg[2 * hidden + k] = dn;
+                    dg[3 * hidden + k] = dn * gr[k];
+                    if (hasPrevious)
+                        dhPrev[k] += dhCol[k] * gz[k];
+                }
+                break;
+            }
+            case CellKind::ReLU:
+            {
+                const ElemType* hOut = h + col * m_yDim;
+                for (size_t k = 0; k < hidden; k++)
+                    dg[k] = hOut[k] > 0 ? dhCol[k] : 0;
+                break;
+            }
+            case CellKind::Tanh:
+            {
+                const ElemType* hOut = h + col * m_yDim;
+                for (size_t k = 0; k < hidden; k++)
+                    dg[k] = dhCol[k] * (1 - hOut[k] * hOut[k]);
+                break;
+            }
+            }
+        }
+
+        // Hand the gradient of the recurrent projection to the previous frame.
+        if (numPrevious > 0)
+        {
+            ElemType* dhPrev = dh + prevOffset * hidden;
+            const ElemType* dg = dGates + frameOffset * gradientRows;
+            if (m_cellKind == CellKind::GRU)
+            {
+                Gemm(false, false, hidden, numPrevious, 2 * hidden, (ElemType)1, recurrentWeights, hidden, dg, gradientRows, (ElemType)1, dhPrev, hidden);
+                Gemm(false, false, hidden, numPrevious, hidden, (ElemType)1, recurrentWeights + 2 * hidden * hidden, hidden, dg + 3 * hidden, gradientRows, (ElemType)1, dhPrev, hidden);
+            }
+            else
+                Gemm(false, false, hidden, numPrevious, gateRows, (ElemType)1, recurrentWeights, hidden, dg, gradientRows, (ElemType)1, dhPrev, hidden);
+        }
+    }
+}
+
+template <class ElemType>
+void CPURNNExecutor<ElemType>::BackwardWeightsCore(const CPUMatrix<ElemType>& inputX, const CPUMatrix<ElemType>& outputY, CPUMatrix<ElemType>& dw,
+                                                   const RnnAttributes& rnnAttributes,
+                                                   CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace)
+{
+    // test that the RNN shape is correct
+    if (!(m_rnnAttributes == rnnAttributes))
+        LogicError("RNN Layout has changed during processing");
+    if (!m_BackwardDataCalledYet)
+        LogicError("CPU RNN BackwardWeightsCore: BackwardDataCore must be called first.");
+    if (dw.GetNumElements() != m_numParameters)
+        InvalidArgument("RNN needs %ld parameters, but %ld were allocated", m_numParameters, dw.GetNumElements());
+
+    // The hidden state gradient buffer of BackwardDataCore is reused to hold the shifted hidden states.
+    const size_t gradientRows = GateGradientRows();
+    ElemType* dGates = workspace.Data();
+    ElemType* hPrev = dGates + m_rnnAttributes.m_numLayers * NumDirections() * gradientRows * m_numColumns;
+
+    // Like cuDNN, the gradients are added to dw.
+    const ElemType* x = inputX.Data();
+    for (size_t layer = 0; layer < m_rnnAttributes.m_numLayers; layer++)
+    {
+        const ElemType* y = LayerOutput(layer, reserve.Data(), outputY.Data());
+        for (size_t direction = 0; direction < NumDirections(); direction++)
+        {
+            const ElemType* dGatesOfDirection = dGates + (layer * NumDirections() + direction) * gradientRows * m_numColumns;
+            BackwardWeightsDirection(layer, direction, x, y, dGatesOfDirection, hPrev, dw.Data());
+        }
+        x = y;
+    }
+}
+
+template <class ElemType>
+void CPURNNExecutor<ElemType>::BackwardWeightsDirection(size_t layer, size_t direction, const ElemType* x, const ElemType* y, const ElemType* dGates,
+                                                        ElemType* hPrev, ElemType* dw) const
+{
+    const size_t hidden = m_rnnAttributes.m_hiddenSize;
+    const size_t inputDim = LayerInputDim(layer);
+    const size_t gateRows = m_numGates * hidden;
+    const size_t gradientRows = GateGradientRows();
+    const bool backward = direction == 1;
+    const auto& offsets = Offsets(layer, direction);
+    const ElemType* h = y + direction * hidden;
+
+    // Input weights: all frames in one GEMM.
+    Gemm(false, true, inputDim, gateRows, m_numColumns, (ElemType)1, x, inputDim, dGates, gradientRows, (ElemType)1, dw + offsets.m_w, inputDim);
+
+    // Recurrent weights: line the previous hidden state up with each column (zero where a sequence starts), then one GEMM as well.
+    const size_t numFrames = m_numSequencesForFrame.size();
+    for (size_t t = 0; t < numFrames; t++)
+    {
+        const size_t numSequences = m_numSequencesForFrame[t];
+        const size_t numPrevious = NumPreviousStates(t, backward);
+        const size_t frameOffset = FrameOffset(t);
+        const size_t prevOffset = numPrevious > 0 ? FrameOffset(PreviousFrame(t, backward)) : 0;
+        for (size_t j = 0; j < numSequences; j++)
+        {
+            ElemType* hPrevCol = hPrev + (frameOffset + j) * hidden;
+            if (j < numPrevious)
+                std::copy(h + (prevOffset + j) * m_yDim, h + (prevOffset + j) * m_yDim + hidden, hPrevCol);
+            else
+                std::fill(hPrevCol, hPrevCol + hidden, (ElemType)0);
+        }
+    }
+    if (m_cellKind == CellKind::GRU)
+    {
+        Gemm(false, true, hidden, 2 * hidden, m_numColumns, (ElemType)1, hPrev, hidden, dGates, gradientRows, (ElemType)1, dw + offsets.m_r, hidden);
+        Gemm(false, true, hidden, hidden, m_numColumns, (ElemType)1, hPrev, hidden, dGates + 3 * hidden, gradientRows, (ElemType)1, dw + offsets.m_r + 2 * hidden * hidden, hidden);
+    }
+    else
+        Gemm(false, true, hidden, gateRows, m_numColumns, (ElemType)1, hPrev, hidden, dGates, gradientRows, (ElemType)1, dw + offsets.m_r, hidden);
+
+    // Biases: row sums of the gate gradients, done as a product with a vector of ones.
+    ElemType* ones = hPrev;
+    std::fill(ones, ones + m_numColumns, (ElemType)1);
+    Gemv(gateRows, m_numColumns, dGates, gradientRows, ones, dw + offsets.m_bw);
+    if (m_cellKind == CellKind::GRU)
+    {
+        Gemv(2 * hidden, m_numColumns, dGates, gradientRows, ones, dw + offsets.m_br);
+        Gemv(hidden, m_numColumns, dGates + 3 * hidden, gradientRows, ones, dw + offsets.m_br + 2 * hidden);
+    }
+    else
+        Gemv(gateRows, m_numColumns, dGates, gradientRows, ones, dw + offsets.m_br);
+}
+
+template class CPURNNExecutor<float>;
+template class CPURNNExecutor<double>;
+
+} } }
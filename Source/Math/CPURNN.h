@@ -0,0 +1,85 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#pragma once
+
+#include "CPUMatrix.h"
+#include "RNNCommon.h"
+#include <vector>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// CPURNNExecutor is the CPU counterpart of CuDnnRNNExecutor: it runs a stack of (optionally bidirectional)
+// LSTM, GRU or plain RNN layers on sequences packed the way cuDNN expects them, i.e. frame by frame with the
+// sequences of each frame sorted by decreasing length. Weights use the cuDNN 'linear input' layout, so models
+// trained on the GPU evaluate and keep training on the CPU unchanged.
+//
+// Per layer and direction the input projection of all time steps is done by a single GEMM; the recurrence then
+// walks the frames and only touches the numSequencesForFrame[t] sequences that are active in frame t. Gate
+// nonlinearities and the cell update are fused into one pass over each column.
+//
+// Like the cuDNN executor it is attached to the output matrix; the reserve holds the activations that the
+// backward passes need and must not be touched between ForwardCore() and the backward calls.
+template <class ElemType>
+class CPURNNExecutor
+{
+public:
+    CPURNNExecutor(size_t xDim, size_t yDim, const RnnAttributes& rnnAttributes);
+
+    void ForwardCore(const CPUMatrix<ElemType>& weightsW, const CPUMatrix<ElemType>& inputX, CPUMatrix<ElemType>& outputY, const vector<size_t>& numSequencesForFrame, const RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace);
+    void BackwardWeightsCore(const CPUMatrix<ElemType>& inputX, const CPUMatrix<ElemType>& outputY, CPUMatrix<ElemType>& dw, const RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace);
+    void BackwardDataCore(const CPUMatrix<ElemType>& outputY, const CPUMatrix<ElemType>& outputDY, const CPUMatrix<ElemType>& w, CPUMatrix<ElemType>& dx, const RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace);
+
+private:
+    enum class CellKind { LSTM, GRU, ReLU, Tanh };
+
+    // Offsets of the blocks of one layer and direction inside the parameter vector.
+    struct ParameterOffsets
+    {
+        size_t m_w;  // input weights, inputDim x (numGates * hidden)
+        size_t m_r;  // recurrent weights, hidden x (numGates * hidden)
+        size_t m_bw; // input bias, numGates * hidden
+        size_t m_br; // recurrent bias, numGates * hidden
+    };
+
+    size_t NumDirections() const { return m_rnnAttributes.m_bidirectional ? 2 : 1; }
+    size_t LayerInputDim(size_t layer) const { return layer == 0 ? m_xDim : m_yDim; }
+    const ParameterOffsets& Offsets(size_t layer, size_t direction) const { return m_offsets[layer * NumDirections() + direction]; }
+
+    // Rows per column of the activations kept in the reserve for one layer and direction, and of their gradients in the workspace.
+    size_t GateStateRows() const;
+    size_t GateGradientRows() const;
+
+    // Column range of frame t, and the number of its sequences that continue a state of the previous frame in the given direction.
+    size_t FrameOffset(size_t t) const { return m_frameOffsets[t]; }
+    size_t NumPreviousStates(size_t t, bool backward) const;
+    size_t PreviousFrame(size_t t, bool backward) const { return backward ? t + 1 : t - 1; }
+
+    // Activations of layer 'layer': intermediate layers live in the reserve, the top layer in the output.
+    ElemType* LayerOutput(size_t layer, ElemType* reserve, ElemType* outputY) const;
+    ElemType* GateState(size_t layer, size_t direction, ElemType* reserve) const;
+
+    void ForwardDirection(size_t layer, size_t direction, const ElemType* w, const ElemType* x, ElemType* y, ElemType* gates) const;
+    void BackwardDataDirection(size_t layer, size_t direction, const ElemType* w, const ElemType* y, const ElemType* dy, const ElemType* gates,
+                               ElemType* dGates, ElemType* dh, ElemType* dc) const;
+    void BackwardWeightsDirection(size_t layer, size_t direction, const ElemType* x, const ElemType* y, const ElemType* dGates,
+                                  ElemType* hPrev, ElemType* dw) const;
+
+private:
+    RnnAttributes m_rnnAttributes;
+    CellKind m_cellKind;
+    size_t m_numGates;
+    size_t m_xDim, m_yDim;
+    size_t m_numParameters;
+    std::vector<ParameterOffsets> m_offsets;
+
+    // Packing of the current minibatch.
+    std::vector<size_t> m_numSequencesForFrame;
+    std::vector<size_t> m_frameOffsets;
+    size_t m_numColumns;
+
+    bool m_BackwardDataCalledYet;
+};
+
+} } }
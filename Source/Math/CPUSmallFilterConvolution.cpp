@@ -0,0 +1,400 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include "Basics.h"
+#include "CPUSmallFilterConvolution.h"
+#include <algorithm>
+#include <vector>
+
+#ifdef USE_MKL
+#include <mkl_cblas.h>
+#else
+#include <cblas.h>
+#endif
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+static void Gemm(size_t m, size_t n, size_t k, const float* a, size_t lda, const float* b, size_t ldb, float* c, size_t ldc)
+{
+    cblas_sgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, (int)m, (int)n, (int)k, 1.0f, a, (int)lda, b, (int)ldb, 0.0f, c, (int)ldc);
+}
+
+static void Gemm(size_t m, size_t n, size_t k, const double* a, size_t lda, const double* b, size_t ldb, double* c, size_t ldc)
+{
+    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, (int)m, (int)n, (int)k, 1.0, a, (int)lda, b, (int)ldb, 0.0, c, (int)ldc);
+}
+
+// Transformation matrices of Winograd F(m x m, 3 x 3) from Lavin & Gray, "Fast Algorithms for Convolutional Neural Networks".
+// A tile of (m + 2) x (m + 2) inputs d and the 3 x 3 kernel g give m x m outputs Y = A^T [(G g G^T) .* (B^T d B)] A.
+template <size_t m>
+struct WinogradTransforms;
+
+template <>
+struct WinogradTransforms<2>
+{
+    static constexpr double BT[4][4] = {
+        { 1,  0, -1,  0 },
+        { 0,  1,  1,  0 },
+        { 0, -1,  1,  0 },
+        { 0,  1,  0, -1 } };
+    static constexpr double G[4][3] = {
+        { 1,    0,   0   },
+        { 0.5,  0.5, 0.5 },
+        { 0.5, -0.5, 0.5 },
+        { 0,    0,   1   } };
+    static constexpr double AT[2][4] = {
+        { 1, 1,  1,  0 },
+        { 0, 1, -1, -1 } };
+};
+
+template <>
+struct WinogradTransforms<4>
+{
+    static constexpr double BT[6][6] = {
+        { 4,  0, -5,  0, 1, 0 },
+        { 0, -4, -4,  1, 1, 0 },
+        { 0,  4, -4, -1, 1, 0 },
+        { 0, -2, -1,  2, 1, 0 },
+        { 0,  2, -1, -2, 1, 0 },
+        { 0,  4,  0, -5, 0, 1 } };
+    static constexpr double G[6][3] = {
+        {  1.0 / 4,   0,         0       },
+        { -1.0 / 6,  -1.0 / 6,  -1.0 / 6 },
+        { -1.0 / 6,   1.0 / 6,  -1.0 / 6 },
+        {  1.0 / 24,  1.0 / 12,  1.0 / 6 },
+        {  1.0 / 24, -1.0 / 12,  1.0 / 6 },
+        {  0,         0,         1       } };
+    static constexpr double AT[4][6] = {
+        { 1, 1,  1, 1,  1, 0 },
+        { 0, 1, -1, 2, -2, 0 },
+        { 0, 1,  1, 4,  4, 0 },
+        { 0, 1, -1, 8, -8, 1 } };
+};
+
+constexpr double WinogradTransforms<2>::BT[4][4];
+constexpr double WinogradTransforms<2>::G[4][3];
+constexpr double WinogradTransforms<2>::AT[2][4];
+constexpr double WinogradTransforms<4>::BT[6][6];
+constexpr double WinogradTransforms<4>::G[6][3];
+constexpr double WinogradTransforms<4>::AT[4][6];
+
+// Y = L X R^T for row-major L (rows x inner) and R (cols x inner); X is inner x inner.
+template <class ElemType, size_t rows, size_t cols, size_t inner>
+static inline void Transform(const double (&l)[rows][inner], const ElemType (&x)[inner][inner], const double (&r)[cols][inner], ElemType (&y)[rows][cols])
+{
+    ElemType t[rows][inner];
+    for (size_t i = 0; i < rows; i++)
+        for (size_t j = 0; j < inner; j++)
+        {
+            ElemType sum = 0;
+            for (size_t k = 0; k < inner; k++)
+                sum += (ElemType)l[i][k] * x[k][j];
+            t[i][j] = sum;
+        }
+    for (size_t i = 0; i < rows; i++)
+        for (size_t j = 0; j < cols; j++)
+        {
+            ElemType sum = 0;
+            for (size_t k = 0; k < inner; k++)
+                sum += t[i][k] * (ElemType)r[j][k];
+            y[i][j] = sum;
+        }
+}
+
+template <class ElemType>
+bool CPUSmallFilterConvolution<ElemType>::IsSupported(const Geometry& g)
+{
+    auto isSmall = [](size_t kernelSize) { return kernelSize == 1 || kernelSize == 3; };
+    return isSmall(g.m_kernelW) && isSmall(g.m_kernelH) &&
+           g.m_strideW > 0 && g.m_strideH > 0 && g.m_dilationW > 0 && g.m_dilationH > 0 &&
+           g.m_padW >= 0 && g.m_padH >= 0 &&
+           g.m_inC > 0 && g.m_outC > 0 && g.m_outW > 0 && g.m_outH > 0;
+}
+
+template <class ElemType>
+CPUSmallFilterConvolution<ElemType>::CPUSmallFilterConvolution(const Geometry& geometry)
+    : m_geometry(geometry)
+{
+    if (!IsSupported(geometry))
+        InvalidArgument("CPUSmallFilterConvolution: only 1x1 and 3x3 kernels with non-negative padding are supported.");
+
+    const auto& g = m_geometry;
+    bool unitStride = g.m_strideW == 1 && g.m_strideH == 1 && g.m_dilationW == 1 && g.m_dilationH == 1;
+    if (unitStride && g.m_kernelW == 1 && g.m_kernelH == 1 && g.m_padW == 0 && g.m_padH == 0 && g.m_outW == g.m_inW && g.m_outH == g.m_inH)
+        m_algorithm = Algorithm::Pointwise;
+    else if (unitStride && g.m_kernelW == 3 && g.m_kernelH == 3)
+        // The larger tiles waste work on the border of small outputs.
+        m_algorithm = (g.m_outW >= 8 && g.m_outH >= 8) ? Algorithm::Winograd4x4 : Algorithm::Winograd2x2;
+    else
+        m_algorithm = Algorithm::Direct;
+}
+
+template <class ElemType>
+size_t CPUSmallFilterConvolution<ElemType>::GetPreparedKernelSize() const
+{
+    const auto& g = m_geometry;
+    switch (m_algorithm)
+    {
+    case Algorithm::Winograd2x2:
+    case Algorithm::Winograd4x4:
+    {
+        size_t tileSize = m_algorithm == Algorithm::Winograd2x2 ? 2 : 4;
+        return (tileSize + 2) * (tileSize + 2) * g.m_outC * g.m_inC;
+    }
+    case Algorithm::Direct:
+    {
+        size_t numBlocks = (g.m_outC + s_mapBlockSize - 1) / s_mapBlockSize;
+        return numBlocks * s_mapBlockSize * g.m_inC * g.m_kernelH * g.m_kernelW;
+    }
+    default:
+        return 0;
+    }
+}
+
+template <class ElemType>
+size_t CPUSmallFilterConvolution<ElemType>::GetWorkspaceSize() const
+{
+    const auto& g = m_geometry;
+    switch (m_algorithm)
+    {
+    case Algorithm::Winograd2x2:
+    case Algorithm::Winograd4x4:
+    {
+        size_t tileSize = m_algorithm == Algorithm::Winograd2x2 ? 2 : 4;
+        // Transformed inputs and products of one sample.
+        return (tileSize + 2) * (tileSize + 2) * (g.m_inC + g.m_outC) * NumTiles(tileSize);
+    }
+    default:
+        return 0;
+    }
+}
+
+template <class ElemType>
+void CPUSmallFilterConvolution<ElemType>::PrepareKernel(const ElemType* kernel, ElemType* preparedKernel) const
+{
+    switch (m_algorithm)
+    {
+    case Algorithm::Winograd2x2:
+        TransformKernel<2>(kernel, preparedKernel);
+        break;
+    case Algorithm::Winograd4x4:
+        TransformKernel<4>(kernel, preparedKernel);
+        break;
+    case Algorithm::Direct:
+        PackKernel(kernel, preparedKernel);
+        break;
+    default:
+        break;
+    }
+}
+
+template <class ElemType>
+void CPUSmallFilterConvolution<ElemType>::Forward(const ElemType* in, const ElemType* kernel, const ElemType* preparedKernel, ElemType* out, size_t batchSize, ElemType* workspace) const
+{
+    switch (m_algorithm)
+    {
+    case Algorithm::Pointwise:
+        ForwardPointwise(in, kernel, out, batchSize);
+        break;
+    case Algorithm::Winograd2x2:
+        ForwardWinograd<2>(in, preparedKernel, out, batchSize, workspace);
+        break;
+    case Algorithm::Winograd4x4:
+        ForwardWinograd<4>(in, preparedKernel, out, batchSize, workspace);
+        break;
+    case Algorithm::Direct:
+        ForwardDirect(in, preparedKernel, out, batchSize);
+        break;
+    }
+}
+
+// A sample is a [WH x C] matrix and the kernel a [C x K] one, so each sample is one GEMM.
+template <class ElemType>
+void CPUSmallFilterConvolution<ElemType>::ForwardPointwise(const ElemType* in, const ElemType* kernel, ElemType* out, size_t batchSize) const
+{
+    const auto& g = m_geometry;
+    size_t mapSize = g.m_inW * g.m_inH;
+    for (size_t n = 0; n < batchSize; n++)
+        Gemm(mapSize, g.m_outC, g.m_inC, in + n * mapSize * g.m_inC, mapSize, kernel, g.m_inC, out + n * mapSize * g.m_outC, mapSize);
+}
+
+// The kernel transformed into U = G g G^T, laid out [point][map][channel]. The transform runs in double precision,
+// as its result is kept for as long as the kernel does not change.
+template <class ElemType>
+template <size_t m>
+void CPUSmallFilterConvolution<ElemType>::TransformKernel(const ElemType* kernel, ElemType* u) const
+{
+    using T = WinogradTransforms<m>;
+    const size_t alpha = m + 2;
+    const size_t KC = m_geometry.m_outC * m_geometry.m_inC;
+
+#pragma omp parallel for
+    for (long long kc = 0; kc < (long long)KC; kc++)
+    {
+        const ElemType* src = kernel + kc * 9;
+        // G is alpha x 3, so the kernel transform is a non-square instance of L X R^T.
+        double t[alpha][3];
+        for (size_t i = 0; i < alpha; i++)
+            for (size_t j = 0; j < 3; j++)
+                t[i][j] = T::G[i][0] * src[j] + T::G[i][1] * src[3 + j] + T::G[i][2] * src[6 + j];
+        for (size_t i = 0; i < alpha; i++)
+            for (size_t j = 0; j < alpha; j++)
+                u[(i * alpha + j) * KC + kc] = (ElemType)(t[i][0] * T::G[j][0] + t[i][1] * T::G[j][1] + t[i][2] * T::G[j][2]);
+    }
+}
+
+// Samples are processed one at a time:
+// 1. the input tiles of every channel are transformed into V, laid out [point][channel][tile];
+// 2. for every one of the (m + 2)^2 points, the products summed over channels are the GEMM M = V U,
+//    with U the transformed kernel of TransformKernel();
+// 3. M, laid out [point][map][tile], is transformed back into output tiles.
+template <class ElemType>
+template <size_t m>
+void CPUSmallFilterConvolution<ElemType>::ForwardWinograd(const ElemType* in, const ElemType* u, ElemType* out, size_t batchSize, ElemType* workspace) const
+{
+    using T = WinogradTransforms<m>;
+    const size_t alpha = m + 2;
+    const size_t points = alpha * alpha;
+    const auto& g = m_geometry;
+    const size_t C = g.m_inC;
+    const size_t K = g.m_outC;
+    const size_t tilesW = (g.m_outW + m - 1) / m;
+    const size_t tilesH = (g.m_outH + m - 1) / m;
+    const size_t numTiles = tilesW * tilesH;
+
+    ElemType* v = workspace;
+    ElemType* products = v + points * C * numTiles;
+
+    for (size_t n = 0; n < batchSize; n++)
+    {
+        const ElemType* sample = in + n * g.m_inW * g.m_inH * C;
+        ElemType* sampleOut = out + n * g.m_outW * g.m_outH * K;
+
+#pragma omp parallel for
+        for (long long ct = 0; ct < (long long)(C * numTiles); ct++)
+        {
+            size_t c = ct / numTiles;
+            size_t tile = ct % numTiles;
+            int h0 = (int)((tile / tilesW) * m) - g.m_padH;
+            int w0 = (int)((tile % tilesW) * m) - g.m_padW;
+            const ElemType* map = sample + c * g.m_inW * g.m_inH;
+            ElemType d[alpha][alpha], transformed[alpha][alpha];
+            for (size_t i = 0; i < alpha; i++)
+            {
+                int h = h0 + (int)i;
+                for (size_t j = 0; j < alpha; j++)
+                {
+                    int w = w0 + (int)j;
+                    d[i][j] = (h >= 0 && h < (int)g.m_inH && w >= 0 && w < (int)g.m_inW) ? map[w + g.m_inW * h] : 0;
+                }
+            }
+            Transform(T::BT, d, T::BT, transformed);
+            for (size_t p = 0; p < points; p++)
+                v[(p * C + c) * numTiles + tile] = transformed[p / alpha][p % alpha];
+        }
+
+        for (size_t p = 0; p < points; p++)
+            Gemm(numTiles, K, C, v + p * C * numTiles, numTiles, u + p * K * C, C, products + p * K * numTiles, numTiles);
+
+#pragma omp parallel for
+        for (long long kt = 0; kt < (long long)(K * numTiles); kt++)
+        {
+            size_t k = kt / numTiles;
+            size_t tile = kt % numTiles;
+            size_t h0 = (tile / tilesW) * m;
+            size_t w0 = (tile % tilesW) * m;
+            ElemType product[alpha][alpha], y[m][m];
+            for (size_t p = 0; p < points; p++)
+                product[p / alpha][p % alpha] = products[(p * K + k) * numTiles + tile];
+            Transform(T::AT, product, T::AT, y);
+            ElemType* map = sampleOut + k * g.m_outW * g.m_outH;
+            for (size_t i = 0; i < m && h0 + i < g.m_outH; i++)
+                for (size_t j = 0; j < m && w0 + j < g.m_outW; j++)
+                    map[(w0 + j) + g.m_outW * (h0 + i)] = y[i][j];
+        }
+    }
+}
+
+// The weights are packed as [map block][channel][kernel row][kernel column][map within block], zero filled past the
+// last map; every output row of a map block then accumulates in a [W' x block] buffer.
+template <class ElemType>
+void CPUSmallFilterConvolution<ElemType>::PackKernel(const ElemType* kernel, ElemType* packed) const
+{
+    const size_t B = s_mapBlockSize;
+    const size_t K = m_geometry.m_outC;
+    const size_t kernelSize = m_geometry.m_kernelW * m_geometry.m_kernelH * m_geometry.m_inC;
+    const size_t numBlocks = (K + B - 1) / B;
+
+#pragma omp parallel for
+    for (long long i = 0; i < (long long)(numBlocks * B * kernelSize); i++)
+    {
+        size_t r = i % B;
+        size_t offset = (i / B) % kernelSize;
+        size_t k = (i / B / kernelSize) * B + r;
+        packed[i] = k < K ? kernel[k * kernelSize + offset] : 0;
+    }
+}
+
+template <class ElemType>
+void CPUSmallFilterConvolution<ElemType>::ForwardDirect(const ElemType* in, const ElemType* packed, ElemType* out, size_t batchSize) const
+{
+    const auto& g = m_geometry;
+    const size_t B = s_mapBlockSize;
+    const size_t C = g.m_inC;
+    const size_t K = g.m_outC;
+    const size_t numBlocks = (K + B - 1) / B;
+
+#pragma omp parallel
+    {
+        std::vector<ElemType> acc(g.m_outW * B);
+#pragma omp for
+        for (long long job = 0; job < (long long)(batchSize * numBlocks * g.m_outH); job++)
+        {
+            size_t oh = job % g.m_outH;
+            size_t block = (job / g.m_outH) % numBlocks;
+            size_t n = job / g.m_outH / numBlocks;
+            const ElemType* sample = in + n * g.m_inW * g.m_inH * C;
+            std::fill(acc.begin(), acc.end(), (ElemType)0);
+
+            for (size_t c = 0; c < C; c++)
+            {
+                for (size_t y = 0; y < g.m_kernelH; y++)
+                {
+                    int h = (int)(oh * g.m_strideH + y * g.m_dilationH) - g.m_padH;
+                    if (h < 0 || h >= (int)g.m_inH)
+                        continue;
+                    const ElemType* row = sample + (c * g.m_inH + h) * g.m_inW;
+                    for (size_t x = 0; x < g.m_kernelW; x++)
+                    {
+                        const ElemType* weights = packed + ((block * C + c) * g.m_kernelH * g.m_kernelW + y * g.m_kernelW + x) * B;
+                        int w = (int)(x * g.m_dilationW) - g.m_padW;
+                        for (size_t ow = 0; ow < g.m_outW; ow++, w += (int)g.m_strideW)
+                        {
+                            if (w < 0 || w >= (int)g.m_inW)
+                                continue;
+                            ElemType value = row[w];
+                            ElemType* a = acc.data() + ow * B;
+                            for (size_t r = 0; r < B; r++)
+                                a[r] += value * weights[r];
+                        }
+                    }
+                }
+            }
+
+            ElemType* sampleOut = out + n * g.m_outW * g.m_outH * K;
+            for (size_t r = 0; r < B && block * B + r < K; r++)
+            {
+                ElemType* outRow = sampleOut + ((block * B + r) * g.m_outH + oh) * g.m_outW;
+                for (size_t ow = 0; ow < g.m_outW; ow++)
+                    outRow[ow] = acc[ow * B + r];
+            }
+        }
+    }
+}
+
+template class CPUSmallFilterConvolution<float>;
+template class CPUSmallFilterConvolution<double>;
+
+} } }
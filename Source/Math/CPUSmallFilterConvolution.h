@@ -0,0 +1,81 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#pragma once
+
+#include <cstddef>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// CPUSmallFilterConvolution computes the forward pass of 2D convolutions with 1x1 and 3x3 kernels on the input
+// in place, without the unrolled (im2col) buffer of the GEMM convolution engine:
+// - 1x1 kernels with unit stride and no padding are a single matrix product per sample;
+// - 3x3 kernels with unit stride use Winograd minimal filtering F(2x2, 3x3), or F(4x4, 3x3) for larger outputs,
+//   which take 2.25 and 4 times fewer multiplications than the direct method;
+// - all other 1x1 and 3x3 kernels (strided, dilated) run a direct convolution with the weights packed in blocks
+//   of output maps, so that the inner loop updates a whole block of maps from every input value it reads.
+//
+// Samples use the CNTK/cuDNN layout W x H x C with W changing fastest; the kernel holds one kW x kH x C block per output map.
+// The Winograd and direct algorithms run on a prepared kernel (transformed or packed) that PrepareKernel() computes once,
+// so that callers can keep it for as long as the kernel does not change.
+template <class ElemType>
+class CPUSmallFilterConvolution
+{
+public:
+    struct Geometry
+    {
+        size_t m_inW, m_inH, m_inC;
+        size_t m_outW, m_outH, m_outC;
+        size_t m_kernelW, m_kernelH;
+        size_t m_strideW, m_strideH;
+        size_t m_dilationW, m_dilationH;
+        int m_padW, m_padH; // lower padding
+    };
+
+    enum class Algorithm
+    {
+        Pointwise,
+        Winograd2x2,
+        Winograd4x4,
+        Direct
+    };
+
+    static bool IsSupported(const Geometry& geometry);
+
+    CPUSmallFilterConvolution(const Geometry& geometry);
+
+    Algorithm GetAlgorithm() const { return m_algorithm; }
+
+    // Number of elements of the prepared kernel; 0 if Forward() takes the kernel as it is.
+    size_t GetPreparedKernelSize() const;
+
+    // Number of elements of the workspace Forward() needs.
+    size_t GetWorkspaceSize() const;
+
+    void PrepareKernel(const ElemType* kernel, ElemType* preparedKernel) const;
+
+    // preparedKernel is the output of PrepareKernel() for kernel, or nullptr if GetPreparedKernelSize() is 0.
+    void Forward(const ElemType* in, const ElemType* kernel, const ElemType* preparedKernel, ElemType* out, size_t batchSize, ElemType* workspace) const;
+
+private:
+    template <size_t m>
+    void TransformKernel(const ElemType* kernel, ElemType* u) const;
+    void PackKernel(const ElemType* kernel, ElemType* packed) const;
+
+    template <size_t m>
+    void ForwardWinograd(const ElemType* in, const ElemType* u, ElemType* out, size_t batchSize, ElemType* workspace) const;
+    void ForwardDirect(const ElemType* in, const ElemType* packed, ElemType* out, size_t batchSize) const;
+    void ForwardPointwise(const ElemType* in, const ElemType* kernel, ElemType* out, size_t batchSize) const;
+
+    size_t NumTiles(size_t tileSize) const { return ((m_geometry.m_outW + tileSize - 1) / tileSize) * ((m_geometry.m_outH + tileSize - 1) / tileSize); }
+
+    // Output maps per block of the packed weights of the direct convolution.
+    static const size_t s_mapBlockSize = 8;
+
+private:
+    Geometry m_geometry;
+    Algorithm m_algorithm;
+};
+
+} } }
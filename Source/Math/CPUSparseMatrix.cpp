@@ -926,6 +926,235 @@ void CPUSparseMatrix<ElemType>::Reset()
     SetBlockIdShift(0);
 }
 
+// Nonzero elements of a CSC matrix or of a column slice of it: the nonzero elements of column j are Value(p) at row Row(p)
+// for p in [Begin(j), End(j)).
+template <class ElemType>
+class CSCColumns
+{
+public:
+    CSCColumns(const CPUSparseMatrix<ElemType>& a)
+        : m_values(a.Buffer() + a.SecondaryIndexLocation()[0]), m_rows(a.MajorIndexLocation()), m_columnStarts(a.SecondaryIndexLocation()), m_numCols(a.GetNumCols())
+    {
+    }
+
+    size_t Begin(size_t j) const { return m_columnStarts[j] - m_columnStarts[0]; }
+    size_t End(size_t j) const { return m_columnStarts[j + 1] - m_columnStarts[0]; }
+    size_t NzCount() const { return End(m_numCols - 1); }
+    size_t Row(size_t p) const { return m_rows[p]; }
+    ElemType Value(size_t p) const { return m_values[p]; }
+
+private:
+    const ElemType* m_values;
+    const CPUSPARSE_INDEX_TYPE* m_rows;
+    const CPUSPARSE_INDEX_TYPE* m_columnStarts;
+    size_t m_numCols;
+};
+
+// Cache-blocked, multithreaded products of a dense and a CSC matrix for the transpose combinations that matter in practice:
+// - dense * sparse, as in Times(W, x) with sparse input x: every output column is the weighted sum of the dense columns
+//   selected by the nonzero elements of one sparse column. Tasks are (row block, column) pairs, so that a thread keeps
+//   a block of rows of the dense matrix in cache while it walks its columns.
+// - dense * sparse', as in the weight gradient dY * x' of Times(W, x): the nonzero elements are sorted by their output
+//   column, so that every output column is owned by one task and no atomics are needed. For one-hot and bag-of-words
+//   inputs few output columns receive many updates, which then stay in cache.
+// - dense' * sparse and sparse' * dense: every output element is a sparse dot product with a dense column; tasks are
+//   (row block, column) pairs of the output.
+// - sparse * dense and sparse * dense': every task owns a block of output columns and adds the scaled sparse columns to them.
+// The innermost loops run over contiguous memory where the layout allows it, so that the compiler vectorizes them.
+// MultiplyDenseAndSparse below dispatches to these and handles the remaining combinations itself.
+template <class ElemType>
+class BlockedSparseDenseProduct
+{
+public:
+    // Rows per task; a block of the dense matrix is s_rowBlockSize elements high.
+    static const size_t s_rowBlockSize = 512;
+
+    // c = alpha * a * b + beta * c, b sparse
+    static void DenseTimesSparse(ElemType alpha, const CPUMatrix<ElemType>& a, const CPUSparseMatrix<ElemType>& b, ElemType beta, CPUMatrix<ElemType>& c)
+    {
+        const CSCColumns<ElemType> sparse(b);
+        const size_t m = c.GetNumRows();
+        const size_t n = c.GetNumCols();
+        const size_t numRowBlocks = NumBlocks(m);
+
+#pragma omp parallel for if (IsWorthParallelizing(m, sparse.NzCount()))
+        for (long task = 0; task < (long)(numRowBlocks * n); task++)
+        {
+            const size_t j = task % n;
+            const size_t i0 = (task / n) * s_rowBlockSize;
+            const size_t rows = std::min(s_rowBlockSize, m - i0);
+            ElemType* cj = &c(i0, j);
+
+            ScaleColumn(beta, cj, rows);
+            for (size_t p = sparse.Begin(j); p < sparse.End(j); p++)
+                Axpy(alpha * sparse.Value(p), &a(i0, sparse.Row(p)), cj, rows);
+        }
+    }
+
+    // c = alpha * a * b' + beta * c, b sparse
+    static void DenseTimesSparseTransposed(ElemType alpha, const CPUMatrix<ElemType>& a, const CPUSparseMatrix<ElemType>& b, ElemType beta, CPUMatrix<ElemType>& c)
+    {
+        ScaleMatrix(beta, c);
+
+        // Sort the nonzero elements by their row, which is the output column they update, and find the range of each output column.
+        const CSCColumns<ElemType> sparse(b);
+        std::vector<std::pair<CPUSPARSE_INDEX_TYPE, CPUSPARSE_INDEX_TYPE>> updates; // (output column, nonzero element)
+        std::vector<CPUSPARSE_INDEX_TYPE> columnOf(sparse.NzCount());        // column of b, and hence of a, of each nonzero element
+        updates.reserve(sparse.NzCount());
+        for (size_t j = 0; j < b.GetNumCols(); j++)
+        {
+            for (size_t p = sparse.Begin(j); p < sparse.End(j); p++)
+            {
+                updates.push_back(std::make_pair((CPUSPARSE_INDEX_TYPE)sparse.Row(p), (CPUSPARSE_INDEX_TYPE)p));
+                columnOf[p] = (CPUSPARSE_INDEX_TYPE)j;
+            }
+        }
+        std::sort(updates.begin(), updates.end());
+
+        std::vector<size_t> groupStarts;
+        std::vector<ElemType> values(updates.size());
+        for (size_t u = 0; u < updates.size(); u++)
+        {
+            if (u == 0 || updates[u].first != updates[u - 1].first)
+                groupStarts.push_back(u);
+            values[u] = alpha * sparse.Value(updates[u].second);
+        }
+        groupStarts.push_back(updates.size());
+
+        const size_t m = c.GetNumRows();
+        const size_t numGroups = groupStarts.size() - 1;
+        const size_t numRowBlocks = NumBlocks(m);
+
+#pragma omp parallel for if (IsWorthParallelizing(m, updates.size()))
+        for (long task = 0; task < (long)(numRowBlocks * numGroups); task++)
+        {
+            const size_t group = task % numGroups;
+            const size_t i0 = (task / numGroups) * s_rowBlockSize;
+            const size_t rows = std::min(s_rowBlockSize, m - i0);
+            ElemType* cj = &c(i0, updates[groupStarts[group]].first);
+
+            for (size_t u = groupStarts[group]; u < groupStarts[group + 1]; u++)
+                Axpy(values[u], &a(i0, columnOf[updates[u].second]), cj, rows);
+        }
+    }
+
+    // c = alpha * a' * b + beta * c, b sparse: c(i, j) is the dot product of column i of a and column j of b.
+    static void DenseTransposedTimesSparse(ElemType alpha, const CPUMatrix<ElemType>& a, const CPUSparseMatrix<ElemType>& b, ElemType beta, CPUMatrix<ElemType>& c)
+    {
+        const CSCColumns<ElemType> sparse(b);
+        const size_t m = c.GetNumRows();
+        const size_t n = c.GetNumCols();
+        const size_t numRowBlocks = NumBlocks(m);
+
+#pragma omp parallel for if (IsWorthParallelizing(m, sparse.NzCount()))
+        for (long task = 0; task < (long)(numRowBlocks * n); task++)
+        {
+            const size_t j = task % n;
+            const size_t i0 = (task / n) * s_rowBlockSize;
+            const size_t i1 = std::min(i0 + s_rowBlockSize, m);
+            for (size_t i = i0; i < i1; i++)
+            {
+                const ElemType* ai = &a(0, i);
+                ElemType sum = 0;
+                for (size_t p = sparse.Begin(j); p < sparse.End(j); p++)
+                    sum += sparse.Value(p) * ai[sparse.Row(p)];
+                c(i, j) = beta == 0 ? alpha * sum : alpha * sum + beta * c(i, j);
+            }
+        }
+    }
+
+    // c = alpha * a' * b + beta * c, a sparse
+    static void SparseTransposedTimesDense(ElemType alpha, const CPUSparseMatrix<ElemType>& a, const CPUMatrix<ElemType>& b, ElemType beta, CPUMatrix<ElemType>& c)
+    {
+        const CSCColumns<ElemType> sparse(a);
+        const size_t m = c.GetNumRows();
+        const size_t n = c.GetNumCols();
+        const size_t numColumnBlocks = NumBlocks(n);
+
+        // Tasks are (column block, row) pairs here: the nonzero elements of the sparse column i are reused for a block of columns of b.
+#pragma omp parallel for if (IsWorthParallelizing(n, sparse.NzCount()))
+        for (long task = 0; task < (long)(numColumnBlocks * m); task++)
+        {
+            const size_t i = task % m;
+            const size_t j0 = (task / m) * s_rowBlockSize;
+            const size_t j1 = std::min(j0 + s_rowBlockSize, n);
+            for (size_t j = j0; j < j1; j++)
+            {
+                const ElemType* bj = &b(0, j);
+                ElemType sum = 0;
+                for (size_t p = sparse.Begin(i); p < sparse.End(i); p++)
+                    sum += sparse.Value(p) * bj[sparse.Row(p)];
+                c(i, j) = beta == 0 ? alpha * sum : alpha * sum + beta * c(i, j);
+            }
+        }
+    }
+
+    // c = alpha * a * op(b) + beta * c, a sparse, op(b) = b or b'
+    template <bool transposeB>
+    static void SparseTimesDense(ElemType alpha, const CPUSparseMatrix<ElemType>& a, const CPUMatrix<ElemType>& b, ElemType beta, CPUMatrix<ElemType>& c)
+    {
+        const CSCColumns<ElemType> sparse(a);
+        const size_t n = c.GetNumCols();
+        const size_t k = a.GetNumCols();
+        // Output columns per task. Tasks own their columns, so there are no write conflicts.
+        const size_t columnBlockSize = transposeB ? 16 : 1;
+        const size_t numColumnBlocks = (n + columnBlockSize - 1) / columnBlockSize;
+
+#pragma omp parallel for if (IsWorthParallelizing(n, sparse.NzCount()))
+        for (long block = 0; block < (long)numColumnBlocks; block++)
+        {
+            const size_t j0 = block * columnBlockSize;
+            const size_t j1 = std::min(j0 + columnBlockSize, n);
+            for (size_t j = j0; j < j1; j++)
+                ScaleColumn(beta, &c(0, j), c.GetNumRows());
+
+            for (size_t l = 0; l < k; l++)
+            {
+                for (size_t j = j0; j < j1; j++)
+                {
+                    ElemType weight = transposeB ? b(j, l) : b(l, j);
+                    if (weight == 0)
+                        continue;
+                    weight *= alpha;
+                    ElemType* cj = &c(0, j);
+                    for (size_t p = sparse.Begin(l); p < sparse.End(l); p++)
+                        cj[sparse.Row(p)] += weight * sparse.Value(p);
+                }
+            }
+        }
+    }
+
+private:
+    static size_t NumBlocks(size_t size) { return (size + s_rowBlockSize - 1) / s_rowBlockSize; }
+
+    // Below about a million multiply-adds the threads cost more than they save.
+    static bool IsWorthParallelizing(size_t denseDim, size_t nzCount) { return denseDim * nzCount >= 1000000; }
+
+    static void ScaleColumn(ElemType beta, ElemType* c, size_t rows)
+    {
+        if (beta == 0)
+            memset(c, 0, sizeof(ElemType) * rows);
+        else if (beta != 1)
+            for (size_t i = 0; i < rows; i++)
+                c[i] *= beta;
+    }
+
+    static void ScaleMatrix(ElemType beta, CPUMatrix<ElemType>& c)
+    {
+        if (beta == 1)
+            return;
+#pragma omp parallel for
+        for (long j = 0; j < (long)c.GetNumCols(); j++)
+            ScaleColumn(beta, &c(0, j), c.GetNumRows());
+    }
+
+    static void Axpy(ElemType alpha, const ElemType* x, ElemType* y, size_t n)
+    {
+        for (size_t i = 0; i < n; i++)
+            y[i] += alpha * x[i];
+    }
+};
+
 // Implements product of one sparse and one dense matrix updating a third dense matrix. Input matrices are optionally transposed.
 // NOTE: The only for using a class template instead of a function template was that I couldn't make the function template compile.
 template <class ElemType, bool denseTimesSparse /* false means SparseTimesDense */, bool transposeA, bool transposeB>
@@ -959,6 +1188,18 @@ public:
         else
             c.VerifySize(m, n); // Can't resize if beta != 0
 
+        // The common combinations have blocked kernels, which also apply beta. Below if-statements are evaluated at compile time.
+        if (sparse.GetFormat() == matrixFormatSparseCSC && !sparse.IsEmpty() && !dense.IsEmpty())
+        {
+            typedef BlockedSparseDenseProduct<ElemType> Blocked;
+            if      ( denseTimesSparse && !transposeA && !transposeB) return Blocked::DenseTimesSparse(alpha, dense, sparse, beta, c);
+            else if ( denseTimesSparse && !transposeA &&  transposeB) return Blocked::DenseTimesSparseTransposed(alpha, dense, sparse, beta, c);
+            else if ( denseTimesSparse &&  transposeA && !transposeB) return Blocked::DenseTransposedTimesSparse(alpha, dense, sparse, beta, c);
+            else if (!denseTimesSparse && !transposeA && !transposeB) return Blocked::template SparseTimesDense<false>(alpha, sparse, dense, beta, c);
+            else if (!denseTimesSparse && !transposeA &&  transposeB) return Blocked::template SparseTimesDense<true>(alpha, sparse, dense, beta, c);
+            else if (!denseTimesSparse &&  transposeA && !transposeB) return Blocked::SparseTransposedTimesDense(alpha, sparse, dense, beta, c);
+        }
+
         if (beta == 0)
             memset(c.Data(), 0, sizeof(ElemType)* c.GetNumElements());
         else if (beta != 1)
@@ -1182,25 +1423,150 @@ void CPUSparseMatrix<ElemType>::ColumnwiseScaleAndWeightedAdd(ElemType alpha, co
     else
         c.VerifySize(a.GetNumRows(), a.GetNumCols()); // Can't resize if beta != 0
 
+    if (a.IsEmpty())
+        return;
+
     const ElemType* vd = v.Data();
+    const CSCColumns<ElemType> sparse(a);
 
 #pragma omp parallel for
     for (long col = 0; col < (long)a.GetNumCols(); col++)
     {
-        auto start = a.SecondaryIndexLocation()[col];
-        auto end = a.SecondaryIndexLocation()[col + 1];
-
-        for (auto p = start; p < end; p++)
+        const ElemType scale = alpha * vd[col];
+        ElemType* cj = &c(0, col);
+        for (size_t p = sparse.Begin(col); p < sparse.End(col); p++)
         {
-            auto row = a.MajorIndexLocation()[p];
-            ElemType val = a.Buffer()[p];
-
             if (beta == 0) // don't even read the memory if beta is 0
-                c(row, col) = alpha * vd[col] * val;
+                cj[sparse.Row(p)] = scale * sparse.Value(p);
             else
-                c(row, col) = alpha * vd[col] * val + beta * c(row, col);
+                cj[sparse.Row(p)] = scale * sparse.Value(p) + beta * cj[sparse.Row(p)];
+        }
+    }
+}
+
+// idx[0, j * k + s] = row of the nonzero element of column j within its s-th block of numClasses rows, i.e. the class
+// indices of a matrix of k stacked one-hot vectors per column, in the form DoGatherColumnsOf() takes them.
+// Blocks without a nonzero element get the gap index -1.
+template <class ElemType>
+void CPUSparseMatrix<ElemType>::AssignOneHotIndicesTo(CPUMatrix<ElemType>& idx, size_t numClasses) const
+{
+    if (GetFormat() != matrixFormatSparseCSC)
+        NOT_IMPLEMENTED;
+
+    if (numClasses == 0 || GetNumRows() % numClasses != 0)
+        InvalidArgument("AssignOneHotIndicesTo: The number of rows (%d) must be a multiple of the number of classes (%d).", (int)GetNumRows(), (int)numClasses);
+
+    const size_t numBlocks = GetNumRows() / numClasses;
+    idx.RequireSize(1, GetNumCols() * numBlocks);
+    if (idx.IsEmpty())
+        return;
+    idx.SetValue((ElemType)-1);
+
+    const CSCColumns<ElemType> sparse(*this);
+    ElemType* indices = idx.Data();
+    bool isOneHot = true;
+#pragma omp parallel for reduction(&& : isOneHot)
+    for (long col = 0; col < (long)GetNumCols(); col++)
+    {
+        for (size_t p = sparse.Begin(col); p < sparse.End(col); p++)
+        {
+            size_t block = sparse.Row(p) / numClasses;
+            ElemType& index = indices[col * numBlocks + block];
+            if (index >= 0)
+                isOneHot = false;
+            index = (ElemType)(sparse.Row(p) - block * numClasses);
+        }
+    }
+
+    if (!isOneHot)
+        InvalidArgument("AssignOneHotIndicesTo: A column has more than one nonzero element in a block of %d rows.", (int)numClasses);
+}
+
+// *this[:,idx[j]] = a[:,j] * alpha + *this[:,idx[j]] * beta, scattering dense columns into a sparse block column matrix.
+// Only the columns idx refers to get a block, which keeps e.g. the gradient of an embedding as sparse as the lookups
+// that produced it. Several source columns may add to the same target column.
+template <class ElemType>
+CPUSparseMatrix<ElemType>& CPUSparseMatrix<ElemType>::DoScatterColumnsOf(ElemType beta, const CPUMatrix<ElemType>& idx, const CPUMatrix<ElemType>& a, ElemType alpha)
+{
+    VerifyWritable(__func__);
+
+    if (GetFormat() != matrixFormatSparseBlockCol)
+        NOT_IMPLEMENTED;
+
+    if (idx.GetNumRows() != 1) // index is 1-dimensional only
+        InvalidArgument("DoScatterColumnsOf: Map must be a row vector.");
+    if (idx.GetNumCols() != a.GetNumCols())
+        InvalidArgument("DoScatterColumnsOf: Map must have width of input vector.");
+    if (a.GetNumRows() != GetNumRows())
+        InvalidArgument("DoScatterColumnsOf: Output must have same height as input vector.");
+
+    // pre-scale the existing blocks with beta, from here on we only add
+    if (beta == 0)
+        Reset();
+    else if (beta != 1 && GetBlockSize() > 0)
+        Scale(beta, *this);
+
+    // sort the source columns by target column, so that all columns adding to the same block are adjacent
+    vector<pair<size_t, size_t>> targets; // (target column, source column)
+    targets.reserve(idx.GetNumCols());
+    for (size_t j = 0; j < idx.GetNumCols(); j++)
+    {
+        auto jOutF = idx(0, j);
+        if (std::isnan(jOutF) || (jOutF < 0)) // negative index means gap
+            continue;
+        size_t jOut = (size_t)jOutF;
+        if (jOut >= GetNumCols())
+            InvalidArgument("DoScatterColumnsOf: Map out of bounds. %ld >= %ld", (long int)jOut, (long int)GetNumCols());
+        targets.push_back(make_pair(jOut, j));
+    }
+    sort(targets.begin(), targets.end());
+
+    // find the block of every distinct target column, adding blocks for new ones
+    const size_t numRows = GetNumRows();
+    const size_t blockSizePrev = GetBlockSize();
+    unordered_map<size_t, size_t> col2BlockId;
+    for (size_t blockId = 0; blockId < blockSizePrev; blockId++)
+        col2BlockId[GetBlockIds()[blockId] - GetBlockIdShift()] = blockId;
+
+    vector<size_t> groupStarts;
+    vector<size_t> groupBlockIds;
+    size_t blockSizeCurr = blockSizePrev;
+    for (size_t i = 0; i < targets.size(); i++)
+    {
+        if (i > 0 && targets[i].first == targets[i - 1].first)
+            continue;
+        groupStarts.push_back(i);
+        auto found = col2BlockId.find(targets[i].first);
+        groupBlockIds.push_back(found != col2BlockId.end() ? found->second : blockSizeCurr++);
+    }
+    groupStarts.push_back(targets.size());
+
+    if (blockSizeCurr > blockSizePrev)
+    {
+        RequireSizeAndAllocate(numRows, GetNumCols(), numRows * blockSizeCurr, true, true);
+        for (size_t g = 0; g < groupBlockIds.size(); g++)
+        {
+            if (groupBlockIds[g] >= blockSizePrev)
+                GetBlockIds()[groupBlockIds[g]] = targets[groupStarts[g]].first + GetBlockIdShift();
         }
+        SetBlockSize(blockSizeCurr);
+        memset(Buffer() + numRows * blockSizePrev, 0, sizeof(ElemType) * numRows * (blockSizeCurr - blockSizePrev));
     }
+
+    // every block is owned by one group, so the groups can be added in parallel
+#pragma omp parallel for
+    for (long g = 0; g < (long)groupBlockIds.size(); g++)
+    {
+        ElemType* block = Buffer() + groupBlockIds[g] * numRows;
+        for (size_t i = groupStarts[g]; i < groupStarts[g + 1]; i++)
+        {
+            const ElemType* column = &a(0, targets[i].second);
+            for (size_t row = 0; row < numRows; row++)
+                block[row] += alpha * column[row];
+        }
+    }
+
+    return *this;
 }
 
 /// sparse *= alpha
@@ -98,6 +98,8 @@ public:
 
     CPUSparseMatrix<ElemType>& DoGatherColumnsOf(ElemType beta, const CPUMatrix<ElemType>& idx, const CPUSparseMatrix<ElemType>& a, ElemType alpha);
     CPUSparseMatrix<ElemType>& DoScatterColumnsOf(ElemType beta, const CPUMatrix<ElemType>& idx, const CPUSparseMatrix<ElemType>& a, ElemType alpha);
+    CPUSparseMatrix<ElemType>& DoScatterColumnsOf(ElemType beta, const CPUMatrix<ElemType>& idx, const CPUMatrix<ElemType>& a, ElemType alpha);
+    void AssignOneHotIndicesTo(CPUMatrix<ElemType>& idx, size_t numClasses) const;
 
     size_t BufferSize() const
     {
@@ -299,6 +301,18 @@ public:
         return GetBlockIds();
     }
 
+    // column indices of the non-zero blocks of a sparse block column matrix
+    std::vector<size_t> GetBlockColumns() const
+    {
+        if (GetFormat() != matrixFormatSparseBlockCol)
+            LogicError("CPUSparseMatrix::GetBlockColumns is only applicable to the sparse block column format");
+
+        std::vector<size_t> columns(GetBlockSize());
+        for (size_t blockId = 0; blockId < columns.size(); blockId++)
+            columns[blockId] = GetBlockIds()[blockId] - GetBlockIdShift();
+        return columns;
+    }
+
     CPUSPARSE_INDEX_TYPE* MajorIndexLocation() const
     {
         return (GetUnCompIndex() + 
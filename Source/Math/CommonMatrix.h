@@ -347,7 +347,10 @@ protected:
     bool IsEmpty() const { return m_numRows == 0 || m_numCols == 0; }
 
     ElemType* Buffer() const { return m_pArray; }
-    void SetBuffer(ElemType* pArray, size_t alloc, bool external = false) { m_pArray = pArray; m_totalBufferSizeAllocated = alloc; m_externalBuffer = external; }
+    void SetBuffer(ElemType* pArray, size_t alloc, bool external = false) { m_pArray = pArray; m_totalBufferSizeAllocated = alloc; m_externalBuffer = external; m_externalBufferOwner.reset(); }
+
+    const shared_ptr<void>& GetExternalBufferOwner() const { return m_externalBufferOwner; }
+    void SetExternalBufferOwner(const shared_ptr<void>& owner) { m_externalBufferOwner = owner; }
 
     size_t BufferSizeAllocated() const { return m_totalBufferSizeAllocated; }
     
@@ -424,6 +427,7 @@ protected:
     MatrixFormat m_format;
     mutable DEVICEID_TYPE m_computeDevice; // current GPU device Id or CPUDEVICE
     bool m_externalBuffer; // is the buffer used by this matrix,
+    shared_ptr<void> m_externalBufferOwner; // if set, keeps the external buffer alive as long as this storage exists
 
     // m_numRows and m_numCols should be removed
     size_t m_numRows;
@@ -521,6 +525,16 @@ public:
 
     bool OwnBuffer() const { return !HasExternalBuffer(); }
 
+    // Ties the lifetime of 'owner' (e.g. a memory-mapped file) to the storage, which refers to its memory as an external buffer.
+    void SetExternalBufferOwner(const shared_ptr<void>& owner)
+    {
+        if (!m_sob->HasExternalBuffer())
+            LogicError("SetExternalBufferOwner: The matrix does not use an external buffer.");
+        m_sob->SetExternalBufferOwner(owner);
+    }
+
+    bool HasExternalBufferOwner() const { return m_sob->HasExternalBuffer() && m_sob->GetExternalBufferOwner() != nullptr; }
+
     bool IsEmpty() const { return m_numRows == 0 || m_numCols == 0; }
 
     size_t GetSizeAllocated() const { return m_sob->GetSizeAllocated(); }
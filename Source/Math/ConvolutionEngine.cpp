@@ -7,6 +7,7 @@
 #include "ConvolutionEngine.h"
 #include "CuDnnFactories.h"
 #include "MklDnnCommon.h"
+#include "CPUSmallFilterConvolution.h"
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
@@ -570,6 +571,9 @@ public:
     {
     }
 
+    // Group convolution is done by MKL-DNN, which does not take a quantized multiplier.
+    bool SupportsQuantizedMultiplier() const override { return m_geometry->Groups() == 1; }
+
 protected:
     using typename Base::IntMatPtr;
 
@@ -578,6 +582,7 @@ protected:
     using Base::m_imageLayout;
     using Base::m_maxTempMemSizeInSamples;
     using Base::m_poolIncludePad;
+    using Base::m_pQuantizedMultiplier;
 
     using Base::m_mpRowCol;
     using Base::m_mpRowIwht;
@@ -614,7 +619,7 @@ protected:
     void ForwardCore(const Mat& in, const Mat& kernel, Mat& out, Mat& workspace) override
     {
 #ifdef USE_MKL2017DNN
-        if (ForwardCoreMKL(in, kernel, out)) return;
+        if (!m_pQuantizedMultiplier && ForwardCoreMKL(in, kernel, out)) return;
 #endif
 
         size_t batchSize = in.GetNumCols();
@@ -656,7 +661,7 @@ protected:
             {
                 auto outSlice = out.ColumnSlice(start, 1);
                 outSlice.Reshape(mapOutSize, mapCount);
-                Mat::Multiply(unrolledInput, true, kern, false, outSlice);
+                Mat::MultiplyAndWeightedAdd(1, unrolledInput, true, kern, false, 0, outSlice, m_pQuantizedMultiplier);
             }
             else
             {
@@ -667,7 +672,7 @@ protected:
                     outTempSlice = outTempSlice.ColumnSlice(0, curBatchSize * mapCount);
                     outTempSlice.Reshape(mapOutSize * curBatchSize, mapCount);
                 }
-                Mat::Multiply(unrolledInput, true, kern, false, outTempSlice);
+                Mat::MultiplyAndWeightedAdd(1, unrolledInput, true, kern, false, 0, outTempSlice, m_pQuantizedMultiplier);
                 outTempSlice.Reshape(curBatchSize, mapOutSize * mapCount);
                 auto outSlice = out.ColumnSlice(start, curBatchSize);
                 outSlice.AssignTransposeOf(outTempSlice);
@@ -955,13 +960,6 @@ protected:
 
         bool Supported(const ConvolveGeometry* geometry, bool forward)
         {
-#ifdef USE_MKLDNN
-            //TODO: test code for linking with mkldnn.dll, will extend to support dilated convolution with MKL-DNN later
-            mkldnn_primitive_attr_t attr;
-            mkldnn_primitive_attr_create(&attr);
-            mkldnn_primitive_attr_destroy(attr);
-#endif
-
             //MKL2017 does not support asymmetric padding yet
             if (geometry->IsAsymmetricPadding(/*useMKL=*/true)) {
                 fprintf(stderr, "WARNING: Detected asymmetric padding issue with lowerPad != higherPad, not supported by MKL. Switching to GEMM convolution engine. \n");
@@ -1151,6 +1149,482 @@ public:
     }
 };
 
+//-------------------------------------------------------------
+// Small filter convolution engine.
+// Forward convolution with 1x1 and 3x3 kernels runs the Winograd and direct CPU kernels of CPUSmallFilterConvolution,
+// which read the input in place instead of unrolling it; the backward pass and pooling are those of the GEMM engine.
+// The transformed (Winograd) or packed (direct) kernel is kept with a copy of the kernel it was computed from, and
+// only recomputed when the kernel values change. Not used on MKL 2017 DNN builds, whose GEMM engine runs MKL convolutions.
+//-------------------------------------------------------------
+template <class ElemType>
+class SmallFilterConvolutionEngine : public GemmConvolutionEngine<ElemType>
+{
+public:
+    using Base = GemmConvolutionEngine<ElemType>;
+    using typename Base::Mat;
+    using Kernels = CPUSmallFilterConvolution<ElemType>;
+
+public:
+    SmallFilterConvolutionEngine(ConvolveGeometryPtr geometry, DEVICEID_TYPE deviceId, ImageLayoutKind imageLayout, size_t maxTempMemSizeInSamples, PoolKind poolKind, bool poolIncludePad)
+        : Base(geometry, deviceId, imageLayout, maxTempMemSizeInSamples, poolKind, poolIncludePad)
+    {
+    }
+
+    static bool IsSupported(DEVICEID_TYPE deviceId, ConvolveGeometryPtr geometry, PoolKind poolKind)
+    {
+#ifdef USE_MKL2017DNN
+        UNUSED(deviceId); UNUSED(geometry); UNUSED(poolKind);
+        return false;
+#else
+        typename Kernels::Geometry g;
+        return poolKind == PoolKind::None && Base::IsSupported(deviceId, geometry) && GetGeometry(*geometry, g) && Kernels::IsSupported(g);
+#endif
+    }
+
+protected:
+    using Base::m_geometry;
+    using Base::m_pQuantizedMultiplier;
+
+    void ForwardCore(const Mat& in, const Mat& kernel, Mat& out, Mat& workspace) override
+    {
+        if (m_pQuantizedMultiplier || in.GetMatrixType() != MatrixType::DENSE)
+            return Base::ForwardCore(in, kernel, out, workspace);
+
+        if (!m_kernels)
+        {
+            typename Kernels::Geometry g;
+            GetGeometry(*m_geometry, g);
+            m_kernels = std::make_unique<Kernels>(g);
+        }
+        const ElemType* preparedKernel = nullptr;
+        if (m_kernels->GetPreparedKernelSize() > 0)
+        {
+            const ElemType* kernelData = kernel.Data();
+            size_t kernelSize = kernel.GetNumElements();
+            if (m_preparedKernelSource.size() != kernelSize || !std::equal(kernelData, kernelData + kernelSize, m_preparedKernelSource.begin()))
+            {
+                m_preparedKernel.resize(m_kernels->GetPreparedKernelSize());
+                m_kernels->PrepareKernel(kernelData, m_preparedKernel.data());
+                m_preparedKernelSource.assign(kernelData, kernelData + kernelSize);
+            }
+            preparedKernel = m_preparedKernel.data();
+        }
+        workspace.Resize(1, std::max<size_t>(m_kernels->GetWorkspaceSize(), 1));
+        m_kernels->Forward(in.Data(), kernel.Data(), preparedKernel, out.Data(), in.GetNumCols(), workspace.Data());
+    }
+
+private:
+    // 2D convolutions over [W x H x C] samples, and 1D ones over [W x C], with kernels covering all input channels.
+    static bool GetGeometry(const ConvolveGeometry& geometry, typename Kernels::Geometry& g)
+    {
+        const auto& inT = geometry.InputShape();
+        const auto& kernT = geometry.KernelShape();
+        const auto& outT = geometry.OutputShape();
+        size_t rank = inT.GetRank();
+        if ((rank != 2 && rank != 3) || kernT.GetRank() != rank || outT.GetRank() != rank || geometry.Groups() != 1)
+            return false;
+        size_t c = rank - 1;
+        if (kernT[c] != inT[c] || outT[c] != geometry.GetMapCount(c) || geometry.GetLowerPad(c) != 0)
+            return false;
+
+        g.m_inC = inT[c];
+        g.m_outC = outT[c];
+        g.m_inW = inT[0];
+        g.m_outW = outT[0];
+        g.m_kernelW = kernT[0];
+        g.m_strideW = geometry.GetStride(0);
+        g.m_dilationW = geometry.GetDilation(0);
+        g.m_padW = geometry.GetLowerPad(0);
+        bool is2D = rank == 3;
+        g.m_inH = is2D ? inT[1] : 1;
+        g.m_outH = is2D ? outT[1] : 1;
+        g.m_kernelH = is2D ? kernT[1] : 1;
+        g.m_strideH = is2D ? geometry.GetStride(1) : 1;
+        g.m_dilationH = is2D ? geometry.GetDilation(1) : 1;
+        g.m_padH = is2D ? geometry.GetLowerPad(1) : 0;
+        return true;
+    }
+
+    std::unique_ptr<Kernels> m_kernels;
+    std::vector<ElemType> m_preparedKernel;
+    std::vector<ElemType> m_preparedKernelSource;
+};
+
+#ifdef USE_MKLDNN
+//-------------------------------------------------------------
+// MKL-DNN convolution and pooling engine.
+// Runs direct (not unrolled) convolution, including dilated and group convolution, and max/average pooling
+// over up to 3 spatial dimensions. MKL-DNN only supports float, and max unpooling is left to the reference engine.
+// Primitives are created on first use and kept for the minibatch size they were created for; the geometry of an
+// engine never changes, so the cache is keyed by the operation and dropped when the minibatch size changes.
+//-------------------------------------------------------------
+template <class ElemType>
+class MklDnnConvolutionEngine : public ReferenceConvolutionEngine<ElemType>
+{
+public:
+    using Base = ReferenceConvolutionEngine<ElemType>;
+    using typename Base::Mat;
+
+public:
+    MklDnnConvolutionEngine(ConvolveGeometryPtr geometry, DEVICEID_TYPE deviceId, ImageLayoutKind imageLayout, size_t maxTempMemSizeInSamples, PoolKind poolKind, bool poolIncludePad)
+        : Base(geometry, deviceId, imageLayout, maxTempMemSizeInSamples, poolKind, poolIncludePad), m_gradientBuffer(deviceId)
+    {
+    }
+
+    static bool IsSupported(DEVICEID_TYPE deviceId, ConvolveGeometryPtr geometry, PoolKind poolKind, bool poolIncludePad)
+    {
+        Dims dims;
+        return std::is_same<ElemType, float>::value && deviceId < 0 && IsMklDnnSafeOnThisCpu() && GetDims(*geometry, poolKind, poolIncludePad, 1, dims);
+    }
+
+protected:
+    using Base::m_geometry;
+    using Base::m_deviceId;
+    using Base::m_imageLayout;
+    using Base::m_poolKind;
+    using Base::m_poolIncludePad;
+
+    void EnsureCompatible() override
+    {
+        if (m_imageLayout != ImageLayoutKind::CHW)
+            LogicError("MKL-DNN convolution engine supports only CHW/cudnn layout.");
+        if (IsGpu(m_deviceId))
+            LogicError("MKL-DNN convolution engine supports only CPU device.");
+    }
+
+    void ForwardCore(const Mat& in, const Mat& kernel, Mat& out, Mat& /*workspace*/) override
+    {
+        Execute(GetPrimitive(Op::Forward, in.GetNumCols()), in.Data(), kernel.Data(), out.Data());
+    }
+
+    void BackwardDataCore(const Mat& srcGrad, const Mat& kernel, Mat& grad, bool accumulateGradient, Mat& workspace) override
+    {
+        auto& primitive = GetPrimitive(Op::BackwardData, srcGrad.GetNumCols());
+        ExecuteForGradient(primitive, srcGrad.Data(), kernel.Data(), grad, accumulateGradient, workspace);
+    }
+
+    void BackwardKernelCore(const Mat& srcGrad, const Mat& in, Mat& kernelGrad, bool accumulateGradient, bool /*allowReuse*/, Mat& workspace) override
+    {
+        auto& primitive = GetPrimitive(Op::BackwardKernel, srcGrad.GetNumCols());
+        ExecuteForGradient(primitive, in.Data(), srcGrad.Data(), kernelGrad, accumulateGradient, workspace);
+    }
+
+    void ForwardPoolingCore(const Mat& in, Mat& out) override
+    {
+        Execute(GetPrimitive(Op::ForwardPooling, in.GetNumCols()), in.Data(), nullptr, out.Data());
+        m_lastPoolingInput = in.Data();
+    }
+
+    void BackwardPoolingCore(const Mat& out, const Mat& srcGrad, const Mat& in, Mat& grad, bool accumulateGradient) override
+    {
+        size_t batchSize = srcGrad.GetNumCols();
+        auto& forward = GetPrimitive(Op::ForwardPooling, batchSize);
+        auto& backward = GetPrimitive(Op::BackwardPooling, batchSize);
+        // Max pooling backprop reads the positions of the maxima from the workspace of the forward primitive.
+        // It is stale if the engine has pooled another input since, e.g. a later step of a recurrent loop.
+        if (forward.m_workspace && m_lastPoolingInput != in.Data())
+        {
+            m_pooledOutput.resize(out.GetNumElements());
+            Execute(forward, in.Data(), nullptr, m_pooledOutput.data());
+            m_lastPoolingInput = in.Data();
+        }
+        ExecuteForGradient(backward, srcGrad.Data(), nullptr, grad, accumulateGradient, m_gradientBuffer);
+    }
+
+private:
+    enum class Op
+    {
+        Forward,
+        BackwardData,
+        BackwardKernel,
+        ForwardPooling,
+        BackwardPooling
+    };
+
+    // MKL-DNN orders dimensions from the slowest to the fastest changing one, CNTK the other way round.
+    // 1D convolutions run as 2D ones of height 1; spatial arrays (kernel, strides, ...) follow the data dimensions.
+    struct Dims
+    {
+        int m_dataRank;
+        int m_weightsRank;
+        mkldnn_memory_format_t m_dataFormat;
+        mkldnn_memory_format_t m_weightsFormat;
+        mkldnn_dims_t m_src, m_dst, m_weights;
+        mkldnn_dims_t m_kernel, m_strides, m_dilates, m_padL, m_padR;
+    };
+
+    static bool GetDims(const ConvolveGeometry& g, PoolKind poolKind, bool poolIncludePad, size_t batchSize, Dims& dims)
+    {
+        const auto& inT = g.InputShape();
+        const auto& kernT = g.KernelShape();
+        const auto& outT = g.OutputShape();
+        size_t rank = inT.GetRank();
+        if (rank < 1 || rank > 4 || kernT.GetRank() != rank || outT.GetRank() != rank)
+            return false;
+        if (find(begin(g.Sharing()), end(g.Sharing()), false) != end(g.Sharing()))
+            return false;
+
+        // The kernel has to cover all channels (of its group) for convolution, and only one for pooling.
+        size_t c = rank - 1;
+        size_t groups = g.Groups();
+        size_t mapCount = g.GetMapCount(c);
+        if (poolKind == PoolKind::None)
+        {
+            if (groups == 0 || mapCount % groups != 0 || kernT[c] * groups != inT[c] || outT[c] != mapCount)
+                return false;
+        }
+        else if (kernT[c] != 1 || g.GetStride(c) != 1 || outT[c] != inT[c])
+            return false;
+        if (g.GetLowerPad(c) != 0)
+            return false;
+
+        int spatialRank = (int)std::max<size_t>(rank - 1, 2);
+        dims.m_dataRank = spatialRank + 2;
+        dims.m_dataFormat = spatialRank == 2 ? mkldnn_nchw : mkldnn_ncdhw;
+        dims.m_src[0] = dims.m_dst[0] = (int)batchSize;
+        dims.m_src[1] = (int)inT[c];
+        dims.m_dst[1] = (int)outT[c];
+        for (int d = 0; d < spatialRank; d++)
+        {
+            dims.m_src[2 + d] = dims.m_dst[2 + d] = 1;
+            dims.m_kernel[d] = dims.m_strides[d] = 1;
+            dims.m_dilates[d] = dims.m_padL[d] = dims.m_padR[d] = 0;
+        }
+        for (size_t i = 0; i < c; i++)
+        {
+            int d = spatialRank - 1 - (int)i;
+            int kernel = (int)kernT[i];
+            int stride = (int)g.GetStride(i);
+            int dilation = (int)g.GetDilation(i);
+            int lo = g.GetLowerPad(i);
+            // The upper padding MKL-DNN needs to produce exactly the output CNTK expects.
+            int hi = ((int)outT[i] - 1) * stride + (kernel - 1) * dilation + 1 - (int)inT[i] - lo;
+            if (lo < 0 || hi < 0)
+                return false;
+            if (poolKind != PoolKind::None && dilation != 1)
+                return false;
+            // Average pooling including padding divides by the kernel size, which only matches windows inside the declared padding.
+            if (poolKind == PoolKind::Average && poolIncludePad && hi > g.GetUpperPad(i))
+                return false;
+
+            dims.m_src[2 + d] = (int)inT[i];
+            dims.m_dst[2 + d] = (int)outT[i];
+            dims.m_kernel[d] = kernel;
+            dims.m_strides[d] = stride;
+            dims.m_dilates[d] = dilation - 1;
+            dims.m_padL[d] = lo;
+            dims.m_padR[d] = hi;
+        }
+
+        // Kernel weights use the cuDNN layout: output maps, input channels, then the spatial dimensions.
+        int w = 0;
+        if (groups > 1)
+            dims.m_weights[w++] = (int)groups;
+        dims.m_weights[w++] = (int)(mapCount / groups);
+        dims.m_weights[w++] = (int)kernT[c];
+        for (int d = 0; d < spatialRank; d++)
+            dims.m_weights[w++] = dims.m_kernel[d];
+        dims.m_weightsRank = w;
+        if (spatialRank == 2)
+            dims.m_weightsFormat = groups > 1 ? mkldnn_goihw : mkldnn_oihw;
+        else
+            dims.m_weightsFormat = groups > 1 ? mkldnn_goidhw : mkldnn_oidhw;
+        return true;
+    }
+
+    static mkldnn_memory_desc_t MemoryDesc(int rank, const mkldnn_dims_t dims, mkldnn_memory_format_t format)
+    {
+        mkldnn_memory_desc_t desc;
+        CHECK_MKLDNN(mkldnn_memory_desc_init(&desc, rank, dims, mkldnn_f32, format));
+        return desc;
+    }
+
+    // An operation for one minibatch size, with the memory of its operands.
+    struct Primitive
+    {
+        MklDnnPrimitiveDescPtr m_desc;
+        MklDnnMemoryAdapter<ElemType> m_inputs[2];
+        MklDnnMemoryAdapter<ElemType> m_output;
+        // Max pooling only: positions of the maxima, written by forward and read by backward.
+        MklDnnPrimitivePtr m_workspace;
+        std::vector<ElemType> m_workspaceBuffer;
+        MklDnnPrimitivePtr m_primitive;
+    };
+
+    Primitive& GetPrimitive(Op op, size_t batchSize)
+    {
+        // Only the primitives of the last minibatch size are kept, so that varying minibatch sizes (e.g. the last
+        // minibatch of an epoch, or cross-validation) do not pile up primitives and their buffers.
+        if (batchSize != m_primitivesBatchSize)
+        {
+            m_primitives.clear();
+            m_primitivesBatchSize = batchSize;
+            m_lastPoolingInput = nullptr; // the positions of the maxima went with the pooling primitive
+        }
+        auto& primitive = m_primitives[op];
+        if (!primitive)
+            primitive = CreatePrimitive(op, batchSize);
+        return *primitive;
+    }
+
+    mkldnn_convolution_desc_t ConvolutionForwardDesc(const Dims& dims) const
+    {
+        auto src = MemoryDesc(dims.m_dataRank, dims.m_src, mkldnn_any);
+        auto weights = MemoryDesc(dims.m_weightsRank, dims.m_weights, mkldnn_any);
+        auto dst = MemoryDesc(dims.m_dataRank, dims.m_dst, mkldnn_any);
+        mkldnn_convolution_desc_t desc;
+        CHECK_MKLDNN(mkldnn_dilated_convolution_forward_desc_init(&desc, mkldnn_forward_training, mkldnn_convolution_direct, &src, &weights, nullptr, &dst,
+                                                                  dims.m_strides, dims.m_dilates, dims.m_padL, dims.m_padR, mkldnn_padding_zero));
+        return desc;
+    }
+
+    mkldnn_pooling_desc_t PoolingForwardDesc(const Dims& dims) const
+    {
+        // Pooling keeps the plain layout: reordering to a blocked one and back costs more than the pooling itself.
+        auto src = MemoryDesc(dims.m_dataRank, dims.m_src, dims.m_dataFormat);
+        auto dst = MemoryDesc(dims.m_dataRank, dims.m_dst, dims.m_dataFormat);
+        mkldnn_pooling_desc_t desc;
+        CHECK_MKLDNN(mkldnn_pooling_forward_desc_init(&desc, mkldnn_forward_training, PoolingAlgorithm(), &src, &dst,
+                                                      dims.m_strides, dims.m_kernel, dims.m_padL, dims.m_padR, mkldnn_padding_zero));
+        return desc;
+    }
+
+    mkldnn_alg_kind_t PoolingAlgorithm() const
+    {
+        if (m_poolKind == PoolKind::Max)
+            return mkldnn_pooling_max;
+        if (m_poolKind == PoolKind::Average)
+            return m_poolIncludePad ? mkldnn_pooling_avg_include_padding : mkldnn_pooling_avg_exclude_padding;
+        InvalidArgument("Pooling type %d is not supported.", (int)m_poolKind);
+    }
+
+    std::unique_ptr<Primitive> CreatePrimitive(Op op, size_t batchSize)
+    {
+        Dims dims;
+        if (!GetDims(*m_geometry, m_poolKind, m_poolIncludePad, batchSize, dims))
+            RuntimeError("MKL-DNN convolution engine does not support this configuration. Geometry: %s", ((string)*m_geometry).c_str());
+
+        auto userData = [&](const mkldnn_dims_t d) { return MemoryDesc(dims.m_dataRank, d, dims.m_dataFormat); };
+        auto userWeights = MemoryDesc(dims.m_weightsRank, dims.m_weights, dims.m_weightsFormat);
+        auto query = [](const MklDnnPrimitiveDescPtr& pd, mkldnn_query_t what) { return mkldnn_primitive_desc_query_pd(pd.get(), what, 0); };
+
+        auto p = std::make_unique<Primitive>();
+        std::vector<mkldnn_primitive_at_t> inputs;
+        std::vector<const_mkldnn_primitive_t> outputs;
+        switch (op)
+        {
+        case Op::Forward:
+        {
+            auto desc = ConvolutionForwardDesc(dims);
+            p->m_desc = MklDnnCreatePrimitiveDesc(&desc);
+            p->m_inputs[0].Create(userData(dims.m_src), query(p->m_desc, mkldnn_query_src_pd), true);
+            p->m_inputs[1].Create(userWeights, query(p->m_desc, mkldnn_query_weights_pd), true);
+            p->m_output.Create(userData(dims.m_dst), query(p->m_desc, mkldnn_query_dst_pd), false);
+            break;
+        }
+        case Op::BackwardData:
+        case Op::BackwardKernel:
+        {
+            auto forwardDesc = ConvolutionForwardDesc(dims);
+            auto forward = MklDnnCreatePrimitiveDesc(&forwardDesc);
+            auto src = MemoryDesc(dims.m_dataRank, dims.m_src, mkldnn_any);
+            auto weights = MemoryDesc(dims.m_weightsRank, dims.m_weights, mkldnn_any);
+            auto dst = MemoryDesc(dims.m_dataRank, dims.m_dst, mkldnn_any);
+            mkldnn_convolution_desc_t desc;
+            if (op == Op::BackwardData)
+            {
+                CHECK_MKLDNN(mkldnn_dilated_convolution_backward_data_desc_init(&desc, mkldnn_convolution_direct, &src, &weights, &dst,
+                                                                                dims.m_strides, dims.m_dilates, dims.m_padL, dims.m_padR, mkldnn_padding_zero));
+                p->m_desc = MklDnnCreatePrimitiveDesc(&desc, forward.get());
+                p->m_inputs[0].Create(userData(dims.m_dst), query(p->m_desc, mkldnn_query_diff_dst_pd), true);
+                p->m_inputs[1].Create(userWeights, query(p->m_desc, mkldnn_query_weights_pd), true);
+                p->m_output.Create(userData(dims.m_src), query(p->m_desc, mkldnn_query_diff_src_pd), false);
+            }
+            else
+            {
+                CHECK_MKLDNN(mkldnn_dilated_convolution_backward_weights_desc_init(&desc, mkldnn_convolution_direct, &src, &weights, nullptr, &dst,
+                                                                                   dims.m_strides, dims.m_dilates, dims.m_padL, dims.m_padR, mkldnn_padding_zero));
+                p->m_desc = MklDnnCreatePrimitiveDesc(&desc, forward.get());
+                p->m_inputs[0].Create(userData(dims.m_src), query(p->m_desc, mkldnn_query_src_pd), true);
+                p->m_inputs[1].Create(userData(dims.m_dst), query(p->m_desc, mkldnn_query_diff_dst_pd), true);
+                p->m_output.Create(userWeights, query(p->m_desc, mkldnn_query_diff_weights_pd), false);
+            }
+            break;
+        }
+        case Op::ForwardPooling:
+        {
+            auto desc = PoolingForwardDesc(dims);
+            p->m_desc = MklDnnCreatePrimitiveDesc(&desc);
+            p->m_inputs[0].Create(userData(dims.m_src), query(p->m_desc, mkldnn_query_src_pd), true);
+            p->m_output.Create(userData(dims.m_dst), query(p->m_desc, mkldnn_query_dst_pd), false);
+            auto workspace = query(p->m_desc, mkldnn_query_workspace_pd);
+            if (workspace)
+            {
+                p->m_workspace = MklDnnCreatePrimitive(workspace, {}, {});
+                p->m_workspaceBuffer.resize(mkldnn_memory_primitive_desc_get_size(workspace) / sizeof(ElemType) + 1);
+                CHECK_MKLDNN(mkldnn_memory_set_data_handle(p->m_workspace.get(), p->m_workspaceBuffer.data()));
+            }
+            break;
+        }
+        case Op::BackwardPooling:
+        {
+            auto& forward = GetPrimitive(Op::ForwardPooling, batchSize);
+            auto diffSrc = userData(dims.m_src);
+            auto diffDst = userData(dims.m_dst);
+            mkldnn_pooling_desc_t desc;
+            CHECK_MKLDNN(mkldnn_pooling_backward_desc_init(&desc, PoolingAlgorithm(), &diffSrc, &diffDst,
+                                                           dims.m_strides, dims.m_kernel, dims.m_padL, dims.m_padR, mkldnn_padding_zero));
+            p->m_desc = MklDnnCreatePrimitiveDesc(&desc, forward.m_desc.get());
+            p->m_inputs[0].Create(diffDst, query(p->m_desc, mkldnn_query_diff_dst_pd), true);
+            p->m_output.Create(diffSrc, query(p->m_desc, mkldnn_query_diff_src_pd), false);
+            if (forward.m_workspace)
+                inputs.push_back(mkldnn_primitive_at(forward.m_workspace.get(), 0));
+            break;
+        }
+        }
+
+        size_t numInputs = (op == Op::ForwardPooling || op == Op::BackwardPooling) ? 1 : 2;
+        for (size_t i = 0; i < numInputs; i++)
+            inputs.insert(inputs.begin() + i, mkldnn_primitive_at(p->m_inputs[i].Memory(), 0));
+        outputs.push_back(p->m_output.Memory());
+        if (p->m_workspace)
+            outputs.push_back(p->m_workspace.get());
+        p->m_primitive = MklDnnCreatePrimitive(p->m_desc.get(), inputs, outputs);
+        return p;
+    }
+
+    void Execute(Primitive& primitive, const ElemType* input0, const ElemType* input1, ElemType* output)
+    {
+        std::vector<mkldnn_primitive_t> net;
+        primitive.m_inputs[0].Bind(input0, net);
+        if (input1)
+            primitive.m_inputs[1].Bind(input1, net);
+        net.push_back(primitive.m_primitive.get());
+        primitive.m_output.Bind(output, net);
+        MklDnnExecute(net);
+    }
+
+    // MKL-DNN overwrites its outputs, so gradients to be accumulated are computed into the buffer and added.
+    void ExecuteForGradient(Primitive& primitive, const ElemType* input0, const ElemType* input1, Mat& grad, bool accumulateGradient, Mat& buffer)
+    {
+        if (!accumulateGradient)
+        {
+            Execute(primitive, input0, input1, grad.Data());
+            return;
+        }
+        buffer.Resize(grad.GetNumRows(), grad.GetNumCols());
+        Execute(primitive, input0, input1, buffer.Data());
+        grad.AssignSumOf(grad, buffer);
+    }
+
+    std::map<Op, std::unique_ptr<Primitive>> m_primitives;
+    size_t m_primitivesBatchSize = 0;
+    const ElemType* m_lastPoolingInput = nullptr;
+    std::vector<ElemType> m_pooledOutput;
+    Mat m_gradientBuffer;
+};
+#endif
+
 template <class ElemType>
 std::unique_ptr<ConvolutionEngine<ElemType>> ConvolutionEngine<ElemType>::Create(ConvolveGeometryPtr geometry, DEVICEID_TYPE deviceId,
                                                                                  ImageLayoutKind imageLayout, size_t maxTempMemSizeInSamples, PoolKind poolKind,
@@ -1189,8 +1663,28 @@ std::unique_ptr<ConvolutionEngine<ElemType>> ConvolutionEngine<ElemType>::Create
                                                                forceDeterministicAlgorithms, poolIncludePad, inputHasFreeDimension);
     }
 
+#ifdef USE_MKLDNN
+    if (isEnabled(ConvolutionEngineKind::MklDnn) &&
+        MklDnnConvolutionEngine<ElemType>::IsSupported(deviceId, geometry, poolKind, poolIncludePad))
+    {
+        if (GetMathLibTraceLevel() > 0)
+            fprintf(stderr, "%lsusing MKL-DNN convolution engine for geometry: %s.\n", logPrefix.c_str(), engStr.c_str());
+
+        return std::make_unique<MklDnnConvolutionEngine<ElemType>>(geometry, deviceId, imageLayout, maxTempMemSizeInSamples, poolKind, poolIncludePad);
+    }
+#endif
+
     if (geometry->Groups() == 1)
     {
+        // Without MKL-DNN (not built in, or not safe on this CPU), the small filter kernels are the fastest CPU path for the geometries they support.
+        if (isEnabled(ConvolutionEngineKind::SmallFilter) && SmallFilterConvolutionEngine<ElemType>::IsSupported(deviceId, geometry, poolKind))
+        {
+            if (GetMathLibTraceLevel() > 0)
+                fprintf(stderr, "%lsusing small filter convolution engine for geometry: %s.\n", logPrefix.c_str(), engStr.c_str());
+
+            return std::make_unique<SmallFilterConvolutionEngine<ElemType>>(geometry, deviceId, imageLayout, maxTempMemSizeInSamples, poolKind, poolIncludePad);
+        }
+
         if (isEnabled(ConvolutionEngineKind::Gemm) && GemmConvolutionEngine<ElemType>::IsSupported(deviceId, geometry))
         {
             if (GetMathLibTraceLevel() > 0)
@@ -22,8 +22,11 @@ enum class ConvolutionEngineKind
     CuDnn     = 1 << 1, // cuDNN, works only for 2D/3D convos with full sharing.
     Legacy    = 1 << 2, // Legacy, for backwards compatibility. REVIEW alexeyk: implement sparse version and remove Legacy altogether.
     Gemm      = 1 << 3, // Uses convolution unrolling+GEMM technique. Works only for convos with full sharing.
+    MklDnn    = 1 << 4, // MKL-DNN direct convolution and pooling, CPU and float only. Works only for convos with full sharing and up to 3 spatial dims.
+    SmallFilter = 1 << 5, // Winograd and direct CPU kernels for the forward pass of 1D/2D convos with 1x1 and 3x3 kernels, GEMM otherwise.
+                          // Opt-in, hence not part of All.
 
-    All       = Reference | CuDnn | Legacy | Gemm
+    All       = Reference | CuDnn | Legacy | Gemm | MklDnn
 };
 
 enum class PoolKind
@@ -75,6 +78,17 @@ public:
 
     virtual bool ImplementsGradientOverwriteOptimization() const { return false; }
 
+    // Makes Forward() compute the convolution products with the specified quantized multiplier (nullptr to switch back).
+    // This is meant for inference; the backward methods are not affected.
+    void SetQuantizedMultiplier(shared_ptr<QuantizedMultiplier<ElemType>> pQuantizedMultiplier)
+    {
+        if (pQuantizedMultiplier && !SupportsQuantizedMultiplier())
+            LogicError("Quantized convolution is only supported by the GEMM convolution engine on CPU.");
+        m_pQuantizedMultiplier = pQuantizedMultiplier;
+    }
+
+    virtual bool SupportsQuantizedMultiplier() const { return false; }
+
 protected:
     ConvolutionEngine(ConvolveGeometryPtr geometry, DEVICEID_TYPE deviceId, ImageLayoutKind imageLayout, size_t maxTempMemSizeInSamples, PoolKind poolKind, bool poolIncludePad = false)
         : m_geometry(geometry), m_deviceId(deviceId), m_imageLayout(imageLayout), m_maxTempMemSizeInSamples(maxTempMemSizeInSamples), m_poolKind(poolKind), m_poolIncludePad(poolIncludePad)
@@ -107,6 +121,7 @@ protected:
     size_t m_maxTempMemSizeInSamples;
     PoolKind m_poolKind;
     bool m_poolIncludePad;
+    shared_ptr<QuantizedMultiplier<ElemType>> m_pQuantizedMultiplier;
 };
 
 #pragma warning(pop)
@@ -271,6 +271,19 @@ void GPUSparseMatrix<ElemType>::CopyToCPUSparseMatrix(CPUSparseMatrix<ElemType>&
         NOT_IMPLEMENTED;
 }
 
+template <class ElemType>
+std::vector<size_t> GPUSparseMatrix<ElemType>::GetBlockColumns() const
+{
+    if (GetFormat() != matrixFormatSparseBlockCol)
+        LogicError("GPUSparseMatrix::GetBlockColumns is only applicable to the sparse block column format");
+
+    PrepareDevice();
+    std::vector<GPUSPARSE_INDEX_TYPE> blockIds(GetBlockSize());
+    if (!blockIds.empty())
+        CUDA_CALL(cudaMemcpy(blockIds.data(), BlockId2ColOrRow(), blockIds.size() * sizeof(GPUSPARSE_INDEX_TYPE), cudaMemcpyDeviceToHost));
+    return std::vector<size_t>(blockIds.begin(), blockIds.end());
+}
+
 template <class ElemType>
 void GPUSparseMatrix<ElemType>::CopyToDenseMatrix(GPUMatrix<ElemType>& denseMatrix) const
 {
@@ -322,6 +322,8 @@ public:
     GPUMatrix<ElemType> CopyToDenseMatrix() const;
     void CopyToDenseMatrix(GPUMatrix<ElemType>& denseMatrix) const;
     void CopyToCPUSparseMatrix(CPUSparseMatrix<ElemType>& cpuSparseMatrix) const;
+    // column indices of the non-zero blocks of a sparse block column matrix; only the block ids are copied to the host
+    std::vector<size_t> GetBlockColumns() const;
     void ChangeDeviceTo(DEVICEID_TYPE toId);
 
     template<class ElemType2>
@@ -1097,11 +1097,21 @@ Matrix<ElemType>& Matrix<ElemType>::DoGatherColumnsOf(ElemType beta, const Matri
 // idx has width of 'a' and contains values w.r.t. 'this'
 // Unlike gather, for scatter, 'this' must have been sized already.
 // Invalid entries (gap columns) are denoted by idx(0,j) == -1.
+// A dense 'a' may be scattered into a sparse block column 'this' on the CPU, e.g. for the gradient of an embedding lookup.
 template <class ElemType>
 Matrix<ElemType>& Matrix<ElemType>::DoScatterColumnsOf(ElemType beta, const Matrix<ElemType>& idx, const Matrix<ElemType>& a, ElemType alpha, bool idxHaveDups)
 {
     DecideAndMoveToRightDevice(*this, idx, a); // TODO: only move target if beta != 0
 
+    if (a.GetMatrixType() == DENSE && GetMatrixType() == SPARSE)
+    {
+        if (GetCurrentMatrixLocation() != CPU)
+            RuntimeError("Matrix::DoScatterColumnsOf: Scattering a dense into a sparse matrix is only implemented on the CPU.");
+
+        m_CPUSparseMatrix->DoScatterColumnsOf(beta, *idx.m_CPUMatrix, *a.m_CPUMatrix, alpha);
+        return *this;
+    }
+
     if (a.GetMatrixType() != this->GetMatrixType())
         RuntimeError("Matrix::DoScatterColumnsOf: The source and target matrices must have same storage type (SPARSE/DENSE).");
 
@@ -1467,6 +1477,18 @@ void Matrix<ElemType>::AdjustSparseBlockColumn(const GPUSPARSE_INDEX_TYPE* cpuCo
         m_GPUSparseMatrix->AdjustCol2BlockId(cpuCol2BlockId, numBlocks, useBlockId2Col));
 }
 
+template <class ElemType>
+std::vector<size_t> Matrix<ElemType>::GetSparseBlockColumns() const
+{
+    if (GetFormat() != matrixFormatSparseBlockCol)
+        LogicError("GetSparseBlockColumns: Matrix is not in the sparse block column format.");
+
+    if (GetDeviceId() == CPUDEVICE)
+        return m_CPUSparseMatrix->GetBlockColumns();
+    else
+        return m_GPUSparseMatrix->GetBlockColumns();
+}
+
 template <class ElemType>
 void Matrix<ElemType>::SetDiagonalValue(const ElemType v)
 {
@@ -3676,6 +3698,27 @@ Matrix<ElemType>& Matrix<ElemType>::AssignOneHot(const Matrix<ElemType>& a, vect
     return *this;
 }
 
+// Inverse of AssignOneHot() for sparse CSC input: *this is a row vector with the class index of every block of
+// numClasses rows in every column of a, as DoGatherColumnsOf() takes it. Blocks without a nonzero element get -1.
+// Only implemented on the CPU.
+template <class ElemType>
+Matrix<ElemType>& Matrix<ElemType>::AssignOneHotIndicesOf(const Matrix<ElemType>& a, size_t numClasses)
+{
+    if (a.GetMatrixType() != SPARSE || a.GetFormat() != matrixFormatSparseCSC)
+        InvalidArgument("AssignOneHotIndicesOf: The input must be a sparse CSC matrix.");
+
+    if (GetMatrixType() != DENSE)
+        InvalidArgument("AssignOneHotIndicesOf: The target must be a dense matrix.");
+
+    if (a.GetDeviceId() != CPUDEVICE || GetDeviceId() != CPUDEVICE)
+        RuntimeError("AssignOneHotIndicesOf: Only implemented on the CPU. On the GPU, pass the indices as a dense matrix instead.");
+
+    a.m_CPUSparseMatrix->AssignOneHotIndicesTo(*m_CPUMatrix, numClasses);
+    SetDataLocation(CPU, DENSE);
+
+    return *this;
+}
+
 template <class ElemType>
 Matrix<ElemType>& Matrix<ElemType>::GatherFromTarget(const Matrix<ElemType>& indices, const Matrix<ElemType>& target, size_t row_elements)
 {
@@ -5033,7 +5076,7 @@ void Matrix<ElemType>::RNNForward(const Matrix<ElemType> &inputX, const Matrix<E
 
     DISPATCH_MATRIX_ON_FLAG(this,
                             this,
-                            NOT_IMPLEMENTED,
+                            m_CPUMatrix->RNNForward(*(inputX.m_CPUMatrix), *(paramW.m_CPUMatrix), xDim, yDim, numSequencesForFrame, rnnAttributes, *(reserve.m_CPUMatrix), *(workspace.m_CPUMatrix)),
                             m_GPUMatrix->RNNForward(*(inputX.m_GPUMatrix), *(paramW.m_GPUMatrix), xDim, yDim, numSequencesForFrame, rnnAttributes, *(reserve.m_GPUMatrix), *(workspace.m_GPUMatrix)),
                             NOT_IMPLEMENTED,
                             NOT_IMPLEMENTED);
@@ -5048,7 +5091,7 @@ void Matrix<ElemType>::RNNBackwardData(const Matrix<ElemType>& outputDY, const M
     workspace._transferToDevice(GetDeviceId());
     DISPATCH_MATRIX_ON_FLAG(this,
                             this,
-                            NOT_IMPLEMENTED,
+                            m_CPUMatrix->RNNBackwardData(*(outputDY.m_CPUMatrix), *(paramW.m_CPUMatrix), *(outputDX.m_CPUMatrix), rnnAttributes, *(reserve.m_CPUMatrix), *(workspace.m_CPUMatrix)),
                             m_GPUMatrix->RNNBackwardData(*(outputDY.m_GPUMatrix), *(paramW.m_GPUMatrix), *(outputDX.m_GPUMatrix), rnnAttributes, *(reserve.m_GPUMatrix), *(workspace.m_GPUMatrix)),
                             NOT_IMPLEMENTED,
                             NOT_IMPLEMENTED);
@@ -5063,7 +5106,7 @@ void Matrix<ElemType>::RNNBackwardWeights(const Matrix<ElemType>& inputX, const
     workspace._transferToDevice(GetDeviceId());
     DISPATCH_MATRIX_ON_FLAG(this,
                             this,
-                            NOT_IMPLEMENTED,
+                            m_CPUMatrix->RNNBackwardWeights(*(inputX.m_CPUMatrix), *(outputY.m_CPUMatrix), *(dw.m_CPUMatrix), rnnAttributes, *(reserve.m_CPUMatrix), *(workspace.m_CPUMatrix)),
                             m_GPUMatrix->RNNBackwardWeights(*(inputX.m_GPUMatrix), *(outputY.m_GPUMatrix), *(dw.m_GPUMatrix), rnnAttributes, *(reserve.m_GPUMatrix), *(workspace.m_GPUMatrix)),
                             NOT_IMPLEMENTED,
                             NOT_IMPLEMENTED);
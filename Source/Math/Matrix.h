@@ -61,6 +61,8 @@ struct /*interface*/ MATH_API MatrixBase : public std::enable_shared_from_this<M
     virtual MatrixType GetMatrixType() const = 0;
     virtual MatrixFormat GetFormat() const = 0;
     virtual void CastAssignValuesOf(const MatrixBase& other) = 0; // allows for mixed assignment with conversion
+    virtual void SetExternalBufferOwner(const std::shared_ptr<void>& owner) = 0; // keeps the owner of an external buffer (e.g. a memory-mapped file) alive with the storage
+    virtual bool HasExternalBufferOwner() const = 0;
     // TODO: Move more generic functions such as getting dims, resizing, and getting/setting as scalars in here.
     virtual ~MatrixBase();
 };
@@ -165,6 +167,8 @@ public:
     MatrixType GetMatrixType() const override;
     MatrixFormat GetFormat() const override;
     bool OwnBuffer() const { return m_baseMatrix->OwnBuffer(); }
+    void SetExternalBufferOwner(const std::shared_ptr<void>& owner) override { m_baseMatrix->SetExternalBufferOwner(owner); }
+    bool HasExternalBufferOwner() const override { return m_baseMatrix->HasExternalBufferOwner(); }
     int GetDeviceId() const; // -1 if CPU, otherwise GPU CUDA device id
     DEVICEID_TYPE GetPreferredDeviceId() const { return m_preferredDeviceId; }; // -1 if CPU, otherwise GPU CUDA device id
     void SetPreferredDeviceId(DEVICEID_TYPE preferredDeviceId) { m_preferredDeviceId = preferredDeviceId; }
@@ -302,6 +306,9 @@ public:
 
     void AdjustSparseBlockColumn(const GPUSPARSE_INDEX_TYPE* cpuCol2BlockId, size_t numBlocks, bool useBlockId2Col);
 
+    // Column indices of the non-zero blocks of a sparse block column matrix, in the order of the blocks.
+    std::vector<size_t> GetSparseBlockColumns() const;
+
     void SetDiagonalValue(const ElemType v);
     void SetDiagonalValue(const Matrix<ElemType>& vector);
     void SetUniformRandomValue(const ElemType low, const ElemType high, unsigned long seed = USE_TIME_BASED_SEED);
@@ -319,6 +326,7 @@ public:
     Matrix<ElemType>& AssignNceUnnormalizedEval(const Matrix<ElemType>& a, const Matrix<ElemType>& b, const Matrix<ElemType>& c, const Matrix<ElemType>& bias);
 
     Matrix<ElemType>& AssignOneHot(const Matrix<ElemType>& a, vector<size_t>& shape, size_t axis, bool is_sparse);
+    Matrix<ElemType>& AssignOneHotIndicesOf(const Matrix<ElemType>& a, size_t numClasses);
     Matrix<ElemType>& GatherFromTarget(const Matrix<ElemType>& indices, const Matrix<ElemType>& target, size_t row_elements);
     Matrix<ElemType>& ScatterToIndices(const Matrix<ElemType>& values, const Matrix<ElemType>& indices, size_t row_elements, const Matrix<char>* mask = nullptr);
 
@@ -16,11 +16,6 @@
 #include "mkl_dnn.h"
 #include "mkl_cblas.h"
 
-// This header is from MKL-DNN
-#ifdef USE_MKLDNN
-#include "mkldnn.h"
-#endif
-
 namespace Microsoft { namespace MSR { namespace CNTK {
 
 template<typename T> inline
@@ -1655,4 +1650,162 @@ public:
 
 } } }
 
-#endif
\ No newline at end of file
+#endif
+#ifdef USE_MKLDNN
+
+// This header is from MKL-DNN
+#include "mkldnn.h"
+
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+inline void CHECK_MKLDNN(mkldnn_status_t status)
+{
+    if (status != mkldnn_success)
+        RuntimeError("mkldnn err (%d)\n", (int)status);
+}
+
+// MKL-DNN releases without https://github.com/intel/mkl-dnn/commit/ccfbf83ab489b42f7452b6701498b07c28cdb502
+// compute a wrong cache size on AMD processors and crash, so MKL-DNN is only used on Intel processors.
+inline bool IsMklDnnSafeOnThisCpu()
+{
+    static const bool isIntel = []
+    {
+        unsigned int regs[4] = {};
+#ifdef _MSC_VER
+        __cpuid((int*)regs, 0);
+#else
+        __get_cpuid(0, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+        char vendor[13] = {};
+        memcpy(vendor, &regs[1], 4); // EBX
+        memcpy(vendor + 4, &regs[3], 4); // EDX
+        memcpy(vendor + 8, &regs[2], 4); // ECX
+        return strcmp(vendor, "GenuineIntel") == 0;
+    }();
+    return isIntel;
+}
+
+// The CPU engine all MKL-DNN primitives are created for.
+inline mkldnn_engine_t MklDnnCpuEngine()
+{
+    static mkldnn_engine_t engine = []
+    {
+        mkldnn_engine_t e;
+        CHECK_MKLDNN(mkldnn_engine_create(&e, mkldnn_cpu, 0));
+        return e;
+    }();
+    return engine;
+}
+
+struct MklDnnPrimitiveDescDeleter
+{
+    void operator()(mkldnn_primitive_desc_t pd) const { mkldnn_primitive_desc_destroy(pd); }
+};
+
+struct MklDnnPrimitiveDeleter
+{
+    void operator()(mkldnn_primitive_t p) const { mkldnn_primitive_destroy(p); }
+};
+
+typedef std::unique_ptr<std::remove_pointer<mkldnn_primitive_desc_t>::type, MklDnnPrimitiveDescDeleter> MklDnnPrimitiveDescPtr;
+typedef std::unique_ptr<std::remove_pointer<mkldnn_primitive_t>::type, MklDnnPrimitiveDeleter> MklDnnPrimitivePtr;
+
+inline MklDnnPrimitiveDescPtr MklDnnCreatePrimitiveDesc(const_mkldnn_op_desc_t opDesc, const_mkldnn_primitive_desc_t hint = nullptr)
+{
+    mkldnn_primitive_desc_t pd;
+    CHECK_MKLDNN(mkldnn_primitive_desc_create(&pd, opDesc, MklDnnCpuEngine(), hint));
+    return MklDnnPrimitiveDescPtr(pd);
+}
+
+inline MklDnnPrimitivePtr MklDnnCreatePrimitive(const_mkldnn_primitive_desc_t pd, const std::vector<mkldnn_primitive_at_t>& inputs, std::vector<const_mkldnn_primitive_t> outputs)
+{
+    mkldnn_primitive_t p;
+    CHECK_MKLDNN(mkldnn_primitive_create(&p, pd, inputs.empty() ? nullptr : inputs.data(), outputs.empty() ? nullptr : outputs.data()));
+    return MklDnnPrimitivePtr(p);
+}
+
+// Submits the primitives in order to an eager stream and waits for them.
+inline void MklDnnExecute(std::vector<mkldnn_primitive_t>& net)
+{
+    mkldnn_stream_t stream;
+    CHECK_MKLDNN(mkldnn_stream_create(&stream, mkldnn_eager));
+    mkldnn_status_t status = mkldnn_stream_submit(stream, net.size(), net.data(), nullptr);
+    if (status == mkldnn_success)
+        status = mkldnn_stream_wait(stream, 1, nullptr);
+    mkldnn_stream_destroy(stream);
+    CHECK_MKLDNN(status);
+}
+
+// MKL-DNN counterpart of MKLDnnResourceAdapter: binds a user buffer in a plain layout (nchw, oihw, ...)
+// to a primitive that may prefer a blocked layout, reordering through a private buffer when the two differ.
+template <typename ElemType>
+class MklDnnMemoryAdapter
+{
+    MklDnnPrimitivePtr m_userMemory;
+    MklDnnPrimitivePtr m_primMemory;
+    MklDnnPrimitivePtr m_reorder;
+    std::vector<ElemType> m_buffer;
+    bool m_isInput = true;
+
+    static void* Aligned(std::vector<ElemType>& buffer, size_t bytes)
+    {
+        const size_t alignment = 64;
+        buffer.resize((bytes + alignment) / sizeof(ElemType) + 1);
+        auto address = reinterpret_cast<uintptr_t>(buffer.data());
+        return reinterpret_cast<void*>((address + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    }
+
+public:
+    // primPd is owned by the primitive descriptor it was queried from.
+    void Create(const mkldnn_memory_desc_t& userDesc, const_mkldnn_primitive_desc_t primPd, bool isInput)
+    {
+        m_isInput = isInput;
+        mkldnn_primitive_desc_t userPd;
+        CHECK_MKLDNN(mkldnn_memory_primitive_desc_create(&userPd, &userDesc, MklDnnCpuEngine()));
+        MklDnnPrimitiveDescPtr userPdPtr(userPd);
+        m_userMemory = MklDnnCreatePrimitive(userPd, {}, {});
+        m_primMemory.reset();
+        m_reorder.reset();
+        if (mkldnn_memory_primitive_desc_equal(userPd, primPd))
+            return;
+
+        m_primMemory = MklDnnCreatePrimitive(primPd, {}, {});
+        CHECK_MKLDNN(mkldnn_memory_set_data_handle(m_primMemory.get(), Aligned(m_buffer, mkldnn_memory_primitive_desc_get_size(primPd))));
+
+        mkldnn_primitive_desc_t reorderPd;
+        if (isInput)
+            CHECK_MKLDNN(mkldnn_reorder_primitive_desc_create(&reorderPd, userPd, primPd));
+        else
+            CHECK_MKLDNN(mkldnn_reorder_primitive_desc_create(&reorderPd, primPd, userPd));
+        MklDnnPrimitiveDescPtr reorderPdPtr(reorderPd);
+        auto from = isInput ? m_userMemory.get() : m_primMemory.get();
+        auto to = isInput ? m_primMemory.get() : m_userMemory.get();
+        m_reorder = MklDnnCreatePrimitive(reorderPd, { mkldnn_primitive_at(from, 0) }, { to });
+    }
+
+    // The memory the primitive reads from or writes to.
+    const_mkldnn_primitive_t Memory() const { return m_primMemory ? m_primMemory.get() : m_userMemory.get(); }
+
+    // Points the adapter at the user buffer and appends the reorder, if any, to the net.
+    // Inputs must be bound before the primitive is appended, outputs after it.
+    void Bind(const void* userData, std::vector<mkldnn_primitive_t>& net)
+    {
+        CHECK_MKLDNN(mkldnn_memory_set_data_handle(m_userMemory.get(), const_cast<void*>(userData)));
+        if (m_reorder)
+            net.push_back(m_reorder.get());
+    }
+};
+
+} } }
+
+#endif
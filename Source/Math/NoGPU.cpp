@@ -215,6 +215,11 @@ void GPUSparseMatrix<ElemType>::CopyToCPUSparseMatrix(CPUSparseMatrix<ElemType>&
 {
 }
 template <class ElemType>
+std::vector<size_t> GPUSparseMatrix<ElemType>::GetBlockColumns() const
+{
+    return std::vector<size_t>();
+}
+template <class ElemType>
 void GPUSparseMatrix<ElemType>::ChangeDeviceTo(DEVICEID_TYPE toId)
 {
 }
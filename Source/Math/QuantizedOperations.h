@@ -4,6 +4,12 @@
 //
 #pragma once
 #include "Quantizers.h"
+#include <stdint.h>
+
+#if !defined(__CUDACC__) && (defined(__AVX2__) || defined(__SSSE3__) || defined(_M_X64))
+#include <immintrin.h>
+#define QUANTIZED_OPERATIONS_USE_SIMD
+#endif
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
@@ -21,6 +27,7 @@ class QuantizedMultiplier
     // Placeholders for quantized matrices A and B
     vector<short> m_pMatA, m_pMatB;
 
+protected:
     // Whether matrices A and B are constant (i.e. weights)
     // If the matrix is constant, the size of the underlying container for quatized values will be preserved for
     // the lifespan of the object
@@ -29,6 +36,14 @@ class QuantizedMultiplier
 
     bool m_firstPass;
 
+    // For derived multipliers that do their own quantization.
+    QuantizedMultiplier(bool isAConstant, bool isBConstant) :
+        m_isAConstant(isAConstant), m_isBConstant(isBConstant), m_firstPass(true)
+    {
+        if (isAConstant && isBConstant)
+            LogicError("Quantized multiplication is applied to two constant matrices -- it is highly inefficient. Better approach is to replace the operation with the resulting matrix.");
+    }
+
 public: 
     QuantizedMultiplier(shared_ptr<QuantizerBase<ElemType, short>> pQuantizerA, bool isAConstant, shared_ptr<QuantizerBase<ElemType, short>> pQuantizerB, bool isBConstant) :
         m_pQuantizerA(pQuantizerA), m_pQuantizerB(pQuantizerB), m_isAConstant(isAConstant), m_isBConstant(isBConstant), m_firstPass(true)
@@ -41,8 +56,20 @@ public:
     {
     };
 
+    virtual ~QuantizedMultiplier() {}
+
+    // op(A)[m,k]*op(B)[k,n] = C[m,n], where op(X) is X or its transpose.
+    virtual void Multiply(int m, int n, int k, bool transposeA, bool transposeB, ElemType* A, ElemType* B, ElemType* C)
+    {
+        // TODO: support transpose product
+        if (transposeA || transposeB)
+            LogicError("Quantized multiplier currently doesn't support transpose.");
+
+        Multiply(m, n, k, A, B, C);
+    }
+
     // A[m,k]*B[k,n] = C[m,n]
-    void Multiply(int m, int n, int k, ElemType* A, ElemType* B, ElemType* C)
+    virtual void Multiply(int m, int n, int k, ElemType* A, ElemType* B, ElemType* C)
     {
         // Quantize
         if (!m_isAConstant || m_firstPass)
@@ -86,4 +113,230 @@ public:
     void SetIsBConstant(bool v) { m_isBConstant = v; }
 };
 
+// Dot product of two vectors of int8 values in [-127, 127]. The length must be a multiple of 32.
+// The products are computed as unsigned * signed (|a| * sign(a) * b), which is what the int8 multiply-add instructions take;
+// the value -128 is excluded, so that the pairwise sums of the 16-bit products cannot saturate.
+inline int32_t Int8DotProduct(const int8_t* a, const int8_t* b, size_t length)
+{
+    assert(length % 32 == 0);
+#if defined(QUANTIZED_OPERATIONS_USE_SIMD) && defined(__AVX512VNNI__) && defined(__AVX512VL__)
+    __m256i sum = _mm256_setzero_si256();
+    for (size_t i = 0; i < length; i += 32)
+    {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        sum = _mm256_dpbusd_epi32(sum, _mm256_sign_epi8(va, va), _mm256_sign_epi8(vb, va));
+    }
+    __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+#elif defined(QUANTIZED_OPERATIONS_USE_SIMD) && defined(__AVX2__)
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (size_t i = 0; i < length; i += 32)
+    {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i products = _mm256_maddubs_epi16(_mm256_sign_epi8(va, va), _mm256_sign_epi8(vb, va));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+    }
+    __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+#elif defined(QUANTIZED_OPERATIONS_USE_SIMD)
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i sum128 = _mm_setzero_si128();
+    for (size_t i = 0; i < length; i += 16)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i products = _mm_maddubs_epi16(_mm_sign_epi8(va, va), _mm_sign_epi8(vb, va));
+        sum128 = _mm_add_epi32(sum128, _mm_madd_epi16(products, ones));
+    }
+#endif
+#if defined(QUANTIZED_OPERATIONS_USE_SIMD)
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum128);
+#else
+    int32_t sum = 0;
+    for (size_t i = 0; i < length; i++)
+        sum += (int32_t)a[i] * (int32_t)b[i];
+    return sum;
+#endif
+}
+
+// Int8 product of two dense matrices for inference, where at most one of the matrices (the weights) is constant.
+// The constant matrix is quantized once, with a separate scale for each output channel, i.e. for each row of C if A
+// is constant and for each column of C if B is constant. The other matrix (the activations) is quantized on each call
+// with a single scale, derived from the calibrated range of its values if one has been set, and from the absolute
+// max of the values otherwise.
+// Both operands are packed into vectors of k int8 values, zero padded to a multiple of 32, so that each element of C is
+// the dot product of two contiguous vectors. The integer accumulation is exact; the error is the int8 rounding of the operands.
+template <class ElemType>
+class Int8QuantizedMultiplier : public QuantizedMultiplier<ElemType>
+{
+    typedef QuantizedMultiplier<ElemType> Base;
+
+    static const int8_t rangeMax = 127;
+
+    // Quantized operands: op(A) as m vectors and op(B) as n vectors of length m_packedLength, with their scales.
+    std::vector<int8_t> m_packedA, m_packedB;
+    std::vector<float> m_scalesA, m_scalesB;
+    size_t m_packedLength;
+
+    // Whether the constant operand was quantized as its transpose, see QuantizeConstantOperand().
+    bool m_isConstantTransposed;
+
+    // Absolute range of the values of the non-constant operand; 0 if the range is taken from each call.
+    float m_inputRange;
+
+    // While calibrating, the products are computed with the range of each call and the max of these ranges is recorded.
+    bool m_calibrating;
+    float m_calibratedRange;
+
+public:
+    Int8QuantizedMultiplier(bool isAConstant, bool isBConstant, float inputRange = 0) :
+        Base(isAConstant, isBConstant), m_packedLength(0), m_isConstantTransposed(false), m_inputRange(inputRange), m_calibrating(false), m_calibratedRange(0)
+    {
+    }
+
+    // Quantizes the constant operand (the weights) ahead of the products, e.g. when the model is loaded, instead of in the
+    // first call to Multiply(). 'data' is the column-major [rows x cols] matrix X that is passed to Multiply() as A or B,
+    // and 'transpose' whether the products use its transpose. Call again whenever the weights change.
+    void QuantizeConstantOperand(const ElemType* data, int rows, int cols, bool transpose)
+    {
+        if (this->m_isAConstant)
+        {
+            int m = transpose ? cols : rows;
+            int k = transpose ? rows : cols;
+            m_packedLength = PackedLength(k);
+            Pack(data, m, k, transpose ? k : 1, transpose ? 1 : m, /*perVectorScale =*/ true, m_packedA, m_scalesA);
+        }
+        else if (this->m_isBConstant)
+        {
+            int k = transpose ? cols : rows;
+            int n = transpose ? rows : cols;
+            m_packedLength = PackedLength(k);
+            Pack(data, n, k, transpose ? 1 : k, transpose ? n : 1, /*perVectorScale =*/ true, m_packedB, m_scalesB);
+        }
+        else
+            LogicError("Int8QuantizedMultiplier: neither operand is constant.");
+
+        m_isConstantTransposed = transpose;
+        this->m_firstPass = false;
+    }
+
+    virtual void Multiply(int m, int n, int k, ElemType* A, ElemType* B, ElemType* C) override
+    {
+        Multiply(m, n, k, /*transposeA =*/ false, /*transposeB =*/ false, A, B, C);
+    }
+
+    // op(A)[m,k]*op(B)[k,n] = C[m,n], where op(X) is X or its transpose.
+    virtual void Multiply(int m, int n, int k, bool transposeA, bool transposeB, ElemType* A, ElemType* B, ElemType* C) override
+    {
+        size_t packedLength = PackedLength(k);
+        bool firstPass = this->m_firstPass || (packedLength != m_packedLength);
+        m_packedLength = packedLength;
+
+        // The constant operand is normally quantized by QuantizeConstantOperand(); it is (re)quantized here only if
+        // that has not been done or was done for a product of another shape.
+        // Element l of vector i of op(A) is at A[i * vectorStride + l * elementStride]; the same for op(B). All matrices are column major.
+        if (!this->m_isAConstant || firstPass || (m_scalesA.size() != m) || (m_isConstantTransposed != transposeA))
+        {
+            Pack(A, m, k, transposeA ? k : 1, transposeA ? 1 : m, this->m_isAConstant, m_packedA, m_scalesA);
+            if (this->m_isAConstant)
+                m_isConstantTransposed = transposeA;
+        }
+
+        if (!this->m_isBConstant || firstPass || (m_scalesB.size() != n) || (m_isConstantTransposed != transposeB))
+        {
+            Pack(B, n, k, transposeB ? 1 : k, transposeB ? n : 1, this->m_isBConstant, m_packedB, m_scalesB);
+            if (this->m_isBConstant)
+                m_isConstantTransposed = transposeB;
+        }
+
+        this->m_firstPass = false;
+
+        // Parallelize over the larger dimension of C, which is the minibatch for Times and the unrolled image for Convolution.
+        if (m >= n)
+        {
+#pragma omp parallel for if ((size_t)m * n * k >= 65536)
+            for (long i = 0; i < m; i++)
+                for (int j = 0; j < n; j++)
+                    C[i + (size_t)j * m] = DotProduct(i, j);
+        }
+        else
+        {
+#pragma omp parallel for if ((size_t)m * n * k >= 65536)
+            for (long j = 0; j < n; j++)
+                for (int i = 0; i < m; i++)
+                    C[i + (size_t)j * m] = DotProduct(i, j);
+        }
+    }
+
+    float GetInputRange() const { return m_inputRange; }
+    void SetInputRange(float inputRange) { m_inputRange = inputRange; }
+
+    void StartCalibration()
+    {
+        m_calibrating = true;
+        m_calibratedRange = 0;
+    }
+
+    // Ends the calibration and uses the max range seen since StartCalibration() from now on; returns that range.
+    float FinishCalibration()
+    {
+        m_calibrating = false;
+        m_inputRange = m_calibratedRange;
+        return m_inputRange;
+    }
+
+private:
+    static size_t PackedLength(int k) { return (k + 31) / 32 * 32; }
+
+    ElemType DotProduct(size_t i, size_t j) const
+    {
+        int32_t dotProduct = Int8DotProduct(&m_packedA[i * m_packedLength], &m_packedB[j * m_packedLength], m_packedLength);
+        return (ElemType)(dotProduct * m_scalesA[i] * m_scalesB[j]);
+    }
+
+    static float AbsMax(const ElemType* data, int numVectors, int k, size_t vectorStride, size_t elementStride)
+    {
+        float absMax = 0;
+        for (int i = 0; i < numVectors; i++)
+            for (int l = 0; l < k; l++)
+                absMax = std::max(absMax, std::abs((float)data[i * vectorStride + l * elementStride]));
+        return absMax;
+    }
+
+    void Pack(const ElemType* data, int numVectors, int k, size_t vectorStride, size_t elementStride, bool perVectorScale,
+              std::vector<int8_t>& packed, std::vector<float>& scales)
+    {
+        packed.assign(numVectors * m_packedLength, 0);
+        scales.resize(numVectors);
+
+        float range = 0;
+        if (!perVectorScale)
+        {
+            range = (m_inputRange > 0 && !m_calibrating) ? m_inputRange : AbsMax(data, numVectors, k, vectorStride, elementStride);
+            if (m_calibrating)
+                m_calibratedRange = std::max(m_calibratedRange, range);
+        }
+
+#pragma omp parallel for if ((size_t)numVectors * k >= 65536)
+        for (long i = 0; i < numVectors; i++)
+        {
+            const ElemType* values = data + i * vectorStride;
+            float vectorRange = perVectorScale ? AbsMax(values, 1, k, 0, elementStride) : range;
+            float quantizeFactor = (vectorRange > 0) ? rangeMax / vectorRange : 0;
+            scales[i] = vectorRange / rangeMax;
+
+            int8_t* packedVector = &packed[i * m_packedLength];
+            for (int l = 0; l < k; l++)
+            {
+                // Values outside of a calibrated range are clipped.
+                float value = std::round((float)values[l * elementStride] * quantizeFactor);
+                packedVector[l] = (int8_t)std::max((float)-rangeMax, std::min((float)rangeMax, value));
+            }
+        }
+    }
+};
+
 }}}
\ No newline at end of file
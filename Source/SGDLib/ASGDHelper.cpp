@@ -2,7 +2,8 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
 //
-// ASGDHelper.cpp : Implements ASGDHelper interface. The implementation is based on Multiverso.
+// ASGDHelper.cpp : Implements ASGDHelper interface. The implementation is based on Multiverso when it is available,
+//                  otherwise on a parameter server built into CNTK.
 //
 
 #define _CRT_SECURE_NO_WARNINGS // "secure" CRT not available on all platforms  --add this at the top of all CPP files that give "function or variable may be unsafe" warnings
@@ -14,6 +15,12 @@
 
 #include <functional>
 #include <thread>
+#include <mutex>
+#include <future>
+#include <chrono>
+#include <climits>
+#include <list>
+#include <map>
 #include <unordered_map>
 #include <numeric>
 #include <algorithm>
@@ -595,35 +602,597 @@ private:
 
 #endif 
 
-// A None implementation of ASGDHelper interface which does nothing
-// This is used when CNTK_ENABLE_ASGD = false
+// -----------------------------------------------------------------------
+// LocalParameterServerHelper -- built-in implementation of the ASGDHelper interface on top of MPI,
+// used when CNTK is built without Multiverso.
+//
+// The learnable parameters are flattened into one array which is partitioned into contiguous
+// shards, one per rank. Every rank is the server of its own shard and a client of all of them.
+// A single communication thread per rank serves the requests of the other ranks and runs the
+// exchanges of the local worker, so MPI is never called from two threads at the same time.
+// The training thread must not use MPI while the helper is alive; barriers go through WaitAll().
+//
+// An exchange sends to every shard owner the delta of the local model since the previous exchange
+// (scaled by DecayCoefficient(), or 1/#workers when simulating model averaging); the owner adds it
+// to its shard and answers with the updated values. With a bounded staleness s, the answer to the
+// c-th exchange of a worker is held back until every worker has sent at least c - s exchanges;
+// a worker waiting in a barrier does not hold anybody back.
+// -----------------------------------------------------------------------
 template<class ElemType = float>
-class NoneASGDHelper : public ASGDHelper<ElemType>
+class LocalParameterServerHelper : public ASGDHelper<ElemType>
 {
 public:
-    NoneASGDHelper(const std::list<ComputationNodeBasePtr> & learnableNodes,
-        int nodeNumRanks,
+    typedef shared_ptr<ComputationNode<ElemType>> ComputationNodePtr;
+
+    LocalParameterServerHelper(const std::list<ComputationNodeBasePtr> & learnableNodes,
+        size_t nodeNumRanks,
         bool useAsyncBuffer = true,
-        bool isSimModelAveragingSGD = false,
+        bool isSimulatedModelAveragingSGD = false,
         AdjustLearningRateAtBeginning adjusttype = AdjustLearningRateAtBeginning::None,
-        double adjustcoef = 0.2,
-        size_t adjustnbmb = 600,
+        double adjustCoef = 0.2,
+        size_t adjustPerMinibatches = 600,
         int traceLevel = 0,
         int syncPerfStats = 0,
-        const MPIWrapperPtr& pMPI = nullptr) { }
+        size_t maxStaleness = SIZE_MAX) :
+        m_mpi(MPIWrapper::GetInstance()),
+        m_numWorkers((int)nodeNumRanks), m_myRank((int)MPIWrapper::GetInstance()->CurrentNodeRank()),
+        m_useAsyncBuffer(useAsyncBuffer), m_isSimulatedModelAveragingSGD(isSimulatedModelAveragingSGD),
+        m_adjustLearningRateAtBeginningType(adjusttype), m_adjustCoefficient(adjustCoef), m_adjustMBNumber(adjustPerMinibatches),
+        m_traceLevel(traceLevel), m_syncPerfStats(syncPerfStats), m_maxStaleness(maxStaleness),
+        m_parameterSyncCounter(0), m_clock(0), m_barrierGeneration(0), m_stopped(false)
+    {
+        if (m_mpi == nullptr || m_mpi->NumNodesInUse() != nodeNumRanks)
+            LogicError("LocalParameterServerHelper: the number of workers does not match the MPI configuration.");
+
+        if (m_isSimulatedModelAveragingSGD)
+        {
+            // every exchange waits for all workers, the server then holds the average of the local models
+            m_useAsyncBuffer = false;
+            m_maxStaleness = 0;
+        }
+
+        size_t totalModelSize = 0;
+        for (auto& node : learnableNodes)
+        {
+            ComputationNodePtr pNode = dynamic_pointer_cast<ComputationNode<ElemType>>(node);
+            m_tableOffsets.push_back(totalModelSize);
+            m_tableLength.push_back(pNode->Value().GetNumElements());
+            totalModelSize += m_tableLength.back();
+        }
+
+        for (int rank = 0; rank <= m_numWorkers; rank++)
+            m_shardOffsets.push_back(totalModelSize * rank / m_numWorkers);
+        if (ShardSize(m_myRank) > (size_t)INT_MAX)
+            InvalidArgument("LocalParameterServerHelper: the model is too large to be served by %d workers.", m_numWorkers);
+
+        m_base.resize(totalModelSize);
+        m_pulled.resize(totalModelSize);
+        m_delta.resize(totalModelSize);
+        m_shard.resize(ShardSize(m_myRank));
+        m_receiveBuffer.resize(ShardSize(m_myRank));
+
+        m_workerClock.assign(m_numWorkers, 0);
+        m_workerInBarrier.assign(m_numWorkers, false);
+        m_workerBarrierGeneration.assign(m_numWorkers, -1);
+    }
+
+    ~LocalParameterServerHelper()
+    {
+        try
+        {
+            WaitAsyncBuffer();
+            // all ranks stop together, so no request can arrive once the servers shut down
+            if (m_communicationThread.joinable())
+                Submit(JobType::Stop).get();
+        }
+        catch (const std::exception& e)
+        {
+            fprintf(stderr, "~LocalParameterServerHelper: %s\n", e.what());
+        }
+        if (m_communicationThread.joinable())
+            m_communicationThread.join();
+    }
+
+    void InitModel(const std::list<ComputationNodeBasePtr> & learnableNodes) override
+    {
+        // Every worker starts from the same model, so each server takes its shard from the local copy.
+        CopyModelToArray(learnableNodes, m_base.data());
+        std::copy(m_base.begin() + m_shardOffsets[m_myRank], m_base.begin() + m_shardOffsets[m_myRank + 1], m_shard.begin());
+
+        m_communicationThread = std::thread([this]() { CommunicationLoop(); });
+
+        Submit(JobType::Pull).get();
+        m_base = m_pulled;
+        SetModelFromArray(learnableNodes, m_base.data());
+
+        if (m_traceLevel > 0)
+            fprintf(stderr, "parameter server: initial model loaded, serving %d of %d parameters.\n", (int)ShardSize(m_myRank), (int)m_base.size());
+        m_reportTimer.Start();
+    }
+
+    bool PushAndPullModel(const std::list<ComputationNodeBasePtr> & learnableNodes, size_t sampleSinceLastSynced) override
+    {
+        m_parameterSyncCounter++;
+        WaitAsyncBuffer();
+
+        m_reportTimer.Restart();
+        CopyModelToArray(learnableNodes, m_delta.data());
+
+        const ElemType factor = m_isSimulatedModelAveragingSGD ? (ElemType)(1.0 / m_numWorkers) : (ElemType)DecayCoefficient();
+        for (size_t i = 0; i < m_delta.size(); i++)
+            m_delta[i] = factor * (m_delta[i] - m_base[i]);
+
+        if (m_useAsyncBuffer)
+        {
+            // continue from the result of the previous exchange while this one is in flight
+            m_base = m_pulled;
+            SetModelFromArray(learnableNodes, m_base.data());
+            m_pendingExchange = Submit(JobType::PushAndPull);
+        }
+        else
+        {
+            Submit(JobType::PushAndPull).get();
+            m_base = m_pulled;
+            SetModelFromArray(learnableNodes, m_base.data());
+        }
+        m_reportTimer.Stop();
+
+        if (m_traceLevel > 2 && m_syncPerfStats > 0 && m_parameterSyncCounter % m_syncPerfStats == 0)
+            fprintf(stderr, "\t\t -- pushAndPull %d-th sync: %.4lf seconds, %d samples since last sync\n",
+                (int)m_parameterSyncCounter, m_reportTimer.ElapsedSeconds(), (int)sampleSinceLastSynced);
+        return true;
+    }
+
+    void WaitAll() override
+    {
+        WaitAsyncBuffer();
+        Submit(JobType::Barrier).get();
+    }
+
+    void WaitAsyncBuffer() override
+    {
+        if (m_pendingExchange.valid())
+            m_pendingExchange.get();
+    }
 
-    ~NoneASGDHelper() { }
+private:
+    enum class JobType : int
+    {
+        PushAndPull = 0,
+        Pull = 1,
+        Barrier = 2,
+        Stop = 3,
+    };
+
+    // tags of the point-to-point messages of the parameter server
+    enum : int
+    {
+        RequestTag = 0x5053,
+        PayloadTag = 0x5054,
+        ReplyTag = 0x5055,
+    };
+
+    // header of a request, sent as MPI_INT; a PushAndPull header is followed by the delta of the shard
+    struct RequestHeader
+    {
+        int type;
+        int clock;
+        int barrierGeneration;
+    };
+    static const int HeaderSize = sizeof(RequestHeader) / sizeof(int);
+
+    struct PendingReply
+    {
+        int source;
+        int clock;
+    };
+
+    struct OutgoingReply
+    {
+        std::vector<ElemType> values;
+        MPI_Request request;
+    };
+
+    // the job of the local worker the communication thread is currently working on
+    struct ClientJob
+    {
+        JobType type;
+        std::promise<void> done;
+        RequestHeader header;
+        std::vector<MPI_Request> requests;
+        bool started;
+        bool localPartDone;
+    };
+
+    size_t ShardSize(int rank) const { return m_shardOffsets[rank + 1] - m_shardOffsets[rank]; }
+
+    void CopyModelToArray(const std::list<ComputationNodeBasePtr> & learnableNodes, ElemType* array)
+    {
+        int i = 0;
+        for (auto nodeIter = learnableNodes.begin(); nodeIter != learnableNodes.end(); nodeIter++, i++)
+        {
+            ComputationNodePtr node = dynamic_pointer_cast<ComputationNode<ElemType>>(*nodeIter);
+            ElemType* px = array + m_tableOffsets[i];
+            size_t length = m_tableLength[i];
+            node->Value().CopyToArray(px, length);
+        }
+    }
+
+    void SetModelFromArray(const std::list<ComputationNodeBasePtr> & learnableNodes, ElemType* array)
+    {
+        int i = 0;
+        for (auto nodeIter = learnableNodes.begin(); nodeIter != learnableNodes.end(); nodeIter++, i++)
+        {
+            ComputationNodePtr node = dynamic_pointer_cast<ComputationNode<ElemType>>(*nodeIter);
+            Matrix<ElemType>& mat = node->Value();
+            mat.SetValue(mat.GetNumRows(), mat.GetNumCols(), mat.GetDeviceId(), array + m_tableOffsets[i]);
+        }
+    }
 
-    void InitModel(const std::list<ComputationNodeBasePtr> & learnableNode) override { }
+    // Hands a job to the communication thread; the future is ready once the job is done.
+    std::future<void> Submit(JobType type)
+    {
+        std::unique_ptr<ClientJob> job(new ClientJob());
+        job->type = type;
+        job->started = false;
+        job->localPartDone = false;
+        auto done = job->done.get_future();
+
+        std::unique_lock<std::mutex> lock(m_jobMutex);
+        if (m_stopped)
+            RuntimeError("LocalParameterServerHelper: the communication thread is not running.");
+        assert(!m_nextJob);
+        if (type == JobType::PushAndPull)
+            m_clock++;
+        job->header.type = (int)type;
+        job->header.clock = m_clock;
+        job->header.barrierGeneration = m_barrierGeneration;
+        m_nextJob = std::move(job);
+        return done;
+    }
 
-    bool PushAndPullModel(const std::list<ComputationNodeBasePtr> & learnableNodes, size_t sampleSinceLastSynced) override { 
+    void CommunicationLoop()
+    {
+        std::unique_ptr<ClientJob> job;
+        try
+        {
+            // one outstanding header receive per remote rank keeps the requests of every rank in order
+            std::vector<RequestHeader> incoming(m_numWorkers);
+            std::vector<MPI_Request> incomingRequests(m_numWorkers);
+            std::vector<bool> listening(m_numWorkers, false);
+            for (int rank = 0; rank < m_numWorkers; rank++)
+            {
+                if (rank == m_myRank)
+                    continue;
+                m_mpi->Irecv(&incoming[rank], HeaderSize, MPI_INT, rank, RequestTag, &incomingRequests[rank]) || MpiFail("parameter server: MPI_Irecv");
+                listening[rank] = true;
+            }
+
+            bool stopping = false;
+            int numStoppedRanks = 0;
+            for (;;)
+            {
+                bool progress = false;
+
+                // server: requests of the other ranks
+                for (int rank = 0; rank < m_numWorkers; rank++)
+                {
+                    if (!listening[rank])
+                        continue;
+                    int flag = 0;
+                    m_mpi->Test(&incomingRequests[rank], &flag, MPI_STATUS_IGNORE) || MpiFail("parameter server: MPI_Test");
+                    if (!flag)
+                        continue;
+                    progress = true;
+                    if ((JobType)incoming[rank].type == JobType::Stop)
+                    {
+                        listening[rank] = false;
+                        numStoppedRanks++;
+                        continue;
+                    }
+                    ServeRequest(rank, incoming[rank]);
+                    m_mpi->Irecv(&incoming[rank], HeaderSize, MPI_INT, rank, RequestTag, &incomingRequests[rank]) || MpiFail("parameter server: MPI_Irecv");
+                }
+                progress |= ProgressOutgoingReplies();
+
+                // client: the job of the local worker
+                if (!job)
+                {
+                    std::unique_lock<std::mutex> lock(m_jobMutex);
+                    job = std::move(m_nextJob);
+                }
+                if (job && !stopping && ProgressClientJob(*job))
+                {
+                    progress = true;
+                    if (job->type == JobType::Stop)
+                        stopping = true;
+                    else
+                    {
+                        m_localJob = nullptr;
+                        job->done.set_value();
+                        job.reset();
+                    }
+                }
+
+                if (stopping && numStoppedRanks == m_numWorkers - 1 && m_outgoingReplies.empty())
+                    break;
+                if (!progress)
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+        catch (...)
+        {
+            std::unique_lock<std::mutex> lock(m_jobMutex);
+            m_stopped = true;
+            if (!job)
+                job = std::move(m_nextJob);
+            if (job)
+                job->done.set_exception(std::current_exception());
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(m_jobMutex);
+        m_stopped = true;
+        job->done.set_value();
+    }
+
+    // Advances the job of the local worker; returns true once it is complete.
+    bool ProgressClientJob(ClientJob& job)
+    {
+        if (!job.started)
+        {
+            job.started = true;
+            StartClientJob(job);
+        }
+
+        bool complete = job.localPartDone;
+        for (auto& request : job.requests)
+        {
+            int flag = 0;
+            m_mpi->Test(&request, &flag, MPI_STATUS_IGNORE) || MpiFail("parameter server: MPI_Test");
+            complete &= (flag != 0);
+        }
+        if (!complete)
+            return false;
+
+        // a Stop job starts with a barrier; once all ranks are in it, the other servers are told to stop listening
+        if (job.type == JobType::Stop && (JobType)job.header.type == JobType::Barrier)
+        {
+            job.header.type = (int)JobType::Stop;
+            job.requests.clear();
+            for (int rank = 0; rank < m_numWorkers; rank++)
+            {
+                if (rank == m_myRank)
+                    continue;
+                job.requests.emplace_back();
+                m_mpi->Isend(&job.header, HeaderSize, MPI_INT, rank, RequestTag, &job.requests.back()) || MpiFail("parameter server: MPI_Isend");
+            }
+            return false;
+        }
         return true;
     }
 
-    void WaitAll() override { }
+    void StartClientJob(ClientJob& job)
+    {
+        // the header is sent from the job, which outlives the requests
+        const bool isBarrier = (job.type == JobType::Barrier || job.type == JobType::Stop);
+        if (isBarrier)
+            job.header.type = (int)JobType::Barrier;
+
+        for (int rank = 0; rank < m_numWorkers; rank++)
+        {
+            if (rank == m_myRank || (!isBarrier && ShardSize(rank) == 0))
+                continue;
+
+            job.requests.emplace_back();
+            m_mpi->Isend(&job.header, HeaderSize, MPI_INT, rank, RequestTag, &job.requests.back()) || MpiFail("parameter server: MPI_Isend");
+            if (isBarrier)
+                continue;
+
+            ElemType* shardBegin = m_pulled.data() + m_shardOffsets[rank];
+            if (job.type == JobType::PushAndPull)
+            {
+                job.requests.emplace_back();
+                m_mpi->Isend(m_delta.data() + m_shardOffsets[rank], (int)ShardSize(rank), MPIWrapper::GetDataType(shardBegin), rank, PayloadTag, &job.requests.back()) || MpiFail("parameter server: MPI_Isend");
+            }
+            job.requests.emplace_back();
+            m_mpi->Irecv(shardBegin, (int)ShardSize(rank), MPIWrapper::GetDataType(shardBegin), rank, ReplyTag, &job.requests.back()) || MpiFail("parameter server: MPI_Irecv");
+        }
+
+        // the local shard is served without going through MPI
+        m_localJob = &job;
+        if (job.type == JobType::PushAndPull)
+            ApplyDelta(m_myRank, job.header, m_delta.data() + m_shardOffsets[m_myRank]);
+        else
+            HandleRequest(m_myRank, job.header);
+    }
+
+    // Receives the payload of a request of another rank and handles it.
+    void ServeRequest(int source, const RequestHeader& header)
+    {
+        if ((JobType)header.type == JobType::PushAndPull)
+        {
+            m_mpi->Recv(m_receiveBuffer.data(), (int)m_receiveBuffer.size(), MPIWrapper::GetDataType(m_receiveBuffer.data()), source, PayloadTag, MPI_STATUS_IGNORE) || MpiFail("parameter server: MPI_Recv");
+            ApplyDelta(source, header, m_receiveBuffer.data());
+        }
+        else
+            HandleRequest(source, header);
+    }
+
+    void ApplyDelta(int source, const RequestHeader& header, const ElemType* delta)
+    {
+        for (size_t i = 0; i < m_shard.size(); i++)
+            m_shard[i] += delta[i];
+        HandleRequest(source, header);
+    }
+
+    void HandleRequest(int source, const RequestHeader& header)
+    {
+        switch ((JobType)header.type)
+        {
+        case JobType::Pull:
+            SendReply(source);
+            break;
+        case JobType::PushAndPull:
+            m_workerClock[source] = max(m_workerClock[source], header.clock);
+            m_workerInBarrier[source] = false;
+            m_pendingReplies.push_back(PendingReply{ source, header.clock });
+            break;
+        case JobType::Barrier:
+            {
+                m_workerInBarrier[source] = true;
+                m_workerBarrierGeneration[source] = header.barrierGeneration;
+                auto& arrivals = m_barrierArrivals[header.barrierGeneration];
+                arrivals.first++;
+                arrivals.second = max(arrivals.second, header.clock);
+                if (arrivals.first == m_numWorkers)
+                    CompleteBarrier(header.barrierGeneration, arrivals.second);
+            }
+            break;
+        default:
+            LogicError("parameter server: unexpected request %d from rank %d.", header.type, source);
+        }
+        ReleasePendingReplies();
+    }
+
+    // All workers have arrived at the barrier; they leave it with the clock of the one that was furthest ahead.
+    void CompleteBarrier(int generation, int maxClock)
+    {
+        m_barrierArrivals.erase(generation);
+        for (int rank = 0; rank < m_numWorkers; rank++)
+        {
+            m_workerClock[rank] = max(m_workerClock[rank], maxClock);
+            if (m_workerInBarrier[rank] && m_workerBarrierGeneration[rank] == generation)
+                m_workerInBarrier[rank] = false;
+        }
+
+        std::unique_lock<std::mutex> lock(m_jobMutex);
+        m_clock = max(m_clock, maxClock);
+        m_barrierGeneration = generation + 1;
+        if (m_localJob != nullptr && m_localJob->type != JobType::PushAndPull && m_localJob->type != JobType::Pull && m_localJob->header.barrierGeneration == generation)
+            m_localJob->localPartDone = true;
+    }
+
+    // Answers the exchanges which are within the staleness bound.
+    void ReleasePendingReplies()
+    {
+        int minClock = INT_MAX;
+        for (int rank = 0; rank < m_numWorkers; rank++)
+        {
+            if (!m_workerInBarrier[rank])
+                minClock = min(minClock, m_workerClock[rank]);
+        }
+
+        for (auto iter = m_pendingReplies.begin(); iter != m_pendingReplies.end();)
+        {
+            if (minClock == INT_MAX || m_maxStaleness >= (size_t)INT_MAX || (long long)iter->clock <= (long long)minClock + (long long)m_maxStaleness)
+            {
+                SendReply(iter->source);
+                iter = m_pendingReplies.erase(iter);
+            }
+            else
+                iter++;
+        }
+    }
+
+    void SendReply(int destination)
+    {
+        if (destination == m_myRank)
+        {
+            std::copy(m_shard.begin(), m_shard.end(), m_pulled.begin() + m_shardOffsets[m_myRank]);
+            m_localJob->localPartDone = true;
+            return;
+        }
+
+        m_outgoingReplies.emplace_back();
+        auto& reply = m_outgoingReplies.back();
+        reply.values = m_shard;
+        m_mpi->Isend(reply.values.data(), (int)reply.values.size(), MPIWrapper::GetDataType(reply.values.data()), destination, ReplyTag, &reply.request) || MpiFail("parameter server: MPI_Isend");
+    }
+
+    bool ProgressOutgoingReplies()
+    {
+        bool progress = false;
+        for (auto iter = m_outgoingReplies.begin(); iter != m_outgoingReplies.end();)
+        {
+            int flag = 0;
+            m_mpi->Test(&iter->request, &flag, MPI_STATUS_IGNORE) || MpiFail("parameter server: MPI_Test");
+            if (flag)
+            {
+                iter = m_outgoingReplies.erase(iter);
+                progress = true;
+            }
+            else
+                iter++;
+        }
+        return progress;
+    }
+
+    float DecayCoefficient()
+    {
+        float f = 1.f;
+        switch (m_adjustLearningRateAtBeginningType)
+        {
+        case AdjustLearningRateAtBeginning::None:
+            break;
+        case AdjustLearningRateAtBeginning::Linearly:
+            f = min(f, max(0.f, (float)(m_adjustCoefficient + (1 - m_adjustCoefficient) / m_adjustMBNumber * m_parameterSyncCounter)));
+            break;
+        case AdjustLearningRateAtBeginning::Staircase:
+            f = min(f, max(0.f, (float)(m_adjustCoefficient * (m_parameterSyncCounter / m_adjustMBNumber + 1))));
+            break;
+        default:
+            break;
+        }
+        return f;
+    }
+
+    MPIWrapperPtr m_mpi;
+    int m_numWorkers;
+    int m_myRank;
+
+    bool m_useAsyncBuffer;
+    bool m_isSimulatedModelAveragingSGD;
+    AdjustLearningRateAtBeginning m_adjustLearningRateAtBeginningType;
+    double m_adjustCoefficient;
+    size_t m_adjustMBNumber;
+    int m_traceLevel;
+    int m_syncPerfStats;
+    size_t m_maxStaleness;
 
-    void WaitAsyncBuffer() override { }
-};
+    size_t m_parameterSyncCounter;
+    Timer m_reportTimer;
+
+    vector<size_t> m_tableLength;
+    vector<size_t> m_tableOffsets;
+    vector<size_t> m_shardOffsets;
+
+    // client side: the model the worker continued from after the previous exchange, the result of the
+    // latest exchange, and the delta being pushed
+    std::vector<ElemType> m_base;
+    std::vector<ElemType> m_pulled;
+    std::vector<ElemType> m_delta;
+    std::future<void> m_pendingExchange;
+
+    // server side, only touched by the communication thread
+    std::vector<ElemType> m_shard;
+    std::vector<ElemType> m_receiveBuffer;
+    std::vector<int> m_workerClock;
+    std::vector<bool> m_workerInBarrier;
+    std::vector<int> m_workerBarrierGeneration;
+    std::map<int, std::pair<int, int>> m_barrierArrivals; // barrier generation -> (#workers arrived, max clock)
+    std::list<PendingReply> m_pendingReplies;
+    std::list<OutgoingReply> m_outgoingReplies;
+    ClientJob* m_localJob = nullptr;
+
+    // hand-over of jobs between the training thread and the communication thread
+    std::mutex m_jobMutex;
+    std::unique_ptr<ClientJob> m_nextJob;
+    int m_clock;
+    int m_barrierGeneration;
+    bool m_stopped;
+    std::thread m_communicationThread;
+};  // Class LocalParameterServerHelper
 
 template<class ElemType>
 ASGDHelper<ElemType>* NewASGDHelper(
@@ -635,17 +1204,37 @@ ASGDHelper<ElemType>* NewASGDHelper(
     double adjustCoef,
     size_t adjustPerMinibatches,
     int traceLevel,
-    int syncPerfStats) 
+    int syncPerfStats,
+    size_t maxStaleness) 
 {
 #ifdef ASGD_PARALLEL_SUPPORT
+    if (maxStaleness != SIZE_MAX)
+        InvalidArgument("maxStaleness is only supported by the built-in parameter server, not by Multiverso.");
     return new MultiversoHelper<ElemType>(learnableNodes, nodeNumRanks, useAsyncBuffer, isSimulatedModelAveragingSGD, 
                                       adjusttype, adjustCoef, adjustPerMinibatches, traceLevel, syncPerfStats);
 #else
-    return new NoneASGDHelper<ElemType>(learnableNodes, nodeNumRanks, useAsyncBuffer, isSimulatedModelAveragingSGD, 
-                                      adjusttype, adjustCoef, adjustPerMinibatches, traceLevel, syncPerfStats); 
+    return NewLocalParameterServerHelper<ElemType>(learnableNodes, nodeNumRanks, useAsyncBuffer, isSimulatedModelAveragingSGD, 
+                                      adjusttype, adjustCoef, adjustPerMinibatches, traceLevel, syncPerfStats, maxStaleness); 
 #endif
 }
 
+template<class ElemType>
+ASGDHelper<ElemType>* NewLocalParameterServerHelper(
+    const std::list<ComputationNodeBasePtr> & learnableNodes,
+    size_t nodeNumRanks,
+    bool useAsyncBuffer,
+    bool isSimulatedModelAveragingSGD,
+    AdjustLearningRateAtBeginning adjusttype,
+    double adjustCoef,
+    size_t adjustPerMinibatches,
+    int traceLevel,
+    int syncPerfStats,
+    size_t maxStaleness)
+{
+    return new LocalParameterServerHelper<ElemType>(learnableNodes, nodeNumRanks, useAsyncBuffer, isSimulatedModelAveragingSGD, 
+                                      adjusttype, adjustCoef, adjustPerMinibatches, traceLevel, syncPerfStats, maxStaleness); 
+}
+
 template ASGDHelper<float>* NewASGDHelper<float>(
     const std::list<ComputationNodeBasePtr> & learnableNodes,
     size_t nodeNumRanks,
@@ -655,7 +1244,8 @@ template ASGDHelper<float>* NewASGDHelper<float>(
     double adjustCoef,
     size_t adjustPerMinibatches,
     int traceLevel,
-    int syncPerfStats); 
+    int syncPerfStats,
+    size_t maxStaleness); 
 
 template ASGDHelper<double>* NewASGDHelper<double>(
     const std::list<ComputationNodeBasePtr> & learnableNodes,
@@ -666,6 +1256,31 @@ template ASGDHelper<double>* NewASGDHelper<double>(
     double adjustCoef,
     size_t adjustPerMinibatches,
     int traceLevel,
-    int syncPerfStats); 
+    int syncPerfStats,
+    size_t maxStaleness); 
+
+template ASGDHelper<float>* NewLocalParameterServerHelper<float>(
+    const std::list<ComputationNodeBasePtr> & learnableNodes,
+    size_t nodeNumRanks,
+    bool useAsyncBuffer,
+    bool isSimulatedModelAveragingSGD,
+    AdjustLearningRateAtBeginning adjusttype,
+    double adjustCoef,
+    size_t adjustPerMinibatches,
+    int traceLevel,
+    int syncPerfStats,
+    size_t maxStaleness);
+
+template ASGDHelper<double>* NewLocalParameterServerHelper<double>(
+    const std::list<ComputationNodeBasePtr> & learnableNodes,
+    size_t nodeNumRanks,
+    bool useAsyncBuffer,
+    bool isSimulatedModelAveragingSGD,
+    AdjustLearningRateAtBeginning adjusttype,
+    double adjustCoef,
+    size_t adjustPerMinibatches,
+    int traceLevel,
+    int syncPerfStats,
+    size_t maxStaleness);
 
 }}} 
@@ -0,0 +1,157 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// ParameterUpdatePipeline.h -- runs the parameter update of a minibatch on a second thread, overlapped with the
+// next minibatch (see ParameterUpdatePipelining in SGD.h)
+
+#pragma once
+
+#include "Basics.h"
+#include "ComputationNetwork.h"
+#include "ComputationNode.h"
+#include "Matrix.h"
+#include "SGD.h"
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// ---------------------------------------------------------------------------
+// ParameterUpdatePipeline -- keeps at most one parameter update in flight on a background thread.
+//
+// In Overlapped mode the background thread updates the node values in place, so Finish() must be called
+// before the network is evaluated again. In OneStepStale mode it works on private copies of the weights and
+// gradients: the network keeps evaluating the current weights until Finish() publishes the updated ones.
+// Start(), Finish() and the destructor must be called from the training thread.
+// ---------------------------------------------------------------------------
+
+template <class ElemType>
+class ParameterUpdatePipeline
+{
+public:
+    // Called once per learnable node that requires a parameter update.
+    typedef std::function<void(const ComputationNodeBasePtr& node, Matrix<ElemType>& value, Matrix<ElemType>& gradient,
+                               Matrix<ElemType>& smoothedGradient, double& smoothedCount)> UpdateFunction;
+
+    ParameterUpdatePipeline(ParameterUpdatePipelining mode, DEVICEID_TYPE deviceId,
+                            const std::list<ComputationNodeBasePtr>& learnableNodes,
+                            std::list<Matrix<ElemType>>& smoothedGradients, std::vector<double>& smoothedCounts)
+        : m_mode(mode), m_deviceId(deviceId), m_learnableNodes(learnableNodes), m_smoothedGradients(smoothedGradients), m_smoothedCounts(smoothedCounts)
+    {
+        if (m_mode != ParameterUpdatePipelining::OneStepStale)
+            return;
+
+        for (auto& node : m_learnableNodes)
+        {
+            if (!node->IsParameterUpdateRequired())
+                continue;
+
+            auto weights = make_shared<Matrix<ElemType>>(m_deviceId);
+            weights->SetValue(ValueOf(node));
+            m_weights.push_back(weights);
+            m_gradients.push_back(make_shared<Matrix<ElemType>>(m_deviceId));
+        }
+    }
+
+    ~ParameterUpdatePipeline()
+    {
+        // The update must not outlive the matrices it works on. Errors have been reported by Finish() unless we are unwinding.
+        if (m_pendingUpdate.valid())
+            m_pendingUpdate.wait();
+    }
+
+    bool IsEnabled() const { return m_mode != ParameterUpdatePipelining::None; }
+
+    // True if the network may be evaluated while an update is in flight.
+    bool AllowsStaleWeights() const { return m_mode == ParameterUpdatePipelining::OneStepStale; }
+
+    // Bookkeeping of the training thread: number of updates started and number of updates made visible to the network.
+    // Their difference is the staleness of the weights the network currently evaluates, at most 1.
+    size_t NumStartedUpdates() const { return m_numStartedUpdates; }
+    size_t NumPublishedUpdates() const { return m_numPublishedUpdates; }
+
+    // Starts updating all parameters from the current node gradients. Waits for the previous update first.
+    void Start(const UpdateFunction& update)
+    {
+        assert(IsEnabled());
+        Finish();
+
+        // The next backprop overwrites the node gradients, so the stale update works on a snapshot of them.
+        if (AllowsStaleWeights())
+        {
+            size_t i = 0;
+            for (auto& node : m_learnableNodes)
+                if (node->IsParameterUpdateRequired())
+                    m_gradients[i++]->SetValue(GradientOf(node));
+        }
+
+        m_pendingUpdate = std::async(std::launch::async, [this, update]
+        {
+            // We are starting on a new thread. Make sure the new thread is
+            // setup to use the right device
+            Matrix<ElemType>::SetDevice(m_deviceId);
+
+            size_t i = 0;
+            auto smoothedGradientIter = m_smoothedGradients.begin();
+            auto smoothedCountIter = m_smoothedCounts.begin();
+            for (auto nodeIter = m_learnableNodes.begin(); nodeIter != m_learnableNodes.end(); nodeIter++, smoothedGradientIter++, smoothedCountIter++)
+            {
+                const ComputationNodeBasePtr& node = *nodeIter;
+                if (!node->IsParameterUpdateRequired())
+                    continue;
+
+                if (AllowsStaleWeights())
+                    update(node, *m_weights[i], *m_gradients[i], *smoothedGradientIter, *smoothedCountIter);
+                else
+                    update(node, ValueOf(node), GradientOf(node), *smoothedGradientIter, *smoothedCountIter);
+                i++;
+            }
+        });
+        m_numStartedUpdates++;
+    }
+
+    // Waits for the pending update, if any, and makes the updated weights visible to the network.
+    void Finish()
+    {
+        if (!m_pendingUpdate.valid())
+            return;
+
+        m_pendingUpdate.get(); // rethrows errors of the update
+
+        size_t i = 0;
+        for (auto& node : m_learnableNodes)
+        {
+            if (!node->IsParameterUpdateRequired())
+                continue;
+
+            if (AllowsStaleWeights())
+                ValueOf(node).SetValue(*m_weights[i++]);
+            node->BumpEvalTimeStamp();
+        }
+        m_numPublishedUpdates++;
+    }
+
+private:
+    static Matrix<ElemType>& ValueOf(const ComputationNodeBasePtr& node) { return dynamic_pointer_cast<ComputationNode<ElemType>>(node)->Value(); }
+    static Matrix<ElemType>& GradientOf(const ComputationNodeBasePtr& node) { return dynamic_pointer_cast<ComputationNode<ElemType>>(node)->Gradient(); }
+
+    const ParameterUpdatePipelining m_mode;
+    const DEVICEID_TYPE m_deviceId;
+    const std::list<ComputationNodeBasePtr>& m_learnableNodes;
+    std::list<Matrix<ElemType>>& m_smoothedGradients;
+    std::vector<double>& m_smoothedCounts;
+
+    // OneStepStale only: weights being updated and the gradients they are updated with, for each node that requires an update.
+    std::vector<shared_ptr<Matrix<ElemType>>> m_weights;
+    std::vector<shared_ptr<Matrix<ElemType>>> m_gradients;
+
+    std::future<void> m_pendingUpdate;
+    size_t m_numStartedUpdates = 0;
+    size_t m_numPublishedUpdates = 0;
+};
+
+}}}
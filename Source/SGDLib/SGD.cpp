@@ -16,6 +16,7 @@
 #include "MatrixQuantizerImpl.h"
 #include "InputAndParamNodes.h"
 #include "AccumulatorAggregation.h"
+#include "ParameterUpdatePipeline.h"
 
 #ifdef CNTK_PARALLEL_TRAINING_SUPPORT
 //static inline bool operator==(const std::pair<double,size_t>& a, double b) { assert(b==0); return a.first == b; }
@@ -497,7 +498,8 @@ void SGD<ElemType>::TrainOrAdaptModel(int startEpoch, ComputationNetworkPtr net,
                                          m_adjustCoefficient,
                                          m_adjustPerMinibatches,
                                          m_traceLevel,
-                                         m_syncStatsTrace));
+                                         m_syncStatsTrace,
+                                         m_asgdMaxStaleness));
         m_pASGDHelper->InitModel(learnableNodes);
     }
 
@@ -702,7 +704,7 @@ void SGD<ElemType>::TrainOrAdaptModel(int startEpoch, ComputationNetworkPtr net,
 
         if (validationSetDataReader != trainSetDataReader && validationSetDataReader != nullptr)
         {
-            // TODO(dataASGD) making evaluator becoming nondistributed one when using ASGD, since Multiverso has another background thread using MPI.
+            // TODO(dataASGD) making evaluator becoming nondistributed one when using ASGD, since the parameter server has another background thread using MPI.
             //                Making the evaluation serial (non-distributed) will slowdown training especially when validation set is large.
             SimpleEvaluator<ElemType> evalforvalidation(net, UsingAsyncGradientAggregation(i + 1) ?nullptr : m_mpi, m_enableDistributedMBReading);
             vector<wstring> cvSetTrainAndEvalNodes;
@@ -1017,6 +1019,11 @@ size_t SGD<ElemType>::TrainOneEpoch(ComputationNetworkPtr net,
     bool useAsyncGradientAggregation = UsingAsyncGradientAggregation(epochNumber);
     bool useParallelTrain = UsingParallelTrain(epochNumber);
 
+    // Model aggregation and ASGD modify the model right after the update, they cannot run it in the background.
+    bool usePipelinedUpdate = m_parameterUpdatePipelining != ParameterUpdatePipelining::None && !useModelAggregation && !useAsyncGradientAggregation;
+    ParameterUpdatePipeline<ElemType> updatePipeline(usePipelinedUpdate ? m_parameterUpdatePipelining : ParameterUpdatePipelining::None,
+                                                     net->GetDeviceId(), learnableNodes, smoothedGradients, smoothedCounts);
+
     // Find all evaluation nodes that accumulate error on their own.
     auto evaluationNodesWhichAccumulateResult = net->ExtractNodesWhichAccumulateResult(
         set<ComputationNodeBasePtr>(evaluationNodes.begin(), evaluationNodes.end()));
@@ -1103,6 +1110,11 @@ size_t SGD<ElemType>::TrainOneEpoch(ComputationNetworkPtr net,
         if (useDistributedMBReading)
             fprintf(stderr, ", distributed reading is ENABLED");
 
+        if (usePipelinedUpdate)
+            fprintf(stderr, ", pipelined parameter update%s is ENABLED", updatePipeline.AllowsStaleWeights() ? " with one-step-stale gradients" : "");
+        else if (m_parameterUpdatePipelining != ParameterUpdatePipelining::None)
+            fprintf(stderr, ", pipelined parameter update is DISABLED for model aggregation and ASGD");
+
         if (numSubminibatchesNeeded > 1)
         {
             if (m_maxSamplesInRAM < SIZE_MAX)
@@ -1172,6 +1184,10 @@ size_t SGD<ElemType>::TrainOneEpoch(ComputationNetworkPtr net,
         bool wasDataRead = DataReaderHelpers::GetMinibatchIntoNetwork<ElemType>(*trainSetDataReader, net, criterionNodes[0],
                                                                                 useDistributedMBReading, useParallelTrain, *inputMatrices, actualMBSize, m_mpi);
 
+        // From here on the network must see the weights updated with the previous minibatch, unless stale weights are allowed.
+        if (!updatePipeline.AllowsStaleWeights())
+            updatePipeline.Finish();
+
         if (maxNumSamplesExceeded) // Dropping data.
             wasDataRead = false;
 
@@ -1381,34 +1397,51 @@ size_t SGD<ElemType>::TrainOneEpoch(ComputationNetworkPtr net,
             if (numSamplesInMinibatch != aggregateNumSamples)
                 fprintf(stderr, "SGD: using true #samples %d instead of MB size %d\n", (int)numSamplesInMinibatch, (int)aggregateNumSamples);
 #endif
-            auto smoothedGradientIter = smoothedGradients.begin();
-            auto smoothedCountIter = smoothedCounts.begin();
-            for (auto nodeIter = learnableNodes.begin(); nodeIter != learnableNodes.end(); nodeIter++, smoothedGradientIter++, smoothedCountIter++)
+            // BUGBUG (Issue #95): Access to net MBLayout can no longer be done if we have multiple input layouts
+            double momentumPerSample = GetMomentumPerSample(epochNumber /*BUGBUG workaround:*/, net->GetMBLayoutPtrOfNetwork()->GetNumParallelSequences());
+            auto updateNode = [this, learnRatePerSample, momentumPerSample, numSamplesInMinibatch](const ComputationNodeBasePtr& node,
+                                                                                                   Matrix<ElemType>& value, Matrix<ElemType>& gradient,
+                                                                                                   Matrix<ElemType>& smoothedGradient, double& smoothedCount)
             {
-                ComputationNodeBasePtr node = *nodeIter;
-                if (node->IsParameterUpdateRequired())
-                {
 #ifdef _DEBUG
-                    if (smoothedGradientIter->HasNan("TrainOneEpoch/UpdateWeights(): "))
-                        LogicError("%ls %ls operation has NaNs in smoothedGradient.", node->NodeName().c_str(), node->OperationName().c_str());
+                if (smoothedGradient.HasNan("TrainOneEpoch/UpdateWeights(): "))
+                    LogicError("%ls %ls operation has NaNs in smoothedGradient.", node->NodeName().c_str(), node->OperationName().c_str());
 #endif
-                    double nodeDependentLearningRatePerSample = learnRatePerSample * node->GetLearningRateMultiplier();
-                    double nodeDependentRegMultiplier = dynamic_pointer_cast<LearnableParameter<ElemType>>(node)->GetRegMultiplier();
-                    double momentumPerSample = GetMomentumPerSample(epochNumber /*BUGBUG workaround:*/, net->GetMBLayoutPtrOfNetwork()->GetNumParallelSequences());
-                    // TODO: Check why l2Factor is not applied to L1. Bug?
-                    // BUGBUG (Issue #95): Access to net MBLayout can no longer be done if we have multiple input layouts
-                    UpdateWeights(dynamic_pointer_cast<ComputationNode<ElemType>>(node)->Value(),
-                                  dynamic_pointer_cast<ComputationNode<ElemType>>(node)->Gradient(),
-                                  *smoothedGradientIter, *smoothedCountIter,
-                                  nodeDependentLearningRatePerSample, momentumPerSample,
-                                  numSamplesInMinibatch,
-                                  m_L2RegWeight * nodeDependentRegMultiplier, m_L1RegWeight * nodeDependentRegMultiplier,
-                                  m_needAveMultiplier, m_useNesterovMomentum);
-                    node->BumpEvalTimeStamp();
+                double nodeDependentLearningRatePerSample = learnRatePerSample * node->GetLearningRateMultiplier();
+                double nodeDependentRegMultiplier = dynamic_pointer_cast<LearnableParameter<ElemType>>(node)->GetRegMultiplier();
+                // TODO: Check why l2Factor is not applied to L1. Bug?
+                UpdateWeights(value, gradient,
+                              smoothedGradient, smoothedCount,
+                              nodeDependentLearningRatePerSample, momentumPerSample,
+                              numSamplesInMinibatch,
+                              m_L2RegWeight * nodeDependentRegMultiplier, m_L1RegWeight * nodeDependentRegMultiplier,
+                              m_needAveMultiplier, m_useNesterovMomentum);
 #ifdef _DEBUG
-                    if (dynamic_pointer_cast<ComputationNode<ElemType>>(node)->Value().HasNan("TrainOneEpoch/UpdateWeights(): "))
-                        LogicError("%ls %ls operation has NaNs in functionValues after parameter update.", node->NodeName().c_str(), node->OperationName().c_str());
+                if (value.HasNan("TrainOneEpoch/UpdateWeights(): "))
+                    LogicError("%ls %ls operation has NaNs in functionValues after parameter update.", node->NodeName().c_str(), node->OperationName().c_str());
 #endif
+            };
+
+            if (updatePipeline.IsEnabled())
+            {
+                // runs while the next minibatch is read; the nodes' timestamps are bumped once it has finished
+                updatePipeline.Start(updateNode);
+            }
+            else
+            {
+                auto smoothedGradientIter = smoothedGradients.begin();
+                auto smoothedCountIter = smoothedCounts.begin();
+                for (auto nodeIter = learnableNodes.begin(); nodeIter != learnableNodes.end(); nodeIter++, smoothedGradientIter++, smoothedCountIter++)
+                {
+                    ComputationNodeBasePtr node = *nodeIter;
+                    if (node->IsParameterUpdateRequired())
+                    {
+                        updateNode(node,
+                                   dynamic_pointer_cast<ComputationNode<ElemType>>(node)->Value(),
+                                   dynamic_pointer_cast<ComputationNode<ElemType>>(node)->Gradient(),
+                                   *smoothedGradientIter, *smoothedCountIter);
+                        node->BumpEvalTimeStamp();
+                    }
                 }
             }
         }
@@ -1621,7 +1654,7 @@ size_t SGD<ElemType>::TrainOneEpoch(ComputationNetworkPtr net,
         // for the two-forward-pass sequence and ctc training, which allows
         // processing more utterances at the same time. Only used in Kaldi2Reader.
         // TODO: move the two-forward-pass support out of the reader.
-        AttemptUtteranceDerivativeFeatures(net, trainSetDataReader, featureNodes, inputMatrices);
+        AttemptUtteranceDerivativeFeatures(net, trainSetDataReader, featureNodes, inputMatrices, &updatePipeline);
 
         profiler.NextSample();
         isFirstMinibatch = false;
@@ -1632,6 +1665,9 @@ size_t SGD<ElemType>::TrainOneEpoch(ComputationNetworkPtr net,
 
     // --- END MAIN MINIBATCH LOOP
 
+    // the model is checkpointed/evaluated after the epoch
+    updatePipeline.Finish();
+
     if (useModelAggregation )
     {
         m_pMASGDHelper->OnEpochEnd(learnableNodes, smoothedGradients, nSamplesSinceLastModelSync);
@@ -2237,7 +2273,8 @@ template <class ElemType>
 void SGD<ElemType>::AttemptUtteranceDerivativeFeatures(ComputationNetworkPtr net,
                                                        IDataReader* trainSetDataReader,
                                                        const std::vector<ComputationNodeBasePtr>& featureNodes,
-                                                       StreamMinibatchInputs* inputMatrices)
+                                                       StreamMinibatchInputs* inputMatrices,
+                                                       ParameterUpdatePipeline<ElemType>* updatePipeline)
 {
     assert(trainSetDataReader != NULL);
     std::vector<std::vector<std::pair<wstring, size_t>>> uttInfo;
@@ -2255,6 +2292,9 @@ void SGD<ElemType>::AttemptUtteranceDerivativeFeatures(ComputationNetworkPtr net
             InvalidArgument("AttemptUtteranceDerivativeFeatures cannot be used together with forward value memory sharing. "
                             "Set 'shareNodeValueMatrices=false' at the top level of your CNTK config file to get around this error");
 
+        if (updatePipeline && !updatePipeline->AllowsStaleWeights())
+            updatePipeline->Finish();
+
         // BUGBUG (Issue #95): This is no longer correct once we have multiple input layouts.
         trainSetDataReader->CopyMBLayoutTo(net->GetMBLayoutPtrOfNetwork());
         net->ForwardProp(outputNodes[0]); // only evaluate the first output
@@ -2845,6 +2885,14 @@ static GradientsUpdateType ParseGradUpdateType(const wstring& s)
     else InvalidArgument("ParseGradUpdateType: Invalid Gradient Updating Type. Valid values are (none | adagrad | rmsProp | fsAdagrad )");
 }
 
+static ParameterUpdatePipelining ParseParameterUpdatePipelining(const wstring& s)
+{
+    if      (EqualCI(s, L"") || EqualCI(s, L"none") || EqualCI(s, L"false")) return ParameterUpdatePipelining::None;
+    else if (EqualCI(s, L"overlapped") || EqualCI(s, L"true"))               return ParameterUpdatePipelining::Overlapped;
+    else if (EqualCI(s, L"oneStepStale"))                                     return ParameterUpdatePipelining::OneStepStale;
+    else InvalidArgument("ParseParameterUpdatePipelining: Invalid pipelined update type. Valid values are (none | overlapped | oneStepStale)");
+}
+
 static ParallelizationMethod ParseParallelizationMethod(const wstring& s)
 {
     if      (EqualCI(s, L"") || EqualCI(s, L"none")) return ParallelizationMethod::none;
@@ -2866,7 +2914,6 @@ static LearningRateSearchAlgorithm ParseLearningRateSearchType(const wstring& s)
     else InvalidArgument("autoAdjustLR: Invalid learning rate search type. Valid values are (none | searchBeforeEpoch | adjustAfterEpoch)");
 }
   
-#ifdef ASGD_PARALLEL_SUPPORT
 static AdjustLearningRateAtBeginning AdjustLearningRateAtBeginningType(const wstring& s)
 {
     if      (EqualCI(s.c_str(), L"") || EqualCI(s.c_str(), L"none")) return AdjustLearningRateAtBeginning::None;
@@ -2874,7 +2921,6 @@ static AdjustLearningRateAtBeginning AdjustLearningRateAtBeginningType(const wst
     else if (EqualCI(s.c_str(), L"staircase"))                       return AdjustLearningRateAtBeginning::Staircase;
     else InvalidArgument("AdjustLearningRateatBeginningType: Invalid Type. Valid values are (None | Linearly | Staircase)");
 }
-#endif
   
 template<class ConfigRecordType>
 SGDParams::SGDParams(const ConfigRecordType& configSGD, size_t sizeofElemType)
@@ -2915,6 +2961,7 @@ SGDParams::SGDParams(const ConfigRecordType& configSGD, size_t sizeofElemType)
     m_truncated = configSGD(L"truncated", false);
     m_maxSamplesInRAM = configSGD(L"maxSamplesInRAM", (size_t) SIZE_MAX);
     m_numSubminiBatches = configSGD(L"numSubminibatches", (size_t) 1);
+    m_parameterUpdatePipelining = ParseParameterUpdatePipelining(configSGD(L"pipelinedUpdate", L"None"));
 
     m_packThresholdSizeInBytes = configSGD(L"packThresholdSizeInKB", DEFAULT_PACK_THRESHOLD_SIZE_IN_KB) * 1024;
 
@@ -3132,6 +3179,12 @@ SGDParams::SGDParams(const ConfigRecordType& configSGD, size_t sizeofElemType)
     m_enableDistributedMBReading = false;
     m_parallelizationStartEpochNum = 0;
     m_modelAggregationBlockSize = 0; 
+    m_isAsyncBufferEnabled = false;
+    m_isSimulateMA = false;
+    m_adjustLearningRateAtBeginning = AdjustLearningRateAtBeginning::None;
+    m_adjustCoefficient = 0.1;
+    m_adjustPerMinibatches = 256;
+    m_asgdMaxStaleness = SIZE_MAX;
 
     if (configSGD.Exists(L"ParallelTrain"))
     {
@@ -3257,9 +3310,7 @@ SGDParams::SGDParams(const ConfigRecordType& configSGD, size_t sizeofElemType)
 
         if (configParallelTrain.Exists(L"DataParallelASGD"))
         {
-#ifndef ASGD_PARALLEL_SUPPORT
-            InvalidArgument("DataParallelASGD is not enabled in this version.\n");
-#else
+            // without Multiverso, the parameter server built into CNTK is used
             const ConfigRecordType & configDataParallelASGD(configParallelTrain(L"DataParallelASGD", ConfigRecordType::Record()));
             m_nSyncSamplesPerWorker = configDataParallelASGD(L"syncPeriodPerWorker", ConfigRecordType::Array(intargvector(vector<int>{256})));
 #if 1       // legacy option
@@ -3272,6 +3323,7 @@ SGDParams::SGDParams(const ConfigRecordType& configSGD, size_t sizeofElemType)
 #endif
             m_isAsyncBufferEnabled = configDataParallelASGD(L"UsePipeline", false);
             m_isSimulateMA = configDataParallelASGD(L"SimModelAverage", false); // using parameter server-based version of ModelAveragingSGD
+            m_asgdMaxStaleness = configDataParallelASGD(L"maxStaleness", SIZE_MAX); // bounded staleness: max #syncs a worker may run ahead of the slowest one
             if (configDataParallelASGD.Exists(L"AdjustLearningRateAtBeginning")) // adjust learning rate per m_adjustNumInBatch minibatches until to original one,
                                                                                  // this option could be used to takcle the unstableness of DataParallelASGD if you get a chance
             {
@@ -3280,7 +3332,6 @@ SGDParams::SGDParams(const ConfigRecordType& configSGD, size_t sizeofElemType)
                 m_adjustCoefficient = configAdjustLearningRateAtBeginning(L"adjustCoefficient", (double)0.1);
                 m_adjustPerMinibatches = configAdjustLearningRateAtBeginning(L"adjustPerMinibatches", (size_t)256);
             }
-#endif
         }
         } // if (!pMPI)
     } // if (configSGD.Exists(L"ParallelTrain"))
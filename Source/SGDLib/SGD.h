@@ -58,6 +58,13 @@ enum class GradientsUpdateType : int
     FSAdaGrad
 };
 
+enum class ParameterUpdatePipelining : int
+{
+    None,         // the update of minibatch t completes before minibatch t+1 is read
+    Overlapped,   // the update of minibatch t overlaps reading minibatch t+1; forward of t+1 waits for it
+    OneStepStale  // the update of minibatch t also overlaps forward/backward of t+1, which uses the weights from before the update
+};
+
 // modelParallelSGD can be combined with dataParallelSGD/modelAveragingSGD/blockMomentumSGD 
 // but dataParallelSGD/modelAveragingSGD/blockMomentumSGD are mutually exclusive (at least at the moment)
 // we assign the lower 8 bits to the enumerate data parallelization methods 
@@ -201,6 +208,11 @@ protected:
     // if m_maxTempMemSizeInSamples = SIZE_MAX (which means users do not specify the option) and m_numSubminiBatches > 1
     // we divide one minibatch to m_numSubminiBatches subMinibatches
 
+    // run the parameter update of minibatch t on a second thread while minibatch t+1 is read (and, if stale gradients
+    // are allowed, forward/backward propagated). Not used in epochs with model averaging/block momentum or ASGD,
+    // which modify the model after the update.
+    ParameterUpdatePipelining m_parameterUpdatePipelining;
+
     // the number of samples in each epoch (0 means, use all the samples in each epoch).
     size_t m_epochSize;
     size_t m_maxComputedEpochSize;
@@ -312,6 +324,7 @@ protected:
     AdjustLearningRateAtBeginning m_adjustLearningRateAtBeginning;
     double m_adjustCoefficient;
     size_t m_adjustPerMinibatches;
+    size_t m_asgdMaxStaleness;
 
     // sequence training
     double m_hSmoothingWeight;
@@ -332,6 +345,9 @@ protected:
 template <class ElemType>
 class IDistGradAggregator;
 
+template <class ElemType>
+class ParameterUpdatePipeline;
+
 // -----------------------------------------------------------------------
 // class SGD
 // -----------------------------------------------------------------------
@@ -488,7 +504,8 @@ protected:
     void AttemptUtteranceDerivativeFeatures(ComputationNetworkPtr net,
                                             IDataReader* trainSetDataReader,
                                             const std::vector<ComputationNodeBasePtr>& featureNodes,
-                                            StreamMinibatchInputs* inputMatrices);
+                                            StreamMinibatchInputs* inputMatrices,
+                                            ParameterUpdatePipeline<ElemType>* updatePipeline = nullptr);
 
     size_t TrainOneEpoch(ComputationNetworkPtr net,
                          ComputationNetworkPtr refNet,
@@ -114,6 +114,7 @@ void TestFrameMode()
 
     learners[L"gpu"] = [](LearnerPtr l) { return CreateQuantizedDataParallelDistributedLearner(QuantizedMPICommunicator(true, true, 32), l, 0); };
     learners[L"blockmomentum"] = [](LearnerPtr l) { return CreateBlockMomentumDistributedLearner(MPICommunicator(), l, 0, 1024); };
+    learners[L"modelaveraging"] = [](LearnerPtr l) { return CreateModelAveragingDistributedLearner(MPICommunicator(), l, 0, 4, 1); };
 
     // Create a set of devices.
     std::vector<DeviceDescriptor> devices;
@@ -9,8 +9,10 @@
 //#include "Windows.h"
 #include "Matrix.h"
 #include "CPUMatrix.h"
+#include "CPUSparseMatrix.h"
 #include "TensorView.h"
 #include "Sequences.h"
+#include "QuantizedOperations.h"
 #include <chrono>
 #include <iostream>
 #include <vector>
@@ -65,6 +67,195 @@ void MultiplyAndWeightedAddTest(int n, int k, int m)
     std::cout << "Matrix in: " << 1.0 * (t_endG - t_startG) / CLOCKS_PER_SEC << " seconds" << endl;
 }
 
+// Compares the int8 product of constant weights A with inputs B against the float product, in time and accuracy.
+template <class ElemType>
+void Int8MultiplyTest(int n, int k, int m, int count)
+{
+    cout << "A(" << n << "x" << k << ") and B(" << k << "," << m << ")" << endl;
+    CPUMatrix<ElemType> A(n, k);
+    randomInitializeCPUMatrix<ElemType>(A, -1, 1);
+    CPUMatrix<ElemType> B(k, m);
+    randomInitializeCPUMatrix<ElemType>(B);
+    CPUMatrix<ElemType> C(n, m);
+    CPUMatrix<ElemType> CQ(n, m);
+
+    auto t_start = clock();
+    for (int i = 0; i < count; i++)
+        CPUMatrix<ElemType>::MultiplyAndWeightedAdd(1, A, false, B, false, 0, C);
+    auto t_end = clock();
+    std::cout << "float in: " << 1.0 * (t_end - t_start) / CLOCKS_PER_SEC / count << " seconds" << endl;
+
+    auto pQuantizedMultiplier = make_shared<Int8QuantizedMultiplier<ElemType>>(/*isAConstant =*/ true, /*isBConstant =*/ false);
+    t_start = clock();
+    for (int i = 0; i < count; i++)
+        CPUMatrix<ElemType>::MultiplyAndWeightedAdd(1, A, false, B, false, 0, CQ, pQuantizedMultiplier);
+    t_end = clock();
+    std::cout << "int8 in: " << 1.0 * (t_end - t_start) / CLOCKS_PER_SEC / count << " seconds" << endl;
+
+    double maxError = 0, maxValue = 0;
+    foreach_coord (i, j, C)
+    {
+        maxError = max(maxError, (double)fabs(C(i, j) - CQ(i, j)));
+        maxValue = max(maxValue, (double)fabs(C(i, j)));
+    }
+    std::cout << "max abs error: " << maxError << " (max abs value " << maxValue << ")" << endl;
+}
+
+// Compares the half precision product, which converts tiles to float on the fly, against the float product, in time and accuracy.
+void HalfMultiplyTest(int n, int k, int m, int count)
+{
+    cout << "A(" << n << "x" << k << ") and B(" << k << "," << m << ")" << endl;
+    CPUMatrix<float> A(n, k);
+    randomInitializeCPUMatrix<float>(A, -1, 1);
+    CPUMatrix<float> B(k, m);
+    randomInitializeCPUMatrix<float>(B, -1, 1);
+    CPUMatrix<float> C(n, m);
+    CPUMatrix<half> AH(n, k), BH(k, m), CH(n, m);
+    foreach_coord (i, j, A)
+        AH(i, j) = half(A(i, j));
+    foreach_coord (i, j, B)
+        BH(i, j) = half(B(i, j));
+
+    auto t_start = clock();
+    for (int i = 0; i < count; i++)
+        CPUMatrix<float>::MultiplyAndWeightedAdd(1, A, false, B, false, 0, C);
+    auto t_end = clock();
+    std::cout << "float in: " << 1.0 * (t_end - t_start) / CLOCKS_PER_SEC / count << " seconds" << endl;
+
+    t_start = clock();
+    for (int i = 0; i < count; i++)
+        CPUMatrix<half>::MultiplyAndWeightedAdd(1, AH, false, BH, false, 0, CH);
+    t_end = clock();
+    std::cout << "half in: " << 1.0 * (t_end - t_start) / CLOCKS_PER_SEC / count << " seconds" << endl;
+
+    double maxError = 0, maxValue = 0;
+    foreach_coord (i, j, C)
+    {
+        maxError = max(maxError, (double)fabs(C(i, j) - (float)CH(i, j)));
+        maxValue = max(maxValue, (double)fabs(C(i, j)));
+    }
+    std::cout << "max abs error: " << maxError << " (max abs value " << maxValue << ")" << endl;
+}
+
+// c += alpha * a * op(b), b a CSC matrix, with the serial per-nonzero loop that CPUSparseMatrix::MultiplyAndWeightedAdd()
+// used before its blocked kernels; the baseline of SparseMultiplyTest().
+template <class ElemType>
+void ReferenceDenseTimesSparse(ElemType alpha, const CPUMatrix<ElemType>& a, const CPUSparseMatrix<ElemType>& b, bool transposeB, CPUMatrix<ElemType>& c)
+{
+    const ElemType* valueBuffer = b.Data();
+    const CPUSPARSE_INDEX_TYPE* rowIndexBuffer = b.MajorIndexLocation();
+    size_t iNonzero = 0;
+    int numPreviousNonzero = b.SecondaryIndexLocation()[0];
+
+    // Loop over columns of the sparse matrix
+    for (size_t colSparse = 0; colSparse < b.GetNumCols(); colSparse++)
+    {
+        size_t numNonzeroInSparseCol = b.SecondaryIndexLocation()[colSparse + 1] - numPreviousNonzero;
+        // Loop over the nonzero rows of the current column of the sparse matrix
+        for (; iNonzero < numNonzeroInSparseCol; iNonzero++)
+        {
+            size_t rowSparse = rowIndexBuffer[iNonzero];
+            ElemType sparseVal = valueBuffer[iNonzero];
+            size_t outerIndexSparse = transposeB ? rowSparse : colSparse;
+            size_t innerIndex = transposeB ? colSparse : rowSparse;
+
+            // Loop over the outer index of the dense matrix
+            for (size_t outerIndexDense = 0; outerIndexDense < a.GetNumRows(); outerIndexDense++)
+                c(outerIndexDense, outerIndexSparse) += alpha * a(outerIndexDense, innerIndex) * sparseVal;
+        }
+    }
+}
+
+// Times the sparse products of an embedding-like layer, W * x forward and dY * x' for the weight gradient, with x a
+// [vocabSize x m] CSC matrix with nzPerColumn nonzero elements per column (1 for one-hot inputs), against the former
+// serial loop and the dense products with x densified, and reports the difference of the results.
+template <class ElemType>
+void SparseMultiplyTest(int n, int vocabSize, int m, int nzPerColumn, int count)
+{
+    cout << "W(" << n << "x" << vocabSize << ") and x(" << vocabSize << "," << m << ") with " << nzPerColumn << " nonzero elements per column" << endl;
+    CPUMatrix<ElemType> W(n, vocabSize);
+    randomInitializeCPUMatrix<ElemType>(W, -1, 1);
+    CPUMatrix<ElemType> dY(n, m);
+    randomInitializeCPUMatrix<ElemType>(dY, -1, 1);
+
+    vector<CPUSPARSE_INDEX_TYPE> colStarts(1, 0), rows;
+    vector<ElemType> values;
+    for (int j = 0; j < m; j++)
+    {
+        for (int p = 0; p < nzPerColumn; p++)
+        {
+            rows.push_back(rand() % vocabSize);
+            values.push_back(nzPerColumn == 1 ? 1 : (ElemType)rand() / RAND_MAX);
+        }
+        sort(rows.end() - nzPerColumn, rows.end());
+        rows.erase(unique(rows.end() - nzPerColumn, rows.end()), rows.end());
+        values.resize(rows.size());
+        colStarts.push_back((CPUSPARSE_INDEX_TYPE)rows.size());
+    }
+    CPUSparseMatrix<ElemType> x(matrixFormatSparseCSC, vocabSize, m, values.size());
+    x.SetMatrixFromCSCFormat(colStarts.data(), rows.data(), values.data(), values.size(), vocabSize, m);
+    CPUMatrix<ElemType> xDense = x.CopyColumnSliceToDense(0, m);
+
+    CPUMatrix<ElemType> Y(n, m), YDense(n, m);
+    auto t_start = clock();
+    for (int i = 0; i < count; i++)
+        CPUSparseMatrix<ElemType>::MultiplyAndWeightedAdd(1, W, false, x, false, 0, Y);
+    auto t_end = clock();
+    std::cout << "W * x sparse in: " << 1.0 * (t_end - t_start) / CLOCKS_PER_SEC / count << " seconds" << endl;
+
+    CPUMatrix<ElemType> YReference(n, m);
+    t_start = clock();
+    for (int i = 0; i < count; i++)
+    {
+        YReference.SetValue(0);
+        ReferenceDenseTimesSparse<ElemType>(1, W, x, false, YReference);
+    }
+    t_end = clock();
+    std::cout << "W * x serial loop in: " << 1.0 * (t_end - t_start) / CLOCKS_PER_SEC / count << " seconds" << endl;
+
+    t_start = clock();
+    for (int i = 0; i < count; i++)
+        CPUMatrix<ElemType>::MultiplyAndWeightedAdd(1, W, false, xDense, false, 0, YDense);
+    t_end = clock();
+    std::cout << "W * x dense in: " << 1.0 * (t_end - t_start) / CLOCKS_PER_SEC / count << " seconds" << endl;
+
+    CPUMatrix<ElemType> dW(n, vocabSize), dWDense(n, vocabSize);
+    dW.SetValue(0);
+    dWDense.SetValue(0);
+    t_start = clock();
+    for (int i = 0; i < count; i++)
+        CPUSparseMatrix<ElemType>::MultiplyAndWeightedAdd(1, dY, false, x, true, 1, dW);
+    t_end = clock();
+    std::cout << "dY * x' sparse in: " << 1.0 * (t_end - t_start) / CLOCKS_PER_SEC / count << " seconds" << endl;
+
+    CPUMatrix<ElemType> dWReference(n, vocabSize);
+    dWReference.SetValue(0);
+    t_start = clock();
+    for (int i = 0; i < count; i++)
+        ReferenceDenseTimesSparse<ElemType>(1, dY, x, true, dWReference);
+    t_end = clock();
+    std::cout << "dY * x' serial loop in: " << 1.0 * (t_end - t_start) / CLOCKS_PER_SEC / count << " seconds" << endl;
+
+    t_start = clock();
+    for (int i = 0; i < count; i++)
+        CPUMatrix<ElemType>::MultiplyAndWeightedAdd(1, dY, false, xDense, true, 1, dWDense);
+    t_end = clock();
+    std::cout << "dY * x' dense in: " << 1.0 * (t_end - t_start) / CLOCKS_PER_SEC / count << " seconds" << endl;
+
+    double maxError = 0, maxReferenceError = 0;
+    foreach_coord (i, j, Y)
+    {
+        maxError = max(maxError, (double)fabs(Y(i, j) - YDense(i, j)));
+        maxReferenceError = max(maxReferenceError, (double)fabs(Y(i, j) - YReference(i, j)));
+    }
+    foreach_coord (i, j, dW)
+    {
+        maxError = max(maxError, (double)fabs(dW(i, j) - dWDense(i, j)));
+        maxReferenceError = max(maxReferenceError, (double)fabs(dW(i, j) - dWReference(i, j)));
+    }
+    std::cout << "max abs difference to dense: " << maxError << ", to serial loop: " << maxReferenceError << endl;
+}
+
 template <class ElemType>
 void AddMultiplyAndInplaceSigmoidTest(int n, int k, int m)
 {
@@ -353,7 +544,19 @@ int wmain()
     MultiplyAndWeightedAddTest<float>(11,10,12);    
     MultiplyAndWeightedAddTest<float>(110,100,120);    
     MultiplyAndWeightedAddTest<float>(1100,1000,1200);    
-    MultiplyAndWeightedAddTest<float>(11000,10000,12000);*/
+    MultiplyAndWeightedAddTest<float>(11000,10000,12000);
+
+    cout<<endl<<"********************Matrix Int8Multiply TEST********************"<<endl;
+    Int8MultiplyTest<float>(512,512,64,100);
+    Int8MultiplyTest<float>(2048,2048,128,10);
+
+    cout<<endl<<"********************Matrix HalfMultiply TEST********************"<<endl;
+    HalfMultiplyTest(512,512,64,100);
+    HalfMultiplyTest(2048,2048,2048,5);
+
+    cout<<endl<<"********************Matrix SparseMultiply TEST********************"<<endl;
+    SparseMultiplyTest<float>(512,100000,256,1,10);
+    SparseMultiplyTest<float>(512,100000,256,50,10);*/
 
     return 0;
 }
@@ -8,6 +8,7 @@
 #include <random>
 #include <numeric>
 #include <boost/random/normal_distribution.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
 #include "../../../Source/Math/Matrix.h"
 #include "../../../Source/Math/CPUMatrix.h"
 #include "../../../Source/Math/GPUMatrix.h"
@@ -87,7 +88,7 @@ BOOST_AUTO_TEST_CASE(BatchNormalizationForward)
     };
 
     int baseDeviceId = 0;
-    for (int deviceId : {0})
+    for (int deviceId : {-1, 0})
     {
         for (const auto& cfg : GenerateBNTestConfigs())
         {
@@ -151,7 +152,8 @@ BOOST_AUTO_TEST_CASE(BatchNormalizationForward)
             std::stringstream tmsg;
             tmsg << "inOut tensor: " << (std::string)inOutT
                  << ", spatial = " << (spatial ? "true" : "false")
-                 << ", expAvg = " << expAvg << ")";
+                 << ", expAvg = " << expAvg
+                 << ", device = " << deviceId << ")";
             std::string msg = " are not equal, " + tmsg.str();
             std::string msgNan = " has NaNs, " + tmsg.str();
             std::string msgNotNan = " has buffer overflow/underflow, " + tmsg.str();
@@ -217,7 +219,7 @@ BOOST_AUTO_TEST_CASE(BatchNormalizationBackward)
     };
 
     int baseDeviceId = 0;
-    for (int deviceId : {0})
+    for (int deviceId : {-1, 0})
     {
         for (const auto& cfg : GenerateBNTestConfigs())
         {
@@ -280,7 +282,8 @@ BOOST_AUTO_TEST_CASE(BatchNormalizationBackward)
 
             std::stringstream tmsg;
             tmsg << "inOut tensor: " << (std::string)inOutT
-                 << ", spatial = " << (spatial ? "true" : "false");
+                 << ", spatial = " << (spatial ? "true" : "false")
+                 << ", device = " << deviceId;
             std::string msg = " are not equal, " + tmsg.str();
             std::string msgNan = " has NaNs, " + tmsg.str();
             std::string msgNotNan = " has buffer overflow/underflow, " + tmsg.str();
@@ -325,6 +328,132 @@ BOOST_AUTO_TEST_CASE(BatchNormalizationBackward)
     }
 }
 
+// Batch normalization of the CNTK engine on the CPU against a naive implementation, which computes the statistics
+// of a map in one loop over its values and normalizes them in a second one, in double precision. Unlike the tests
+// against cuDNN this covers blending of minibatch and running statistics and partial running averages.
+BOOST_AUTO_TEST_CASE(BatchNormalizationCPUMatchesNaiveReference)
+{
+    std::mt19937 rng(0);
+    boost::random::normal_distribution<float> nd;
+    boost::random::uniform_real_distribution<float> ud(0.5f, 1.5f);
+
+    int deviceId = -1;
+    double eps = 1e-5;
+    for (bool spatial : {false, true})
+    {
+        // Spatial: 30 maps of 4 x 3 values, more than one block of maps per column.
+        TensorShape inOutT = spatial ? TensorShape(4, 3, 30) : TensorShape(7, 2);
+        size_t batchSize = 9;
+        size_t crow = inOutT.GetNumElements();
+        size_t numMaps = spatial ? inOutT[inOutT.GetRank() - 1] : crow;
+        size_t spatialSize = crow / numMaps;
+        size_t count = batchSize * spatialSize;
+
+        for (double blendFactor : {0.0, 0.5, 1.0})
+        {
+            for (double expAvg : {0.0, 0.1, 1.0})
+            {
+                auto eng = BNEng::Create(deviceId, inOutT, spatial, ImageLayoutKind::CHW, BatchNormEngineKind::Cntk);
+
+                auto generate = [&](size_t size, bool positive)
+                {
+                    vec data(size);
+                    std::generate(begin(data), end(data), [&] { return positive ? ud(rng) : nd(rng); });
+                    return data;
+                };
+                vec x = generate(crow * batchSize, false), dy = generate(crow * batchSize, false), dx = generate(crow * batchSize, false);
+                vec scale = generate(numMaps, false), bias = generate(numMaps, false);
+                vec runMean = generate(numMaps, false), runVariance = generate(numMaps, true);
+
+                SingleMatrix xM(crow, batchSize, x.data(), deviceId, matrixFlagNormal);
+                SingleMatrix dyM(crow, batchSize, dy.data(), deviceId, matrixFlagNormal);
+                SingleMatrix dxM(crow, batchSize, dx.data(), deviceId, matrixFlagNormal);
+                SingleMatrix scaleM(numMaps, 1, scale.data(), deviceId, matrixFlagNormal);
+                SingleMatrix biasM(numMaps, 1, bias.data(), deviceId, matrixFlagNormal);
+                SingleMatrix runMeanM(numMaps, 1, runMean.data(), deviceId, matrixFlagNormal);
+                SingleMatrix runVarianceM(numMaps, 1, runVariance.data(), deviceId, matrixFlagNormal);
+                SingleMatrix outM(crow, batchSize, deviceId);
+                SingleMatrix saveMeanM(deviceId), saveInvStdDevM(deviceId);
+                SingleMatrix scaleGradM(numMaps, 1, deviceId), biasGradM(numMaps, 1, deviceId);
+
+                eng->Forward(xM, scaleM, biasM, false, expAvg, blendFactor, runMeanM, runVarianceM, outM, eps, saveMeanM, saveInvStdDevM);
+                eng->Backward(xM, dyM, dxM, scaleM, blendFactor, saveMeanM, saveInvStdDevM, scaleGradM, biasGradM, true);
+
+                vec out(crow * batchSize), saveMean(numMaps), saveInvStdDev(numMaps), scaleGrad(numMaps), biasGrad(numMaps);
+                for (size_t imap = 0; imap < numMaps; imap++)
+                {
+                    // The values of map imap in column icol are value(icol, 0 .. spatialSize - 1).
+                    auto index = [&](size_t icol, size_t i) { return icol * crow + imap * spatialSize + i; };
+
+                    double sum = 0, sumSquares = 0;
+                    for (size_t icol = 0; icol < batchSize; icol++)
+                        for (size_t i = 0; i < spatialSize; i++)
+                        {
+                            sum += x[index(icol, i)];
+                            sumSquares += (double)x[index(icol, i)] * x[index(icol, i)];
+                        }
+                    double batchMean = sum / count;
+                    double batchVariance = sumSquares / count - batchMean * batchMean;
+
+                    double newRunMean = expAvg * batchMean + (1 - expAvg) * runMean[imap];
+                    double newRunVariance = expAvg * batchVariance * count / (count - 1) + (1 - expAvg) * runVariance[imap];
+                    double mean = blendFactor * newRunMean + (1 - blendFactor) * batchMean;
+                    double invStdDev = blendFactor / sqrt(newRunVariance + eps) + (1 - blendFactor) / sqrt(batchVariance + eps);
+                    runMean[imap] = (float)newRunMean;
+                    runVariance[imap] = (float)newRunVariance;
+                    saveMean[imap] = (float)mean;
+                    saveInvStdDev[imap] = (float)invStdDev;
+
+                    double dScale = 0, dBias = 0;
+                    for (size_t icol = 0; icol < batchSize; icol++)
+                        for (size_t i = 0; i < spatialSize; i++)
+                        {
+                            double xHat = (x[index(icol, i)] - mean) * invStdDev;
+                            out[index(icol, i)] = (float)(scale[imap] * xHat + bias[imap]);
+                            dScale += dy[index(icol, i)] * xHat;
+                            dBias += dy[index(icol, i)];
+                        }
+                    scaleGrad[imap] = (float)dScale;
+                    biasGrad[imap] = (float)dBias;
+
+                    // The minibatch statistics enter the output with weight 1 - blendFactor.
+                    for (size_t icol = 0; icol < batchSize; icol++)
+                        for (size_t i = 0; i < spatialSize; i++)
+                        {
+                            double xHat = (x[index(icol, i)] - mean) * invStdDev;
+                            dx[index(icol, i)] += (float)(scale[imap] * invStdDev * (dy[index(icol, i)] - (1 - blendFactor) * (xHat * dScale + dBias) / count));
+                        }
+                }
+
+                std::stringstream tmsg;
+                tmsg << "inOut tensor: " << (std::string)inOutT
+                     << ", spatial = " << (spatial ? "true" : "false")
+                     << ", blendFactor = " << blendFactor
+                     << ", expAvg = " << expAvg;
+                std::string msg = " are not equal, " + tmsg.str();
+
+                float relErr = Err<float>::Rel;
+                float absErr = Err<float>::Abs;
+                std::string emsg;
+
+                auto check = [&](const SingleMatrix& actual, vec& expected, const char* name, float scaleErr)
+                {
+                    SingleMatrix expectedM(actual.GetNumRows(), actual.GetNumCols(), expected.data(), deviceId, matrixFlagNormal);
+                    BOOST_REQUIRE_MESSAGE(CheckEqual(actual, expectedM, emsg, relErr * scaleErr, absErr * scaleErr), name << msg << ". " << emsg);
+                };
+                check(outM, out, "out", 8);
+                check(runMeanM, runMean, "runMean", 1);
+                check(runVarianceM, runVariance, "runVariance", 8);
+                check(saveMeanM, saveMean, "saveMean", 1);
+                check(saveInvStdDevM, saveInvStdDev, "saveInvStdDev", 8);
+                check(scaleGradM, scaleGrad, "scaleGrad", 16);
+                check(biasGradM, biasGrad, "biasGrad", 16);
+                check(dxM, dx, "grad", 16);
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } } } }
@@ -295,6 +295,35 @@ BOOST_FIXTURE_TEST_CASE(CPUMatrixMultiplyAndDiv, RandomSeedFixture)
     BOOST_CHECK(m3.IsEqualTo(m2));
 }
 
+BOOST_FIXTURE_TEST_CASE(CPUMatrixHalfMultiplyAndWeightedAdd, RandomSeedFixture)
+{
+    // Sizes that are not multiples of the tile size of the half precision product, so partial tiles are covered too.
+    const size_t m = 300, k = 270, n = 530;
+    for (bool transposeA : { false, true })
+        for (bool transposeB : { false, true })
+        {
+            SMatrix a(transposeA ? k : m, transposeA ? m : k), b(transposeB ? n : k, transposeB ? k : n), c(m, n);
+            a.SetUniformRandomValue(-1, 1, IncrementCounter());
+            b.SetUniformRandomValue(-1, 1, IncrementCounter());
+            c.SetUniformRandomValue(-1, 1, IncrementCounter());
+
+            // Round the operands to half, so that the float product only differs by the rounding of the result.
+            CPUMatrix<half> ah(a.GetNumRows(), a.GetNumCols()), bh(b.GetNumRows(), b.GetNumCols()), ch(m, n);
+            for (auto ops : { std::make_pair(&a, &ah), std::make_pair(&b, &bh), std::make_pair(&c, &ch) })
+                foreach_coord (i, j, *ops.first)
+                {
+                    (*ops.second)(i, j) = half((*ops.first)(i, j));
+                    (*ops.first)(i, j) = (float)(*ops.second)(i, j);
+                }
+
+            SMatrix::MultiplyAndWeightedAdd(0.5f, a, transposeA, b, transposeB, 0.25f, c);
+            CPUMatrix<half>::MultiplyAndWeightedAdd(half(0.5f), ah, transposeA, bh, transposeB, half(0.25f), ch);
+
+            foreach_coord (i, j, c)
+                BOOST_REQUIRE_MESSAGE(fabs((float)ch(i, j) - c(i, j)) <= 1e-3f * (fabs(c(i, j)) + 1), "Mismatch at (" << i << ", " << j << ") for transposeA = " << transposeA << ", transposeB = " << transposeB);
+        }
+}
+
 BOOST_FIXTURE_TEST_CASE(CPUMatrixElementOperations, RandomSeedFixture)
 {
     // TODO: consider splitting this large test
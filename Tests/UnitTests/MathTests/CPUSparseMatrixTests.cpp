@@ -7,6 +7,7 @@
 #include <crtdefs.h>
 #endif
 #include "../../../Source/Math/CPUSparseMatrix.h"
+#include <omp.h>
 
 using namespace Microsoft::MSR::CNTK;
 
@@ -116,6 +117,209 @@ BOOST_FIXTURE_TEST_CASE(CPUSparseMatrixMultiplyAndAdd, RandomSeedFixture)
     }
 }
 
+// Compares all products of a dense and a sparse [k x numCols] matrix, with m the dense outer dimension, to the dense products.
+// The sparse matrix is a column slice of a [k x n] matrix, or a one-hot matrix.
+static void CheckMultiplyAndWeightedAddDense(RandomSeedFixture& fixture, size_t k, size_t n, size_t m, size_t startColumn, size_t numCols)
+{
+    // a column slice of a matrix with about a quarter of nonzero elements, and a one-hot matrix
+    DenseMatrix dm(k, n);
+    dm.SetUniformRandomValue(-3, 1, fixture.IncrementCounter());
+    dm.InplaceTruncateBottom(0);
+    SparseMatrix smFull(MatrixFormat::matrixFormatSparseCSC, k, n, 0);
+    foreach_coord(row, col, dm)
+    {
+        if (dm(row, col) != 0)
+            smFull.SetValue(row, col, dm(row, col));
+    }
+    SparseMatrix smOneHot(MatrixFormat::matrixFormatSparseCSC, k, numCols, 0);
+    for (size_t col = 0; col < numCols; col++)
+        smOneHot.SetValue((col * 7) % k, col, 1);
+
+    SparseMatrix smSlice = smFull.ColumnSlice(startColumn, numCols);
+
+    for (const SparseMatrix* smPtr : { &smSlice, &smOneHot })
+    {
+        const SparseMatrix& sm = *smPtr;
+        DenseMatrix dense = sm.CopyColumnSliceToDense(0, numCols);
+
+        for (double beta : { 0.0, 0.5 })
+        {
+            auto check = [&](size_t rows, size_t cols, const std::function<void(DenseMatrix&)>& sparseProduct, const std::function<void(DenseMatrix&)>& denseProduct)
+            {
+                DenseMatrix c(rows, cols);
+                c.SetUniformRandomValue(-1, 1, fixture.IncrementCounter());
+                DenseMatrix cRef(c);
+                sparseProduct(c);
+                denseProduct(cRef);
+                BOOST_CHECK(c.IsEqualTo(cRef, c_epsilonFloatE4));
+            };
+
+            for (bool transposeA : { false, true })
+            {
+                // Dense * Sparse and Dense * Sparse'
+                DenseMatrix a(transposeA ? k : m, transposeA ? m : k);
+                a.SetUniformRandomValue(-1, 1, fixture.IncrementCounter());
+                check(m, numCols,
+                      [&](DenseMatrix& c) { SparseMatrix::MultiplyAndWeightedAdd(2, a, transposeA, sm, false, beta, c); },
+                      [&](DenseMatrix& c) { DenseMatrix::MultiplyAndWeightedAdd(2, a, transposeA, dense, false, beta, c); });
+                if (!transposeA)
+                {
+                    DenseMatrix aT(m, numCols);
+                    aT.SetUniformRandomValue(-1, 1, fixture.IncrementCounter());
+                    check(m, k,
+                          [&](DenseMatrix& c) { SparseMatrix::MultiplyAndWeightedAdd(2, aT, false, sm, true, beta, c); },
+                          [&](DenseMatrix& c) { DenseMatrix::MultiplyAndWeightedAdd(2, aT, false, dense, true, beta, c); });
+                }
+
+                // Sparse * Dense, Sparse' * Dense and Sparse * Dense'
+                size_t innerDim = transposeA ? k : numCols;
+                size_t outerDim = transposeA ? numCols : k;
+                for (bool transposeB : { false, true })
+                {
+                    if (transposeA && transposeB)
+                        continue;
+                    DenseMatrix b(transposeB ? m : innerDim, transposeB ? innerDim : m);
+                    b.SetUniformRandomValue(-1, 1, fixture.IncrementCounter());
+                    check(outerDim, m,
+                          [&](DenseMatrix& c) { SparseMatrix::MultiplyAndWeightedAdd(2, sm, transposeA, b, transposeB, beta, c); },
+                          [&](DenseMatrix& c) { DenseMatrix::MultiplyAndWeightedAdd(2, dense, transposeA, b, transposeB, beta, c); });
+                }
+            }
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(CPUSparseMatrixMultiplyAndWeightedAddDense, RandomSeedFixture)
+{
+    CheckMultiplyAndWeightedAddDense(*this, 40, 30, 20, 5, 17);
+}
+
+// Above the row block size (512) of the blocked kernels, with a last partial block, and above the size from which they
+// run in parallel.
+BOOST_FIXTURE_TEST_CASE(CPUSparseMatrixMultiplyAndWeightedAddDenseParallel, RandomSeedFixture)
+{
+    int numThreads = omp_get_max_threads();
+    omp_set_num_threads(4);
+    CheckMultiplyAndWeightedAddDense(*this, 300, 80, 1100, 5, 60);
+    omp_set_num_threads(numThreads);
+}
+
+BOOST_FIXTURE_TEST_CASE(CPUSparseMatrixColumnwiseScaleAndWeightedAddColumnSlice, RandomSeedFixture)
+{
+    const size_t m = 30;
+    const size_t n = 20;
+
+    DenseMatrix dm(m, n);
+    dm.SetUniformRandomValue(-3, 1, IncrementCounter());
+    dm.InplaceTruncateBottom(0);
+    SparseMatrix sm(MatrixFormat::matrixFormatSparseCSC, m, n, 0);
+    foreach_coord(row, col, dm)
+    {
+        if (dm(row, col) != 0)
+            sm.SetValue(row, col, dm(row, col));
+    }
+
+    const size_t startColumn = 7;
+    const size_t numCols = 9;
+    DenseMatrix v(1, numCols);
+    v.SetUniformRandomValue(-1, 1, IncrementCounter());
+    DenseMatrix c(m, numCols);
+    c.SetUniformRandomValue(-1, 1, IncrementCounter());
+    DenseMatrix cRef(c);
+
+    SparseMatrix::ColumnwiseScaleAndWeightedAdd(2, sm.ColumnSlice(startColumn, numCols), v, 0.5, c);
+
+    // like the GPU kernel, only the elements at the nonzero positions of the slice are updated
+    foreach_coord(row, col, cRef)
+    {
+        if (dm(row, startColumn + col) != 0)
+            cRef(row, col) = 0.5 * cRef(row, col) + 2 * v(0, col) * dm(row, startColumn + col);
+    }
+    BOOST_CHECK(c.IsEqualTo(cRef, c_epsilonFloatE4));
+}
+
+BOOST_FIXTURE_TEST_CASE(CPUSparseMatrixAssignOneHotIndicesTo, RandomSeedFixture)
+{
+    const size_t numClasses = 5;
+    const size_t n = 4;
+
+    // two stacked one-hot vectors per column, the second one missing in column 2
+    SparseMatrix sm(MatrixFormat::matrixFormatSparseCSC, 2 * numClasses, n, 0);
+    sm.SetValue(3, 0, 1);
+    sm.SetValue(numClasses + 0, 0, 1);
+    sm.SetValue(1, 1, 1);
+    sm.SetValue(numClasses + 4, 1, 1);
+    sm.SetValue(4, 2, 1);
+    sm.SetValue(0, 3, 1);
+    sm.SetValue(numClasses + 2, 3, 1);
+
+    DenseMatrix idx;
+    sm.AssignOneHotIndicesTo(idx, numClasses);
+    const double expected[] = { 3, 0, 1, 4, 4, -1, 0, 2 };
+    BOOST_CHECK(idx.GetNumRows() == 1);
+    BOOST_CHECK(idx.GetNumCols() == 2 * n);
+    for (size_t j = 0; j < 2 * n; j++)
+        BOOST_CHECK(idx(0, j) == expected[j]);
+
+    DenseMatrix sliceIdx;
+    sm.ColumnSlice(1, 2).AssignOneHotIndicesTo(sliceIdx, numClasses);
+    BOOST_CHECK(sliceIdx.GetNumCols() == 4);
+    for (size_t j = 0; j < 4; j++)
+        BOOST_CHECK(sliceIdx(0, j) == expected[j + 2]);
+
+    // two words in the same block is not one-hot
+    SparseMatrix notOneHot(MatrixFormat::matrixFormatSparseCSC, 2 * numClasses, 1, 0);
+    notOneHot.SetValue(1, 0, 1);
+    notOneHot.SetValue(2, 0, 1);
+    BOOST_CHECK_THROW(notOneHot.AssignOneHotIndicesTo(idx, numClasses), std::invalid_argument);
+}
+
+BOOST_FIXTURE_TEST_CASE(CPUSparseMatrixScatterColumnsToBlockCol, RandomSeedFixture)
+{
+    const size_t m = 8;
+    const size_t numWords = 30;
+    const size_t n = 12;
+
+    // repeated words and a gap
+    const double words[] = { 7, 3, 7, 29, -1, 0, 3, 3, 11, 7, 0, 18 };
+    DenseMatrix idx(1, n);
+    for (size_t j = 0; j < n; j++)
+        idx(0, j) = words[j];
+
+    DenseMatrix a(m, n);
+    a.SetUniformRandomValue(-1, 1, IncrementCounter());
+    DenseMatrix b(m, 2);
+    b.SetUniformRandomValue(-1, 1, IncrementCounter());
+    DenseMatrix idxB(1, 2);
+    idxB(0, 0) = 5; // new column
+    idxB(0, 1) = 7; // existing column
+
+    SparseMatrix sm(MatrixFormat::matrixFormatSparseBlockCol, m, numWords, 0);
+    sm.DoScatterColumnsOf(1, idx, a, 2);
+    sm.DoScatterColumnsOf(0.5, idxB, b, 1);
+
+    DenseMatrix expected(m, numWords);
+    expected.SetValue(0);
+    for (size_t j = 0; j < n; j++)
+    {
+        if (words[j] >= 0)
+        {
+            for (size_t row = 0; row < m; row++)
+                expected(row, (size_t)words[j]) += 2 * a(row, j);
+        }
+    }
+    DenseMatrix::Scale(0.5, expected);
+    for (size_t j = 0; j < 2; j++)
+    {
+        for (size_t row = 0; row < m; row++)
+            expected(row, (size_t)idxB(0, j)) += b(row, j);
+    }
+
+    BOOST_CHECK(sm.GetBlockSize() == 7);
+    foreach_coord(row, col, expected)
+        BOOST_CHECK(abs(sm(row, col) - expected(row, col)) < c_epsilonFloatE4);
+}
+
 BOOST_FIXTURE_TEST_CASE(CPUSparseMatrixDoGatherColumnsOf, RandomSeedFixture)
 {
     const size_t m = 100;
@@ -99,6 +99,26 @@ std::vector<std::tuple<ConvolutionEngineKind, DEVICEID_TYPE, size_t>> GetTestEng
     res.push_back(std::make_tuple(ConvolutionEngineKind::Gemm, -1, 0));
     res.push_back(std::make_tuple(ConvolutionEngineKind::Gemm, -1, 1));
     res.push_back(std::make_tuple(ConvolutionEngineKind::Gemm, -1, 3));
+
+    // Small filter engine, CPU only. Uses GEMM engine for backward pass and unsupported configurations.
+    res.push_back(std::make_tuple((ConvolutionEngineKind)((int)ConvolutionEngineKind::SmallFilter | (int)ConvolutionEngineKind::Gemm), -1, 0));
+
+#ifdef USE_MKLDNN
+    // MKL-DNN engine, CPU only. Falls back to reference engine for configurations it does not support.
+    res.push_back(std::make_tuple((ConvolutionEngineKind)((int)ConvolutionEngineKind::MklDnn | (int)ConvolutionEngineKind::Reference), -1, 0));
+#endif
+    return res;
+}
+
+// Returns vector of pooling engine config parameters: <kind, device>
+std::vector<std::tuple<ConvolutionEngineKind, DEVICEID_TYPE>> GetTestPoolEngineConfigs()
+{
+    std::vector<std::tuple<ConvolutionEngineKind, DEVICEID_TYPE>> res;
+    res.push_back(std::make_tuple(ConvolutionEngineKind::Reference, -1));
+    res.push_back(std::make_tuple(ConvolutionEngineKind::Reference, 0));
+#ifdef USE_MKLDNN
+    res.push_back(std::make_tuple((ConvolutionEngineKind)((int)ConvolutionEngineKind::MklDnn | (int)ConvolutionEngineKind::Reference), -1));
+#endif
     return res;
 }
 
@@ -438,11 +458,12 @@ BOOST_AUTO_TEST_CASE(PoolingForward)
     };
 
     int baseDeviceId = 0;
-    auto engKind = ConvolutionEngineKind::Reference;
     for (auto kind : {PoolKind::Max, PoolKind::Average})
     {
-        for (int deviceId : {-1, 0})
+        for (const auto& engCfg : GetTestPoolEngineConfigs())
         {
+            auto engKind = std::get<0>(engCfg);
+            auto deviceId = std::get<1>(engCfg);
             for (const auto& g : GeneratePoolTestConfigs())
             {
                 auto baseEng = ConvEng::Create(g, baseDeviceId, ImageLayoutKind::CHW, 0, kind, ConvolutionEngineKind::CuDnn);
@@ -464,7 +485,7 @@ BOOST_AUTO_TEST_CASE(PoolingForward)
                 baseEng->ForwardPooling(inB, outB);
 
                 std::stringstream tmsg;
-                tmsg << "Geometry: " << (std::string)(*g) << ", Pool: " << (int)kind << ", Batch: " << n << ", Device: " << deviceId;
+                tmsg << "Geometry: " << (std::string)(*g) << ", Pool: " << (int)kind << ", Batch: " << n << ", Device: " << deviceId << ", Eng: " << (int)engKind;
                 std::string msg = " are not equal, " + tmsg.str();
                 std::string msgNan = " has NaNs, " + tmsg.str();
                 std::string msgNotNan = " has buffer overflow/underflow, " + tmsg.str();
@@ -498,11 +519,12 @@ BOOST_AUTO_TEST_CASE(PoolingBackward)
     };
 
     int baseDeviceId = 0;
-    auto engKind = ConvolutionEngineKind::Reference;
     for (auto kind : {PoolKind::Max, PoolKind::Average})
     {
-        for (int deviceId : {-1, 0})
+        for (const auto& engCfg : GetTestPoolEngineConfigs())
         {
+            auto engKind = std::get<0>(engCfg);
+            auto deviceId = std::get<1>(engCfg);
             for (const auto& g : GeneratePoolTestConfigs())
             {
                 auto baseEng = ConvEng::Create(g, baseDeviceId, ImageLayoutKind::CHW, 0, kind, ConvolutionEngineKind::CuDnn);
@@ -543,7 +565,7 @@ BOOST_AUTO_TEST_CASE(PoolingBackward)
                 baseEng->BackwardPooling(outB, srcGradB, inB, gradBReset, false);
 
                 std::stringstream tmsg;
-                tmsg << "Geometry: " << (std::string)(*g) << ", Pool: " << (int)kind << ", Batch: " << n << ", Device: " << deviceId;
+                tmsg << "Geometry: " << (std::string)(*g) << ", Pool: " << (int)kind << ", Batch: " << n << ", Device: " << deviceId << ", Eng: " << (int)engKind;
                 std::string msg = " are not equal, " + tmsg.str();
                 std::string msgNan = " has NaNs, " + tmsg.str();
                 std::string msgNotNan = " has buffer overflow/underflow, " + tmsg.str();
@@ -642,6 +664,84 @@ BOOST_AUTO_TEST_CASE(MaxUnpooling)
     }
 }
 
+// Geometries big enough for every algorithm of the small filter engine: pointwise, Winograd F(2x2, 3x3) and F(4x4, 3x3),
+// strided and dilated direct convolution.
+BOOST_AUTO_TEST_CASE(SmallFilterConvolutionForwardCPU)
+{
+    std::mt19937 rng(0);
+    boost::random::normal_distribution<float> nd;
+
+    auto createGeometry = [](size_t inW, size_t k, size_t stride, size_t dilation)
+    {
+        return std::make_shared<ConvolveGeometry>(TensorShape(inW, 13, 4),
+            TensorShape(k, k, 4), TensorShape(11), TensorShape(stride, stride, 4),
+            ConvolveGeometry::BoolVec{true},
+            ConvolveGeometry::BoolVec{true, true, false},
+            TensorShape(0), TensorShape(0), TensorShape(dilation, dilation, 1));
+    };
+
+    int deviceId = -1;
+    auto smallFilterKind = (ConvolutionEngineKind)((int)ConvolutionEngineKind::SmallFilter | (int)ConvolutionEngineKind::Gemm);
+    for (size_t k : {1, 3})
+    for (size_t stride : {1, 2})
+    for (size_t dilation : {1, 2})
+    for (size_t inW : {6, 17})
+    {
+        // The reference engine ignores dilation, so it runs the undilated kernel with zeros between the taps.
+        size_t kB = (k - 1) * dilation + 1;
+        auto g = createGeometry(inW, k, stride, dilation);
+        auto gB = createGeometry(inW, kB, stride, 1);
+        auto baseEng = ConvEng::Create(gB, deviceId, ImageLayoutKind::CHW, 0, PoolKind::None, ConvolutionEngineKind::Reference);
+        auto testEng = ConvEng::Create(g, deviceId, ImageLayoutKind::CHW, 0, PoolKind::None, smallFilterKind);
+
+        size_t n = 3;
+        vec buf(g->InputShape().GetNumElements() * n);
+        std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+        SingleMatrix in(g->InputShape().GetNumElements(), n, buf.data(), deviceId, matrixFlagNormal);
+
+        size_t mapCount = g->GetMapCount(g->InputShape().GetRank() - 1);
+        size_t channels = g->KernelShape()[2];
+        buf.resize(g->KernelShape().GetNumElements() * mapCount);
+        vec bufB(gB->KernelShape().GetNumElements() * mapCount);
+        SingleMatrix kernel(deviceId);
+        SingleMatrix kernelB(deviceId);
+
+        SingleMatrix out(g->OutputShape().GetNumElements(), n, deviceId);
+        SingleMatrix outB(g->OutputShape().GetNumElements(), n, deviceId);
+        SingleMatrix workspace(deviceId);
+        SingleMatrix workspaceB(deviceId);
+
+        std::stringstream tmsg;
+        tmsg << "Geometry: " << (std::string)(*g) << ", Dilation: " << dilation << ", Batch: " << n;
+        std::string emsg;
+
+        // The Winograd transforms round sums of 36 products of O(1) values, which leaves an absolute error of a few
+        // ulps of 1 also on outputs close to 0. F(4x4, 3x3), used for outputs of at least 8 x 8, has transforms with
+        // coefficients up to 8 and loses about 5 more bits.
+        bool winograd4x4 = k == 3 && stride == 1 && dilation == 1 && g->OutputShape()[0] >= 8 && g->OutputShape()[1] >= 8;
+        float absErr = Err<float>::Abs * (winograd4x4 ? 1024 : 64);
+
+        // The second pass updates the kernel in place, which must not reuse the transformed kernel of the first one.
+        for (int pass = 0; pass < 2; pass++)
+        {
+            std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+            std::fill(begin(bufB), end(bufB), 0.0f);
+            for (size_t m = 0; m < mapCount; m++)
+                for (size_t c = 0; c < channels; c++)
+                    for (size_t y = 0; y < k; y++)
+                        for (size_t x = 0; x < k; x++)
+                            bufB[x * dilation + kB * (y * dilation + kB * (c + channels * m))] = buf[x + k * (y + k * (c + channels * m))];
+            kernel.SetValue(mapCount, g->KernelShape().GetNumElements(), deviceId, buf.data());
+            kernelB.SetValue(mapCount, gB->KernelShape().GetNumElements(), deviceId, bufB.data());
+
+            testEng->Forward(in, kernel, out, workspace);
+            baseEng->Forward(in, kernelB, outB, workspaceB);
+
+            BOOST_REQUIRE_MESSAGE(CheckEqual(out, outB, emsg, Err<float>::Rel * 4, absErr), "out are not equal, " << tmsg.str() << ", Pass: " << pass << ". " << emsg);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(Half_ConvolutionSuite)
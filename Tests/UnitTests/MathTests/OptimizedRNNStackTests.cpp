@@ -0,0 +1,162 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include <algorithm>
+#include <random>
+#include <numeric>
+#include <boost/random/normal_distribution.hpp>
+#include "../../../Source/Math/Matrix.h"
+#include "../../../Source/Math/RNNCommon.h"
+#include "common.h"
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+// Cell type, bidirectional, number of layers.
+std::vector<std::tuple<std::wstring, bool, size_t>> GenerateRNNTestConfigs()
+{
+    std::vector<std::tuple<std::wstring, bool, size_t>> res;
+    for (auto recurrentOp : { L"lstm", L"gru", L"rnnReLU", L"rnnTanh" })
+        for (bool bidirectional : { false, true })
+            for (size_t numLayers : { 1, 2 })
+                res.push_back(std::make_tuple(recurrentOp, bidirectional, numLayers));
+    return res;
+}
+
+// Sequences of length 5, 3 and 2, packed frame by frame as OptimizedRNNStackNode does for cuDNN.
+static const std::vector<size_t> s_numSequencesForFrame = { 3, 3, 2, 1, 1 };
+
+template <class ElemType>
+struct RNNTestData
+{
+    RNNTestData(const RnnAttributes& attributes, size_t xDim, int deviceId, std::mt19937& rng)
+        : m_attributes(attributes), m_xDim(xDim), m_yDim((attributes.m_bidirectional ? 2 : 1) * attributes.m_hiddenSize),
+          m_numColumns(std::accumulate(s_numSequencesForFrame.begin(), s_numSequencesForFrame.end(), (size_t)0))
+    {
+        boost::random::normal_distribution<ElemType> nd(0, (ElemType)0.5);
+        auto numParameters = attributes.GetNumParameters(xDim);
+        m_w.resize(numParameters.first * numParameters.second);
+        m_x.resize(m_xDim * m_numColumns);
+        m_dy.resize(m_yDim * m_numColumns);
+        for (auto* data : { &m_w, &m_x, &m_dy })
+            std::generate(data->begin(), data->end(), [&] { return nd(rng); });
+        m_deviceId = deviceId;
+    }
+
+    // Runs forward and both backward passes; the loss is sum(y .* dy), so dy is the output gradient.
+    void Run(Matrix<ElemType>& y, Matrix<ElemType>& dx, Matrix<ElemType>& dw)
+    {
+        Matrix<ElemType> w(m_w.size(), 1, m_w.data(), m_deviceId, matrixFlagNormal);
+        Matrix<ElemType> x(m_xDim, m_numColumns, m_x.data(), m_deviceId, matrixFlagNormal);
+        Matrix<ElemType> dy(m_yDim, m_numColumns, m_dy.data(), m_deviceId, matrixFlagNormal);
+        Matrix<ElemType> reserve(m_deviceId);
+        Matrix<ElemType> workspace(m_deviceId);
+
+        y.Resize(m_yDim, m_numColumns);
+        y.RNNForward(x, w, m_xDim, m_yDim, s_numSequencesForFrame, m_attributes, reserve, workspace);
+        dx.Resize(m_xDim, m_numColumns);
+        y.RNNBackwardData(dy, w, dx, m_attributes, reserve, workspace);
+        dw.Resize(m_w.size(), 1);
+        dw.SetValue(0);
+        y.RNNBackwardWeights(x, y, dw, m_attributes, reserve, workspace);
+    }
+
+    ElemType Loss()
+    {
+        Matrix<ElemType> w(m_w.size(), 1, m_w.data(), m_deviceId, matrixFlagNormal);
+        Matrix<ElemType> x(m_xDim, m_numColumns, m_x.data(), m_deviceId, matrixFlagNormal);
+        Matrix<ElemType> y(m_yDim, m_numColumns, m_deviceId);
+        Matrix<ElemType> reserve(m_deviceId);
+        Matrix<ElemType> workspace(m_deviceId);
+        y.RNNForward(x, w, m_xDim, m_yDim, s_numSequencesForFrame, m_attributes, reserve, workspace);
+
+        std::unique_ptr<ElemType[]> values(y.CopyToArray());
+        return std::inner_product(m_dy.begin(), m_dy.end(), values.get(), (ElemType)0);
+    }
+
+    RnnAttributes m_attributes;
+    size_t m_xDim, m_yDim, m_numColumns;
+    int m_deviceId;
+    std::vector<ElemType> m_w, m_x, m_dy;
+};
+
+BOOST_AUTO_TEST_SUITE(OptimizedRNNStackSuite)
+
+BOOST_AUTO_TEST_CASE(OptimizedRNNStackGradientsCPU)
+{
+    std::mt19937 rng(0);
+    const size_t xDim = 4;
+    const size_t hiddenSize = 3;
+    const double eps = 1e-6;
+
+    for (const auto& cfg : GenerateRNNTestConfigs())
+    {
+        RnnAttributes attributes(std::get<1>(cfg), std::get<2>(cfg), hiddenSize, std::get<0>(cfg), -1);
+        RNNTestData<double> data(attributes, xDim, CPUDEVICE, rng);
+
+        Matrix<double> y(CPUDEVICE), dx(CPUDEVICE), dw(CPUDEVICE);
+        data.Run(y, dx, dw);
+        std::unique_ptr<double[]> dxValues(dx.CopyToArray());
+        std::unique_ptr<double[]> dwValues(dw.CopyToArray());
+
+        auto numericGradient = [&](double& value)
+        {
+            double original = value;
+            value = original + eps;
+            double lossPlus = data.Loss();
+            value = original - eps;
+            double lossMinus = data.Loss();
+            value = original;
+            return (lossPlus - lossMinus) / (2 * eps);
+        };
+
+        std::stringstream tmsg;
+        tmsg << "Cell: " << std::string(attributes.m_recurrentOp.begin(), attributes.m_recurrentOp.end())
+             << ", bidirectional: " << attributes.m_bidirectional << ", layers: " << attributes.m_numLayers;
+
+        for (size_t i = 0; i < data.m_x.size(); i++)
+            BOOST_REQUIRE_MESSAGE(AreEqual(dxValues[i], numericGradient(data.m_x[i]), 1e-4, 1e-7), "dx[" << i << "] is wrong, " << tmsg.str());
+        for (size_t i = 0; i < data.m_w.size(); i++)
+            BOOST_REQUIRE_MESSAGE(AreEqual(dwValues[i], numericGradient(data.m_w[i]), 1e-4, 1e-7), "dw[" << i << "] is wrong, " << tmsg.str());
+    }
+}
+
+#ifndef CPUONLY
+BOOST_AUTO_TEST_CASE(OptimizedRNNStackCPUMatchesCuDnn)
+{
+    std::mt19937 rng(0);
+    const size_t xDim = 13;
+    const size_t hiddenSize = 17;
+
+    for (const auto& cfg : GenerateRNNTestConfigs())
+    {
+        RnnAttributes attributes(std::get<1>(cfg), std::get<2>(cfg), hiddenSize, std::get<0>(cfg), -1);
+        RNNTestData<float> cpuData(attributes, xDim, CPUDEVICE, rng);
+        RNNTestData<float> gpuData(cpuData);
+        gpuData.m_deviceId = 0;
+
+        SingleMatrix y(CPUDEVICE), dx(CPUDEVICE), dw(CPUDEVICE);
+        SingleMatrix yB(0), dxB(0), dwB(0);
+        cpuData.Run(y, dx, dw);
+        gpuData.Run(yB, dxB, dwB);
+
+        std::stringstream tmsg;
+        tmsg << "Cell: " << std::string(attributes.m_recurrentOp.begin(), attributes.m_recurrentOp.end())
+             << ", bidirectional: " << attributes.m_bidirectional << ", layers: " << attributes.m_numLayers;
+        std::string msg = " are not equal, " + tmsg.str();
+
+        float relErr = Err<float>::Rel;
+        float absErr = Err<float>::Abs;
+        std::string emsg;
+
+        BOOST_REQUIRE_MESSAGE(CheckEqual(y, SingleMatrix(yB, CPUDEVICE), emsg, relErr * 4, absErr * 4), "y" << msg << ". " << emsg);
+        BOOST_REQUIRE_MESSAGE(CheckEqual(dx, SingleMatrix(dxB, CPUDEVICE), emsg, relErr * 16, absErr * 16), "dx" << msg << ". " << emsg);
+        BOOST_REQUIRE_MESSAGE(CheckEqual(dw, SingleMatrix(dwB, CPUDEVICE), emsg, relErr * 16, absErr * 16), "dw" << msg << ". " << emsg);
+    }
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
@@ -3,6 +3,8 @@
 // Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
 //
 #include "stdafx.h"
+#include <algorithm>
+#include <random>
 #include "../../../Source/Math/QuantizedOperations.h"
 #include "../../../Source/Math/Helpers.h"
 
@@ -50,6 +52,123 @@ BOOST_FIXTURE_TEST_CASE(MultiplyIntToShort, RandomSeedFixture)
         BOOST_CHECK_EQUAL(round(C_upd[i]), C_expected_upd[i]);
 }
 
+// op(A)[m,k]*op(B)[k,n] in float, column major
+static std::vector<float> ReferenceProduct(int m, int n, int k, bool transposeA, bool transposeB, const std::vector<float>& A, const std::vector<float>& B)
+{
+    std::vector<float> C(m * n);
+    for (int i = 0; i < m; i++)
+        for (int j = 0; j < n; j++)
+        {
+            double sum = 0;
+            for (int l = 0; l < k; l++)
+                sum += A[transposeA ? l + i * k : i + l * m] * B[transposeB ? j + l * n : l + j * k];
+            C[i + j * m] = (float)sum;
+        }
+    return C;
+}
+
+BOOST_FIXTURE_TEST_CASE(MultiplyInt8, RandomSeedFixture)
+{
+    // k is not a multiple of the vector length, so that the padding is exercised as well
+    int m = 17, n = 9, k = 70;
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> weights(-0.5f, 0.5f);
+    std::uniform_real_distribution<float> inputs(-4.0f, 4.0f);
+
+    for (bool transposeA : { false, true })
+    {
+        for (bool transposeB : { false, true })
+        {
+            std::vector<float> A(m * k), B(k * n), C(m * n);
+            for (auto& a : A)
+                a = weights(rng);
+            for (auto& b : B)
+                b = inputs(rng);
+
+            auto C_expected = ReferenceProduct(m, n, k, transposeA, transposeB, A, B);
+
+            // The quantization error of each element is at most half a step, i.e. range / 254.
+            float tolerance = k * (0.5f * 4.0f / 254 * 2 + (0.5f / 254) * (4.0f / 254));
+
+            // A - is constant; B - is not
+            Int8QuantizedMultiplier<float> mult(true, false);
+            for (int pass = 0; pass < 2; pass++)
+            {
+                mult.Multiply(m, n, k, transposeA, transposeB, A.data(), B.data(), C.data());
+                for (size_t i = 0; i < m * n; i++)
+                    BOOST_CHECK_SMALL(C[i] - C_expected[i], tolerance);
+            }
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(MultiplyInt8WithWeightsQuantizedAhead, RandomSeedFixture)
+{
+    int m = 6, n = 11, k = 40;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> values(-1.0f, 1.0f);
+    std::vector<float> A(m * k), B(k * n), C(m * n), C_lazy(m * n);
+    for (auto& a : A)
+        a = values(rng);
+    for (auto& b : B)
+        b = values(rng);
+
+    for (bool isAConstant : { true, false })
+    {
+        for (bool transpose : { false, true })
+        {
+            bool transposeA = isAConstant && transpose;
+            bool transposeB = !isAConstant && transpose;
+
+            Int8QuantizedMultiplier<float> lazy(isAConstant, !isAConstant);
+            lazy.Multiply(m, n, k, transposeA, transposeB, A.data(), B.data(), C_lazy.data());
+
+            // The weights are not read by the products once they have been quantized, so zeros are passed instead.
+            Int8QuantizedMultiplier<float> ahead(isAConstant, !isAConstant);
+            std::vector<float> zeros(isAConstant ? A.size() : B.size(), 0);
+            if (isAConstant)
+                ahead.QuantizeConstantOperand(A.data(), transposeA ? k : m, transposeA ? m : k, transposeA);
+            else
+                ahead.QuantizeConstantOperand(B.data(), transposeB ? n : k, transposeB ? k : n, transposeB);
+
+            for (int pass = 0; pass < 2; pass++)
+            {
+                ahead.Multiply(m, n, k, transposeA, transposeB, isAConstant ? zeros.data() : A.data(), isAConstant ? B.data() : zeros.data(), C.data());
+                for (size_t i = 0; i < m * n; i++)
+                    BOOST_REQUIRE_EQUAL(C[i], C_lazy[i]);
+            }
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(MultiplyInt8Calibration, RandomSeedFixture)
+{
+    // A[m,k]*B[k,n] = C[m,n]
+    int m = 5, n = 4, k = 3;
+    std::vector<float> A = { 1,2,3,4,5,6,7,8,9,10,11,12,13,14,15 };
+    std::vector<float> B = { 16,17,18,19,20,21,22,23,24,25,26,27 };
+    std::vector<float> C(m * n);
+
+    // B - is constant; A - is not
+    Int8QuantizedMultiplier<float> mult(false, true);
+    mult.StartCalibration();
+    mult.Multiply(m, n, k, A.data(), B.data(), C.data());
+    std::vector<float> A_large(A.size());
+    std::transform(A.begin(), A.end(), A_large.begin(), [](float a) { return 2 * a; });
+    mult.Multiply(m, n, k, A_large.data(), B.data(), C.data());
+    BOOST_CHECK_EQUAL(mult.FinishCalibration(), 30);
+    BOOST_CHECK_EQUAL(mult.GetInputRange(), 30);
+
+    // Values beyond the calibrated range are clipped.
+    std::vector<float> A_upd(A.size()), A_clipped(A.size());
+    std::transform(A.begin(), A.end(), A_upd.begin(), [](float a) { return 3 * a; });
+    std::transform(A_upd.begin(), A_upd.end(), A_clipped.begin(), [](float a) { return std::min(a, 30.0f); });
+    mult.Multiply(m, n, k, A_upd.data(), B.data(), C.data());
+    auto C_expected = ReferenceProduct(m, n, k, false, false, A_clipped, B);
+    for (size_t i = 0; i < m * n; i++)
+        BOOST_CHECK_CLOSE(C[i], C_expected[i], 1);
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -0,0 +1,185 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// Tests of the parameter server built into CNTK (LocalParameterServerHelper) through the ASGDHelper interface.
+// The tests pass with any number of MPI ranks; run them under mpiexec to exercise more than one worker.
+//
+#include "stdafx.h"
+#include "../../../Source/ComputationNetworkLib/InputAndParamNodes.h"
+#include "ASGDHelper.h"
+#include "MPIWrapper.h"
+#include <chrono>
+#include <memory>
+#include <thread>
+
+using namespace Microsoft::MSR::CNTK;
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+struct ParameterServerFixture
+{
+    ParameterServerFixture()
+    {
+        m_mpi = MPIWrapper::GetInstance();
+        if (m_mpi == nullptr)
+            m_mpi = MPIWrapper::GetInstance(true /*create*/);
+        m_numWorkers = m_mpi->NumNodesInUse();
+        m_rank = m_mpi->CurrentNodeRank();
+
+        // Two parameters of 17 elements in total, so that the shards of the workers differ in size.
+        m_nodes.push_back(make_shared<LearnableParameter<float>>(CPUDEVICE, L"W", 3, 4));
+        m_nodes.push_back(make_shared<LearnableParameter<float>>(CPUDEVICE, L"b", 5, 1));
+        SetModel([](size_t i) { return (float)i; });
+    }
+
+    template <class F>
+    void SetModel(F valueAt)
+    {
+        size_t offset = 0;
+        for (auto& node : m_nodes)
+        {
+            auto& value = dynamic_pointer_cast<ComputationNode<float>>(node)->Value();
+            vector<float> data(value.GetNumElements());
+            for (size_t i = 0; i < data.size(); i++)
+                data[i] = valueAt(offset + i);
+            value.SetValue(value.GetNumRows(), value.GetNumCols(), CPUDEVICE, data.data());
+            offset += data.size();
+        }
+    }
+
+    vector<float> GetModel() const
+    {
+        vector<float> model;
+        for (auto& node : m_nodes)
+        {
+            auto& value = dynamic_pointer_cast<ComputationNode<float>>(node)->Value();
+            vector<float> data(value.GetNumElements());
+            float* array = data.data();
+            size_t arraySize = data.size();
+            value.CopyToArray(array, arraySize);
+            model.insert(model.end(), data.begin(), data.end());
+        }
+        return model;
+    }
+
+    // Local training step: adds 'delta' to every parameter.
+    void AddToModel(float delta)
+    {
+        auto model = GetModel();
+        SetModel([&](size_t i) { return model[i] + delta; });
+    }
+
+    void CheckModel(float offset, const char* what) const
+    {
+        auto model = GetModel();
+        for (size_t i = 0; i < model.size(); i++)
+            BOOST_REQUIRE_MESSAGE(fabs(model[i] - (i + offset)) < 1e-4f,
+                                  what << ": worker " << m_rank << ", parameter " << i << " is " << model[i] << ", expected " << (i + offset));
+    }
+
+    // Sum of the deltas (rank + 1) all workers add in one step.
+    float SumOfWorkerDeltas() const { return (float)(m_numWorkers * (m_numWorkers + 1) / 2); }
+
+    MPIWrapperPtr m_mpi;
+    size_t m_numWorkers;
+    size_t m_rank;
+    list<ComputationNodeBasePtr> m_nodes;
+};
+
+BOOST_FIXTURE_TEST_SUITE(ASGDHelperSuite, ParameterServerFixture)
+
+BOOST_AUTO_TEST_CASE(ParameterServerAccumulatesPushesOfAllWorkers)
+{
+    unique_ptr<ASGDHelper<float>> helper(NewLocalParameterServerHelper<float>(m_nodes, m_numWorkers, /*useAsyncBuffer=*/false));
+    helper->InitModel(m_nodes);
+    CheckModel(0, "initial model");
+
+    const size_t numSyncs = 3;
+    for (size_t sync = 0; sync < numSyncs; sync++)
+    {
+        AddToModel((float)(m_rank + 1));
+        BOOST_REQUIRE(helper->PushAndPullModel(m_nodes));
+    }
+
+    // once everybody has pushed, a pull returns the sum of all deltas
+    helper->WaitAll();
+    helper->PushAndPullModel(m_nodes);
+    CheckModel(numSyncs * SumOfWorkerDeltas(), "after barrier");
+}
+
+BOOST_AUTO_TEST_CASE(ParameterServerSimulatedModelAveraging)
+{
+    unique_ptr<ASGDHelper<float>> helper(NewLocalParameterServerHelper<float>(m_nodes, m_numWorkers, /*useAsyncBuffer=*/true, /*isSimulatedModelAveragingSGD=*/true));
+    helper->InitModel(m_nodes);
+
+    // every exchange waits for all workers and yields the average of the local models
+    float expected = 0;
+    for (size_t sync = 0; sync < 3; sync++)
+    {
+        AddToModel((float)(m_rank + 1));
+        helper->PushAndPullModel(m_nodes);
+        expected += SumOfWorkerDeltas() / m_numWorkers;
+        CheckModel(expected, "model average");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ParameterServerBoundsStaleness)
+{
+    const size_t maxStaleness = 1;
+    unique_ptr<ASGDHelper<float>> helper(NewLocalParameterServerHelper<float>(m_nodes, m_numWorkers, /*useAsyncBuffer=*/false, false,
+                                                                              AdjustLearningRateAtBeginning::None, 0.2, 600, 0, 0, maxStaleness));
+    helper->InitModel(m_nodes);
+
+    // Worker 0 is slow. The result of the c-th exchange of any worker contains its own c pushes and
+    // at least c - maxStaleness pushes of every other worker, each of which adds 1.
+    const size_t numSyncs = 5;
+    for (size_t clock = 1; clock <= numSyncs; clock++)
+    {
+        if (m_rank == 0)
+            this_thread::sleep_for(chrono::milliseconds(50));
+        AddToModel(1);
+        helper->PushAndPullModel(m_nodes);
+
+        float minimum = (float)(clock + (m_numWorkers - 1) * (clock - min(clock, maxStaleness)));
+        float maximum = (float)(numSyncs * m_numWorkers);
+        auto model = GetModel();
+        for (size_t i = 0; i < model.size(); i++)
+        {
+            float pushes = model[i] - i;
+            BOOST_REQUIRE_MESSAGE(pushes > minimum - 1e-4f && pushes < maximum + 1e-4f,
+                                  "exchange " << clock << " of worker " << m_rank << " contains " << pushes << " pushes, expected at least " << minimum);
+        }
+    }
+
+    helper->WaitAll();
+    helper->PushAndPullModel(m_nodes);
+    CheckModel(numSyncs * m_numWorkers, "after barrier");
+}
+
+BOOST_AUTO_TEST_CASE(ParameterServerPipelinedExchanges)
+{
+    unique_ptr<ASGDHelper<float>> helper(NewLocalParameterServerHelper<float>(m_nodes, m_numWorkers, /*useAsyncBuffer=*/true));
+    helper->InitModel(m_nodes);
+
+    // with the pipeline the worker continues from the result of the previous exchange, but no delta is lost
+    const size_t numSyncs = 4;
+    for (size_t sync = 0; sync < numSyncs; sync++)
+    {
+        AddToModel((float)(m_rank + 1));
+        helper->PushAndPullModel(m_nodes);
+    }
+
+    // the first exchange after the barrier brings in the state at the barrier, the second one returns it
+    helper->WaitAll();
+    helper->PushAndPullModel(m_nodes);
+    helper->WaitAll();
+    helper->PushAndPullModel(m_nodes);
+    helper->WaitAsyncBuffer();
+    CheckModel(numSyncs * SumOfWorkerDeltas(), "after barrier");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
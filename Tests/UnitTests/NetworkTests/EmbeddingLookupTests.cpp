@@ -0,0 +1,190 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// Tests of EmbeddingLookupNode against LookupTableNode, which computes the same embeddings as a product with the one-hot input.
+//
+#include "stdafx.h"
+#include "../../../Source/ComputationNetworkLib/ComputationNetwork.h"
+#include "../../../Source/ComputationNetworkLib/ComputationNetworkBuilder.h"
+#include <cmath>
+#include <memory>
+
+using namespace Microsoft::MSR::CNTK;
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+// Criterion sum(weights .* lookup(E, words)) over a minibatch of two sequences, the second one followed by a gap.
+struct EmbeddingNetwork
+{
+    typedef shared_ptr<ComputationNode<float>> ComputationNodePtr;
+    enum class Kind { lookupTable, embeddingLookupSparse, embeddingLookupDense };
+
+    static const size_t dim = 3;      // embedding dimension
+    static const size_t numWords = 6; // vocabulary size
+    static const size_t k = 2;        // words per sample
+    static const size_t numSequences = 2;
+    static const size_t numTimeSteps = 3;
+    static const size_t numCols = numSequences * numTimeSteps;
+
+    // The word indices of the samples, k per column; column t * numSequences + s is time step t of sequence s.
+    // -1 is a missing word, which only sparse input can express, and the last column is the gap.
+    static vector<int> Words() { return { 4, 1, 0, 4, -1, 5, 4, 2, 3, 3, -1, -1 }; }
+    static const size_t gapColumn = 5;
+
+    EmbeddingNetwork(Kind kind, bool withMissingWord)
+    {
+        m_net = make_shared<ComputationNetwork>(CPUDEVICE);
+        ComputationNetworkBuilder<float> builder(*m_net);
+
+        m_E = builder.CreateLearnableParameter(L"E", dim, numWords);
+        if (kind == Kind::embeddingLookupSparse)
+            m_words = builder.CreateSparseInputNode(L"words", k * numWords);
+        else
+            m_words = builder.CreateInputNode(L"words", kind == Kind::lookupTable ? k * numWords : k);
+        auto weights = builder.CreateInputNode(L"weights", k * dim);
+        if (kind == Kind::lookupTable)
+            m_output = builder.LookupTable(m_E, m_words, L"output");
+        else
+            m_output = builder.EmbeddingLookup(m_E, m_words, L"output");
+        m_criterion = builder.Sum(builder.ElementTimes(m_output, weights), L"criterion");
+        m_net->AddToNodeGroup(L"output", m_output);
+        m_net->AddToNodeGroup(L"criterion", m_criterion);
+
+        m_net->CompileNetwork();
+        m_net->AllocateAllMatrices({}, { m_output }, m_criterion);
+
+        vector<float> embedding(dim * numWords);
+        for (size_t i = 0; i < embedding.size(); i++)
+            embedding[i] = sinf(0.9f * i + 0.3f);
+        m_E->Value().SetValue(dim, numWords, CPUDEVICE, embedding.data());
+
+        auto layout = m_net->GetMBLayoutPtrOfNetwork();
+        layout->Init(numSequences, numTimeSteps);
+        layout->AddSequence(0, 0, 0, numTimeSteps);
+        layout->AddSequence(1, 1, 0, numTimeSteps - 1);
+        layout->AddGap(1, numTimeSteps - 1, numTimeSteps);
+
+        auto wordIndices = Words();
+        if (!withMissingWord)
+            wordIndices[4] = 2;
+        if (kind == Kind::lookupTable)
+        {
+            // LookupTable does not take sparse input with several words per sample on the CPU, hence the reference gets dense one-hot input
+            vector<float> data(k * numWords * numCols, 0);
+            for (size_t i = 0; i < wordIndices.size(); i++)
+            {
+                if (wordIndices[i] >= 0)
+                    data[i * numWords + wordIndices[i]] = 1;
+            }
+            m_words->Value().SetValue(k * numWords, numCols, CPUDEVICE, data.data());
+        }
+        else if (kind == Kind::embeddingLookupDense)
+        {
+            vector<float> data(wordIndices.begin(), wordIndices.end());
+            m_words->Value().SetValue(k, numCols, CPUDEVICE, data.data());
+        }
+        else
+        {
+            vector<CPUSPARSE_INDEX_TYPE> colStarts(1, 0), rows;
+            vector<float> values;
+            for (size_t j = 0; j < numCols; j++)
+            {
+                for (size_t w = 0; w < k; w++)
+                {
+                    if (wordIndices[j * k + w] < 0)
+                        continue;
+                    rows.push_back((CPUSPARSE_INDEX_TYPE)(w * numWords + wordIndices[j * k + w]));
+                    values.push_back(1);
+                }
+                colStarts.push_back((CPUSPARSE_INDEX_TYPE)rows.size());
+            }
+            m_words->Value().SetMatrixFromCSCFormat(colStarts.data(), rows.data(), values.data(), values.size(), k * numWords, numCols);
+        }
+
+        vector<float> weightValues(k * dim * numCols);
+        for (size_t i = 0; i < weightValues.size(); i++)
+            weightValues[i] = cosf(1.3f * i);
+        weights->Value().SetValue(k * dim, numCols, CPUDEVICE, weightValues.data());
+    }
+
+    void ForwardAndBackward()
+    {
+        ScopedNetworkOperationMode modeGuard(m_net, NetworkOperationMode::training);
+        ComputationNodeBasePtr criterion = m_criterion;
+        m_net->ForwardProp(criterion);
+        m_net->Backprop(criterion);
+    }
+
+    static vector<float> ToVector(const Matrix<float>& matrix)
+    {
+        Matrix<float> dense(matrix.GetNumRows(), matrix.GetNumCols(), CPUDEVICE);
+        dense.SetValue(0);
+        Matrix<float>::ScaleAndAdd(1, matrix, dense);
+        vector<float> data(dense.GetNumElements());
+        float* array = data.data();
+        size_t arraySize = data.size();
+        dense.CopyToArray(array, arraySize);
+        return data;
+    }
+
+    // The output without the gap column.
+    vector<float> OutputValues() const
+    {
+        auto values = ToVector(m_output->Value());
+        values.erase(values.begin() + gapColumn * k * dim, values.begin() + (gapColumn + 1) * k * dim);
+        return values;
+    }
+
+    ComputationNetworkPtr m_net;
+    ComputationNodePtr m_E, m_words, m_output, m_criterion;
+};
+
+static void CheckClose(const vector<float>& actual, const vector<float>& expected, const char* what)
+{
+    BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); i++)
+        BOOST_CHECK_MESSAGE(fabs(actual[i] - expected[i]) < 1e-5f, what << "[" << i << "] is " << actual[i] << ", expected " << expected[i]);
+}
+
+static void CheckAgainstLookupTable(EmbeddingNetwork::Kind kind, bool withMissingWord)
+{
+    EmbeddingNetwork reference(EmbeddingNetwork::Kind::lookupTable, withMissingWord);
+    EmbeddingNetwork embeddingLookup(kind, withMissingWord);
+    reference.ForwardAndBackward();
+    embeddingLookup.ForwardAndBackward();
+
+    CheckClose(embeddingLookup.OutputValues(), reference.OutputValues(), "output");
+    CheckClose(EmbeddingNetwork::ToVector(embeddingLookup.m_criterion->Value()), EmbeddingNetwork::ToVector(reference.m_criterion->Value()), "criterion");
+
+    // the gradient is scattered into the looked-up columns only
+    BOOST_CHECK(embeddingLookup.m_E->Gradient().GetMatrixType() == SPARSE);
+    BOOST_CHECK(embeddingLookup.m_E->Gradient().GetFormat() == matrixFormatSparseBlockCol);
+    CheckClose(EmbeddingNetwork::ToVector(embeddingLookup.m_E->Gradient()), EmbeddingNetwork::ToVector(reference.m_E->Gradient()), "gradient of E");
+}
+
+BOOST_AUTO_TEST_SUITE(EmbeddingLookupSuite)
+
+BOOST_AUTO_TEST_CASE(EmbeddingLookupOfSparseInputMatchesLookupTable)
+{
+    CheckAgainstLookupTable(EmbeddingNetwork::Kind::embeddingLookupSparse, /*withMissingWord=*/true);
+}
+
+BOOST_AUTO_TEST_CASE(EmbeddingLookupOfDenseIndicesMatchesLookupTable)
+{
+    CheckAgainstLookupTable(EmbeddingNetwork::Kind::embeddingLookupDense, /*withMissingWord=*/false);
+}
+
+BOOST_AUTO_TEST_CASE(EmbeddingLookupRejectsSeveralWordsInOneBlock)
+{
+    EmbeddingNetwork net(EmbeddingNetwork::Kind::embeddingLookupSparse, /*withMissingWord=*/false);
+    vector<CPUSPARSE_INDEX_TYPE> colStarts = { 0, 2, 2, 2, 2, 2, 2 }, rows = { 1, 3 };
+    vector<float> values = { 1, 1 };
+    net.m_words->Value().SetMatrixFromCSCFormat(colStarts.data(), rows.data(), values.data(), values.size(), EmbeddingNetwork::k * EmbeddingNetwork::numWords, EmbeddingNetwork::numCols);
+    BOOST_CHECK_THROW(net.ForwardAndBackward(), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
@@ -0,0 +1,148 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// Tests of the hoisting of loop-invariant nodes out of recurrent loops (ComputationNetwork::FormRecurrentLoops()).
+// The recurrence h = tanh(W * PastValue(h) + x + sigmoid(ReconcileDynamicAxis(b, PastValue(h)))) contains a subgraph that
+// only takes the MBLayout from the loop. It is evaluated once per minibatch and must give the same values and gradients as
+// the frame-by-frame evaluation inside the loop.
+//
+#include "stdafx.h"
+#include "../../../Source/ComputationNetworkLib/ComputationNetwork.h"
+#include "../../../Source/ComputationNetworkLib/ComputationNetworkBuilder.h"
+#include "../../../Source/ComputationNetworkLib/ReshapingNodes.h"
+#include <cmath>
+#include <memory>
+
+using namespace Microsoft::MSR::CNTK;
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+// ReconcileDynamicAxis that claims to read the value of its layout input, which keeps it inside the loop.
+template <class ElemType>
+class InLoopReconcileDynamicAxisNode : public ReconcileDynamicAxisNode<ElemType>
+{
+public:
+    InLoopReconcileDynamicAxisNode(DEVICEID_TYPE deviceId, const wstring& name)
+        : ReconcileDynamicAxisNode<ElemType>(deviceId, name)
+    {
+    }
+
+    virtual bool InputUsedInComputingOutputValue(size_t /*childIndex*/) const override { return true; }
+};
+
+struct RecurrenceWithInvariantSubgraph
+{
+    typedef shared_ptr<ComputationNode<float>> ComputationNodePtr;
+    static const size_t dim = 3;
+    static const size_t numSequences = 2;
+    static const size_t numTimeSteps = 5;
+
+    RecurrenceWithInvariantSubgraph(bool hoistable)
+    {
+        m_net = make_shared<ComputationNetwork>(CPUDEVICE);
+        ComputationNetworkBuilder<float> builder(*m_net);
+
+        m_W = builder.CreateLearnableParameter(L"W", dim, dim);
+        m_b = builder.CreateLearnableParameter(L"b", dim, 1);
+        m_x = builder.CreateInputNode(L"x", dim);
+
+        auto pastValue = builder.PastValue(nullptr, 0.1f, dim, 1, L"pastValue");
+        auto recurrent = builder.Plus(builder.Times(m_W, pastValue), m_x, L"recurrent");
+        if (hoistable)
+            m_broadcast = builder.ReconcileDynamicAxis(nullptr, nullptr, L"broadcast");
+        else
+            m_broadcast = m_net->AddNodeToNetWithElemType(make_shared<InLoopReconcileDynamicAxisNode<float>>(CPUDEVICE, L"broadcast"));
+        m_invariant = builder.Sigmoid(m_broadcast, L"invariant");
+        m_h = builder.Tanh(builder.Plus(recurrent, m_invariant), L"h");
+        m_broadcast->AttachInputs({ m_b, pastValue });
+        pastValue->AttachInputs({ m_h });
+        m_criterion = builder.Sum(m_h, L"criterion");
+        m_net->AddToNodeGroup(L"output", m_h);
+        m_net->AddToNodeGroup(L"criterion", m_criterion);
+
+        m_net->CompileNetwork();
+        m_net->AllocateAllMatrices({}, { m_h }, m_criterion);
+
+        SetValue(m_W, dim, dim, [](size_t i) { return 0.4f * sinf((float)i); });
+        SetValue(m_b, dim, 1, [](size_t i) { return 0.5f - 0.3f * i; });
+
+        auto layout = m_net->GetMBLayoutPtrOfNetwork();
+        layout->Init(numSequences, numTimeSteps);
+        for (size_t s = 0; s < numSequences; s++)
+            layout->AddSequence(s, s, 0, numTimeSteps);
+        SetValue(m_x, dim, numSequences * numTimeSteps, [](size_t i) { return cosf(0.7f * i); });
+    }
+
+    static void SetValue(const ComputationNodePtr& node, size_t numRows, size_t numCols, const function<float(size_t)>& valueAt)
+    {
+        vector<float> data(numRows * numCols);
+        for (size_t i = 0; i < data.size(); i++)
+            data[i] = valueAt(i);
+        node->Value().SetValue(numRows, numCols, CPUDEVICE, data.data());
+    }
+
+    static vector<float> ToVector(const Matrix<float>& matrix)
+    {
+        vector<float> data(matrix.GetNumElements());
+        float* array = data.data();
+        size_t arraySize = data.size();
+        matrix.CopyToArray(array, arraySize);
+        return data;
+    }
+
+    void ForwardAndBackward()
+    {
+        ScopedNetworkOperationMode modeGuard(m_net, NetworkOperationMode::training);
+        ComputationNodeBasePtr criterion = m_criterion;
+        m_net->ForwardProp(criterion);
+        m_net->Backprop(criterion);
+    }
+
+    ComputationNetworkPtr m_net;
+    ComputationNodePtr m_W, m_b, m_x;
+    ComputationNodePtr m_broadcast, m_invariant, m_h, m_criterion;
+};
+
+static void CheckClose(const vector<float>& actual, const vector<float>& expected, const char* what)
+{
+    BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); i++)
+        BOOST_CHECK_MESSAGE(fabs(actual[i] - expected[i]) < 1e-5f, what << "[" << i << "] is " << actual[i] << ", expected " << expected[i]);
+}
+
+BOOST_AUTO_TEST_SUITE(LoopInvariantHoistingSuite)
+
+BOOST_AUTO_TEST_CASE(HoistedNodesMatchInLoopEvaluation)
+{
+    RecurrenceWithInvariantSubgraph hoisted(/*hoistable=*/true);
+    RecurrenceWithInvariantSubgraph inLoop(/*hoistable=*/false);
+
+    // the subgraph only takes the layout from the loop, so it is moved out of it; the recurrence itself stays
+    BOOST_CHECK(!hoisted.m_broadcast->IsPartOfLoop());
+    BOOST_CHECK(!hoisted.m_invariant->IsPartOfLoop());
+    BOOST_CHECK(hoisted.m_h->IsPartOfLoop());
+    BOOST_CHECK(inLoop.m_broadcast->IsPartOfLoop());
+    BOOST_CHECK(inLoop.m_invariant->IsPartOfLoop());
+    BOOST_CHECK(inLoop.m_h->IsPartOfLoop());
+
+    hoisted.ForwardAndBackward();
+    inLoop.ForwardAndBackward();
+
+    auto values = RecurrenceWithInvariantSubgraph::ToVector(hoisted.m_h->Value());
+    size_t numElements = RecurrenceWithInvariantSubgraph::dim * RecurrenceWithInvariantSubgraph::numSequences * RecurrenceWithInvariantSubgraph::numTimeSteps;
+    BOOST_REQUIRE_EQUAL(values.size(), numElements);
+    CheckClose(values, RecurrenceWithInvariantSubgraph::ToVector(inLoop.m_h->Value()), "h");
+    CheckClose(RecurrenceWithInvariantSubgraph::ToVector(hoisted.m_criterion->Value()), RecurrenceWithInvariantSubgraph::ToVector(inLoop.m_criterion->Value()), "criterion");
+    CheckClose(RecurrenceWithInvariantSubgraph::ToVector(hoisted.m_W->Gradient()), RecurrenceWithInvariantSubgraph::ToVector(inLoop.m_W->Gradient()), "gradient of W");
+    CheckClose(RecurrenceWithInvariantSubgraph::ToVector(hoisted.m_b->Gradient()), RecurrenceWithInvariantSubgraph::ToVector(inLoop.m_b->Gradient()), "gradient of b");
+
+    // the gradient flows through the invariant subgraph
+    auto gradientOfB = RecurrenceWithInvariantSubgraph::ToVector(hoisted.m_b->Gradient());
+    BOOST_CHECK(any_of(gradientOfB.begin(), gradientOfB.end(), [](float g) { return fabs(g) > 1e-3f; }));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
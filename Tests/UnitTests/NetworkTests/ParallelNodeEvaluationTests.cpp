@@ -0,0 +1,169 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// Tests of the concurrent evaluation of independent nodes (Globals::SetParallelNodeEvaluation()).
+// Nodes may mask the gaps of an input in place before reading it, each with its own value, so readers of a
+// common input with gaps must not run at the same time.
+//
+#include "stdafx.h"
+#include "../../../Source/ComputationNetworkLib/ComputationNetwork.h"
+#include "../../../Source/ComputationNetworkLib/ComputationNetworkBuilder.h"
+#include "Globals.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <omp.h>
+#include <thread>
+
+using namespace Microsoft::MSR::CNTK;
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+// Masks the gaps of its input to its own value, waits, and then copies the input, like e.g. a reduction does.
+// Counts how many probes run at the same time.
+template <class ElemType>
+class MaskingProbeNode : public ComputationNode<ElemType>, public NumInputs<1>
+{
+    typedef ComputationNode<ElemType> Base; UsingComputationNodeMembersBoilerplate;
+    static const std::wstring TypeName() { return L"MaskingProbe"; }
+
+public:
+    MaskingProbeNode(DEVICEID_TYPE deviceId, const wstring& name)
+        : Base(deviceId, name), m_maskValue(0), m_numRunning(nullptr), m_maxNumRunning(nullptr)
+    {
+    }
+
+    MaskingProbeNode(DEVICEID_TYPE deviceId, const wstring& name, ElemType maskValue, atomic<int>& numRunning, atomic<int>& maxNumRunning)
+        : Base(deviceId, name), m_maskValue(maskValue), m_numRunning(&numRunning), m_maxNumRunning(&maxNumRunning)
+    {
+    }
+
+    virtual void /*ComputationNode::*/ ForwardProp(const FrameRange& fr) override
+    {
+        int numRunning = ++*m_numRunning;
+        int maxNumRunning = *m_maxNumRunning;
+        while (numRunning > maxNumRunning && !m_maxNumRunning->compare_exchange_weak(maxNumRunning, numRunning))
+            ;
+
+        InputRef(0).MaskMissingValueColumnsTo(fr, m_maskValue);
+        this_thread::sleep_for(chrono::milliseconds(50));
+        ValueFor(fr).AssignValuesOf(InputRef(0).ValueFor(fr));
+
+        --*m_numRunning;
+    }
+
+    virtual void /*ComputationNode::*/ BackpropTo(const size_t /*inputIndex*/, const FrameRange& /*fr*/) override
+    {
+    }
+
+    virtual void /*ComputationNodeBase::*/ Validate(bool isFinalValidationPass) override
+    {
+        ValidateUnaryMap(isFinalValidationPass);
+    }
+
+private:
+    ElemType m_maskValue;
+    atomic<int>* m_numRunning;
+    atomic<int>* m_maxNumRunning;
+};
+
+struct ParallelNodeEvaluationFixture
+{
+    static const size_t dim = 2;
+    static const size_t numTimeSteps = 4;
+
+    ParallelNodeEvaluationFixture()
+        : m_numRunning(0), m_maxNumRunning(0), m_numThreads(omp_get_max_threads())
+    {
+        // two threads, so that the nodes of a level overlap on any machine
+        omp_set_num_threads(2);
+        Globals::SetParallelNodeEvaluation(true);
+    }
+
+    ~ParallelNodeEvaluationFixture()
+    {
+        Globals::SetParallelNodeEvaluation(false);
+        omp_set_num_threads(m_numThreads);
+    }
+
+    // Runs a probe with mask value 1 on 'first' and one with mask value 2 on 'second', and returns their values.
+    vector<vector<float>> RunProbes(bool shareInput)
+    {
+        auto net = make_shared<ComputationNetwork>(CPUDEVICE);
+        ComputationNetworkBuilder<float> builder(*net);
+        auto first = builder.CreateInputNode(L"first", dim);
+        auto second = shareInput ? first : builder.CreateInputNode(L"second", dim);
+        vector<ComputationNodeBasePtr> probes;
+        for (float maskValue : { 1.0f, 2.0f })
+        {
+            auto probe = make_shared<MaskingProbeNode<float>>(CPUDEVICE, maskValue == 1 ? L"probe1" : L"probe2", maskValue, m_numRunning, m_maxNumRunning);
+            net->AddNodeToNetAndAttachInputs(probe, { maskValue == 1 ? first : second });
+            probes.push_back(probe);
+        }
+
+        net->CompileNetwork();
+        net->AllocateAllMatrices(probes, probes, nullptr);
+
+        // sequence 0 fills all time steps, sequence 1 is followed by a gap of two steps
+        auto layout = net->GetMBLayoutPtrOfNetwork();
+        layout->Init(2, numTimeSteps);
+        layout->AddSequence(0, 0, 0, numTimeSteps);
+        layout->AddSequence(1, 1, 0, 2);
+        layout->AddGap(1, 2, numTimeSteps);
+        vector<float> data(dim * 2 * numTimeSteps, 0);
+        for (auto input : { first, second })
+            input->Value().SetValue(dim, 2 * numTimeSteps, CPUDEVICE, data.data());
+
+        net->ForwardProp(probes);
+
+        vector<vector<float>> values;
+        for (auto& probe : probes)
+        {
+            auto& value = dynamic_pointer_cast<ComputationNode<float>>(probe)->Value();
+            values.push_back(vector<float>(value.GetNumElements()));
+            float* array = values.back().data();
+            size_t arraySize = values.back().size();
+            value.CopyToArray(array, arraySize);
+        }
+        return values;
+    }
+
+    // The gaps are the columns 2 * t + 1 for t >= 2.
+    static void CheckGaps(const vector<float>& value, float expected)
+    {
+        for (size_t t = 2; t < numTimeSteps; t++)
+        {
+            for (size_t i = 0; i < dim; i++)
+                BOOST_CHECK_EQUAL(value[(2 * t + 1) * dim + i], expected);
+        }
+    }
+
+    atomic<int> m_numRunning;
+    atomic<int> m_maxNumRunning;
+    int m_numThreads;
+};
+
+BOOST_FIXTURE_TEST_SUITE(ParallelNodeEvaluationSuite, ParallelNodeEvaluationFixture)
+
+BOOST_AUTO_TEST_CASE(ReadersOfDifferentInputsRunConcurrently)
+{
+    auto values = RunProbes(/*shareInput=*/false);
+    BOOST_CHECK_EQUAL(m_maxNumRunning.load(), 2);
+    CheckGaps(values[0], 1);
+    CheckGaps(values[1], 2);
+}
+
+BOOST_AUTO_TEST_CASE(ReadersOfSharedInputWithGapsRunOneAfterTheOther)
+{
+    auto values = RunProbes(/*shareInput=*/true);
+    BOOST_CHECK_EQUAL(m_maxNumRunning.load(), 1);
+    // each probe sees the gaps masked to its own value
+    CheckGaps(values[0], 1);
+    CheckGaps(values[1], 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
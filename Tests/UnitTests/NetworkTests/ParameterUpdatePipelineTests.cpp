@@ -0,0 +1,357 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// Tests of the pipelined parameter update of SGD::TrainOneEpoch (ParameterUpdatePipeline).
+// ParameterUpdatePipelineSuite simulates the training loop: the "minibatch" computes the gradient of 0.5 * ||w - target||^2
+// from the node values, so results depend on which weights the network sees. PipelinedTrainingSuite runs SGD::Train itself.
+//
+#include "stdafx.h"
+#include "../../../Source/ComputationNetworkLib/ComputationNetworkBuilder.h"
+#include "../../../Source/ComputationNetworkLib/InputAndParamNodes.h"
+#include "../../../Source/SGDLib/ParameterUpdatePipeline.h"
+#include "../../../Source/SGDLib/SGD.h"
+#include "DataReader.h"
+#include <boost/filesystem.hpp>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+using namespace Microsoft::MSR::CNTK;
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+struct ParameterUpdatePipelineFixture
+{
+    ParameterUpdatePipelineFixture()
+    {
+        m_nodes.push_back(make_shared<LearnableParameter<float>>(CPUDEVICE, L"W", 3, 4));
+        m_nodes.push_back(make_shared<LearnableParameter<float>>(CPUDEVICE, L"b", 5, 1));
+        size_t offset = 0;
+        for (auto& node : m_nodes)
+        {
+            auto& value = ValueOf(node);
+            vector<float> data(value.GetNumElements());
+            for (size_t i = 0; i < data.size(); i++)
+                data[i] = (float)(offset + i);
+            value.SetValue(value.GetNumRows(), value.GetNumCols(), CPUDEVICE, data.data());
+            offset += data.size();
+
+            Node(node)->GradientPtrRef() = make_shared<Matrix<float>>(value.GetNumRows(), value.GetNumCols(), CPUDEVICE);
+            m_smoothedGradients.emplace_back(CPUDEVICE);
+            m_smoothedCounts.push_back(0);
+        }
+    }
+
+    static shared_ptr<ComputationNode<float>> Node(const ComputationNodeBasePtr& node) { return dynamic_pointer_cast<ComputationNode<float>>(node); }
+    static Matrix<float>& ValueOf(const ComputationNodeBasePtr& node) { return Node(node)->Value(); }
+
+    static vector<float> ToVector(const Matrix<float>& matrix)
+    {
+        vector<float> data(matrix.GetNumElements());
+        float* array = data.data();
+        size_t arraySize = data.size();
+        matrix.CopyToArray(array, arraySize);
+        return data;
+    }
+
+    // Forward and backward of one minibatch: gradient = w - target, computed from what the network sees.
+    void ComputeGradients(float target)
+    {
+        for (auto& node : m_nodes)
+        {
+            auto& gradient = Node(node)->Gradient();
+            gradient.SetValue(ValueOf(node));
+            gradient += -target;
+        }
+    }
+
+    ParameterUpdatePipeline<float>::UpdateFunction PlainSgd(chrono::milliseconds duration = chrono::milliseconds(0))
+    {
+        return [duration](const ComputationNodeBasePtr&, Matrix<float>& value, Matrix<float>& gradient, Matrix<float>&, double& smoothedCount)
+        {
+            Matrix<float>::ScaleAndAdd(-0.25f, gradient, value);
+            smoothedCount++;
+            this_thread::sleep_for(duration);
+        };
+    }
+
+    // Runs the loop of SGD::TrainOneEpoch and returns the final weights. Records the staleness of the weights each
+    // minibatch is computed on, and the minibatch each parameter update belongs to, in the order the updates ran.
+    vector<float> Train(ParameterUpdatePipelining mode, size_t numMinibatches)
+    {
+        ParameterUpdatePipeline<float> pipeline(mode, CPUDEVICE, m_nodes, m_smoothedGradients, m_smoothedCounts);
+        for (size_t t = 0; t < numMinibatches; t++)
+        {
+            if (!pipeline.AllowsStaleWeights())
+                pipeline.Finish(); // before forward propagation, as in TrainOneEpoch
+            m_staleness.push_back(pipeline.NumStartedUpdates() - pipeline.NumPublishedUpdates());
+            ComputeGradients((float)t);
+
+            auto sgd = PlainSgd();
+            auto update = [this, sgd, t](const ComputationNodeBasePtr& node, Matrix<float>& value, Matrix<float>& gradient, Matrix<float>& smoothedGradient, double& smoothedCount)
+            {
+                m_updatedMinibatches.push_back(t); // only touched by the one update in flight, and read after Finish()
+                sgd(node, value, gradient, smoothedGradient, smoothedCount);
+            };
+            if (pipeline.IsEnabled())
+                pipeline.Start(update);
+            else
+            {
+                auto smoothedGradientIter = m_smoothedGradients.begin();
+                auto smoothedCountIter = m_smoothedCounts.begin();
+                for (auto& node : m_nodes)
+                    update(node, ValueOf(node), Node(node)->Gradient(), *smoothedGradientIter++, *smoothedCountIter++);
+            }
+        }
+        pipeline.Finish();
+        BOOST_CHECK_EQUAL(pipeline.NumPublishedUpdates(), pipeline.IsEnabled() ? numMinibatches : 0);
+        return Weights();
+    }
+
+    vector<float> Weights() const
+    {
+        vector<float> weights;
+        for (auto& node : m_nodes)
+        {
+            auto data = ToVector(ValueOf(node));
+            weights.insert(weights.end(), data.begin(), data.end());
+        }
+        return weights;
+    }
+
+    list<ComputationNodeBasePtr> m_nodes;
+    list<Matrix<float>> m_smoothedGradients;
+    vector<double> m_smoothedCounts;
+    vector<size_t> m_staleness;
+    vector<size_t> m_updatedMinibatches;
+};
+
+BOOST_FIXTURE_TEST_SUITE(ParameterUpdatePipelineSuite, ParameterUpdatePipelineFixture)
+
+BOOST_AUTO_TEST_CASE(OverlappedUpdateMatchesSequentialUpdate)
+{
+    auto initial = Weights();
+    auto expected = Train(ParameterUpdatePipelining::None, 6);
+
+    ParameterUpdatePipelineFixture pipelined;
+    BOOST_REQUIRE(pipelined.Weights() == initial);
+    auto actual = pipelined.Train(ParameterUpdatePipelining::Overlapped, 6);
+
+    BOOST_CHECK(actual == expected);
+    BOOST_CHECK(pipelined.m_smoothedCounts == m_smoothedCounts);
+}
+
+BOOST_AUTO_TEST_CASE(OneStepStaleUpdateUsesGradientsOfPreviousWeights)
+{
+    // w_{t+1} = w_t - 0.25 (w_{t-1} - t), with w_{-1} = w_0: the gradient of minibatch t is computed
+    // on the weights that do not yet contain the update of minibatch t-1
+    auto previous = Weights();
+    auto expected = previous;
+    const size_t numMinibatches = 6;
+    for (size_t t = 0; t < numMinibatches; t++)
+    {
+        auto next = expected;
+        for (size_t i = 0; i < next.size(); i++)
+            next[i] -= 0.25f * (previous[i] - (float)t);
+        previous = expected;
+        expected = next;
+    }
+
+    auto actual = Train(ParameterUpdatePipelining::OneStepStale, numMinibatches);
+    BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); i++)
+        BOOST_CHECK_CLOSE(actual[i], expected[i], 1e-3f);
+}
+
+BOOST_AUTO_TEST_CASE(FinishBumpsTimeStampsOfUpdatedParameters)
+{
+    for (auto mode : { ParameterUpdatePipelining::Overlapped, ParameterUpdatePipelining::OneStepStale })
+    {
+        ParameterUpdatePipeline<float> pipeline(mode, CPUDEVICE, m_nodes, m_smoothedGradients, m_smoothedCounts);
+        ComputeGradients(0);
+
+        vector<uint64_t> before;
+        for (auto& node : m_nodes)
+            before.push_back(node->GetEvalTimeStamp());
+        auto weightsBefore = Weights();
+
+        pipeline.Start(PlainSgd(chrono::milliseconds(10)));
+        if (pipeline.AllowsStaleWeights())
+        {
+            // the network keeps seeing the old weights until the update is published
+            BOOST_CHECK(Weights() == weightsBefore);
+        }
+        size_t i = 0;
+        for (auto& node : m_nodes)
+            BOOST_CHECK_EQUAL(node->GetEvalTimeStamp(), before[i++]);
+
+        pipeline.Finish();
+        BOOST_CHECK(Weights() != weightsBefore);
+        i = 0;
+        for (auto& node : m_nodes)
+            BOOST_CHECK_GT(node->GetEvalTimeStamp(), before[i++]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(PipelinedUpdatesRunInOrderWithBoundedStaleness)
+{
+    const size_t numMinibatches = 5;
+    vector<size_t> expectedOrder;
+    for (size_t t = 0; t < numMinibatches; t++)
+        expectedOrder.insert(expectedOrder.end(), m_nodes.size(), t);
+
+    for (auto mode : { ParameterUpdatePipelining::None, ParameterUpdatePipelining::Overlapped, ParameterUpdatePipelining::OneStepStale })
+    {
+        ParameterUpdatePipelineFixture fixture;
+        fixture.Train(mode, numMinibatches);
+
+        // only OneStepStale computes a minibatch on weights that lack the update of the previous one
+        vector<size_t> expectedStaleness(numMinibatches, 0);
+        if (mode == ParameterUpdatePipelining::OneStepStale)
+            fill(expectedStaleness.begin() + 1, expectedStaleness.end(), 1);
+        BOOST_CHECK(fixture.m_staleness == expectedStaleness);
+        BOOST_CHECK(fixture.m_updatedMinibatches == expectedOrder);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(OneStepStaleUpdateOverlapsNextMinibatch)
+{
+    // The update of minibatch 0 cannot complete before the forward and backward of minibatch 1 have run,
+    // which only works if the training thread does not wait for it. The timeout merely avoids hanging on failure.
+    ParameterUpdatePipeline<float> pipeline(ParameterUpdatePipelining::OneStepStale, CPUDEVICE, m_nodes, m_smoothedGradients, m_smoothedCounts);
+    promise<void> nextMinibatchComputed;
+    auto nextMinibatchComputedFuture = nextMinibatchComputed.get_future().share();
+    atomic<bool> timedOut(false);
+    auto sgd = PlainSgd();
+    auto update = [&](const ComputationNodeBasePtr& node, Matrix<float>& value, Matrix<float>& gradient, Matrix<float>& smoothedGradient, double& smoothedCount)
+    {
+        if (nextMinibatchComputedFuture.wait_for(chrono::seconds(30)) != future_status::ready)
+            timedOut = true;
+        sgd(node, value, gradient, smoothedGradient, smoothedCount);
+    };
+
+    ComputeGradients(0);
+    auto weightsBefore = Weights();
+    pipeline.Start(update);
+
+    BOOST_CHECK_EQUAL(pipeline.NumStartedUpdates() - pipeline.NumPublishedUpdates(), 1);
+    ComputeGradients(1);
+    BOOST_CHECK(Weights() == weightsBefore);
+    nextMinibatchComputed.set_value();
+
+    pipeline.Finish();
+    BOOST_CHECK(!timedOut);
+    BOOST_CHECK_EQUAL(pipeline.NumStartedUpdates() - pipeline.NumPublishedUpdates(), 0);
+    BOOST_CHECK(Weights() != weightsBefore);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// Serves numSamples samples of a linear regression task, x = (sin j, cos j) and y = 0.5 x_0 - 0.3 x_1 + 0.1, in order.
+class RegressionDataReader : public IDataReader
+{
+public:
+    static const size_t numSamples = 24;
+
+    virtual void Init(const ConfigParameters&) override { }
+    virtual void Init(const ScriptableObjects::IConfigRecord&) override { }
+    virtual void Destroy() override { }
+
+    virtual void StartMinibatchLoop(size_t mbSize, size_t /*epoch*/, size_t /*requestedEpochSamples*/) override
+    {
+        m_mbSize = mbSize;
+        m_nextSample = 0;
+    }
+
+    virtual bool GetMinibatch(StreamMinibatchInputs& matrices) override
+    {
+        size_t numCols = min(m_mbSize, numSamples - m_nextSample);
+        if (numCols == 0)
+            return false;
+
+        vector<float> features, labels;
+        for (size_t j = m_nextSample; j < m_nextSample + numCols; j++)
+        {
+            features.push_back(sinf((float)j));
+            features.push_back(cosf((float)j));
+            labels.push_back(0.5f * features[features.size() - 2] - 0.3f * features.back() + 0.1f);
+        }
+        matrices.GetInputMatrix<float>(L"features").SetValue(2, numCols, CPUDEVICE, features.data());
+        matrices.GetInputMatrix<float>(L"labels").SetValue(1, numCols, CPUDEVICE, labels.data());
+        matrices.GetInput(L"features").pMBLayout->InitAsFrameMode(numCols);
+        m_nextSample += numCols;
+        return true;
+    }
+
+    virtual bool DataEnd() override { return m_nextSample == numSamples; }
+    virtual size_t GetNumParallelSequencesForFixingBPTTMode() override { return 1; }
+
+private:
+    size_t m_mbSize = 0;
+    size_t m_nextSample = 0;
+};
+
+// Trains prediction = Times(Tanh(W), features) + b with SGD and returns W and b. Tanh(W) only depends on W, so it is
+// recomputed by the next minibatch only if the update bumped the time stamp of W.
+static vector<float> TrainRegression(const string& pipelinedUpdate)
+{
+    auto net = make_shared<ComputationNetwork>(CPUDEVICE);
+    ComputationNetworkBuilder<float> builder(*net);
+    auto W = builder.CreateLearnableParameter(L"W", 1, 2);
+    auto b = builder.CreateLearnableParameter(L"b", 1, 1);
+    auto features = builder.CreateInputNode(L"features", 2);
+    auto labels = builder.CreateInputNode(L"labels", 1);
+    auto prediction = builder.Plus(builder.Times(builder.Tanh(W), features), b, L"prediction");
+    auto criterion = builder.SquareError(labels, prediction, L"criterion");
+    net->AddToNodeGroup(L"feature", features);
+    net->AddToNodeGroup(L"label", labels);
+    net->AddToNodeGroup(L"output", prediction);
+    net->AddToNodeGroup(L"criterion", criterion);
+    net->CompileNetwork();
+    W->Value().SetValue(0.2f);
+    b->Value().SetValue(-0.1f);
+
+    auto modelDir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(modelDir);
+    ConfigParameters config;
+    config.Parse("modelPath=" + (modelDir / "model.dnn").string() + "\n"
+                 "minibatchSize=4\n"
+                 "epochSize=0\n"
+                 "maxEpochs=2\n"
+                 "learningRatesPerMB=0.2\n"
+                 "momentumPerMB=0\n"
+                 "numMBsToShowResult=0\n"
+                 "pipelinedUpdate=" + pipelinedUpdate);
+
+    SGD<float> sgd(config);
+    RegressionDataReader reader;
+    sgd.Train(net, CPUDEVICE, &reader, nullptr, /*startEpoch=*/0, /*loadNetworkFromCheckpoint=*/false);
+    boost::filesystem::remove_all(modelDir);
+
+    return { W->Value()(0, 0), W->Value()(0, 1), b->Value()(0, 0) };
+}
+
+BOOST_AUTO_TEST_SUITE(PipelinedTrainingSuite)
+
+BOOST_AUTO_TEST_CASE(OverlappedTrainingMatchesSequentialTraining)
+{
+    auto sequential = TrainRegression("none");
+    auto overlapped = TrainRegression("overlapped");
+    BOOST_CHECK(overlapped == sequential);
+
+    // training on one-step-stale weights takes a different path, but the network must see the published updates as well
+    auto initial = vector<float>{ 0.2f, 0.2f, -0.1f };
+    auto stale = TrainRegression("oneStepStale");
+    BOOST_REQUIRE_EQUAL(stale.size(), sequential.size());
+    BOOST_CHECK(stale != sequential);
+    for (size_t i = 0; i < stale.size(); i++)
+        BOOST_CHECK_LT(fabs(stale[i] - sequential[i]), 0.5f * fabs(sequential[i] - initial[i]));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
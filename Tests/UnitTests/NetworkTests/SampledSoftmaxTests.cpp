@@ -0,0 +1,233 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include "../../../Source/ComputationNetworkLib/ComputationNetwork.h"
+#include "../../../Source/ComputationNetworkLib/ComputationNetworkBuilder.h"
+#include "../../../Source/ComputationNetworkLib/TrainingNodes.h"
+#include "../../../Source/Math/CPURNGHandle.h"
+#include <boost/random/uniform_real_distribution.hpp>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+using namespace Microsoft::MSR::CNTK;
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+BOOST_AUTO_TEST_SUITE(SampledSoftmaxTests)
+
+BOOST_AUTO_TEST_CASE(AliasTableMatchesSamplingWeights)
+{
+    const vector<double> weights = { 5, 0, 1, 3, 0.5, 10, 0.5, 0 };
+    const double totalWeight = 20;
+    const size_t numDraws = 1000000;
+
+    AliasTable aliasTable;
+    aliasTable.Build(weights);
+    BOOST_REQUIRE_EQUAL(aliasTable.GetNumClasses(), weights.size());
+
+    mt19937 rng(0);
+    uniform_real_distribution<double> r(0, 1);
+    vector<size_t> counts(weights.size(), 0);
+    for (size_t i = 0; i < numDraws; i++)
+        counts[aliasTable.Sample(r(rng))]++;
+
+    for (size_t c = 0; c < weights.size(); c++)
+    {
+        double p = weights[c] / totalWeight;
+        double frequency = (double)counts[c] / numDraws;
+        if (p == 0)
+            BOOST_REQUIRE_MESSAGE(counts[c] == 0, "Class " << c << " has zero weight but was sampled " << counts[c] << " times");
+        else // 5 standard deviations
+            BOOST_REQUIRE_MESSAGE(fabs(frequency - p) < 5 * sqrt(p * (1 - p) / numDraws), "Class " << c << ": frequency " << frequency << ", expected " << p);
+    }
+
+    // the largest random number still maps to a valid class
+    BOOST_REQUIRE(aliasTable.Sample(nextafter(1.0, 0.0)) < weights.size());
+}
+
+BOOST_AUTO_TEST_CASE(AliasTableRejectsInvalidWeights)
+{
+    AliasTable aliasTable;
+    BOOST_REQUIRE_THROW(aliasTable.Build(vector<double>{ 1, -1, 2 }), std::invalid_argument);
+    BOOST_REQUIRE_THROW(aliasTable.Build(vector<double>{ 0, 0 }), std::invalid_argument);
+    BOOST_REQUIRE_THROW(aliasTable.Build(vector<double>{}), std::invalid_argument);
+}
+
+// Criterion -sum_t log softmax_0(hidden_t' [w_label, w_sample...] - log(S q(.))) on a single sequence.
+// The hidden activations are the columns of the parameter 'hidden', multiplied with an identity input, so that the gradient
+// of 'hidden' is that of the node's hidden activation input.
+struct SampledSoftmaxNetwork
+{
+    typedef shared_ptr<ComputationNode<double>> ComputationNodePtr;
+    static const size_t hiddenDim = 3;
+    static const size_t numClasses = 5;
+    static const size_t numSamples = 4;
+    static const size_t numFrames = hiddenDim;
+    static const uint64_t seed = 17;
+
+    SampledSoftmaxNetwork()
+        : m_samplingWeights({ 1, 2, 3, 4, 0.5 }), m_labels({ 1, 3, 4 })
+    {
+        m_net = make_shared<ComputationNetwork>(CPUDEVICE);
+        ComputationNetworkBuilder<double> builder(*m_net);
+
+        auto labels = builder.CreateInputNode(L"labels", numClasses);
+        auto identity = builder.CreateInputNode(L"identity", hiddenDim);
+        m_hidden = builder.CreateLearnableParameter(L"hidden", hiddenDim, hiddenDim);
+        m_outputWeights = builder.CreateLearnableParameter(L"outputWeights", hiddenDim, numClasses);
+        auto samplingWeights = builder.CreateLearnableParameter(L"samplingWeights", numClasses, 1);
+        samplingWeights->SetLearningRateMultiplier(0);
+        auto criterion = builder.SampledSoftmaxWithCrossEntropy(labels, builder.Times(m_hidden, identity), m_outputWeights, samplingWeights, numSamples, L"criterion");
+        m_criterion = dynamic_pointer_cast<SampledSoftmaxWithCrossEntropyNode<double>>(criterion);
+        m_net->AddToNodeGroup(L"criterion", criterion);
+
+        m_net->CompileNetwork();
+        m_net->AllocateAllMatrices({}, {}, criterion);
+
+        SetValue(m_hidden, hiddenDim, hiddenDim, [](size_t i) { return 0.8 * sin(1.3 * i + 0.2); });
+        SetValue(m_outputWeights, hiddenDim, numClasses, [](size_t i) { return 0.6 * cos(0.9 * i); });
+        SetValue(samplingWeights, numClasses, 1, [this](size_t i) { return m_samplingWeights[i]; });
+
+        m_net->GetMBLayoutPtrOfNetwork()->InitAsFrameMode(numFrames);
+        SetValue(labels, numClasses, numFrames, [this](size_t i) { return i % numClasses == m_labels[i / numClasses] ? 1.0 : 0.0; });
+        SetValue(identity, hiddenDim, numFrames, [](size_t i) { return i % hiddenDim == i / hiddenDim ? 1.0 : 0.0; });
+    }
+
+    static void SetValue(const ComputationNodePtr& node, size_t numRows, size_t numCols, const function<double(size_t)>& valueAt)
+    {
+        vector<double> data(numRows * numCols);
+        for (size_t i = 0; i < data.size(); i++)
+            data[i] = valueAt(i);
+        node->Value().SetValue(numRows, numCols, CPUDEVICE, data.data());
+        node->BumpEvalTimeStamp();
+    }
+
+    // Every evaluation draws the same samples.
+    double ForwardProp()
+    {
+        ScopedNetworkOperationMode modeGuard(m_net, NetworkOperationMode::training);
+        m_criterion->SetRngState(seed);
+        m_net->ForwardProp(ComputationNodeBasePtr(m_criterion));
+        return m_criterion->Value().Get00Element();
+    }
+
+    void Backprop()
+    {
+        ScopedNetworkOperationMode modeGuard(m_net, NetworkOperationMode::training);
+        m_net->Backprop(ComputationNodeBasePtr(m_criterion));
+    }
+
+    // The samples the node draws, from the same random numbers.
+    vector<size_t> DrawSamples() const
+    {
+        AliasTable aliasTable;
+        aliasTable.Build(m_samplingWeights);
+        CPURNGHandle rng(CPUDEVICE, seed);
+        boost::random::uniform_real_distribution<double> r(0, 1);
+        vector<size_t> samples(numSamples);
+        for (auto& sample : samples)
+            sample = aliasTable.Sample(r(rng.Generator()));
+        return samples;
+    }
+
+    vector<double> m_samplingWeights;
+    vector<size_t> m_labels;
+    ComputationNetworkPtr m_net;
+    ComputationNodePtr m_hidden, m_outputWeights;
+    shared_ptr<SampledSoftmaxWithCrossEntropyNode<double>> m_criterion;
+};
+
+BOOST_AUTO_TEST_CASE(SampledSoftmaxCorrectsLogitsBySamplingProbabilities)
+{
+    SampledSoftmaxNetwork network;
+    double criterion = network.ForwardProp();
+
+    // recompute the criterion from the same samples, with and without the correction -log(S q(c))
+    auto samples = network.DrawSamples();
+    const auto& hidden = network.m_hidden->Value();
+    const auto& weights = network.m_outputWeights->Value();
+    double totalWeight = accumulate(network.m_samplingWeights.begin(), network.m_samplingWeights.end(), 0.0);
+    auto logit = [&](size_t c, size_t t, bool corrected)
+    {
+        double z = 0;
+        for (size_t i = 0; i < SampledSoftmaxNetwork::hiddenDim; i++)
+            z += hidden(i, t) * weights(i, c);
+        return corrected ? z - log(SampledSoftmaxNetwork::numSamples * network.m_samplingWeights[c] / totalWeight) : z;
+    };
+    double expected[2] = { 0, 0 };
+    for (bool corrected : { false, true })
+    {
+        for (size_t t = 0; t < SampledSoftmaxNetwork::numFrames; t++)
+        {
+            double labelLogit = logit(network.m_labels[t], t, corrected);
+            double sumOfExp = exp(labelLogit);
+            for (size_t sample : samples)
+                sumOfExp += exp(logit(sample, t, corrected));
+            expected[corrected] -= labelLogit - log(sumOfExp);
+        }
+    }
+    BOOST_CHECK_CLOSE(criterion, expected[true], 1e-8);
+    BOOST_CHECK(fabs(expected[true] - expected[false]) > 1e-2);
+}
+
+BOOST_AUTO_TEST_CASE(SampledSoftmaxGradientsMatchFiniteDifferences)
+{
+    SampledSoftmaxNetwork network;
+    network.ForwardProp();
+    network.Backprop();
+
+    const double epsilon = 1e-6;
+    for (auto& nameAndParameter : vector<pair<const char*, SampledSoftmaxNetwork::ComputationNodePtr>>{ { "hidden", network.m_hidden }, { "outputWeights", network.m_outputWeights } })
+    {
+        auto& parameter = nameAndParameter.second;
+        Matrix<double> gradient(parameter->Gradient().DeepClone());
+        auto& value = parameter->Value();
+        for (size_t j = 0; j < value.GetNumCols(); j++)
+        {
+            for (size_t i = 0; i < value.GetNumRows(); i++)
+            {
+                double original = value(i, j);
+                value(i, j) = original + epsilon;
+                parameter->BumpEvalTimeStamp();
+                double plus = network.ForwardProp();
+                value(i, j) = original - epsilon;
+                parameter->BumpEvalTimeStamp();
+                double minus = network.ForwardProp();
+                value(i, j) = original;
+                parameter->BumpEvalTimeStamp();
+
+                double numericalGradient = (plus - minus) / (2 * epsilon);
+                BOOST_CHECK_MESSAGE(fabs(gradient(i, j) - numericalGradient) < 1e-6,
+                                    "Gradient of " << nameAndParameter.first << "(" << i << ", " << j << ") is " << gradient(i, j) << ", expected " << numericalGradient);
+            }
+        }
+    }
+}
+
+// Class indices are half values in a half network, which cannot tell all classes apart beyond 2048.
+BOOST_AUTO_TEST_CASE(SampledSoftmaxRejectsHalfBeyond2048Classes)
+{
+    for (size_t numClasses : { 2048, 2049 })
+    {
+        auto net = make_shared<ComputationNetwork>(CPUDEVICE);
+        ComputationNetworkBuilder<half> builder(*net);
+        auto labels = builder.CreateInputNode(L"labels", numClasses);
+        auto hidden = builder.CreateInputNode(L"hidden", 3);
+        auto outputWeights = builder.CreateLearnableParameter(L"outputWeights", 3, numClasses);
+        auto samplingWeights = builder.CreateLearnableParameter(L"samplingWeights", numClasses, 1);
+        auto criterion = builder.SampledSoftmaxWithCrossEntropy(labels, hidden, outputWeights, samplingWeights, 4, L"criterion");
+        net->AddToNodeGroup(L"criterion", criterion);
+        if (numClasses <= 2048)
+            BOOST_CHECK_NO_THROW(net->CompileNetwork());
+        else
+            BOOST_CHECK_THROW(net->CompileNetwork(), std::invalid_argument);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
@@ -0,0 +1,140 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// Tests of ComputationNetwork::FuseTimesPlusActivation() and the TimesPlusActivationNode it creates, against the unfused network.
+//
+#include "stdafx.h"
+#include "../../../Source/ComputationNetworkLib/ComputationNetwork.h"
+#include "../../../Source/ComputationNetworkLib/ComputationNetworkBuilder.h"
+#include <cmath>
+#include <memory>
+
+using namespace Microsoft::MSR::CNTK;
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+// Three dense layers ReLU -> Sigmoid -> Tanh on a minibatch of two sequences. The first layer is wide enough for its
+// product to be computed in several blocks of columns, the second one adds the bias first and has a [dim x 1] bias.
+// The sum of the third layer is an output as well, hence that layer cannot be fused.
+struct DenseNetwork
+{
+    typedef shared_ptr<ComputationNode<float>> ComputationNodePtr;
+
+    static const size_t inputDim = 20;
+    static const size_t hiddenDim = 600;
+    static const size_t secondDim = 4;
+    static const size_t outputDim = 3;
+    static const size_t numSequences = 2;
+    static const size_t numTimeSteps = 125;
+
+    DenseNetwork(bool fuse)
+    {
+        m_net = make_shared<ComputationNetwork>(CPUDEVICE);
+        ComputationNetworkBuilder<float> builder(*m_net);
+
+        auto features = builder.CreateInputNode(L"features", inputDim);
+        auto W1 = builder.CreateLearnableParameter(L"W1", hiddenDim, inputDim);
+        auto b1 = builder.CreateLearnableParameter(L"b1", TensorShape(hiddenDim));
+        auto W2 = builder.CreateLearnableParameter(L"W2", secondDim, hiddenDim);
+        auto b2 = builder.CreateLearnableParameter(L"b2", secondDim, 1);
+        auto W3 = builder.CreateLearnableParameter(L"W3", outputDim, secondDim);
+        auto b3 = builder.CreateLearnableParameter(L"b3", TensorShape(outputDim));
+
+        auto h1 = builder.RectifiedLinear(builder.Plus(builder.Times(W1, features), b1), L"h1");
+        auto h2 = builder.Sigmoid(builder.Plus(b2, builder.Times(W2, h1)), L"h2");
+        m_sum = builder.Plus(builder.Times(W3, h2), b3, L"sum");
+        m_output = builder.Tanh(m_sum, L"output");
+        m_net->AddToNodeGroup(L"output", m_output);
+        m_net->AddToNodeGroup(L"output", m_sum);
+
+        m_net->CompileNetwork();
+        if (fuse)
+        {
+            m_replacedNodes = m_net->FuseTimesPlusActivation<float>();
+            m_net->CompileNetwork();
+        }
+        m_net->AllocateAllMatrices({}, { m_output, m_sum }, nullptr);
+
+        size_t seed = 0;
+        for (const auto& parameter : { W1, b1, W2, b2, W3, b3 })
+        {
+            auto& value = parameter->Value();
+            vector<float> data(value.GetNumElements());
+            for (size_t i = 0; i < data.size(); i++)
+                data[i] = 0.5f * sinf(0.7f * (i + seed) + 0.2f);
+            value.SetValue(value.GetNumRows(), value.GetNumCols(), CPUDEVICE, data.data());
+            seed += data.size();
+        }
+
+        auto layout = m_net->GetMBLayoutPtrOfNetwork();
+        layout->Init(numSequences, numTimeSteps);
+        layout->AddSequence(0, 0, 0, numTimeSteps);
+        layout->AddSequence(1, 1, 0, numTimeSteps);
+
+        vector<float> data(inputDim * numSequences * numTimeSteps);
+        for (size_t i = 0; i < data.size(); i++)
+            data[i] = cosf(1.3f * i);
+        features->Value().SetValue(inputDim, numSequences * numTimeSteps, CPUDEVICE, data.data());
+    }
+
+    void Evaluate()
+    {
+        m_net->ForwardProp(vector<ComputationNodeBasePtr>{ m_output, m_sum });
+    }
+
+    static vector<float> ToVector(const Matrix<float>& matrix)
+    {
+        vector<float> data(matrix.GetNumElements());
+        float* array = data.data();
+        size_t arraySize = data.size();
+        matrix.CopyToArray(array, arraySize);
+        return data;
+    }
+
+    ComputationNetworkPtr m_net;
+    ComputationNodePtr m_sum, m_output;
+    map<ComputationNodeBasePtr, ComputationNodeBasePtr> m_replacedNodes;
+};
+
+static void CheckClose(const vector<float>& actual, const vector<float>& expected, const char* what)
+{
+    BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); i++)
+        BOOST_CHECK_MESSAGE(fabs(actual[i] - expected[i]) < 1e-5f, what << "[" << i << "] is " << actual[i] << ", expected " << expected[i]);
+}
+
+BOOST_AUTO_TEST_SUITE(TimesPlusActivationSuite)
+
+BOOST_AUTO_TEST_CASE(FusedDenseLayersMatchUnfusedNetwork)
+{
+    DenseNetwork reference(/*fuse=*/false);
+    DenseNetwork fused(/*fuse=*/true);
+
+    // the activations of the first two layers are replaced, their Times and Plus nodes are merged into the replacements
+    BOOST_CHECK_EQUAL(fused.m_replacedNodes.size(), 6);
+    size_t numFusedNodes = 0;
+    for (const auto& replacedNode : fused.m_replacedNodes)
+    {
+        if (replacedNode.second)
+        {
+            numFusedNodes++;
+            BOOST_CHECK(replacedNode.second->OperationName() == L"TimesPlusActivation");
+            BOOST_CHECK(replacedNode.second->NodeName() == replacedNode.first->NodeName());
+            BOOST_CHECK(fused.m_net->GetNodeFromName(replacedNode.first->NodeName()) == replacedNode.second);
+        }
+    }
+    BOOST_CHECK_EQUAL(numFusedNodes, 2);
+    BOOST_CHECK(fused.m_net->GetNodeFromName(L"h2")->GetSampleLayout() == TensorShape(DenseNetwork::secondDim, 1));
+    BOOST_CHECK(fused.m_net->GetNodeFromName(L"output")->OperationName() == L"Tanh");
+
+    reference.Evaluate();
+    fused.Evaluate();
+    CheckClose(DenseNetwork::ToVector(fused.m_output->Value()), DenseNetwork::ToVector(reference.m_output->Value()), "output");
+    CheckClose(DenseNetwork::ToVector(fused.m_sum->Value()), DenseNetwork::ToVector(reference.m_sum->Value()), "sum");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
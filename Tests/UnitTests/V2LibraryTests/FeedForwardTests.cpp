@@ -6,6 +6,8 @@
 #include "CNTKLibrary.h"
 #include <functional>
 #include "Common.h"
+#include "CNTKLibraryC.h"
+#include <thread>
 
 using namespace CNTK;
 
@@ -450,8 +452,295 @@ void TestTimesReduceSequenceAxis(
     }
 }
 
+void TestBatchingEvaluator(const DeviceDescriptor& device, CNTK_DeviceDescriptor cdevice)
+{
+    using namespace std::placeholders;
+
+    const size_t inputDim = 37;
+    const size_t numOutputClasses = 11;
+    const size_t numThreads = 8;
+    const size_t numRequestsPerThread = 20;
+
+    auto features = InputVariable({ inputDim }, DataType::Float, L"features");
+    auto classifier = FullyConnectedFeedForwardClassifierNet(features, numOutputClasses, 64, 2, device, std::bind(Sigmoid, _1, L""), L"classifierOutput");
+
+    const std::wstring tempModelPath = L"batching.model";
+    if ((_wunlink(tempModelPath.c_str()) != 0) && (errno != ENOENT))
+        BOOST_ERROR("Error deleting temp model file 'batching.model'");
+    classifier->Save(tempModelPath);
+
+    CNTK_ModelHandle model;
+    auto rc = CNTK_LoadModel("batching.model", &cdevice, &model);
+    BOOST_REQUIRE_EQUAL(rc.value, CNTK_SUCCESS);
+    if (_wunlink(tempModelPath.c_str()) != 0)
+        BOOST_ERROR("Error deleting temp model file 'batching.model'");
+
+    CNTK_BatchingOptions options{ 16, 1000 };
+    CNTK_BatchingEvaluatorHandle evaluator;
+    rc = CNTK_CreateBatchingEvaluator(model, &options, &evaluator);
+    BOOST_REQUIRE_EQUAL(rc.value, CNTK_SUCCESS);
+    CNTK_ReleaseModel(model);
+
+    // One input sample per request, the expected outputs are computed request by request.
+    std::mt19937_64 generator(7);
+    std::uniform_real_distribution<float> distribution(-1, 1);
+    std::vector<std::vector<float>> inputData(numThreads * numRequestsPerThread);
+    std::vector<std::vector<float>> expected;
+    for (auto& sample : inputData)
+    {
+        for (size_t i = 0; i < inputDim; ++i)
+            sample.push_back(distribution(generator));
+
+        std::unordered_map<Variable, ValuePtr> outputs{ { classifier->Output(), nullptr } };
+        classifier->Evaluate({ { features, Value::CreateBatch(NDShape{ inputDim }, sample, device) } }, outputs, device);
+        auto value = MakeSharedObject<NDArrayView>(DataType::Float, outputs[classifier->Output()]->Shape(), DeviceDescriptor::CPUDevice());
+        value->CopyFrom(*outputs[classifier->Output()]->Data());
+        expected.push_back(std::vector<float>(value->DataBuffer<float>(), value->DataBuffer<float>() + numOutputClasses));
+    }
+
+    std::vector<std::vector<float>> results(inputData.size());
+    std::vector<int32_t> statusCodes(inputData.size(), CNTK_SUCCESS);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < numThreads; ++t)
+    {
+        threads.push_back(std::thread([&, t]()
+        {
+            char inputName[] = "features";
+            char outputName[] = "classifierOutput";
+            uint32_t inputShapeDims[] = { (uint32_t)inputDim };
+            CNTK_Variable input{ inputName, { inputShapeDims, 1 } };
+            CNTK_Variable output{ outputName, { nullptr, 0 } };
+
+            for (size_t r = t * numRequestsPerThread; r < (t + 1) * numRequestsPerThread; ++r)
+            {
+                CNTK_Value inputValue{ { inputShapeDims, 1 }, inputData[r].data() };
+                CNTK_Value* outputValues = nullptr;
+                auto status = CNTK_EvaluateBatched(evaluator, &input, &inputValue, 1, &output, 1, &outputValues);
+                statusCodes[r] = status.value;
+                if (status.value != CNTK_SUCCESS)
+                    continue;
+
+                results[r].assign(outputValues[0].data, outputValues[0].data + numOutputClasses);
+                CNTK_CleanValue(&outputValues[0]);
+                CNTK_ReleaseArray(outputValues);
+            }
+        }));
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    for (size_t r = 0; r < inputData.size(); ++r)
+    {
+        BOOST_REQUIRE_EQUAL(statusCodes[r], CNTK_SUCCESS);
+        RequireClose(results[r], expected[r], 0.0001f, 0.0001f);
+    }
+
+    CNTK_BatchingStatistics statistics;
+    rc = CNTK_GetBatchingStatistics(evaluator, true, &statistics);
+    BOOST_REQUIRE_EQUAL(rc.value, CNTK_SUCCESS);
+    BOOST_TEST(statistics.numRequests == inputData.size());
+    BOOST_TEST(statistics.numBatches <= statistics.numRequests);
+    BOOST_TEST(statistics.numBatches >= inputData.size() / options.maxBatchSize);
+    BOOST_TEST(statistics.queueLatency.p50 <= statistics.queueLatency.p99);
+    BOOST_TEST(statistics.computeLatency.p99 <= statistics.computeLatency.max);
+
+    rc = CNTK_GetBatchingStatistics(evaluator, false, &statistics);
+    BOOST_REQUIRE_EQUAL(rc.value, CNTK_SUCCESS);
+    BOOST_TEST(statistics.numRequests == 0);
+
+    CNTK_ReleaseBatchingEvaluator(evaluator);
+}
+
+void TestSharedModelParameters(const DeviceDescriptor& device, CNTK_DeviceDescriptor cdevice)
+{
+    using namespace std::placeholders;
+
+    const size_t inputDim = 37;
+    const size_t numOutputClasses = 11;
+    const size_t hiddenLayerDim = 64;
+
+    auto features = InputVariable({ inputDim }, DataType::Float, L"features");
+    auto baseModel = FullyConnectedFeedForwardClassifierNet(features, numOutputClasses, hiddenLayerDim, 2, device, std::bind(Sigmoid, _1, L""), L"classifierOutput");
+
+    // A fine-tuned variant of the base model that differs in the output layer only.
+    auto variantModel = baseModel->Clone(ParameterCloningMethod::Clone);
+    auto variantParameters = variantModel->Parameters();
+    auto tunedParameter = *std::find_if(variantParameters.begin(), variantParameters.end(), [&](const Parameter& p) { return p.Shape() == NDShape{ numOutputClasses, hiddenLayerDim }; });
+    tunedParameter.SetValue(NDArrayView::RandomUniform<float>(tunedParameter.Shape(), -0.5, 0.5, 3, device));
+
+    auto sizeInBytes = [](const Variable& variable) { return (uint64_t)(variable.Shape().TotalSize() * sizeof(float)); };
+    uint64_t allBytes = 0;
+    for (const auto& parameter : baseModel->Parameters())
+        allBytes += sizeInBytes(parameter);
+    for (const auto& constant : baseModel->Constants())
+        allBytes += sizeInBytes(constant);
+    auto tunedBytes = sizeInBytes(tunedParameter);
+
+    // The zero initialized biases of the two hidden layers are stored once.
+    auto modelBytes = allBytes - hiddenLayerDim * sizeof(float);
+
+    auto loadModel = [&](const FunctionPtr& function, const std::wstring& path)
+    {
+        if ((_wunlink(path.c_str()) != 0) && (errno != ENOENT))
+            BOOST_ERROR("Error deleting temp model file");
+        function->Save(path);
+
+        CNTK_ModelHandle model;
+        auto rc = CNTK_LoadModel(std::string(path.begin(), path.end()).c_str(), &cdevice, &model);
+        BOOST_REQUIRE_EQUAL(rc.value, CNTK_SUCCESS);
+        if (_wunlink(path.c_str()) != 0)
+            BOOST_ERROR("Error deleting temp model file");
+        return model;
+    };
+
+    auto memoryUsage = [](CNTK_ModelHandle model)
+    {
+        CNTK_ModelMemoryUsage usage;
+        auto rc = CNTK_GetModelMemoryUsage(model, &usage);
+        BOOST_REQUIRE_EQUAL(rc.value, CNTK_SUCCESS);
+        BOOST_TEST(usage.totalBytes == usage.sharedBytes + usage.uniqueBytes);
+        return usage;
+    };
+
+    auto base = loadModel(baseModel, L"shared_base.model");
+    auto usage = memoryUsage(base);
+    BOOST_TEST(usage.totalBytes == modelBytes);
+    BOOST_TEST(usage.uniqueBytes == modelBytes);
+
+    auto variant = loadModel(variantModel, L"shared_variant.model");
+    usage = memoryUsage(variant);
+    BOOST_TEST(usage.totalBytes == modelBytes);
+    BOOST_TEST(usage.uniqueBytes == tunedBytes);
+    BOOST_TEST(usage.sharedBytes == modelBytes - tunedBytes);
+
+    usage = memoryUsage(base);
+    BOOST_TEST(usage.uniqueBytes == tunedBytes);
+    BOOST_TEST(usage.proportionalBytes <= modelBytes - (modelBytes - tunedBytes) / 2);
+
+    // Shared and frozen clones share everything with the model, cloned parameters are private.
+    CNTK_ModelHandle sharedClone, frozenClone, privateClone;
+    auto rc = CNTK_CloneModel(variant, CNTK_ModelParameterShare, false, &sharedClone);
+    BOOST_REQUIRE_EQUAL(rc.value, CNTK_SUCCESS);
+    rc = CNTK_CloneModel(variant, CNTK_ModelParameterFreeze, false, &frozenClone);
+    BOOST_REQUIRE_EQUAL(rc.value, CNTK_SUCCESS);
+    rc = CNTK_CloneModel(variant, CNTK_ModelParameterClone, false, &privateClone);
+    BOOST_REQUIRE_EQUAL(rc.value, CNTK_SUCCESS);
+
+    BOOST_TEST(memoryUsage(sharedClone).sharedBytes == modelBytes);
+    BOOST_TEST(memoryUsage(frozenClone).sharedBytes == modelBytes);
+    BOOST_TEST(memoryUsage(privateClone).sharedBytes == 0);
+    BOOST_TEST(memoryUsage(variant).uniqueBytes == 0);
+
+    // The shared values evaluate to the same results as the original models.
+    std::mt19937_64 generator(11);
+    std::uniform_real_distribution<float> distribution(-1, 1);
+    std::vector<float> sample;
+    for (size_t i = 0; i < inputDim; ++i)
+        sample.push_back(distribution(generator));
+
+    auto evaluate = [&](const FunctionPtr& function)
+    {
+        std::unordered_map<Variable, ValuePtr> outputs{ { function->Output(), nullptr } };
+        function->Evaluate({ { function->Arguments().front(), Value::CreateBatch(NDShape{ inputDim }, sample, device) } }, outputs, device);
+        auto value = MakeSharedObject<NDArrayView>(DataType::Float, outputs[function->Output()]->Shape(), DeviceDescriptor::CPUDevice());
+        value->CopyFrom(*outputs[function->Output()]->Data());
+        return std::vector<float>(value->DataBuffer<float>(), value->DataBuffer<float>() + numOutputClasses);
+    };
+
+    auto evaluateC = [&](CNTK_ModelHandle model)
+    {
+        char inputName[] = "features";
+        char outputName[] = "classifierOutput";
+        uint32_t inputShapeDims[] = { (uint32_t)inputDim, 1 };
+        CNTK_Variable input{ inputName, { inputShapeDims, 1 } };
+        CNTK_Variable output{ outputName, { nullptr, 0 } };
+        CNTK_Value inputValue{ { inputShapeDims, 2 }, sample.data() };
+        bool reset = true;
+        CNTK_Value* outputValues = nullptr;
+        auto status = CNTK_EvaluateSequence(model, &input, &inputValue, &reset, 1, &output, 1, &outputValues);
+        BOOST_REQUIRE_EQUAL(status.value, CNTK_SUCCESS);
+        std::vector<float> result(outputValues[0].data, outputValues[0].data + numOutputClasses);
+        CNTK_CleanValue(&outputValues[0]);
+        CNTK_ReleaseArray(outputValues);
+        return result;
+    };
+
+    RequireClose(evaluateC(base), evaluate(baseModel), 0.0001f, 0.0001f);
+    RequireClose(evaluateC(variant), evaluate(variantModel), 0.0001f, 0.0001f);
+    RequireClose(evaluateC(frozenClone), evaluate(variantModel), 0.0001f, 0.0001f);
+
+    CNTK_ReleaseModel(sharedClone);
+    CNTK_ReleaseModel(frozenClone);
+    CNTK_ReleaseModel(privateClone);
+    CNTK_ReleaseModel(base);
+    BOOST_TEST(memoryUsage(variant).uniqueBytes == modelBytes);
+    CNTK_ReleaseModel(variant);
+}
+
 BOOST_AUTO_TEST_SUITE(FeedForwardSuite)
 
+void TestParallelNodeEvaluation(const DeviceDescriptor& device)
+{
+    using namespace std::placeholders;
+
+    const size_t inputDim = 23;
+    const size_t hiddenDim = 31;
+    const size_t outputDim = 7;
+    const size_t numTowers = 4;
+    const size_t numSamples = 5;
+
+    // Towers on top of a common layer; in backprop all towers accumulate into the gradient of that layer.
+    auto features = InputVariable({ inputDim }, DataType::Float, L"features");
+    auto sharedLayer = FullyConnectedDNNLayer(features, hiddenDim, device, std::bind(Sigmoid, _1, L""));
+    FunctionPtr model;
+    for (size_t i = 0; i < numTowers; ++i)
+    {
+        auto tower = FullyConnectedDNNLayer(sharedLayer, hiddenDim, device, std::bind(Tanh, _1, L""), L"", (unsigned long)(2 + i));
+        tower = FullyConnectedLinearLayer(tower, outputDim, device, L"", (unsigned long)(2 + numTowers + i));
+        model = model ? Plus(model, tower) : tower;
+    }
+
+    std::vector<float> inputData(inputDim * numSamples);
+    for (size_t i = 0; i < inputData.size(); ++i)
+        inputData[i] = (float)((i * 37) % 101) / 101;
+    auto inputValue = Value::CreateBatch(features.Shape(), inputData, device, /*readOnly =*/ true);
+
+    // Each clone gets a network of its own, allocated with the current setting.
+    auto forwardAndBackward = [&](const FunctionPtr& function)
+    {
+        std::unordered_map<Variable, ValuePtr> outputs = { { function->Output(), nullptr } };
+        auto backpropState = function->Forward({ { features, inputValue } }, outputs, device, { function->Output() });
+        auto outputValue = outputs[function->Output()];
+
+        auto rootGradientValue = MakeSharedObject<Value>(MakeSharedObject<NDArrayView>(1.0f, outputValue->Shape(), device));
+        std::unordered_map<Variable, ValuePtr> parameterGradients;
+        for (const auto& parameter : function->Parameters())
+            parameterGradients[parameter] = nullptr;
+        function->Backward(backpropState, { { function->Output(), rootGradientValue } }, parameterGradients);
+
+        std::vector<std::vector<float>> results;
+        auto addResult = [&results](const NDArrayViewPtr& value)
+        {
+            auto cpuValue = value->DeepClone(DeviceDescriptor::CPUDevice());
+            results.emplace_back(cpuValue->DataBuffer<float>(), cpuValue->DataBuffer<float>() + cpuValue->Shape().TotalSize());
+        };
+        addResult(outputValue->Data());
+        for (const auto& parameter : function->Parameters())
+            addResult(parameterGradients[parameter]->Data());
+        return results;
+    };
+
+    auto expected = forwardAndBackward(model->Clone(ParameterCloningMethod::Share));
+    Internal::EnableParallelNodeEvaluation();
+    auto actual = forwardAndBackward(model->Clone(ParameterCloningMethod::Share));
+    Internal::DisableParallelNodeEvaluation();
+
+    BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i)
+        FloatingPointVectorCompare(actual[i], expected[i], "Parallel node evaluation produced different results");
+}
+
 BOOST_AUTO_TEST_CASE(FFTimesAndPlusInCPU)
 {
     TestTimesAndPlus<double>(4, 2, 5, DeviceDescriptor::CPUDevice(), 3, true, true, true);
@@ -510,6 +799,36 @@ BOOST_AUTO_TEST_CASE(FFNetworkCreationInCPU)
     }
 }
 
+BOOST_AUTO_TEST_CASE(BatchingEvaluatorInCPU)
+{
+    if (ShouldRunOnCpu())
+        TestBatchingEvaluator(DeviceDescriptor::CPUDevice(), CNTK_DeviceDescriptor{ CNTK_DeviceKind_CPU, 0 });
+}
+
+BOOST_AUTO_TEST_CASE(BatchingEvaluatorInGPU)
+{
+    if (ShouldRunOnGpu())
+        TestBatchingEvaluator(DeviceDescriptor::GPUDevice(0), CNTK_DeviceDescriptor{ CNTK_DeviceKind_GPU, 0 });
+}
+
+BOOST_AUTO_TEST_CASE(SharedModelParametersInCPU)
+{
+    if (ShouldRunOnCpu())
+        TestSharedModelParameters(DeviceDescriptor::CPUDevice(), CNTK_DeviceDescriptor{ CNTK_DeviceKind_CPU, 0 });
+}
+
+BOOST_AUTO_TEST_CASE(ParallelNodeEvaluationInCPU)
+{
+    if (ShouldRunOnCpu())
+        TestParallelNodeEvaluation(DeviceDescriptor::CPUDevice());
+}
+
+BOOST_AUTO_TEST_CASE(SharedModelParametersInGPU)
+{
+    if (ShouldRunOnGpu())
+        TestSharedModelParameters(DeviceDescriptor::GPUDevice(0), CNTK_DeviceDescriptor{ CNTK_DeviceKind_GPU, 0 });
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }}
@@ -1200,6 +1200,271 @@ void TestMatMul(const DeviceDescriptor& device)
     }
 }
 
+void TestEvaluationContextPool(const DeviceDescriptor& device)
+{
+    using namespace std::placeholders;
+
+    const size_t inputDim = 20;
+    const size_t numOutputClasses = 7;
+    const size_t numSamples = 5;
+
+    auto features = InputVariable({ inputDim }, DataType::Float, L"features");
+    auto model = FullyConnectedFeedForwardClassifierNet(features, numOutputClasses, 32, 2, device, std::bind(Sigmoid, _1, L""), L"classifierOutput");
+
+    auto pool = CreateEvaluationContextPool(model, device, 2);
+    BOOST_TEST(pool->NumberOfContexts() == 2);
+    BOOST_TEST(pool->NumberOfAvailableContexts() == 2);
+
+    std::vector<float> inputData(inputDim * numSamples);
+    for (size_t i = 0; i < inputData.size(); ++i)
+        inputData[i] = (float)((i * 7) % 13) / 13;
+
+    auto evaluate = [&](const FunctionPtr& function)
+    {
+        auto input = function->Arguments()[0];
+        auto output = function->Output();
+        std::unordered_map<Variable, ValuePtr> outputs{ { output, nullptr } };
+        function->Evaluate({ { input, Value::CreateBatch(input.Shape(), inputData, device) } }, outputs, device);
+
+        std::vector<std::vector<float>> result;
+        outputs[output]->CopyVariableValueTo(output, result);
+        return result;
+    };
+
+    auto expected = evaluate(model);
+
+    auto context1 = pool->Acquire();
+    auto context2 = pool->Acquire();
+    auto context3 = pool->Acquire();
+    BOOST_TEST(pool->NumberOfContexts() == 3);
+    BOOST_TEST(pool->NumberOfAvailableContexts() == 0);
+    BOOST_TEST(((context1 != context2) && (context2 != context3) && (context1 != context3)));
+
+    // The contexts share the Parameters with the model, but have their own arguments.
+    auto modelParameters = model->Parameters();
+    auto contextParameters = context1->Parameters();
+    BOOST_TEST((std::unordered_set<Parameter>(modelParameters.begin(), modelParameters.end()) == std::unordered_set<Parameter>(contextParameters.begin(), contextParameters.end())));
+    BOOST_TEST((context1->Arguments()[0] != features));
+
+    for (const auto& context : { context1, context2, context3 })
+    {
+        auto result = evaluate(context);
+        for (size_t i = 0; i < numSamples; ++i)
+            FloatingPointVectorCompare(result[i], expected[i], "EvaluationContextPool: the output of the context does not match the model.");
+    }
+
+    // Released contexts are reused.
+    auto context2Ptr = context2.get();
+    context2 = nullptr;
+    BOOST_TEST(pool->NumberOfAvailableContexts() == 1);
+
+    auto context4 = pool->Acquire();
+    BOOST_TEST(context4.get() == context2Ptr);
+    BOOST_TEST(pool->NumberOfContexts() == 3);
+
+    auto result = evaluate(context4);
+    for (size_t i = 0; i < numSamples; ++i)
+        FloatingPointVectorCompare(result[i], expected[i], "EvaluationContextPool: the output of a reused context does not match the model.");
+}
+
+void TestFreezeForInference(const DeviceDescriptor& device)
+{
+    using namespace std::placeholders;
+
+    const size_t inputDim = 20;
+    const size_t numOutputClasses = 7;
+    const size_t numSamples = 5;
+    const size_t maxBatchSize = 8;
+
+    auto features = InputVariable({ inputDim }, DataType::Float, L"features");
+    auto labels = InputVariable({ numOutputClasses }, DataType::Float, L"labels");
+    auto dropout = Dropout(features, 0.5, 5336, L"dropout");
+    auto classifier = FullyConnectedFeedForwardClassifierNet(dropout, numOutputClasses, 32, 2, device, std::bind(Sigmoid, _1, L""), L"classifier");
+
+    // A bias that only depends on Parameters and Constants, which is precomputed by the freezing.
+    auto offset = Parameter({ numOutputClasses }, DataType::Float, 0.25, device, L"offset");
+    auto scale = Constant({ numOutputClasses }, DataType::Float, 2.0, device, L"scale");
+    auto bias = ElementTimes(offset, scale, L"bias");
+    auto output = Plus(classifier, bias, L"output");
+    auto loss = CrossEntropyWithSoftmax(output, labels, L"loss");
+    auto trainingModel = Combine({ loss, output });
+
+    std::vector<float> inputData(inputDim * numSamples);
+    for (size_t i = 0; i < inputData.size(); ++i)
+        inputData[i] = (float)((i * 7) % 13) / 13;
+
+    auto evaluate = [&](const FunctionPtr& function, const Variable& input)
+    {
+        auto functionOutput = function->Output();
+        std::unordered_map<Variable, ValuePtr> outputs{ { functionOutput, nullptr } };
+        function->Evaluate({ { input, Value::CreateBatch(input.Shape(), inputData, device) } }, outputs, device);
+
+        std::vector<std::vector<float>> result;
+        outputs[functionOutput]->CopyVariableValueTo(functionOutput, result);
+        return result;
+    };
+
+    // Dropout is the identity during evaluation.
+    auto expected = evaluate(output, features);
+
+    auto frozenModel = FreezeForInference(trainingModel, { output }, maxBatchSize, device);
+
+    // The criterion and its labels are gone, the Parameters are Constants and the bias has been precomputed.
+    BOOST_TEST(frozenModel->Outputs().size() == 1);
+    BOOST_TEST(frozenModel->Arguments().size() == 1);
+    BOOST_TEST(frozenModel->Parameters().empty());
+    BOOST_TEST(frozenModel->FindByName(L"bias") == nullptr);
+    BOOST_TEST(frozenModel->FindByName(L"loss") == nullptr);
+
+    size_t numDropouts = 0;
+    frozenModel->PreorderTraverse([&numDropouts](const FunctionPtr& function) {
+        if (function->OpName() == L"Dropout")
+            numDropouts++;
+    }, /*traverseInsideBlockFunction =*/ true);
+    BOOST_TEST(numDropouts == 0);
+
+    // The frozen model does not share the Constants with the training model.
+    auto frozenInput = frozenModel->Arguments()[0];
+    for (auto& parameter : trainingModel->Parameters())
+        parameter.SetValue(MakeSharedObject<NDArrayView>(0.0f, parameter.Shape(), device));
+
+    auto result = evaluate(frozenModel, frozenInput);
+    for (size_t i = 0; i < numSamples; ++i)
+        FloatingPointVectorCompare(result[i], expected[i], "FreezeForInference: the output of the frozen model does not match the model.");
+
+    // The frozen model, including its memory plan, survives a save and reload.
+    std::vector<Variable*> variables{ &frozenInput };
+    SaveAndReloadModel<float>(frozenModel, variables, device);
+
+    result = evaluate(frozenModel, frozenInput);
+    for (size_t i = 0; i < numSamples; ++i)
+        FloatingPointVectorCompare(result[i], expected[i], "FreezeForInference: the output of the reloaded frozen model does not match the model.");
+
+    VerifyException([&]() {
+        FreezeForInference(trainingModel, { features });
+    }, "Was able to freeze a model for an output that is an input variable.");
+}
+
+void TestFreezeForInferenceFoldsBatchNormalization(const DeviceDescriptor& device)
+{
+    const size_t numInputChannels = 2;
+    const size_t numFeatureMaps = 4;
+    const size_t numOutputClasses = 5;
+    const size_t imageSize = 6;
+    const size_t numSamples = 3;
+
+    auto constant = [&](const NDShape& shape, float offset)
+    {
+        std::vector<float> data(shape.TotalSize());
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = offset + (float)((i * 5) % 7) / 7;
+        return Constant(MakeSharedObject<NDArrayView>(shape, data)->DeepClone(device));
+    };
+
+    auto features = InputVariable({ imageSize, imageSize, numInputChannels }, DataType::Float, L"features");
+
+    // Convolution followed by a spatial normalization, and a dense layer with bias followed by a per element normalization.
+    auto convolutionMap = Parameter({ 3, 3, numInputChannels, numFeatureMaps }, DataType::Float, GlorotUniformInitializer(), device);
+    auto convolution = Convolution(convolutionMap, features, { 1, 1, numInputChannels });
+    auto convolutionNormalization = BatchNormalization(convolution,
+        constant({ numFeatureMaps }, 0.5f), constant({ numFeatureMaps }, -0.25f), constant({ numFeatureMaps }, 0.1f), constant({ numFeatureMaps }, 0.5f),
+        Constant::Scalar(10.0f, device), /*spatial =*/ true, 5000, 0, 1e-5, /*useCuDNNEngine =*/ false);
+    auto hidden = Reshape(ReLU(convolutionNormalization), { imageSize * imageSize * numFeatureMaps });
+
+    auto weights = Parameter({ numOutputClasses, imageSize * imageSize * numFeatureMaps }, DataType::Float, GlorotUniformInitializer(), device);
+    auto dense = Plus(Times(weights, hidden), Parameter({ numOutputClasses }, 0.3f, device));
+    auto output = BatchNormalization(dense,
+        constant({ numOutputClasses }, 1.0f), constant({ numOutputClasses }, 0.2f), constant({ numOutputClasses }, -0.3f), constant({ numOutputClasses }, 0.75f),
+        Constant::Scalar(10.0f, device), /*spatial =*/ false, 5000, 0, 1e-5, /*useCuDNNEngine =*/ false);
+
+    std::vector<float> inputData(features.Shape().TotalSize() * numSamples);
+    for (size_t i = 0; i < inputData.size(); ++i)
+        inputData[i] = (float)((i * 7) % 13) / 13 - 0.5f;
+
+    auto evaluate = [&](const FunctionPtr& function)
+    {
+        auto input = function->Arguments()[0];
+        auto functionOutput = function->Output();
+        std::unordered_map<Variable, ValuePtr> outputs{ { functionOutput, nullptr } };
+        function->Evaluate({ { input, Value::CreateBatch(input.Shape(), inputData, device) } }, outputs, device);
+
+        std::vector<std::vector<float>> result;
+        outputs[functionOutput]->CopyVariableValueTo(functionOutput, result);
+        return result;
+    };
+
+    auto expected = evaluate(output);
+
+    auto frozenModel = FreezeForInference(output, {}, 0, device);
+
+    size_t numNormalizations = 0;
+    frozenModel->PreorderTraverse([&numNormalizations](const FunctionPtr& function) {
+        if (function->OpName() == L"BatchNormalization")
+            numNormalizations++;
+    }, /*traverseInsideBlockFunction =*/ true);
+    BOOST_TEST(numNormalizations == 0);
+
+    auto result = evaluate(frozenModel);
+    for (size_t i = 0; i < numSamples; ++i)
+        FloatingPointVectorCompare(result[i], expected[i], "FreezeForInference: the output of the model with folded batch normalization does not match the model.");
+}
+
+void TestFreezeForInferenceFusesTimesPlusActivation(const DeviceDescriptor& device)
+{
+    const size_t inputDim = 10;
+    const size_t hiddenDim = 300;
+    const size_t outputDim = 4;
+    const size_t numSamples = 200;
+
+    auto features = InputVariable({ inputDim }, DataType::Float, L"features");
+    auto dense = [&](const Variable& input, size_t outputDim, bool biasFirst, const std::function<FunctionPtr(const Variable&)>& activation)
+    {
+        auto weights = Parameter({ outputDim, input.Shape()[0] }, DataType::Float, GlorotUniformInitializer(), device);
+        auto bias = Parameter({ outputDim }, DataType::Float, UniformInitializer(1.0), device);
+        auto product = Times(weights, input);
+        return activation(biasFirst ? Plus(bias, product) : Plus(product, bias));
+    };
+
+    // The sum of the last layer is an output as well, hence it is not fused.
+    auto hidden = dense(dense(features, hiddenDim, false, [](const Variable& x) { return ReLU(x); }), hiddenDim, true, [](const Variable& x) { return Sigmoid(x); });
+    auto sum = Plus(Times(Parameter({ outputDim, hiddenDim }, DataType::Float, GlorotUniformInitializer(), device), hidden), Parameter({ outputDim }, 0.1f, device), L"sum");
+    auto model = Combine({ Tanh(sum, L"output"), sum });
+
+    std::vector<float> inputData(inputDim * numSamples);
+    for (size_t i = 0; i < inputData.size(); ++i)
+        inputData[i] = (float)((i * 7) % 13) / 13 - 0.5f;
+
+    auto evaluate = [&](const FunctionPtr& function)
+    {
+        auto input = function->Arguments()[0];
+        std::unordered_map<Variable, ValuePtr> outputs;
+        for (const auto& output : function->Outputs())
+            outputs.insert({ output, nullptr });
+        function->Evaluate({ { input, Value::CreateBatch(input.Shape(), inputData, device) } }, outputs, device);
+
+        std::vector<std::vector<std::vector<float>>> result;
+        for (const auto& output : function->Outputs())
+        {
+            result.push_back({});
+            outputs[output]->CopyVariableValueTo(output, result.back());
+        }
+        return result;
+    };
+
+    auto expected = evaluate(model);
+
+    auto frozenModel = FreezeForInference(model, {}, 0, device);
+    auto result = evaluate(frozenModel);
+    for (size_t i = 0; i < result.size(); ++i)
+        for (size_t j = 0; j < numSamples; ++j)
+            FloatingPointVectorCompare(result[i][j], expected[i][j], "FreezeForInference: the output of the model with fused dense layers does not match the model.");
+
+    result = evaluate(frozenModel->Clone(ParameterCloningMethod::Share));
+    for (size_t i = 0; i < result.size(); ++i)
+        for (size_t j = 0; j < numSamples; ++j)
+            FloatingPointVectorCompare(result[i][j], expected[i][j], "FreezeForInference: the output of the clone of the model with fused dense layers does not match the model.");
+}
+
 BOOST_AUTO_TEST_SUITE(FunctionSuite)
 
 BOOST_AUTO_TEST_CASE(FindNameInCPU)
@@ -1334,6 +1599,38 @@ BOOST_AUTO_TEST_CASE(MatMul)
         TestMatMul(DeviceDescriptor::GPUDevice(0));
 }
 
+BOOST_AUTO_TEST_CASE(EvaluationContextPool)
+{
+    if (ShouldRunOnCpu())
+        TestEvaluationContextPool(DeviceDescriptor::CPUDevice());
+    if (ShouldRunOnGpu())
+        TestEvaluationContextPool(DeviceDescriptor::GPUDevice(0));
+}
+
+BOOST_AUTO_TEST_CASE(FreezeForInference)
+{
+    if (ShouldRunOnCpu())
+        TestFreezeForInference(DeviceDescriptor::CPUDevice());
+    if (ShouldRunOnGpu())
+        TestFreezeForInference(DeviceDescriptor::GPUDevice(0));
+}
+
+BOOST_AUTO_TEST_CASE(FreezeForInferenceFoldsBatchNormalization)
+{
+    if (ShouldRunOnCpu())
+        TestFreezeForInferenceFoldsBatchNormalization(DeviceDescriptor::CPUDevice());
+    if (ShouldRunOnGpu())
+        TestFreezeForInferenceFoldsBatchNormalization(DeviceDescriptor::GPUDevice(0));
+}
+
+BOOST_AUTO_TEST_CASE(FreezeForInferenceFusesTimesPlusActivation)
+{
+    if (ShouldRunOnCpu())
+        TestFreezeForInferenceFusesTimesPlusActivation(DeviceDescriptor::CPUDevice());
+    if (ShouldRunOnGpu())
+        TestFreezeForInferenceFusesTimesPlusActivation(DeviceDescriptor::GPUDevice(0));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }}
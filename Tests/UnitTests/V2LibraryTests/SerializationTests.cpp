@@ -371,6 +371,18 @@ std::shared_ptr<std::fstream> GetFstream(const std::wstring& filePath, bool read
 #endif
 }
 
+std::string ReadFileContent(const std::wstring& filePath)
+{
+    auto stream = GetFstream(filePath, true);
+    return std::string(std::istreambuf_iterator<char>(*stream), std::istreambuf_iterator<char>());
+}
+
+void WriteFileContent(const std::wstring& filePath, const std::string& content)
+{
+    auto stream = GetFstream(filePath, false);
+    stream->write(content.data(), content.size());
+}
+
 void ForceInitParameters(FunctionPtr f) 
 {
     for (const auto& p : f->Parameters()) 
@@ -462,6 +474,50 @@ void TestFunctionSerialization(const DeviceDescriptor& device)
     TestFunctionSaveAndLoad(BuildLSTMClassifierNet(inputVar, 5, device), device);
 }
 
+void TestMappedModelSaveAndLoad(const DeviceDescriptor& device)
+{
+    auto file = L"TestMappedModelSaveAndLoad.out";
+    auto inputVar = InputVariable({ 20 }, DataType::Float, L"features");
+    auto function = BuildLSTMClassifierNet(inputVar, 5, device);
+
+    function->Save(file, ModelFormat::CNTKv2Mapped);
+
+    auto reloadedFunction = Function::Load(file, device, ModelFormat::CNTKv2Mapped);
+    if (!AreEqual(function, reloadedFunction))
+        BOOST_ERROR("TestMappedModelSaveAndLoad: original and reloaded functions are not identical.");
+
+    if (device.Type() == DeviceKind::CPU)
+    {
+        for (const auto& parameter : reloadedFunction->Parameters())
+        {
+            if (reinterpret_cast<uintptr_t>(parameter.Value()->DataBuffer<float>()) % 64 != 0)
+                BOOST_ERROR("TestMappedModelSaveAndLoad: parameter values of a memory-mapped model are not aligned.");
+        }
+    }
+
+    // Parameters of a mapped model are copy-on-write, updating them must not change the file.
+    for (const auto& parameter : reloadedFunction->Parameters())
+        parameter.Value()->SetValue(1.0f);
+
+    auto secondReloadedFunction = Function::Load(file, device, ModelFormat::CNTKv2Mapped);
+    if (!AreEqual(function, secondReloadedFunction))
+        BOOST_ERROR("TestMappedModelSaveAndLoad: updating the parameters of a memory-mapped model changed the model file.");
+
+#ifndef _WIN32
+    // Saving another model to the file of a loaded one replaces the file, instead of overwriting the mapped parameters.
+    BuildFFClassifierNet(inputVar, 5, device)->Save(file, ModelFormat::CNTKv2Mapped);
+    if (!AreEqual(function, secondReloadedFunction))
+        BOOST_ERROR("TestMappedModelSaveAndLoad: saving over the file of a memory-mapped model changed the loaded model.");
+#endif
+
+    // A regular model is not a memory-mapped one.
+    auto regularFile = L"TestMappedModelSaveAndLoad.v2.out";
+    function->Save(regularFile);
+    VerifyException([&regularFile, &device]() {
+        Function::Load(regularFile, device, ModelFormat::CNTKv2Mapped);
+    }, "Was able to load a CNTKv2 model as a memory-mapped model.");
+}
+
 TrainerPtr BuildTrainer(const FunctionPtr& function, const Variable& labels,
                      LearningRateSchedule lr = LearningRateSchedule(0.005, 1),
                      MomentumSchedule m = MomentumAsTimeConstantSchedule(0.0))
@@ -548,7 +604,7 @@ void TestModelSerializationDuringTraining(const DeviceDescriptor& device)
 }
 
 
-void TestTrainingWithCheckpointing(const FunctionPtr& function1, const FunctionPtr& function2, const Variable& labels, const MinibatchSourcePtr& minibatchSource, const DeviceDescriptor& device)
+void TestTrainingWithCheckpointing(const FunctionPtr& function1, const FunctionPtr& function2, const Variable& labels, const MinibatchSourcePtr& minibatchSource, const DeviceDescriptor& device, CheckpointFormat format = CheckpointFormat::CNTKv2)
 {
     auto featureStreamInfo = minibatchSource->StreamInfo(function1->Arguments()[0]);
     auto labelStreamInfo = minibatchSource->StreamInfo(labels);
@@ -566,7 +622,7 @@ void TestTrainingWithCheckpointing(const FunctionPtr& function1, const FunctionP
 
     assert(AreEqual(function1, function2));
 
-    trainer2->SaveCheckpoint(L"trainer.v2.checkpoint");
+    trainer2->SaveCheckpoint(L"trainer.v2.checkpoint", Dictionary(), format);
     trainer2->RestoreFromCheckpoint(L"trainer.v2.checkpoint");
 
     if (!AreEqual(function1, function2))
@@ -590,7 +646,7 @@ void TestTrainingWithCheckpointing(const FunctionPtr& function1, const FunctionP
 
     for (int i = 0; i < 3; ++i)
     {
-        trainer2->SaveCheckpoint(L"trainer.v2.checkpoint");
+        trainer2->SaveCheckpoint(L"trainer.v2.checkpoint", Dictionary(), format);
         trainer2->RestoreFromCheckpoint(L"trainer.v2.checkpoint");
 
         if (!AreEqual(function1, function2))
@@ -610,7 +666,7 @@ void TestTrainingWithCheckpointing(const FunctionPtr& function1, const FunctionP
     }
 }
 
-void TestCheckpointing(const DeviceDescriptor& device)
+void TestCheckpointing(const DeviceDescriptor& device, CheckpointFormat format = CheckpointFormat::CNTKv2)
 {
     auto featureStreamName = L"features";
     auto labelsStreamName = L"labels";
@@ -639,7 +695,7 @@ void TestCheckpointing(const DeviceDescriptor& device)
 
     auto minibatchSource1 = TextFormatMinibatchSource(L"Train-28x28_cntk_text.txt", { { featureStreamName, inputDim }, { labelsStreamName, numOutputClasses } },  1000, false);
 
-    TestTrainingWithCheckpointing(net1_1, net1_2, labels1, minibatchSource1, device);
+    TestTrainingWithCheckpointing(net1_1, net1_2, labels1, minibatchSource1, device, format);
 
     inputDim = 2000;
     numOutputClasses = 5;
@@ -665,7 +721,202 @@ void TestCheckpointing(const DeviceDescriptor& device)
 
     auto minibatchSource2 = TextFormatMinibatchSource(L"Train.ctf", { { featureStreamName, inputDim, true, L"x" }, {  labelsStreamName, numOutputClasses, false, L"y" } }, 1000, false);
 
-    TestTrainingWithCheckpointing(net2_1, net2_2, labels2, minibatchSource2, device);
+    TestTrainingWithCheckpointing(net2_1, net2_2, labels2, minibatchSource2, device, format);
+}
+
+void TestAsyncCheckpointing(const DeviceDescriptor& device)
+{
+    auto featureStreamName = L"features";
+    auto labelsStreamName = L"labels";
+    size_t inputDim = 784;
+    size_t numOutputClasses = 10;
+    auto features = InputVariable({ inputDim }, DataType::Float, featureStreamName);
+    auto labels = InputVariable({ numOutputClasses }, DataType::Float, labelsStreamName);
+    auto net1 = BuildFFClassifierNet(features, numOutputClasses, device, 1);
+    auto net2 = net1->Clone();
+
+    auto minibatchSource = TextFormatMinibatchSource(L"Train-28x28_cntk_text.txt", { { featureStreamName, inputDim }, { labelsStreamName, numOutputClasses } }, 1000, false);
+    auto featureStreamInfo = minibatchSource->StreamInfo(features);
+    auto labelStreamInfo = minibatchSource->StreamInfo(labels);
+    auto minibatchData = minibatchSource->GetNextMinibatch(50, device);
+
+    auto trainer1 = BuildTrainer(net1, labels, LearningRateSchedule(0.005, 1), MomentumAsTimeConstantSchedule(100));
+    auto trainer2 = BuildTrainer(net2, labels, LearningRateSchedule(0.005, 1), MomentumAsTimeConstantSchedule(100));
+
+    trainer1->TrainMinibatch({ { features, minibatchData[featureStreamInfo] }, { labels, minibatchData[labelStreamInfo] } }, device);
+    trainer2->TrainMinibatch({ { features, minibatchData[featureStreamInfo] }, { labels, minibatchData[labelStreamInfo] } }, device);
+
+    // Training continues while the checkpoint is written, the checkpoint holds the state at the time of the call.
+    const std::wstring checkpointFile = L"trainer.v2.async.checkpoint";
+    trainer2->SaveCheckpointAsync(checkpointFile);
+    trainer2->TrainMinibatch({ { features, minibatchData[featureStreamInfo] }, { labels, minibatchData[labelStreamInfo] } }, device);
+    trainer2->WaitForPendingCheckpoint();
+
+    trainer2->RestoreFromCheckpoint(checkpointFile);
+    if (!AreEqual(net1, net2))
+        BOOST_ERROR("TestAsyncCheckpointing: the checkpoint does not hold the model at the time it was taken.");
+
+    for (int i = 0; i < 3; ++i)
+    {
+        trainer1->TrainMinibatch({ { features, minibatchData[featureStreamInfo] }, { labels, minibatchData[labelStreamInfo] } }, device);
+        trainer2->TrainMinibatch({ { features, minibatchData[featureStreamInfo] }, { labels, minibatchData[labelStreamInfo] } }, device);
+
+        FloatingPointCompare(trainer1->PreviousMinibatchLossAverage(), trainer2->PreviousMinibatchLossAverage(),
+                             "Post checkpoint restoration training loss does not match expectation");
+    }
+
+    // Only one checkpoint is written at a time, a second one waits for the first.
+    trainer2->SaveCheckpointAsync(checkpointFile, Dictionary(), CheckpointFormat::CNTKv2Streaming);
+    trainer2->SaveCheckpointAsync(checkpointFile);
+    trainer2->RestoreFromCheckpoint(checkpointFile);
+    if (!AreEqual(net1, net2))
+        BOOST_ERROR("TestAsyncCheckpointing: original and reloaded functions are not identical.");
+}
+
+void TestDeltaCheckpointing(const DeviceDescriptor& device)
+{
+    auto featureStreamName = L"features";
+    auto labelsStreamName = L"labels";
+    size_t inputDim = 2000;
+    size_t numOutputClasses = 5;
+    auto features = InputVariable({ inputDim }, true /*isSparse*/, DataType::Float, featureStreamName);
+    auto labels = InputVariable({ numOutputClasses }, DataType::Float, labelsStreamName, { Axis::DefaultBatchAxis() });
+    auto net1 = BuildLSTMClassifierNet(features, numOutputClasses, device, 1);
+    auto net2 = net1->Clone();
+
+    auto minibatchSource = TextFormatMinibatchSource(L"Train.ctf", { { featureStreamName, inputDim, true, L"x" }, { labelsStreamName, numOutputClasses, false, L"y" } }, 1000, false);
+    auto featureStreamInfo = minibatchSource->StreamInfo(features);
+    auto labelStreamInfo = minibatchSource->StreamInfo(labels);
+
+    // The embedding of the sparse input receives sparse block column gradients, so only the columns seen in the data change.
+    auto trainer1 = BuildTrainer(net1, labels, LearningRateSchedule(0.005, 1), MomentumAsTimeConstantSchedule(100));
+    auto trainer2 = BuildTrainer(net2, labels, LearningRateSchedule(0.005, 1), MomentumAsTimeConstantSchedule(100));
+
+    const std::wstring checkpointFile = L"trainer.v2.delta.checkpoint";
+    const std::wstring deltaFile = checkpointFile + L".delta";
+    _wunlink(deltaFile.c_str());
+
+    // The first call writes a full checkpoint, the next two calls only write the delta and the fourth one compacts.
+    const size_t compactionPeriod = 2;
+    std::string baseModel;
+    for (size_t i = 0; i <= compactionPeriod + 1; ++i)
+    {
+        auto minibatchData = minibatchSource->GetNextMinibatch(50, device);
+        trainer1->TrainMinibatch({ { features, minibatchData[featureStreamInfo] }, { labels, minibatchData[labelStreamInfo] } }, device);
+        trainer2->TrainMinibatch({ { features, minibatchData[featureStreamInfo] }, { labels, minibatchData[labelStreamInfo] } }, device);
+
+        Dictionary externalState;
+        externalState[L"step"] = i;
+        trainer2->SaveDeltaCheckpoint(checkpointFile, externalState, compactionPeriod);
+
+        bool fullCheckpoint = (i == 0 || i > compactionPeriod);
+        if (fullCheckpoint == (ReadFileContent(checkpointFile) == baseModel))
+            BOOST_ERROR("TestDeltaCheckpointing: the full checkpoint was not written at the expected time.");
+        baseModel = ReadFileContent(checkpointFile);
+
+        // Move away from the checkpointed state and restore it.
+        minibatchData = minibatchSource->GetNextMinibatch(50, device);
+        trainer2->TrainMinibatch({ { features, minibatchData[featureStreamInfo] }, { labels, minibatchData[labelStreamInfo] } }, device);
+
+        auto restoredState = trainer2->RestoreFromCheckpoint(checkpointFile);
+        if (!restoredState.Contains(L"step") || restoredState[L"step"].Value<size_t>() != i)
+            BOOST_ERROR("TestDeltaCheckpointing: the external state was not restored.");
+
+        if (!AreEqual(net1, net2))
+            BOOST_ERROR("TestDeltaCheckpointing: original and reloaded functions are not identical.");
+    }
+
+    VerifyException([&]() { ReadFileContent(deltaFile); }, "Was able to read the delta checkpoint that should have been removed by the compaction.");
+
+    for (int i = 0; i < 3; ++i)
+    {
+        auto minibatchData = minibatchSource->GetNextMinibatch(50, device);
+        trainer1->TrainMinibatch({ { features, minibatchData[featureStreamInfo] }, { labels, minibatchData[labelStreamInfo] } }, device);
+        trainer2->TrainMinibatch({ { features, minibatchData[featureStreamInfo] }, { labels, minibatchData[labelStreamInfo] } }, device);
+
+        FloatingPointCompare(trainer1->PreviousMinibatchLossAverage(), trainer2->PreviousMinibatchLossAverage(),
+                             "Post checkpoint restoration training loss does not match expectation");
+    }
+}
+
+void TestDeltaCheckpointingOfWideParameter(const DeviceDescriptor& device)
+{
+    // The gather/scatter kernels take column indices as floats, which are not exact beyond 2^24.
+    const size_t inputDim = (1 << 24) + 16;
+    auto input = InputVariable({ inputDim }, true /*isSparse*/, DataType::Float, L"input");
+    auto embedding = Parameter({ 1, inputDim }, DataType::Float, 0.5, device, L"embedding");
+    auto output = Times(embedding, input, L"output");
+    auto trainer = CreateTrainer(output, output, { SGDLearner({ embedding }, LearningRateSchedule(0.1, 1)) });
+
+    auto train = [&](const std::vector<size_t>& columns)
+    {
+        trainer->TrainMinibatch({ { input, Value::CreateBatch<float>(inputDim, columns, device) } }, device);
+    };
+
+    const std::wstring checkpointFile = L"trainer.v2.delta.wide.checkpoint";
+    const std::wstring deltaFile = checkpointFile + L".delta";
+    _wunlink(deltaFile.c_str());
+
+    trainer->SaveDeltaCheckpoint(checkpointFile, Dictionary(), /*compactionPeriod =*/ 2);
+    train({ 5, inputDim - 3 });
+    trainer->SaveDeltaCheckpoint(checkpointFile, Dictionary(), /*compactionPeriod =*/ 2);
+    auto expected = embedding.Value()->DeepClone();
+
+    // Only the two updated columns are stored, not the 64MB of the whole parameter.
+    if (ReadFileContent(deltaFile).size() > (1 << 20))
+        BOOST_ERROR("TestDeltaCheckpointingOfWideParameter: the delta holds the whole parameter.");
+
+    train({ inputDim - 3, inputDim - 1 });
+    trainer->RestoreFromCheckpoint(checkpointFile);
+    if (!AreEqual(expected, embedding.Value()))
+        BOOST_ERROR("TestDeltaCheckpointingOfWideParameter: the columns beyond 2^24 were not restored.");
+}
+
+void TestStreamingCheckpointIntegrity(const DeviceDescriptor& device)
+{
+    auto features = InputVariable({ 784 }, DataType::Float, L"features");
+    auto labels = InputVariable({ 10 }, DataType::Float, L"labels");
+    auto net = BuildFFClassifierNet(features, 10, device, 1);
+    auto trainer = BuildTrainer(net, labels, LearningRateSchedule(0.005, 1), MomentumAsTimeConstantSchedule(100));
+
+    std::vector<NDArrayViewPtr> valuesBeforeSaving;
+    for (const auto& parameter : net->Parameters())
+        valuesBeforeSaving.push_back(parameter.Value()->DeepClone());
+
+    const std::wstring checkpointFile = L"trainer.v2.streaming.checkpoint";
+    trainer->SaveCheckpoint(checkpointFile, Dictionary(), CheckpointFormat::CNTKv2StreamingCompressed);
+
+    // The checkpoint is written straight from the live parameters, which are left intact.
+    size_t i = 0;
+    for (const auto& parameter : net->Parameters())
+    {
+        if (!AreEqual(valuesBeforeSaving[i++], parameter.Value()))
+            BOOST_ERROR("TestStreamingCheckpointIntegrity: saving the checkpoint changed the value of a parameter.");
+    }
+
+    // The model file of a streaming checkpoint can be loaded as a regular model.
+    auto loaded = Function::Load(checkpointFile, device);
+    if (!AreEqual(net, loaded))
+        BOOST_ERROR("TestStreamingCheckpointIntegrity: the model of the checkpoint is not identical to the original.");
+
+    // Flip a byte of the first tensor record: its checksum no longer matches.
+    auto content = ReadFileContent(checkpointFile);
+    content[16] ^= 0x5a;
+    WriteFileContent(checkpointFile, content);
+
+    VerifyException([&trainer, &checkpointFile]() {
+        trainer->RestoreFromCheckpoint(checkpointFile);
+    }, "Was able to restore from a corrupt streaming checkpoint.");
+
+    // A truncated file (e.g. the writer died) is detected as well.
+    trainer->SaveCheckpoint(checkpointFile, Dictionary(), CheckpointFormat::CNTKv2Streaming);
+    content = ReadFileContent(checkpointFile);
+    content.pop_back();
+    WriteFileContent(checkpointFile, content);
+
+    VerifyException([&trainer, &checkpointFile]() {
+        trainer->RestoreFromCheckpoint(checkpointFile);
+    }, "Was able to restore from a truncated streaming checkpoint.");
 }
 
 
@@ -1024,6 +1275,11 @@ BOOST_AUTO_TEST_CASE(FunctionSerializationInCPU)
     TestFunctionSerialization(DeviceDescriptor::CPUDevice());
 }
 
+BOOST_AUTO_TEST_CASE(MappedModelSaveAndLoadInCPU)
+{
+    TestMappedModelSaveAndLoad(DeviceDescriptor::CPUDevice());
+}
+
 BOOST_AUTO_TEST_CASE(ModelSerializationDuringTrainingInCPU)
 {
     TestModelSerializationDuringTraining(DeviceDescriptor::CPUDevice());
@@ -1034,6 +1290,24 @@ BOOST_AUTO_TEST_CASE(CheckpointingInCPU)
     TestCheckpointing(DeviceDescriptor::CPUDevice());
 }
 
+BOOST_AUTO_TEST_CASE(StreamingCheckpointingInCPU)
+{
+    TestCheckpointing(DeviceDescriptor::CPUDevice(), CheckpointFormat::CNTKv2Streaming);
+    TestCheckpointing(DeviceDescriptor::CPUDevice(), CheckpointFormat::CNTKv2StreamingCompressed);
+    TestStreamingCheckpointIntegrity(DeviceDescriptor::CPUDevice());
+}
+
+BOOST_AUTO_TEST_CASE(AsyncCheckpointingInCPU)
+{
+    TestAsyncCheckpointing(DeviceDescriptor::CPUDevice());
+}
+
+BOOST_AUTO_TEST_CASE(DeltaCheckpointingInCPU)
+{
+    TestDeltaCheckpointing(DeviceDescriptor::CPUDevice());
+    TestDeltaCheckpointingOfWideParameter(DeviceDescriptor::CPUDevice());
+}
+
 BOOST_AUTO_TEST_CASE(LegacyModelSavingInCPU)
 {
     TestLegacyModelSaving(DeviceDescriptor::CPUDevice());
@@ -1077,6 +1351,12 @@ BOOST_AUTO_TEST_CASE(FunctionSerializationInGPU)
     }
 }
 
+BOOST_AUTO_TEST_CASE(MappedModelSaveAndLoadInGPU)
+{
+    if (ShouldRunOnGpu())
+        TestMappedModelSaveAndLoad(DeviceDescriptor::GPUDevice(0));
+}
+
 BOOST_AUTO_TEST_CASE(ModelSerializationDuringTrainingInGPU)
 {
     if (ShouldRunOnGpu())
@@ -1091,6 +1371,27 @@ BOOST_AUTO_TEST_CASE(CheckpointingInGPU)
         TestCheckpointing(DeviceDescriptor::GPUDevice(0));
 }
 
+BOOST_AUTO_TEST_CASE(StreamingCheckpointingInGPU)
+{
+    if (ShouldRunOnGpu())
+        TestCheckpointing(DeviceDescriptor::GPUDevice(0), CheckpointFormat::CNTKv2StreamingCompressed);
+}
+
+BOOST_AUTO_TEST_CASE(AsyncCheckpointingInGPU)
+{
+    if (ShouldRunOnGpu())
+        TestAsyncCheckpointing(DeviceDescriptor::GPUDevice(0));
+}
+
+BOOST_AUTO_TEST_CASE(DeltaCheckpointingInGPU)
+{
+    if (ShouldRunOnGpu())
+    {
+        TestDeltaCheckpointing(DeviceDescriptor::GPUDevice(0));
+        TestDeltaCheckpointingOfWideParameter(DeviceDescriptor::GPUDevice(0));
+    }
+}
+
 
 BOOST_AUTO_TEST_CASE(LegacyModelSavingInGPU)
 {
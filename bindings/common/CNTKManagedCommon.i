@@ -132,6 +132,7 @@ SWIG_STD_VECTOR_ENHANCED(CNTK::Learner)
 %shared_ptr(CNTK::Trainer);
 %shared_ptr(CNTK::MinibatchSource);
 %shared_ptr(CNTK::Evaluator);
+%shared_ptr(CNTK::EvaluationContextPool);
 %template(UnsignedCharVector) std::vector<unsigned char>;
 %template(DictionaryVector) std::vector<CNTK::Dictionary>;
 %template (UnorderedMapStreamInformationMinibatchData) std::unordered_map<CNTK::StreamInformation, CNTK::MinibatchData>;
@@ -236,6 +237,7 @@ IGNORE_CLASS CNTK::DistributedLearner;
 IGNORE_FUNCTION CNTK::CreateDataParallelDistributedLearner;
 IGNORE_FUNCTION CNTK::CreateQuantizedDataParallelDistributedLearner;
 IGNORE_FUNCTION CNTK::CreateBlockMomentumDistributedLearner;
+IGNORE_FUNCTION CNTK::CreateModelAveragingDistributedLearner;
 IGNORE_STRUCT std::hash<::CNTK::StreamInformation>;
 %ignore operator==(const StreamInformation& left, const StreamInformation& right);
 IGNORE_STRUCT CNTK::DistributedWorkerDescriptor;
@@ -243,10 +245,12 @@ IGNORE_STRUCT CNTK::DistributedWorkerDescriptor;
 IGNORE_CLASS CNTK::DistributedCommunicator;
 IGNORE_CLASS CNTK::QuantizedDistributedCommunicator;
 IGNORE_FUNCTION CNTK::MPICommunicator;
+IGNORE_FUNCTION CNTK::CompressedMPICommunicator;
 IGNORE_FUNCTION CNTK::QuantizedMPICommunicator;
 IGNORE_STRUCT CNTK::CrossValidationConfig;
 IGNORE_STRUCT CNTK::CheckpointConfig;
 IGNORE_STRUCT CNTK::TestConfig;
+IGNORE_STRUCT CNTK::ElasticConfig;
 IGNORE_CLASS CNTK::TrainingSession;
 IGNORE_FUNCTION CNTK::CreateBasicTrainingSession;
 IGNORE_FUNCTION CNTK::CreateTrainingSession;
@@ -294,6 +298,10 @@ IGNORE_FUNCTION CNTK::Internal::EnableForwardValuesSharing;
 IGNORE_FUNCTION CNTK::Internal::DisableForwardValuesSharing;
 IGNORE_FUNCTION CNTK::Internal::EnableGradientAccumulationOptimization;
 IGNORE_FUNCTION CNTK::Internal::DisableGradientAccumulationOptimization;
+IGNORE_FUNCTION CNTK::Internal::EnableParallelNodeEvaluation;
+IGNORE_FUNCTION CNTK::Internal::DisableParallelNodeEvaluation;
+IGNORE_FUNCTION CNTK::Internal::EnableSmallFilterConvolution;
+IGNORE_FUNCTION CNTK::Internal::DisableSmallFilterConvolution;
 %ignore CNTK::Internal::DefaultProfilerBufferSize;
 IGNORE_FUNCTION CNTK::Internal::StartProfiler;
 IGNORE_FUNCTION CNTK::Internal::StopProfiler;
@@ -307,6 +315,7 @@ IGNORE_FUNCTION CNTK::Internal::PrintBuiltInfo;
 IGNORE_FUNCTION CNTK::Internal::PrintGpuInfo;
 IGNORE_FUNCTION CNTK::Internal::SetMPIPackThreshold;
 IGNORE_FUNCTION CNTK::Internal::GetMPIPackThreshold;
+IGNORE_FUNCTION CNTK::Internal::EnableConcurrentMPICalls;
 IGNORE_FUNCTION CNTK::Internal::ToDictionary;
 IGNORE_CLASS CNTK::Internal::TensorBoardFileWriter;
 // suppress SWIG warning 302: Identifier redefined.
@@ -673,6 +682,8 @@ MAKE_GETTER(CNTK::Axis, StaticAxisIndex);
 %rename (toString) CNTK::NDArrayView::AsString;
 IGNORE_CLASS CNTK::Evaluator;
 IGNORE_FUNCTION CNTK::CreateEvaluator;
+IGNORE_CLASS CNTK::EvaluationContextPool;
+IGNORE_FUNCTION CNTK::CreateEvaluationContextPool;
 #else
 %rename(SequenceIsFirst) CNTK::Sequence::IsFirst;
 %rename(SequenceIsLast) CNTK::Sequence::IsLast;
@@ -1483,6 +1483,7 @@ std::unordered_map<CNTK::StreamInformation, std::pair<CNTK::NDArrayViewPtr, CNTK
 
 %shared_ptr(CNTK::IDictionarySerializable)
 %shared_ptr(CNTK::Evaluator)
+%shared_ptr(CNTK::EvaluationContextPool)
 %shared_ptr(CNTK::Trainer)
 %shared_ptr(CNTK::TrainingSession)
 %shared_ptr(CNTK::Function)
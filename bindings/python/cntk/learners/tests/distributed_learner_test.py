@@ -31,20 +31,22 @@ def mpiexec_execute(script, mpiexec_params, params, timeout_seconds=TIMEOUT_SECO
     return str_out
 
 BlockMomentumConfig = collections.namedtuple('BlockMomentumConfig', 'block_momentum_as_time_constant block_learning_rate block_size distributed_after')
-DataParallelConfig = collections.namedtuple('DataParallelConfig', 'num_quantization_bits distributed_after')
+DataParallelConfig = collections.namedtuple('DataParallelConfig', 'num_quantization_bits distributed_after compression')
+ModelAveragingConfig = collections.namedtuple('ModelAveragingConfig', 'sync_period max_staleness distributed_after')
     
 class SimpleTrainer:
-    def __init__(self, mode, config):
-        self.create_model()
+    def __init__(self, mode, config, output_scale=1):
+        self.create_model(output_scale)
         self.create_trainer(mode, config)
         
-    def create_model(self):
+    def create_model(self, output_scale):
         self.input_dim = 1000
         self.embed_dim = 30
         i = C.input_variable((self.input_dim,), is_sparse=True)
         self.p = C.parameter(shape=(self.input_dim, self.embed_dim), init=1)
         o = C.times(i, self.p)
-        self.z = C.reduce_sum(o)
+        # the scale sets the magnitude of the gradients
+        self.z = C.reduce_sum(o) * output_scale if output_scale != 1 else C.reduce_sum(o)
 
     def create_trainer(self, mode, config):
         learner = self.create_distributed_learner(mode, config)
@@ -55,13 +57,17 @@ class SimpleTrainer:
         try:
             if mode == 'data_parallel':
                 if config is None:
-                    config = DataParallelConfig(num_quantization_bits=32, distributed_after=0)
-                learner = C.data_parallel_distributed_learner(local_learner, num_quantization_bits=config.num_quantization_bits, distributed_after=config.distributed_after)
+                    config = DataParallelConfig(num_quantization_bits=32, distributed_after=0, compression=None)
+                learner = C.data_parallel_distributed_learner(local_learner, num_quantization_bits=config.num_quantization_bits, distributed_after=config.distributed_after, compression=config.compression)
             elif mode == 'block_momentum':
                 if config is None:
                     # the default config to match data parallel SGD
                     config = BlockMomentumConfig(block_momentum_as_time_constant=0, block_learning_rate=1, block_size=NUM_WORKERS, distributed_after=0)
                 learner = C.block_momentum_distributed_learner(local_learner, block_momentum_as_time_constant=config.block_momentum_as_time_constant, block_learning_rate=config.block_learning_rate, block_size=config.block_size, distributed_after=config.distributed_after)
+            elif mode == 'model_averaging':
+                if config is None:
+                    config = ModelAveragingConfig(sync_period=1, max_staleness=0, distributed_after=0)
+                learner = C.model_averaging_distributed_learner(local_learner, sync_period=config.sync_period, max_staleness=config.max_staleness, distributed_after=config.distributed_after)
             else:
                 learner = local_learner
         except RuntimeError:
@@ -75,7 +81,7 @@ class SimpleTrainer:
 def set_np_random_seed(rank, batch):
     np.random.seed(rank + 10 * batch)
         
-def distributed_worker(outdir, gpu, mode, config):
+def distributed_worker(outdir, gpu, mode, config, output_scale=1):
     if gpu:
         # test with only one GPU
         C.try_set_default_device(C.gpu(0))
@@ -85,7 +91,7 @@ def distributed_worker(outdir, gpu, mode, config):
         # For CPU build it's disabled by default
         C.cntk_py.use_sparse_gradient_aggregation_in_data_parallel_sgd(False)
 
-    trainer = SimpleTrainer(mode, config)
+    trainer = SimpleTrainer(mode, config, output_scale)
     for batch in range(NUM_BATCHES):
         set_np_random_seed(C.Communicator.rank(), batch)
         indices = (np.random.random((BATCH_SIZE_PER_WORKER,))*(trainer.input_dim-1)).astype(np.int)
@@ -98,11 +104,35 @@ def distributed_worker(outdir, gpu, mode, config):
     trainer.trainer.save_checkpoint(os.path.join(outdir, mode+'_last'))
     np.save(os.path.join(outdir, mode+str(C.Communicator.rank())), trainer.p.value)
 
+def distributed_worker_with_evaluation(outdir, gpu, mode, config):
+    if gpu:
+        C.try_set_default_device(C.gpu(0))
+    else:
+        C.cntk_py.use_sparse_gradient_aggregation_in_data_parallel_sgd(False)
+
+    trainer = SimpleTrainer(mode, config)
+    evaluator = C.eval.Evaluator(trainer.z)
+    results = []
+    for batch in range(NUM_BATCHES):
+        set_np_random_seed(C.Communicator.rank(), batch)
+        indices = (np.random.random((BATCH_SIZE_PER_WORKER,))*(trainer.input_dim-1)).astype(np.int)
+        data = C.Value.one_hot(indices, num_classes=trainer.input_dim)
+        trainer.trainer.train_minibatch(data)
+        # distributed evaluation on the training thread while an averaging round is in flight
+        results.append(evaluator.test_minibatch(data, distributed=True))
+
+    trainer.trainer.save_checkpoint(os.path.join(outdir, mode+'_last'))
+    np.save(os.path.join(outdir, mode+str(C.Communicator.rank())), trainer.p.value)
+    np.save(os.path.join(outdir, mode+'_eval'+str(C.Communicator.rank())), np.asarray(results))
+
 TRAINING_SETTINGS = [
     ('data_parallel', None),
     ('block_momentum', None),
     ('block_momentum', BlockMomentumConfig(block_momentum_as_time_constant=4000, block_learning_rate=2, block_size=NUM_WORKERS*BATCH_SIZE_PER_WORKER*3, distributed_after=NUM_WORKERS*BATCH_SIZE_PER_WORKER*2)),
-    ('data_parallel', DataParallelConfig(num_quantization_bits=1, distributed_after=NUM_WORKERS*BATCH_SIZE_PER_WORKER*2)),
+    ('data_parallel', DataParallelConfig(num_quantization_bits=1, distributed_after=NUM_WORKERS*BATCH_SIZE_PER_WORKER*2, compression=None)),
+    ('data_parallel', DataParallelConfig(num_quantization_bits=32, distributed_after=0, compression='bfloat16')),
+    ('model_averaging', ModelAveragingConfig(sync_period=1, max_staleness=0, distributed_after=0)),
+    ('model_averaging', ModelAveragingConfig(sync_period=3, max_staleness=2, distributed_after=NUM_WORKERS*BATCH_SIZE_PER_WORKER*2)),
 ]
 
 @pytest.mark.parametrize("mode, config", TRAINING_SETTINGS)
@@ -136,6 +166,10 @@ def test_distributed_training_accuracy(tmpdir, device_id, mode, config):
     if config is not None:
         return
 
+    train_reference(ref_trainer)
+    assert np.allclose(p0, ref_trainer.p.value)
+
+def train_reference(ref_trainer):
     # reference training on single worker, by concatenating data on all workers
     for batch in range(NUM_BATCHES):
         indices = None
@@ -145,7 +179,62 @@ def test_distributed_training_accuracy(tmpdir, device_id, mode, config):
             indices = np.concatenate([indices, rank_indices]) if indices is not None else rank_indices
         ref_trainer.train_minibatch(indices)
 
-    assert np.allclose(p0, ref_trainer.p.value)
+# gradients of 1/3 are not representable in 16 bits; with a scale of 1e4 the fp16 sums
+# would overflow, so these gradients have to be aggregated in fp32
+COMPRESSION_SETTINGS = [
+    ('float16', 1.0/3, 1e-3),
+    ('bfloat16', 1.0/3, 1e-2),
+    ('float16', 1e4, 1e-5),
+]
+
+@pytest.mark.parametrize("compression, output_scale, rtol", COMPRESSION_SETTINGS)
+def test_compressed_aggregation_accuracy(tmpdir, device_id, compression, output_scale, rtol):
+    mode = 'data_parallel'
+    config = DataParallelConfig(num_quantization_bits=32, distributed_after=0, compression=compression)
+    ref_trainer = SimpleTrainer(None, None, output_scale)
+    if not ref_trainer.create_distributed_learner(mode, config):
+        pytest.skip("unsupported distributed learner mode")
+
+    config_filename = os.path.join(str(tmpdir),'config.pkl')
+    with open(config_filename, 'wb') as pkl:
+        pickle.dump(config, pkl)
+    launch_args = ['--outputdir', str(tmpdir), '--mode', mode, '--config', config_filename, '--output_scale', str(output_scale)]
+    if device_id >= 0:
+        launch_args += ['--gpu']
+
+    mpiexec_execute(__file__, ['-n', str(NUM_WORKERS)], launch_args)
+
+    p0 = np.load(os.path.join(str(tmpdir), mode+'0.npy'))
+    for rank in range(NUM_WORKERS):
+        assert np.array_equal(p0, np.load(os.path.join(str(tmpdir), mode+str(rank)+'.npy')))
+
+    # compare with fp32 aggregation on a single worker
+    train_reference(ref_trainer)
+    assert np.all(np.isfinite(p0))
+    assert np.allclose(p0, ref_trainer.p.value, rtol=rtol)
+
+def test_model_averaging_with_overlapping_evaluation(tmpdir, device_id):
+    mode = 'model_averaging'
+    config = ModelAveragingConfig(sync_period=1, max_staleness=2, distributed_after=0)
+    if not SimpleTrainer(None, None).create_distributed_learner(mode, config):
+        pytest.skip("unsupported distributed learner mode")
+
+    config_filename = os.path.join(str(tmpdir),'config.pkl')
+    with open(config_filename, 'wb') as pkl:
+        pickle.dump(config, pkl)
+    launch_args = ['--outputdir', str(tmpdir), '--mode', mode, '--config', config_filename, '--evaluate']
+    if device_id >= 0:
+        launch_args += ['--gpu']
+
+    mpiexec_execute(__file__, ['-n', str(NUM_WORKERS)], launch_args)
+
+    # the evaluations are aggregated across workers, and the final checkpoint averages the models
+    p0 = np.load(os.path.join(str(tmpdir), mode+'0.npy'))
+    e0 = np.load(os.path.join(str(tmpdir), mode+'_eval0.npy'))
+    assert len(e0) == NUM_BATCHES
+    for rank in range(NUM_WORKERS):
+        assert np.allclose(p0, np.load(os.path.join(str(tmpdir), mode+str(rank)+'.npy')))
+        assert np.allclose(e0, np.load(os.path.join(str(tmpdir), mode+'_eval'+str(rank)+'.npy')))
 
 #mpiexec entrance
 if __name__=='__main__':
@@ -154,6 +243,8 @@ if __name__=='__main__':
     parser.add_argument('-mode', '--mode')
     parser.add_argument('-gpu', '--gpu', action='store_true')
     parser.add_argument('-config', '--config', required=False, default=None)
+    parser.add_argument('-evaluate', '--evaluate', action='store_true')
+    parser.add_argument('-output_scale', '--output_scale', type=float, default=1)
     args = vars(parser.parse_args())
     
     config = None
@@ -161,5 +252,8 @@ if __name__=='__main__':
         with open(args['config'], 'rb') as pkl:
             config = pickle.load(pkl)
 
-    distributed_worker(args['outputdir'], args['gpu'], args['mode'], config)
+    if args['evaluate']:
+        distributed_worker_with_evaluation(args['outputdir'], args['gpu'], args['mode'], config)
+    else:
+        distributed_worker(args['outputdir'], args['gpu'], args['mode'], config, args['output_scale'])
     C.Communicator.finalize()
\ No newline at end of file
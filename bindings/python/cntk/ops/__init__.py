@@ -194,6 +194,35 @@ def as_composite(root_function, name=''):
     from cntk.cntk_py import as_composite
     return as_composite(root_function, name)
 
+@typemap
+def freeze_for_inference(model, outputs=None, max_batch_size=0, device=None):
+    '''
+     Creates a frozen, inference only copy of ``model`` that computes ``outputs``.
+     Everything the outputs do not depend on (e.g. the training criterion) is dropped,
+     parameters are turned into constants, dropout is removed, batch normalization is folded
+     into the weights of a preceding times or convolution where possible, and all subgraphs
+     that only depend on constants are precomputed. When the frozen model is evaluated, the bias
+     and the relu, sigmoid or tanh activation of dense layers are applied in the epilogue of
+     the matrix product; the frozen model cannot be trained.
+
+    Args:
+        model (:class:`~cntk.ops.functions.Function`): the model to freeze
+        outputs (list of :class:`~cntk.variables.Variable`, optional): the outputs to keep;
+         all outputs of ``model`` if not specified
+        max_batch_size (int, defaults to 0): if non-zero, the memory of all intermediate results is
+         planned and allocated upfront for minibatches of up to ``max_batch_size`` samples. The plan is
+         preserved when the frozen model is saved.
+        device (:class:`~cntk.device.DeviceDescriptor`): the device the constant subgraphs are precomputed on
+
+    Returns:
+        :class:`~cntk.ops.functions.Function`
+    '''
+    from cntk.cntk_py import freeze_for_inference
+    if device is None:
+        device = use_default_device()
+    outputs = [o.output if isinstance(o, Function) else o for o in (outputs or [])]
+    return freeze_for_inference(model, outputs, max_batch_size, device)
+
 @typemap
 def alias(x, name=''):
     '''
@@ -44,6 +44,12 @@ class ModelFormat(Enum):
     subset of CNTK functionalities.
     '''
 
+    CNTKv2Mapped = cntk_py.ModelFormat_CNTKv2Mapped
+    '''
+    CNTK version 2 format with the parameter values stored outside of the graph description. Loading
+    memory-maps the file, so parameters are paged in on first use and shared by all processes that load it.
+    '''
+
 @unique
 class CloneMethod(Enum):
     '''
@@ -260,6 +260,24 @@ def test_as_composite():
     composite = C.as_composite(t_plus_b)
     assert(composite.root_function.name == func_name)
 
+def test_freeze_for_inference():
+    x = C.input_variable(2)
+    y = C.input_variable(2)
+    w = C.parameter(init=np.asarray([[1., 2.], [3., 4.]], dtype=np.float32))
+    b = C.parameter(init=np.asarray([1., -1.], dtype=np.float32))
+    z = C.plus(C.times(C.dropout(x, 0.5), w), b * 2, name='z')
+    loss = C.squared_error(z, y)
+
+    frozen = C.freeze_for_inference(C.combine([z, loss]), [z], max_batch_size=4)
+    assert len(frozen.outputs) == 1
+    assert len(frozen.arguments) == 1
+    assert len(frozen.parameters) == 0
+    from cntk.logging.graph import depth_first_search
+    assert depth_first_search(frozen, lambda f: isinstance(f, C.Function) and f.op_name == 'Dropout') == []
+
+    data = np.asarray([[1., 1.], [0., 2.]], dtype=np.float32)
+    assert np.allclose(frozen.eval({frozen.arguments[0]: data}), z.eval({x: data}))
+
 def test_input_order():
     input_dim = 1
     proj_dim = 2
@@ -550,6 +568,19 @@ def test_custom_attributes(tmpdir):
     assert 'def' == root2.custom_attributes['test2']
 
 
+def test_save_load_mapped(tmpdir):
+    x = C.input_variable(3)
+    w = C.parameter((3, 2), init=np.arange(6, dtype=np.float32).reshape(3, 2))
+    b = C.parameter(2, init=np.asarray([1, -1], dtype=np.float32))
+    root = C.times(x, w) + b
+    model_file = os.path.join(str(tmpdir), 'mapped.dnn')
+    root.save(model_file, format=C.ModelFormat.CNTKv2Mapped)
+    root2 = C.load_model(model_file, format=C.ModelFormat.CNTKv2Mapped)
+
+    data = np.asarray([[1, 2, 3]], dtype=np.float32)
+    assert np.allclose(root.eval({root.arguments[0]: data}), root2.eval({root2.arguments[0]: data}))
+
+
 def test_clone_with_different_dynamic_axes():
     q_axis = C.Axis('q')
     a_axis = C.Axis('a')
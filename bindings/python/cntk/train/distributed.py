@@ -120,7 +120,7 @@ class DistributedLearner(cntk_py.DistributedLearner):
         return super(DistributedLearner, self).total_number_of_samples_seen()
 
 @typemap
-def data_parallel_distributed_learner(learner, distributed_after=0, num_quantization_bits=32, use_async_buffered_parameter_update=False):
+def data_parallel_distributed_learner(learner, distributed_after=0, num_quantization_bits=32, use_async_buffered_parameter_update=False, compression=None):
     '''
     Creates a data parallel distributed learner
 
@@ -129,10 +129,17 @@ def data_parallel_distributed_learner(learner, distributed_after=0, num_quantiza
         distributed_after (int): number of samples after which distributed training starts
         num_quantization_bits (int): number of bits for quantization (1 to 32)
         use_async_buffered_parameter_update (bool): use async buffered parameter update, currently must be False
+        compression (str): `None`, ``'float16'`` or ``'bfloat16'``; sends float gradients
+         over the network as 16-bit values. Each reduction step sums in fp32 and rounds
+         back to 16 bits, so the error grows with the number of workers; with ``'float16'``,
+         gradients whose sum could exceed the fp16 range are sent in fp32. Applies to
+         gradients aggregated through CPU memory, cannot be combined with quantization.
     Returns:
         a distributed learner instance
     '''
     if (num_quantization_bits < 32):
+        if compression is not None:
+            raise ValueError('compression cannot be combined with num_quantization_bits < 32')
         return cntk_py.create_quantized_data_parallel_distributed_learner(
             cntk_py.quantized_mpicommunicator(True, True, num_quantization_bits),
             learner,
@@ -140,7 +147,7 @@ def data_parallel_distributed_learner(learner, distributed_after=0, num_quantiza
             use_async_buffered_parameter_update)
     else:
         return cntk_py.create_data_parallel_distributed_learner(
-            cntk_py.mpicommunicator(),
+            mpi_communicator(compression),
             learner,
             distributed_after,
             use_async_buffered_parameter_update)
@@ -196,9 +203,60 @@ def block_momentum_distributed_learner(learner, block_size, block_momentum_as_ti
             reset_sgd_momentum_after_aggregation,
             block_learning_rate)
 
+def model_averaging_distributed_learner(learner, sync_period, max_staleness=1, reset_sgd_momentum_after_aggregation=False, distributed_after=0):
+    '''
+    Creates a model averaging (local SGD) distributed learner, available on
+    both CPU and GPU builds.
+
+    Each worker updates its local model with the given learner. Every
+    ``sync_period`` minibatches the local models are averaged across the
+    workers, weighted by the number of samples each worker processed. The
+    averaging runs on a background thread while the next ``max_staleness``
+    local minibatches are processed, and the local progress made meanwhile is
+    kept on top of the averaged model. The background averaging communicates
+    on a private duplicate of the communicator and needs an MPI library with
+    ``MPI_THREAD_MULTIPLE`` support; otherwise the averaging is synchronous.
+    MPI is only initialized at that level if this is the first communicator
+    created in the process; other distributed training keeps the default
+    ``MPI_THREAD_SERIALIZED``.
+
+    Args:
+        learner: a local learner (i.e. sgd)
+        sync_period (int): number of minibatches between two model averagings
+        max_staleness (int): number of local minibatches that may be processed
+         while an averaging is in flight; 0 makes the averaging synchronous
+        reset_sgd_momentum_after_aggregation (bool): reset SGD momentum after aggregation
+        distributed_after (int): number of samples after which distributed training starts
+
+    Returns:
+        a distributed learner instance
+    '''
+    if max_staleness > 0:
+        cntk_py.enable_concurrent_mpicalls()
+    return cntk_py.create_model_averaging_distributed_learner(
+        cntk_py.mpicommunicator(),
+        learner,
+        distributed_after,
+        sync_period,
+        max_staleness,
+        reset_sgd_momentum_after_aggregation)
+
 @typemap
-def mpi_communicator():
+def mpi_communicator(compression=None):
     '''
     Creates a non quantized MPI communicator.
+
+    Args:
+        compression (str): `None`, ``'float16'`` or ``'bfloat16'``; precision
+         of the float values sent over the network by aggregations
     '''
-    return cntk_py.mpicommunicator()
+    if compression is None or compression == 'none':
+        return cntk_py.mpicommunicator()
+
+    compressions = {
+        'float16': cntk_py.MPICommunicatorCompression_Float16,
+        'bfloat16': cntk_py.MPICommunicatorCompression_BFloat16,
+    }
+    if compression not in compressions:
+        raise ValueError('unknown compression "%s", expected None, "float16" or "bfloat16"' % compression)
+    return cntk_py.compressed_mpicommunicator(compressions[compression])
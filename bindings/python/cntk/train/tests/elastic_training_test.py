@@ -0,0 +1,133 @@
+# Copyright (c) Microsoft. All rights reserved.
+
+# Licensed under the MIT license. See LICENSE.md file in the project root
+# for full license information.
+# ==============================================================================
+
+import argparse
+import os
+import pytest
+import signal
+import subprocess
+import sys
+import numpy as np
+import cntk as C
+from cntk.io import MinibatchSource, CTFDeserializer, StreamDef, StreamDefs, INFINITELY_REPEAT
+
+TIMEOUT_SECONDS = 300
+NUM_WORKERS = 4
+INPUT_DIM = 4
+NUM_CLASSES = 3
+NUM_SEQUENCES = 30
+MAX_SAMPLES = 240
+
+def mpiexec_execute(script, mpiexec_params, params, timeout_seconds=TIMEOUT_SECONDS):
+    cmd = ['mpiexec'] + mpiexec_params + ['python', script] + params
+    p = subprocess.Popen(cmd, stdout=subprocess.PIPE)
+    if sys.version_info[0] < 3:
+        out = p.communicate()[0]
+    else:
+        try:
+            out = p.communicate(timeout=timeout_seconds)[0]  # in case we have a hang
+        except subprocess.TimeoutExpired:
+            os.kill(p.pid, signal.CTRL_C_EVENT)
+            raise RuntimeError('Timeout in mpiexec, possibly hang')
+    return out.decode(sys.getdefaultencoding())
+
+def write_data(data_file):
+    np.random.seed(1)
+    with open(data_file, 'w') as f:
+        for seq in range(NUM_SEQUENCES):
+            features = ' '.join('%f' % v for v in np.random.random(INPUT_DIM))
+            label = np.random.randint(NUM_CLASSES)
+            f.write('%d\t|features %s\t|labels %d:1\n' % (seq, features, label))
+
+def elastic_worker(outdir, gpu, num_active_workers, leaving_ranks):
+    if gpu:
+        C.try_set_default_device(C.gpu(0))
+
+    feature = C.input_variable(INPUT_DIM)
+    label = C.input_variable(NUM_CLASSES)
+    w = C.parameter(shape=(INPUT_DIM, NUM_CLASSES), init=0.1)
+    b = C.parameter(shape=(NUM_CLASSES,), init=0)
+    z = C.times(feature, w) + b
+    ce = C.cross_entropy_with_softmax(z, label)
+    errs = C.classification_error(z, label)
+
+    learner = C.train.distributed.data_parallel_distributed_learner(
+        C.sgd(z.parameters, C.learning_parameter_schedule_per_sample(0.1)))
+    trainer = C.Trainer(z, (ce, errs), [learner])
+
+    mbs = MinibatchSource(CTFDeserializer(os.path.join(outdir, 'data.txt'), StreamDefs(
+        features=StreamDef(field='features', shape=INPUT_DIM),
+        labels=StreamDef(field='labels', shape=NUM_CLASSES, is_sparse=True))),
+        randomize=False, max_sweeps=INFINITELY_REPEAT)
+
+    session = C.training_session(
+        trainer=trainer, mb_source=mbs, mb_size=8,
+        model_inputs_to_streams={feature: mbs.streams.features, label: mbs.streams.labels},
+        max_samples=MAX_SAMPLES,
+        elastic_config=C.ElasticConfig(frequency=(2, C.train.DataUnit.minibatch), num_active_workers=num_active_workers))
+
+    rank = C.Communicator.rank()
+    if rank in leaving_ranks:
+        # leaves at the first membership update
+        session.request_leave()
+    session.train()
+
+    np.save(os.path.join(outdir, 'w%d' % rank), w.value)
+    np.save(os.path.join(outdir, 'b%d' % rank), b.value)
+    np.save(os.path.join(outdir, 'samples%d' % rank), np.asarray([trainer.total_number_of_samples_seen]))
+
+ELASTIC_SETTINGS = [
+    # a worker leaves, the others continue
+    (NUM_WORKERS, [1]),
+    # a worker leaves and the spare takes over
+    (NUM_WORKERS - 1, [1]),
+    # all training workers ask to leave; the first one stays until the spare has taken over its state
+    (NUM_WORKERS - 1, [0, 1, 2]),
+]
+
+@pytest.mark.parametrize("num_active_workers, leaving_ranks", ELASTIC_SETTINGS)
+def test_elastic_training_membership_changes(tmpdir, device_id, num_active_workers, leaving_ranks):
+    outdir = str(tmpdir)
+    write_data(os.path.join(outdir, 'data.txt'))
+
+    launch_args = ['--outputdir', outdir, '--active', str(num_active_workers), '--leaving'] + [str(r) for r in leaving_ranks]
+    if device_id >= 0:
+        launch_args += ['--gpu']
+
+    mpiexec_execute(__file__, ['-n', str(NUM_WORKERS)], launch_args)
+
+    def load(name, rank):
+        return np.load(os.path.join(outdir, '%s%d.npy' % (name, rank)))
+
+    # the ranks that asked to leave stop early
+    left = leaving_ranks
+    remaining = [r for r in range(NUM_WORKERS) if r not in left]
+    first = remaining[0]
+
+    # every worker that trained to the end, including promoted spares, ends up with the same model
+    assert load('samples', first)[0] >= MAX_SAMPLES
+    for rank in remaining:
+        assert np.allclose(load('w', first), load('w', rank))
+        assert np.allclose(load('b', first), load('b', rank))
+        assert load('samples', rank)[0] == load('samples', first)[0]
+
+    for rank in left:
+        assert load('samples', rank)[0] < load('samples', first)[0]
+
+    # the model was trained
+    assert not np.allclose(load('w', first), 0.1)
+
+#mpiexec entrance
+if __name__=='__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-outputdir', '--outputdir')
+    parser.add_argument('-gpu', '--gpu', action='store_true')
+    parser.add_argument('-active', '--active', type=int)
+    parser.add_argument('-leaving', '--leaving', type=int, nargs='*', default=[])
+    args = vars(parser.parse_args())
+
+    elastic_worker(args['outputdir'], args['gpu'], args['active'], args['leaving'])
+    C.Communicator.finalize()
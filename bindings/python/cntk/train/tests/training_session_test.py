@@ -498,6 +498,51 @@ def test_session_restart_from_end_checkpoint(tmpdir, device_id):
     assert(writer.testing_summary_counter == 0)
 
 
+def test_session_restart_from_async_checkpoint(tmpdir, device_id):
+    device = cntk_device(device_id)
+    writer = MockProgressWriter()
+    t, feature, label = create_sample_model(device, writer)
+    mbs = mb_source(tmpdir, "training", max_samples=INFINITELY_REPEAT)
+
+    input_map = {
+        feature: mbs.streams.features,
+        label: mbs.streams.labels
+    }
+
+    test_dir = str(tmpdir)
+
+    C.training_session(trainer=t, mb_source=mbs,
+        mb_size=4, model_inputs_to_streams=input_map,
+        max_samples=60, progress_frequency=20,
+        checkpoint_config = C.CheckpointConfig(frequency=20, preserve_all=True, async_checkpointing=True,
+                                             filename=str(tmpdir / "async_checkpoint"))
+    ).train(device)
+
+    # all background writes are done when training returns
+    candidates = [f for f in listdir(test_dir) if isfile(
+        join(test_dir, f)) and f.startswith("async_checkpoint")]
+
+    for i in range(3):
+        assert("async_checkpoint%d" % i in candidates)
+        assert("async_checkpoint%d.ckp" % i in candidates)
+    assert(not any(f.endswith(".tmp") for f in candidates))
+
+    writer.minibatch_info = []
+    writer.training_summary_counter = 0
+
+    # restoring from the last checkpoint should not cause any training
+    mbs = mb_source(tmpdir, "training", max_samples=INFINITELY_REPEAT)
+    C.training_session(trainer=t, mb_source=mbs,
+        mb_size=4, model_inputs_to_streams=input_map,
+        max_samples=60, progress_frequency=20,
+        checkpoint_config = C.CheckpointConfig(frequency=35, restore=True, async_checkpointing=True,
+                                             filename=str(tmpdir / "async_checkpoint"))
+    ).train(device)
+
+    assert(len(writer.minibatch_info) == 0)
+    assert(writer.training_summary_counter == 0)
+
+
 def test_session_restart_from_checkpoint_preserve_all(tmpdir, device_id):
     device = cntk_device(device_id)
     writer = MockProgressWriter()
@@ -791,3 +836,39 @@ def test_training_session_with_infinite_samples(tmpdir, device_id):
             cv_config = C.CrossValidationConfig(mbs2)
         ).train(device)
     assert 'Cross validation minibatch source must have a limited number of samples or sweeps' in str(info3.value)
+
+def test_session_elastic_training(tmpdir, device_id):
+    import pytest
+    device = cntk_device(device_id)
+    t, feature, label = create_sample_model(device)
+    mbs = mb_source(tmpdir, "training", max_samples=INFINITELY_REPEAT)
+
+    input_map = {
+        feature: mbs.streams.features,
+        label: mbs.streams.labels
+    }
+
+    elastic_config = C.ElasticConfig(frequency=(2, C.train.DataUnit.minibatch))
+    with pytest.raises(ValueError) as info:
+        C.training_session(
+            trainer=t, mb_source=mbs,
+            mb_size=4, model_inputs_to_streams=input_map,
+            max_samples=20,
+            elastic_config=elastic_config)
+    assert 'Elastic training requires a distributed learner' in str(info.value)
+
+    learner = C.train.distributed.data_parallel_distributed_learner(
+        C.sgd(t.model.parameters, C.learning_parameter_schedule_per_sample(0.1)))
+    t = C.Trainer(t.model, (t.loss_function, t.evaluation_function), [learner])
+
+    session = C.training_session(
+        trainer=t, mb_source=mbs,
+        mb_size=4, model_inputs_to_streams=input_map,
+        max_samples=20,
+        elastic_config=elastic_config)
+
+    # The only worker has to keep training, its request to leave stays pending.
+    session.request_leave()
+    session.train(device)
+
+    assert(t.total_number_of_samples_seen == 21)
@@ -66,9 +66,11 @@ class CheckpointConfig(cntk_py.CheckpointConfig):
           See :class:`DataUnit` for more information on frequency data unit.
         restore (bool): flag, indicating whether to restore from available checkpoint before the start of the training
         preserve_all (bool): saves all checkpoints, using ``filename`` as prefix and checkpoint index as a suffix.
+        async_checkpointing (bool): only takes an in-memory snapshot of the model and trainer state when checkpointing,
+          and writes it on a background thread while training continues.
     '''
     def __init__(self, filename, frequency=None,
-                 restore=True, preserve_all=False):
+                 restore=True, preserve_all=False, async_checkpointing=False):
         '''Sets configuration of checkpointing behavior.
 
         Args:
@@ -80,6 +82,8 @@ class CheckpointConfig(cntk_py.CheckpointConfig):
                  :class:`DataUnit`
             restore (bool): flag, indicating whether to restore from available checkpoint before the start of the training
             preserve_all (bool): saves all checkpoints, using ``filename`` as prefix and checkpoint index as a suffix.
+            async_checkpointing (bool): only takes an in-memory snapshot of the model and trainer state when checkpointing,
+              and writes it on a background thread while training continues.
 
         Returns:
             Reconfigured self.
@@ -96,7 +100,7 @@ class CheckpointConfig(cntk_py.CheckpointConfig):
             frequency = sys.maxsize
 
         super(CheckpointConfig, self).__init__(filename, frequency, frequency_unit,
-                                               restore, preserve_all)
+                                               restore, preserve_all, async_checkpointing)
 
 class CrossValidationConfig(cntk_py.CrossValidationConfig):
     '''
@@ -220,6 +224,35 @@ class TestConfig(cntk_py.TestConfig):
         from warnings import warn
         warn('DEPRECATED: ' + message, DeprecationWarning, stacklevel=2)
 
+class ElasticConfig(cntk_py.ElasticConfig):
+    '''
+    An elastic training configuration for the training session.
+
+    The training workers agree on who trains with the given frequency. A worker that called
+    :meth:`TrainingSession.request_leave` stops training at the next such point without interrupting the
+    others, and a spare worker, if any, takes over from it, starting from the in-memory state of the
+    remaining workers. Requires a distributed learner.
+
+    Only workers that ask to leave are handled. A worker that crashes is not detected: the others
+    block in their next collective call until the MPI runtime aborts the job.
+
+    Args:
+        frequency (int, tuple): period of the membership updates (number of samples between them).
+          If a tuple of (`frequency`, :class:`DataUnit`), the `frequency` is in terms of either `DataUnit.sample`, `DataUnit.minibatch` or `DataUnit.sweep`.
+          If `None` or 0, elastic training is disabled.
+        num_active_workers (int): number of workers that train; the remaining workers are spares.
+          If `None`, all workers train.
+    '''
+    def __init__(self, frequency=None, num_active_workers=None):
+        frequency, frequency_unit = _unpack_parameter_frequency(frequency)
+        if frequency is None:
+            frequency = 0
+
+        if num_active_workers is None:
+            num_active_workers = sys.maxsize
+
+        super(ElasticConfig, self).__init__(frequency, frequency_unit, num_active_workers)
+
 class TrainingSession(cntk_py.TrainingSession):
     '''
     The instance of the class should be created by using :func:`~cntk.train.training_session.training_session` function.
@@ -240,13 +273,15 @@ class TrainingSession(cntk_py.TrainingSession):
         checkpoint_config (:class:`CheckpointConfig`): checkpoint configuration
         cv_config (:class:`CrossValidationConfig`): cross validation configuration
         test_config (:class:`TestConfig`): test configuration
+        elastic_config (:class:`ElasticConfig`): elastic training configuration
     '''
     def __init__(self, trainer, mb_source, mb_size,
                  model_inputs_to_streams, max_samples,
                  progress_frequency, 
                  checkpoint_config,
                  cv_config,
-                 test_config):
+                 test_config,
+                 elastic_config=None):
 
         if trainer is None:
             raise ValueError("Trainer must not be None.")
@@ -281,6 +316,9 @@ class TrainingSession(cntk_py.TrainingSession):
         if cv_config is not None:
             self.cv_callback = cv_config.callback
 
+        if elastic_config is None:
+            elastic_config = ElasticConfig()
+
         self._callback_references = (mb_source, checkpoint_config, test_config) # keep a strong reference inside this object so that SWIG finds it
 
         super(TrainingSession, self).__init__(trainer, mb_source, schedule,
@@ -289,7 +327,8 @@ class TrainingSession(cntk_py.TrainingSession):
             progress_frequency_unit,
             checkpoint_config,
             cv_config,
-            test_config)
+            test_config,
+            elastic_config)
 
     @staticmethod
     def _sanitize_minibatch_source(minibatch_source, model_inputs_to_streams, criterion, infinitely_repeat=True):
@@ -332,6 +371,13 @@ class TrainingSession(cntk_py.TrainingSession):
 
         super(TrainingSession, self).train(device)
 
+    def request_leave(self):
+        '''
+        Asks to stop training this worker at the next membership update of elastic training
+        (see :class:`ElasticConfig`). Can be called from any thread.
+        '''
+        super(TrainingSession, self).request_leave()
+
     def on_cross_validation_end(self, index, average_error, num_samples, num_minibatches):
         '''
         Callback that gets executed at the end of cross validation.
@@ -403,7 +449,8 @@ def training_session(trainer,
                      max_samples=None,
                      checkpoint_config=None,
                      cv_config=None,
-                     test_config=None):
+                     test_config=None,
+                     elastic_config=None):
     '''
     A factory function to create a training session object.
 
@@ -419,6 +466,7 @@ def training_session(trainer,
         checkpoint_config (:class:`~CheckpointConfig`): checkpoint configuration
         cv_config (:class:`~CrossValidationConfig`): cross validation configuration
         test_config (:class:`~TestConfig`): test configuration
+        elastic_config (:class:`~ElasticConfig`): elastic training configuration
 
     Returns:
         Instance of :class:`~TrainingSession`
@@ -433,4 +481,4 @@ def training_session(trainer,
        test_config = TestConfig(None)
 
     return TrainingSession(trainer, mb_source, mb_size, model_inputs_to_streams, max_samples,
-                           progress_frequency, checkpoint_config, cv_config, test_config)
+                           progress_frequency, checkpoint_config, cv_config, test_config, elastic_config)